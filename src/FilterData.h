@@ -10,18 +10,131 @@
 #include <queue>
 #include <condition_variable>
 #include <atomic>
-#include "ort-model/ONNXRuntimeModel.h"
+#include <deque>
+#include <array>
+#include "ort-model/InferenceService.h"
+#include "tracker/ByteTracker.h"
+#include "tracker/RoiMosaic.h"
+#include "motion/MotionDetector.h"
+#include "motion/SceneCutDetector.h"
+#include "cascade/CascadeStage.h"
+#include "gate/PresenceGate.h"
+#include "channel/SourceChannel.h"
+#include "pipeline/SpscRing.h"
+#include "output/DetectionWriter.h"
+#include "output/ShmPublisher.h"
+#include "output/PushServer.h"
+#include "output/DetectionResult.h"
+#include "output/SidecarRecorder.h"
+#include "overlay/OverlayGeometry.h"
+#include "overlay/OverlayRenderer.h"
+
+// a captured frame waiting for inference
+struct inference_frame {
+	cv::Mat bgra;
+	uint64_t timestamp_ns; // obs_get_video_frame_time() at capture
+	uint64_t scene;        // filter_stats::scene_cuts at capture
+	// set when another filter on the source already ran the detection, see SourceChannel
+	std::shared_ptr<const channel::SharedDetections> detections;
+};
+
+// a frame on its way through the detection stages: prepared on the worker thread, run and
+// finished on the same thread or, pipelined, on the run and post threads
+struct detection_job {
+	inference_frame frame;
+	std::shared_ptr<SharedModel> model;
+	int slot = -1; // input slot holding the prepared frame, -1 when the detector does not run
+	float threshold = 0.0f;
+	cv::Rect cropRect;
+	std::vector<tracker::MosaicTile> tiles;
+	size_t roiTracks = 0;
+	bool shared = false;    // the detections came from a sibling on the same source
+	bool publishes = false; // siblings take this filter's detections
+	std::shared_ptr<channel::SourceChannel> sourceChannel;
+	std::vector<Object> objects;
+	uint64_t prepare_ns = 0;
+	uint64_t run_ns = 0;
+};
+
+// model input tensors, double buffered so one frame is prepared while the other one runs
+struct input_slot {
+	std::shared_ptr<SharedModel> model; // the model the tensors were created for
+	std::unique_ptr<ModelInput> input;
+	bool busy = false;
+};
+
+// How the preview shows the detections
+enum class PreviewMode {
+	Overlay,     // drawn by the GPU over the live source
+	Frame,       // the detected frame with the overlay, composited on the CPU
+	Transparent, // the overlay alone composited on the CPU, over the live source
+};
+
+// counters shown in the filter properties, written from the tick and the worker
+struct filter_stats {
+	std::atomic<uint64_t> inferences{0};
+	std::atomic<uint64_t> motion_skips{0};
+	std::atomic<uint64_t> scene_cuts{0};
+	std::atomic<uint64_t> detector_ns{0};
+	std::atomic<uint64_t> gate_checks{0};
+	std::atomic<uint64_t> gate_hits{0};
+	std::atomic<uint64_t> gate_ns{0};
+
+	// moving averages in ms of the stages and of the capture to result latency
+	std::atomic<double> prepare_ms{0.0};
+	std::atomic<double> run_ms{0.0};
+	std::atomic<double> post_ms{0.0};
+	std::atomic<double> latency_ms{0.0};
+
+	// preview updates drawn and left out, and the time spent drawing them
+	std::atomic<uint64_t> preview_updates{0};
+	std::atomic<uint64_t> preview_skips{0};
+	std::atomic<uint64_t> preview_ns{0};
+	// what the preview keeps on the CPU and the GPU, and what a full size frame would take
+	std::atomic<uint64_t> preview_bytes{0};
+	std::atomic<uint64_t> preview_full_bytes{0};
+
+	// frame times of the most recent cuts, oldest first
+	static constexpr size_t SCENE_CUT_HISTORY = 32;
+	std::deque<uint64_t> scene_cut_times_ns;
+	std::mutex scene_cut_lock;
+
+	// output records dropped as of the last warning, only used by the tick
+	uint64_t dropped_logged = 0;
+
+	// the counters formatted once a second by the tick, shown by the properties and never
+	// stored in the settings
+	std::string text;
+	std::mutex text_lock;
+};
 
 struct filter_data {
 	std::string useGPU;
+	std::string epOptions;
 	uint32_t numThreads;
 	float conf_threshold;
 	std::string modelSize;
+	bool quantizedModel;
+	bool graphPreprocessing;
 
 	int minAreaThreshold;
 	int objectCategory;
-	int lastDetectedObjectId;
+	// the latest result for the proc handlers, the filter holds one reference; resultLock
+	const obs_detect_result *latestResult;
+	uint64_t resultSequence;
+	std::mutex resultLock;
+	std::string detectedObjectText; // last shown in the detected_object property, tick only
 	std::string saveDetectionsPath;
+	output::DetectionWriter detectionWriter;
+	bool shmOutput;
+	output::ShmPublisher shmPublisher; // opened on the tick, the parent is not known on create
+	std::shared_ptr<output::PushServer> pushServer; // set while push output is on
+	output::DeltaConfig pushDeltaConfig;            // for push clients asking for deltas
+	std::mutex pushServerLock;
+	bool recordSidecar;
+	output::SidecarRecorder sidecarRecorder; // follows OBS recording, started on the tick
+	std::string sidecarRecordingPath;        // the recording it belongs to, tick only
+	std::chrono::steady_clock::time_point last_sidecar_check; // of the OBS outputs, tick only
 	bool crop_enabled;
 	int crop_left;
 	int crop_right;
@@ -33,21 +146,115 @@ struct filter_data {
 	gs_stagesurf_t *stagesurface;
 
 	cv::Mat inputBGRA;
+	// the preview composited on the CPU, at 1/previewScale of previewFrameSize; outputLock
 	cv::Mat outputPreviewBGRA;
+	// the size of the frame it was made from and its mode, Frame or Transparent
+	cv::Size previewFrameSize;
+	PreviewMode previewFrameMode;
+	std::atomic<uint64_t> previewGeneration{0}; // bumped under outputLock with every new preview
+	// outputPreviewBGRA on the GPU, graphics thread only
+	gs_texture_t *previewTexture;
+	uint64_t previewTextureGeneration; // the generation in previewTexture
+	cv::Size previewTextureFrameSize;
+	PreviewMode previewTextureMode;
+	// drawn by the GPU over the live source in PreviewMode::Overlay; guarded by outputLock
+	std::shared_ptr<const overlay::OverlayGeometry> overlayGeometry;
+	overlay::OverlayRenderer overlayRenderer; // graphics thread only
 
 	bool isDisabled;
 	bool preview;
+	PreviewMode previewMode;
+	int previewScale;                       // 1, 2 or 4
+	uint64_t previewIntervalNs;             // between preview updates, 0 for every result
+	std::atomic<uint64_t> lastPreviewNs{0}; // when the preview was last updated
 	bool inferenceEnabled;
+	bool tracking;
+	bool roiInference;
+	int fullFrameInterval;
 
 	std::mutex inputBGRALock;
 	std::mutex outputLock;
 	std::mutex modelMutex;
 
-	std::unique_ptr<ONNXRuntimeModel> onnxruntimemodel;
-	std::vector<std::string> classNames;
+	// shared with the other filters using the same model and settings
+	std::shared_ptr<SharedModel> onnxruntimemodel;
+	// the class name tables are replaced whole under classNamesLock, the output and preview
+	// code works on a snapshot, see class_names()
+	std::shared_ptr<const std::vector<std::string>> classNames;
+	std::mutex classNamesLock;
+
+	// cascade: a second model on the upper part of every first stage object, guarded by
+	// modelMutex like the first one
+	bool cascadeEnabled;
+	std::string cascadeModelName;
+	std::string cascadeModelFile;
+	float cascadeThreshold;
+	cascade::CascadeConfig cascadeConfig;
+	std::shared_ptr<SharedModel> cascadeModel;
+	std::shared_ptr<const std::vector<std::string>> cascadeClassNames; // see classNames
+
+	// presence gate: on frames without objects a cheap model decides if the detector runs,
+	// the model is guarded by modelMutex, the rest belongs to the worker
+	bool presenceGateEnabled;
+	std::string presenceGateModelName;
+	std::string presenceGateModelFile;
+	float presenceThreshold;
+	static constexpr float PRESENCE_CLOSE_MARGIN = 0.1f;
+	std::shared_ptr<SharedModel> presenceGateModel;
+	PresenceGate presenceGate;
+	std::atomic<bool> presenceDetected{false}; // the last detector run found objects
+	std::chrono::steady_clock::time_point last_gate_log;
+
+	// updated by the inference worker, predicted on every video tick
+	tracker::ByteTracker tracker;
+	std::mutex trackerLock;
+
+	// ROI inference: regions around the tracks, grown by this much of the box on each side
+	static constexpr float ROI_EXPANSION = 0.5f;
+	static constexpr int ROI_MIN_SIZE = 64;
+	int framesSinceFullFrame;
+	std::atomic<bool> force_full_frame{false};
+
+	// motion gate: frames whose thumbnail barely changed since the last inference are skipped
+	bool motionGate;
+	float motionThreshold; // fraction of the thumbnail pixels
+	float motionMaxStale;  // seconds, inference runs at least this often
+	bool motionInCrop;
+	static constexpr uint8_t MOTION_PIXEL_THRESHOLD = 12;
+	MotionDetector motionDetector;
+	// low resolution luma of the current frame, shared by the motion gate and the cut detector
+	cv::Mat lumaThumbnail;
+
+	// scene cuts skip the rate limit and drop the detections and tracks of the previous shot
+	bool sceneCutDetection;
+	static constexpr float SCENE_CUT_THRESHOLD = 0.35f;
+	SceneCutDetector sceneCutDetector;
+
+	// the last reported detections, redrawn on the frames that skip inference
+	std::vector<Object> lastObjects;
+	std::mutex lastObjectsLock;
+
+	filter_stats stats;
+	std::chrono::steady_clock::time_point last_stats_update;
 
 	std::chrono::steady_clock::time_point last_inference_time;
-	static constexpr int MIN_INFERENCE_INTERVAL_MS = 200;
+
+	// the module-wide scheduler decides when a frame is submitted, see InferenceScheduler
+	uint64_t schedulerId;
+	int schedulerPriority; // -1 low, 0 normal, 1 high
+	bool pauseWhenHidden;
+
+	// filters on the same source share one capture and one detection per model and crop,
+	// the channel is joined on the first tick once the filter has a parent
+	std::shared_ptr<channel::SourceChannel> sourceChannel;
+	obs_source_t *channelInput; // what the channel was joined for, see channel_input
+	std::string modelKey;   // session key of the loaded model, guarded by modelMutex
+	std::string channelKey; // what the detection depends on, empty without a model
+	bool channelPrimary;    // capture and detect for the others when possible
+	std::mutex channelLock; // guards sourceChannel and channelKey
+	// the last published detections, republished while the motion gate holds them, guarded by
+	// lastObjectsLock
+	std::shared_ptr<const channel::SharedDetections> lastShared;
 
 #if _WIN32
 	std::wstring modelFilepath;
@@ -57,11 +264,27 @@ struct filter_data {
 
 	// 异步推理相关
 	std::thread inference_thread;
-	std::queue<cv::Mat> frame_queue;
+	std::queue<inference_frame> frame_queue;
 	std::mutex queue_mutex;
 	std::condition_variable queue_condition;
 	std::atomic<bool> should_stop{false};
 	std::atomic<bool> thread_running{false};
+
+	// pipelined: the worker prepares frame N+1 while the run thread runs frame N and the post
+	// thread finishes frame N-1; fixed while the threads run, see start_inference_threads
+	bool pipelined;
+	std::thread run_thread;
+	std::thread post_thread;
+	pipeline::SpscRing<detection_job> preparedJobs{1};
+	pipeline::SpscRing<detection_job> detectedJobs{2};
+	std::array<input_slot, 2> inputSlots;
+	std::mutex inputSlotLock;
+	std::condition_variable inputSlotFree;
+
+	// auto-tune runs off the UI thread, inference pauses while it measures
+	std::thread autotune_thread;
+	std::atomic<bool> autotune_running{false};
+	std::atomic<bool> session_tuning_changed{false};
 };
 
 #endif /* FILTERDATA_H */
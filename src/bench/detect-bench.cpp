@@ -0,0 +1,320 @@
+// obs-detect-bench: time detection models outside of OBS and compare their detections.
+//
+// Usage: obs-detect-bench --model <model.onnx> [--reference <model.onnx>]
+//                         [--kind edgeyolo|yunet] [--classes N] [--threads N]
+//                         [--iterations N] [--warmup N] [--threshold F]
+//                         [--preprocess cpp|graph] [--ep cpu,xnnpack,...]
+//                         [--ep-options "key=value;..."] [image.ppm ...]
+//
+// Without images a synthetic 1280x720 frame is used, which is fine for timing but yields no
+// detections. With --reference every image is also run through the reference model (e.g. the
+// float model when benchmarking its quantized variant) and the detections are matched at
+// IoU >= 0.5 to report precision, recall and mean IoU against it.
+//
+// Frames are BGRA like in the filter. --preprocess selects how --model turns them into its
+// input: "cpp" (BGRA to BGR conversion, static_resize and blobFromImage, as the worker does)
+// or "graph" (the ONNX preprocessing graph). The reference always uses "cpp", so passing the
+// same model as both compares the two preprocessing paths.
+//
+// --ep runs --model once per execution provider (the filter's inference device ids) and
+// reports each provider's detections against the first one; the reference runs on the first.
+// Providers missing from the ONNX Runtime build fall back to CPU, the output says where each
+// run actually ended up.
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "kernels/kernels.h"
+#include "ort-model/ONNXRuntimeModel.h"
+#include "edgeyolo/edgeyolo_onnxruntime.hpp"
+#include "yunet/YuNet.h"
+
+namespace {
+
+struct bench_options {
+	std::string model;
+	std::string reference;
+	std::string kind = "edgeyolo";
+	int classes = 80;
+	int threads = 1;
+	int iterations = 100;
+	int warmup = 5;
+	float threshold = 0.5f;
+	bool graph_preprocessing = false;
+	std::vector<std::string> execution_providers;
+	std::string ep_options;
+	std::vector<std::string> images;
+};
+
+struct timing {
+	double load_ms = 0.0;
+	std::vector<double> run_ms;
+};
+
+void usage(const char *argv0)
+{
+	fprintf(stderr,
+		"Usage: %s --model <model.onnx> [--reference <model.onnx>]\n"
+		"          [--kind edgeyolo|yunet] [--classes N] [--threads N]\n"
+		"          [--iterations N] [--warmup N] [--threshold F]\n"
+		"          [--preprocess cpp|graph] [--ep cpu,xnnpack,...]\n"
+		"          [--ep-options \"key=value;...\"] [image.ppm ...]\n",
+		argv0);
+}
+
+bool parse_args(int argc, char **argv, bench_options &opts)
+{
+	for (int i = 1; i < argc; ++i) {
+		const std::string arg = argv[i];
+		const bool has_value = i + 1 < argc;
+		if (arg == "--model" && has_value) {
+			opts.model = argv[++i];
+		} else if (arg == "--reference" && has_value) {
+			opts.reference = argv[++i];
+		} else if (arg == "--kind" && has_value) {
+			opts.kind = argv[++i];
+		} else if (arg == "--classes" && has_value) {
+			opts.classes = atoi(argv[++i]);
+		} else if (arg == "--threads" && has_value) {
+			opts.threads = atoi(argv[++i]);
+		} else if (arg == "--iterations" && has_value) {
+			opts.iterations = atoi(argv[++i]);
+		} else if (arg == "--warmup" && has_value) {
+			opts.warmup = atoi(argv[++i]);
+		} else if (arg == "--threshold" && has_value) {
+			opts.threshold = (float)atof(argv[++i]);
+		} else if (arg == "--preprocess" && has_value) {
+			const std::string mode = argv[++i];
+			if (mode != "cpp" && mode != "graph") {
+				return false;
+			}
+			opts.graph_preprocessing = mode == "graph";
+		} else if (arg == "--ep" && has_value) {
+			std::istringstream list(argv[++i]);
+			std::string ep;
+			while (std::getline(list, ep, ',')) {
+				if (!ep.empty()) {
+					opts.execution_providers.push_back(ep);
+				}
+			}
+		} else if (arg == "--ep-options" && has_value) {
+			opts.ep_options = argv[++i];
+		} else if (arg.rfind("--", 0) == 0) {
+			return false;
+		} else {
+			opts.images.push_back(arg);
+		}
+	}
+	if (opts.execution_providers.empty()) {
+		opts.execution_providers.push_back("cpu");
+	}
+	return !opts.model.empty() && (opts.kind == "edgeyolo" || opts.kind == "yunet") &&
+	       opts.iterations > 0;
+}
+
+// Binary PPM (P6) keeps the tool free of image codec dependencies,
+// e.g. `convert frame.png frame.ppm`
+cv::Mat read_ppm(const std::string &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	std::string magic;
+	int width = 0, height = 0, max_value = 0;
+	file >> magic >> width >> height >> max_value;
+	file.get();
+	if (!file || magic != "P6" || width <= 0 || height <= 0 || max_value != 255) {
+		return cv::Mat();
+	}
+	cv::Mat rgb(height, width, CV_8UC3);
+	file.read((char *)rgb.data, (std::streamsize)rgb.total() * 3);
+	if (!file) {
+		return cv::Mat();
+	}
+	cv::Mat bgra;
+	cv::cvtColor(rgb, bgra, cv::COLOR_RGB2BGRA);
+	return bgra;
+}
+
+std::unique_ptr<ONNXRuntimeModel> load_model(const bench_options &opts, const std::string &path,
+					     const std::string &ep, bool graph_preprocessing,
+					     timing &t)
+{
+	const file_name_t model_path = std::filesystem::path(path).native();
+	const auto start = std::chrono::steady_clock::now();
+	std::unique_ptr<ONNXRuntimeModel> model;
+	if (opts.kind == "yunet") {
+		model = std::make_unique<yunet::YuNetONNX>(model_path, opts.threads, 50,
+							   opts.threads, ep, 0, true, 0.45f,
+							   opts.threshold, nullptr, opts.ep_options);
+	} else {
+		model = std::make_unique<edgeyolo_cpp::EdgeYOLOONNXRuntime>(
+			model_path, opts.threads, opts.classes, opts.threads, ep, 0, true, 0.45f,
+			opts.threshold, nullptr, opts.ep_options);
+	}
+	if (graph_preprocessing && !model->enableGraphPreprocessing("")) {
+		throw std::runtime_error("graph preprocessing is not available for " + path);
+	}
+	t.load_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() -
+							      start)
+			    .count();
+	return model;
+}
+
+std::vector<std::vector<Object>> run_model(ONNXRuntimeModel &model,
+					   const std::vector<cv::Mat> &frames,
+					   const bench_options &opts, timing &t)
+{
+	// BGRA frames go straight into the graph, the C++ path needs BGR first
+	const bool convert = !model.usesGraphPreprocessing();
+	cv::Mat bgr;
+	auto infer = [&](const cv::Mat &frame) {
+		if (!convert) {
+			return model.inference(frame);
+		}
+		cv::cvtColor(frame, bgr, cv::COLOR_BGRA2BGR);
+		return model.inference(bgr);
+	};
+
+	for (int i = 0; i < opts.warmup; ++i) {
+		infer(frames[(size_t)i % frames.size()]);
+	}
+
+	std::vector<std::vector<Object>> detections(frames.size());
+	for (int i = 0; i < opts.iterations; ++i) {
+		const size_t f = (size_t)i % frames.size();
+		const auto start = std::chrono::steady_clock::now();
+		detections[f] = infer(frames[f]);
+		t.run_ms.push_back(std::chrono::duration<double, std::milli>(
+					   std::chrono::steady_clock::now() - start)
+					   .count());
+	}
+	return detections;
+}
+
+void print_timing(const std::string &label, const std::string &path,
+		  const ONNXRuntimeModel &model, timing t)
+{
+	std::sort(t.run_ms.begin(), t.run_ms.end());
+	double total = 0.0;
+	for (double ms : t.run_ms) {
+		total += ms;
+	}
+	const size_t n = t.run_ms.size();
+	printf("%-10s %s on %s\n", label.c_str(), path.c_str(), model.executionProvider().c_str());
+	printf("           load %.1f ms, run mean %.2f ms, p50 %.2f ms, p95 %.2f ms, min %.2f ms\n",
+	       t.load_ms, total / (double)n, t.run_ms[n / 2], t.run_ms[std::min(n - 1, n * 95 / 100)],
+	       t.run_ms[0]);
+}
+
+float iou(const cv::Rect_<float> &a, const cv::Rect_<float> &b)
+{
+	const float inter = (a & b).area();
+	const float uni = a.area() + b.area() - inter;
+	return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+void print_agreement(const std::vector<std::vector<Object>> &test,
+		     const std::vector<std::vector<Object>> &reference)
+{
+	size_t test_count = 0, reference_count = 0, matched = 0;
+	double iou_sum = 0.0;
+	for (size_t f = 0; f < test.size(); ++f) {
+		std::vector<bool> used(test[f].size(), false);
+		for (const Object &ref : reference[f]) {
+			float best = 0.5f;
+			int best_index = -1;
+			for (size_t i = 0; i < test[f].size(); ++i) {
+				const float o = iou(ref.rect, test[f][i].rect);
+				if (!used[i] && test[f][i].label == ref.label && o >= best) {
+					best = o;
+					best_index = (int)i;
+				}
+			}
+			if (best_index >= 0) {
+				used[(size_t)best_index] = true;
+				++matched;
+				iou_sum += best;
+			}
+		}
+		test_count += test[f].size();
+		reference_count += reference[f].size();
+	}
+	printf("agreement  %zu/%zu reference detections matched (recall %.3f), precision %.3f, "
+	       "mean IoU %.3f\n",
+	       matched, reference_count,
+	       reference_count ? (double)matched / (double)reference_count : 1.0,
+	       test_count ? (double)matched / (double)test_count : 1.0,
+	       matched ? iou_sum / (double)matched : 0.0);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	bench_options opts;
+	if (!parse_args(argc, argv, opts)) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	detect_kernels_init();
+
+	std::vector<cv::Mat> frames;
+	for (const std::string &image : opts.images) {
+		cv::Mat frame = read_ppm(image);
+		if (frame.empty()) {
+			fprintf(stderr, "Cannot read %s (expected binary PPM)\n", image.c_str());
+			return 1;
+		}
+		frames.push_back(frame);
+	}
+	if (frames.empty()) {
+		cv::Mat frame(720, 1280, CV_8UC4);
+		cv::randu(frame, cv::Scalar::all(0), cv::Scalar::all(255));
+		frames.push_back(frame);
+	}
+
+	try {
+		const std::string &first_ep = opts.execution_providers.front();
+		std::vector<std::vector<Object>> first_detections;
+		for (const std::string &ep : opts.execution_providers) {
+			timing model_timing;
+			auto model = load_model(opts, opts.model, ep, opts.graph_preprocessing,
+						model_timing);
+			const auto detections = run_model(*model, frames, opts, model_timing);
+			print_timing(opts.execution_providers.size() > 1 ? ep : "model", opts.model,
+				     *model, model_timing);
+			if (&ep == &first_ep) {
+				first_detections = detections;
+			} else {
+				print_agreement(detections, first_detections);
+			}
+		}
+
+		if (!opts.reference.empty()) {
+			timing reference_timing;
+			auto reference =
+				load_model(opts, opts.reference, first_ep, false, reference_timing);
+			const auto reference_detections =
+				run_model(*reference, frames, opts, reference_timing);
+			print_timing("reference", opts.reference, *reference, reference_timing);
+			print_agreement(first_detections, reference_detections);
+		}
+	} catch (const std::exception &e) {
+		fprintf(stderr, "Benchmark failed: %s\n", e.what());
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,80 @@
+#include "CascadeStage.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+#include "ort-model/InferenceService.h"
+#include "tracker/RoiMosaic.h"
+
+namespace cascade {
+
+std::vector<Object> runCascade(SharedModel &model, float conf_threshold, const cv::Mat &bgra,
+			       const std::vector<Object> &parents, const CascadeConfig &config)
+{
+	std::vector<Object> children;
+	const cv::Rect bounds(0, 0, bgra.cols, bgra.rows);
+
+	std::vector<const Object *> ordered;
+	for (const Object &parent : parents) {
+		ordered.push_back(&parent);
+	}
+	std::sort(ordered.begin(), ordered.end(), [](const Object *a, const Object *b) {
+		return a->rect.area() > b->rect.area();
+	});
+	if (ordered.size() > config.max_crops) {
+		ordered.resize(config.max_crops);
+	}
+
+	std::vector<cv::Rect> regions;
+	std::vector<uint64_t> region_parents;
+	for (const Object *parent : ordered) {
+		const cv::Rect region =
+			cv::Rect((int)std::floor(parent->rect.x), (int)std::floor(parent->rect.y),
+				 (int)std::ceil(parent->rect.width),
+				 (int)std::ceil(parent->rect.height * config.upper_fraction)) &
+			bounds;
+		if (region.area() > 0) {
+			regions.push_back(region);
+			region_parents.push_back(parent->id);
+		}
+	}
+
+	// drop the smallest crops until the rest fit at a usable scale
+	const cv::Size canvas = model.inputSize();
+	std::vector<tracker::MosaicTile> tiles;
+	while (!regions.empty() && !tracker::packMosaic(regions, canvas, config.min_scale, tiles)) {
+		regions.pop_back();
+		region_parents.pop_back();
+	}
+	if (tiles.empty()) {
+		return children;
+	}
+
+	cv::Mat mosaic, mosaicBGR;
+	tracker::renderMosaic(bgra, canvas, tiles, mosaic);
+	cv::cvtColor(mosaic, mosaicBGR, cv::COLOR_BGRA2BGR);
+
+	// tiles are in packing order, find each tile's parent by its source region
+	std::vector<uint64_t> tile_parents(tiles.size(), 0);
+	for (size_t t = 0; t < tiles.size(); ++t) {
+		for (size_t r = 0; r < regions.size(); ++r) {
+			if (regions[r] == tiles[t].source) {
+				tile_parents[t] = region_parents[r];
+				break;
+			}
+		}
+	}
+
+	std::vector<size_t> tile_indices;
+	children = tracker::mapMosaicDetections(model.inference(mosaicBGR, conf_threshold), tiles,
+						&tile_indices);
+	for (size_t i = 0; i < children.size(); ++i) {
+		children[i].parent_id = tile_parents[tile_indices[i]];
+		children[i].id = 0;
+	}
+	return children;
+}
+
+} // namespace cascade
@@ -0,0 +1,38 @@
+#ifndef CASCADE_STAGE_H
+#define CASCADE_STAGE_H
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+class SharedModel;
+
+namespace cascade {
+
+struct CascadeConfig {
+	// the second stage looks at this top part of every parent box (faces in person boxes)
+	float upper_fraction = 0.5f;
+	// the largest parents are kept when there are more
+	size_t max_crops = 8;
+	// crops are never shrunk below this, the smallest parents are dropped instead
+	double min_scale = 0.25;
+};
+
+/**
+ * Run a second stage detector on the upper crops of the first stage objects.
+ *
+ * All crops go through the model in one run, packed into a mosaic of its input size from the
+ * captured frame, so the frame is neither captured nor converted again. Every result gets the
+ * id of the parent whose crop it was found in as parent_id, and its label from the second
+ * stage's classes.
+ *
+ * @param bgra The frame the parents were detected in.
+ */
+std::vector<Object> runCascade(SharedModel &model, float conf_threshold, const cv::Mat &bgra,
+			       const std::vector<Object> &parents, const CascadeConfig &config);
+
+} // namespace cascade
+
+#endif /* CASCADE_STAGE_H */
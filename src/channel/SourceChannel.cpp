@@ -0,0 +1,185 @@
+#include "SourceChannel.h"
+
+#include <algorithm>
+
+#include "plugin-support.h"
+
+namespace channel {
+
+namespace {
+
+// a member that has not ticked for this long is disabled and loses its role
+constexpr std::chrono::seconds IDLE_AFTER(1);
+
+std::mutex registry_mutex;
+std::map<obs_source_t *, std::weak_ptr<SourceChannel>> registry;
+
+} // namespace
+
+std::shared_ptr<SourceChannel> SourceChannel::join(obs_source_t *input, uint64_t filter_id,
+						   Subscriber subscriber)
+{
+	std::shared_ptr<SourceChannel> channel;
+	{
+		std::lock_guard<std::mutex> lock(registry_mutex);
+		for (auto it = registry.begin(); it != registry.end();) {
+			it = it->second.expired() ? registry.erase(it) : std::next(it);
+		}
+		channel = registry[input].lock();
+		if (!channel) {
+			channel = std::make_shared<SourceChannel>();
+			registry[input] = channel;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(channel->mutex_);
+	channel->members_.push_back({filter_id, std::move(subscriber), std::string(), 1.0f, false,
+				     Clock::now()});
+	obs_log(LOG_INFO, "Filter joined the capture channel of %s (%zu filters)",
+		obs_source_get_name(input), channel->members_.size());
+	return channel;
+}
+
+void SourceChannel::leave(uint64_t filter_id)
+{
+	// after this no delivery to the member is in flight, publishDetections holds the lock
+	std::lock_guard<std::mutex> lock(mutex_);
+	members_.erase(std::remove_if(members_.begin(), members_.end(),
+				      [&](const Member &member) { return member.id == filter_id; }),
+		       members_.end());
+}
+
+void SourceChannel::update(uint64_t filter_id, const std::string &detection_key, float threshold,
+			   bool prefer_primary)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (Member &member : members_) {
+		if (member.id == filter_id) {
+			member.detection_key = detection_key;
+			member.threshold = threshold;
+			member.prefer_primary = prefer_primary;
+			member.last_tick = Clock::now();
+		}
+	}
+}
+
+const SourceChannel::Member *SourceChannel::find(uint64_t filter_id) const
+{
+	for (const Member &member : members_) {
+		if (member.id == filter_id) {
+			return &member;
+		}
+	}
+	return nullptr;
+}
+
+const SourceChannel::Member *SourceChannel::primary(const std::string *detection_key) const
+{
+	const Clock::time_point now = Clock::now();
+	const Member *first = nullptr;
+	for (const Member &member : members_) {
+		if (now - member.last_tick >= IDLE_AFTER ||
+		    (detection_key && member.detection_key != *detection_key)) {
+			continue;
+		}
+		if (member.prefer_primary) {
+			return &member;
+		}
+		if (!first) {
+			first = &member;
+		}
+	}
+	return first;
+}
+
+bool SourceChannel::capturesFrames(uint64_t filter_id) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const Member *member = primary(nullptr);
+	return !member || member->id == filter_id;
+}
+
+void SourceChannel::publishFrame(const cv::Mat &bgra, uint64_t timestamp_ns)
+{
+	// the capturer hands over a frame it no longer writes to, no copy needed
+	std::lock_guard<std::mutex> lock(mutex_);
+	frame_ = bgra;
+	frame_timestamp_ns_ = timestamp_ns;
+}
+
+bool SourceChannel::latestFrame(cv::Mat &bgra, uint64_t &timestamp_ns) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (frame_.empty()) {
+		return false;
+	}
+	bgra = frame_;
+	timestamp_ns = frame_timestamp_ns_;
+	return true;
+}
+
+bool SourceChannel::runsDetection(uint64_t filter_id) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const Member *self = find(filter_id);
+	if (!self || self->detection_key.empty()) {
+		return true;
+	}
+	const Member *member = primary(&self->detection_key);
+	return !member || member->id == filter_id;
+}
+
+bool SourceChannel::isSubscriber(const Member &member, const Member &self,
+				 Clock::time_point now) const
+{
+	return member.id != self.id && !self.detection_key.empty() &&
+	       member.detection_key == self.detection_key && now - member.last_tick < IDLE_AFTER;
+}
+
+bool SourceChannel::hasSubscribers(uint64_t filter_id) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const Member *self = find(filter_id);
+	if (!self) {
+		return false;
+	}
+	const Clock::time_point now = Clock::now();
+	return std::any_of(members_.begin(), members_.end(), [&](const Member &member) {
+		return isSubscriber(member, *self, now);
+	});
+}
+
+float SourceChannel::detectionThreshold(uint64_t filter_id) const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const Member *self = find(filter_id);
+	if (!self) {
+		return 1.0f;
+	}
+	const Clock::time_point now = Clock::now();
+	float threshold = self->threshold;
+	for (const Member &member : members_) {
+		if (isSubscriber(member, *self, now)) {
+			threshold = std::min(threshold, member.threshold);
+		}
+	}
+	return threshold;
+}
+
+void SourceChannel::publishDetections(uint64_t filter_id,
+				      const std::shared_ptr<const SharedDetections> &detections)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const Member *self = find(filter_id);
+	if (!self) {
+		return;
+	}
+	const Clock::time_point now = Clock::now();
+	for (const Member &member : members_) {
+		if (isSubscriber(member, *self, now) && member.subscriber) {
+			member.subscriber(detections);
+		}
+	}
+}
+
+} // namespace channel
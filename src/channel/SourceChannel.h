@@ -0,0 +1,94 @@
+#ifndef SOURCE_CHANNEL_H
+#define SOURCE_CHANNEL_H
+
+#include <obs.h>
+#include <opencv2/core.hpp>
+
+#include <chrono>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+namespace channel {
+
+// Detections of one frame, in frame coordinates, before any filter's own post-filters
+struct SharedDetections {
+	cv::Mat bgra;
+	uint64_t timestamp_ns;
+	std::vector<Object> objects;
+};
+
+using Subscriber = std::function<void(const std::shared_ptr<const SharedDetections> &)>;
+
+/**
+ * Shared capture and detections of the Detect filters stacked on one source that see the same
+ * frames, i.e. that capture the same input (see join).
+ *
+ * One member captures the frames for all (the member that asked to be primary, otherwise the
+ * first to join), and of the members detecting with the same model on the same crop one runs
+ * the detection and publishes the raw results, every member applies its own post-filters. Members that stopped ticking,
+ * e.g. disabled filters, hand their role to the next one.
+ */
+class SourceChannel {
+public:
+	// The channel of the source or filter whose output the filter captures, created for the
+	// first filter that captures it. Filters with different inputs get different frames, e.g.
+	// with another filter's effect or overlay, and never share.
+	static std::shared_ptr<SourceChannel> join(obs_source_t *input, uint64_t filter_id,
+						   Subscriber subscriber);
+	void leave(uint64_t filter_id);
+
+	/**
+	 * Called on every tick, keeps the member alive and up to date.
+	 *
+	 * @param detection_key Members with the same key take each other's detections, an empty
+	 *                      key takes part in the capture only.
+	 * @param threshold The lowest confidence the member uses.
+	 */
+	void update(uint64_t filter_id, const std::string &detection_key, float threshold,
+		    bool prefer_primary);
+
+	bool capturesFrames(uint64_t filter_id) const;
+	void publishFrame(const cv::Mat &bgra, uint64_t timestamp_ns);
+	bool latestFrame(cv::Mat &bgra, uint64_t &timestamp_ns) const;
+
+	bool runsDetection(uint64_t filter_id) const;
+	// Whether other members wait for this member's detections
+	bool hasSubscribers(uint64_t filter_id) const;
+	// The lowest threshold of the members sharing the detections, so they all get theirs
+	float detectionThreshold(uint64_t filter_id) const;
+	void publishDetections(uint64_t filter_id,
+			       const std::shared_ptr<const SharedDetections> &detections);
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	struct Member {
+		uint64_t id;
+		Subscriber subscriber;
+		std::string detection_key;
+		float threshold = 1.0f;
+		bool prefer_primary = false;
+		Clock::time_point last_tick;
+	};
+
+	// The primary among the live members, of those with detection_key if it is given
+	const Member *primary(const std::string *detection_key) const;
+	const Member *find(uint64_t filter_id) const;
+	// Live members other than self that take self's detections
+	bool isSubscriber(const Member &member, const Member &self, Clock::time_point now) const;
+
+	mutable std::mutex mutex_;
+	std::vector<Member> members_; // in joining order
+	cv::Mat frame_;
+	uint64_t frame_timestamp_ns_ = 0;
+};
+
+} // namespace channel
+
+#endif /* SOURCE_CHANNEL_H */
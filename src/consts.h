@@ -2,6 +2,7 @@
 #define CONSTS_H
 
 const char *const USEGPU_CPU = "cpu";
+const char *const USEGPU_XNNPACK = "xnnpack";
 const char *const USEGPU_DML = "dml";
 const char *const USEGPU_CUDA = "cuda";
 const char *const USEGPU_TENSORRT = "tensorrt";
@@ -6,6 +6,8 @@ void drawDashedLine(Mat &img, Point pt1, Point pt2, Scalar color, int thickness,
 {
 	double lineLength = norm(pt1 - pt2);
 	double angle = atan2(pt2.y - pt1.y, pt2.x - pt1.x);
+	const double dx = cos(angle);
+	const double dy = sin(angle);
 
 	Point p1 = pt1;
 	Point p2;
@@ -13,14 +15,12 @@ void drawDashedLine(Mat &img, Point pt1, Point pt2, Scalar color, int thickness,
 
 	for (double d = 0; d < lineLength; d += dashLength) {
 		if (draw) {
-			p2.x = pt1.x +
-			       static_cast<int>(cos(angle) * std::min(d + dashLength, lineLength));
-			p2.y = pt1.y +
-			       static_cast<int>(sin(angle) * std::min(d + dashLength, lineLength));
+			p2.x = pt1.x + static_cast<int>(dx * std::min(d + dashLength, lineLength));
+			p2.y = pt1.y + static_cast<int>(dy * std::min(d + dashLength, lineLength));
 			line(img, p1, p2, color, thickness, lineType);
 		}
-		p1.x = pt1.x + static_cast<int>(cos(angle) * (d + dashLength));
-		p1.y = pt1.y + static_cast<int>(sin(angle) * (d + dashLength));
+		p1.x = pt1.x + static_cast<int>(dx * (d + dashLength));
+		p1.y = pt1.y + static_cast<int>(dy * (d + dashLength));
 		draw = !draw;
 	}
 }
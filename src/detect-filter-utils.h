@@ -3,6 +3,8 @@
 
 #include <opencv2/core/types.hpp>
 
+// Both draw on BGR and BGRA images alike, give color an alpha of 255 to keep BGRA opaque
+
 void drawDashedLine(cv::Mat &img, cv::Point pt1, cv::Point pt2, cv::Scalar color, int thickness = 1,
 		    int lineType = 8, int dashLength = 10);
 
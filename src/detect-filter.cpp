@@ -9,6 +9,7 @@
 
 #include <opencv2/imgproc.hpp>
 
+#include <algorithm>
 #include <numeric>
 #include <memory>
 #include <exception>
@@ -16,26 +17,68 @@
 #include <new>
 #include <mutex>
 #include <regex>
+#include <filesystem>
 #include <thread>
 
 #include <nlohmann/json.hpp>
 
+#include <util/platform.h>
+
 #include <plugin-support.h>
 #include "FilterData.h"
 #include "consts.h"
 #include "obs-utils/obs-utils.h"
+#include "obs-utils/obs-config-utils.h"
 #include "ort-model/utils.hpp"
 #include "detect-filter-utils.h"
 #include "edgeyolo/edgeyolo_onnxruntime.hpp"
 #include "yunet/YuNet.h"
+#include "tracker/RoiMosaic.h"
+#include "cascade/CascadeStage.h"
+#include "scheduler/InferenceScheduler.h"
+#include "channel/SourceChannel.h"
+#include "output/DetectionWriter.h"
+#include "output/ShmPublisher.h"
+#include "output/PushServer.h"
+#include "output/DetectionResult.h"
+#include "output/SidecarRecorder.h"
 
 #define EXTERNAL_MODEL_SIZE "!!!EXTERNAL_MODEL!!!"
 #define FACE_DETECT_MODEL_SIZE "!!!FACE_DETECT!!!"
+#define AUTOTUNE_CONFIG_SECTION "autotune"
 
 struct detect_filter : public filter_data {};
 
 // 异步推理线程函数声明
 void inference_worker(struct detect_filter *tf);
+static void start_inference_threads(struct detect_filter *tf);
+static void stop_inference_threads(struct detect_filter *tf);
+static void get_detections_proc(void *data, calldata_t *cd);
+static void get_detections_result_proc(void *data, calldata_t *cd);
+
+// A snapshot of the class names of the detector and of the cascade stage
+struct class_name_tables {
+	std::shared_ptr<const std::vector<std::string>> names;
+	std::shared_ptr<const std::vector<std::string>> cascade;
+
+	output::ClassNames outputNames() const { return {*names, *cascade}; }
+};
+
+static class_name_tables class_names(struct detect_filter *tf)
+{
+	std::lock_guard<std::mutex> lock(tf->classNamesLock);
+	return {tf->classNames, tf->cascadeClassNames};
+}
+
+// Replace one of the tables, the snapshots taken before keep the old one
+static void set_class_names(struct detect_filter *tf,
+			    std::shared_ptr<const std::vector<std::string>> &table,
+			    const std::vector<std::string> &names)
+{
+	auto copy = std::make_shared<const std::vector<std::string>>(names);
+	std::lock_guard<std::mutex> lock(tf->classNamesLock);
+	table = std::move(copy);
+}
 
 const char *detect_filter_getname(void *unused)
 {
@@ -43,6 +86,93 @@ const char *detect_filter_getname(void *unused)
 	return obs_module_text("Detect");
 }
 
+/**                   AUTO-TUNE                     */
+
+static bool load_session_tuning(const file_name_t &model_path, SessionTuning &tuning)
+{
+	const std::string hash = modelFileHash(model_path);
+	nlohmann::json j;
+	if (hash.empty() ||
+	    getJsonFromConfig(AUTOTUNE_CONFIG_SECTION, hash.c_str(), &j) !=
+		    OBS_BGREMOVAL_CONFIG_SUCCESS) {
+		return false;
+	}
+	return SessionTuning::fromJson(j, tuning);
+}
+
+static void autotune_worker(struct detect_filter *tf, file_name_t model_path,
+			    obs_weak_source_t *weak_source)
+{
+	obs_log(LOG_INFO, "Auto-tuning inference settings");
+	SessionTuning best;
+	double best_ms = 0.0;
+	const unsigned hw_threads = std::thread::hardware_concurrency();
+	const int max_threads = (int)std::min(hw_threads > 0 ? hw_threads : 1u, 8u);
+
+	if (autotuneSession(model_path, max_threads, tf->should_stop, best, best_ms)) {
+		nlohmann::json j = best.toJson();
+		j["run_ms"] = best_ms;
+		setJsonInConfig(AUTOTUNE_CONFIG_SECTION, modelFileHash(model_path).c_str(), j);
+		obs_log(LOG_INFO, "Auto-tune result: %s (%.2f ms)", best.describe().c_str(),
+			best_ms);
+
+		// switch the filter to the tuned settings, unless it is being destroyed
+		obs_source_t *source = obs_weak_source_get_source(weak_source);
+		if (source) {
+			tf->session_tuning_changed = true;
+			obs_data_t *settings = obs_source_get_settings(source);
+			obs_data_set_int(settings, "numThreads", 0);
+			obs_source_update(source, settings);
+			obs_data_release(settings);
+			obs_source_release(source);
+		}
+	} else {
+		obs_log(LOG_WARNING, "Auto-tune did not finish");
+	}
+
+	obs_weak_source_release(weak_source);
+	tf->autotune_running = false;
+}
+
+static bool autotune_clicked(obs_properties_t *props, obs_property_t *property, void *data)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(property);
+	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
+
+	if (tf->useGPU != USEGPU_CPU) {
+		obs_log(LOG_WARNING, "Auto-tune only applies to CPU inference");
+		return false;
+	}
+	if (tf->modelFilepath.empty() || tf->autotune_running) {
+		return false;
+	}
+	if (tf->autotune_thread.joinable()) {
+		tf->autotune_thread.join();
+	}
+
+	tf->autotune_running = true;
+	tf->autotune_thread = std::thread(autotune_worker, tf, tf->modelFilepath,
+					  obs_source_get_weak_source(tf->source));
+	return false;
+}
+
+// The statistics line, as the properties show it
+static std::string stats_description(struct detect_filter *tf)
+{
+	std::lock_guard<std::mutex> lock(tf->stats.text_lock);
+	return std::string(obs_module_text("Stats")) + ": " + tf->stats.text;
+}
+
+static bool stats_refresh_clicked(obs_properties_t *props, obs_property_t *property, void *data)
+{
+	UNUSED_PARAMETER(property);
+	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
+	obs_property_set_description(obs_properties_get(props, "stats"),
+				     stats_description(tf).c_str());
+	return true;
+}
+
 /**                   PROPERTIES                     */
 
 static bool visible_on_bool(obs_properties_t *ppts, obs_data_t *settings, const char *bool_prop,
@@ -60,12 +190,41 @@ static bool enable_advanced_settings(obs_properties_t *ppts, obs_property_t *p,
 	const bool enabled = obs_data_get_bool(settings, "advanced");
 
 	for (const char *prop_name :
-	     {"threshold", "useGPU", "numThreads", "model_size", "detected_object",
-	      "save_detections_path", "crop_group", "min_size_threshold"}) {
+	     {"threshold", "useGPU", "ep_options", "numThreads", "autotune", "model_size",
+	      "quantized_model", "graph_preprocessing", "preview_mode", "preview_max_fps",
+	      "roi_inference", "full_frame_interval", "motion_gate", "motion_threshold",
+	      "motion_max_stale", "motion_in_crop", "scene_cut", "cascade", "cascade_model",
+	      "cascade_threshold", "presence_gate", "presence_gate_model", "presence_threshold",
+	      "scheduler_priority", "pause_when_hidden", "channel_primary", "pipelined",
+	      "detected_object", "stats", "stats_refresh", "save_detections_path",
+	      "save_detections_mode", "shm_output", "push_output", "record_sidecar", "crop_group",
+	      "min_size_threshold"}) {
 		p = obs_properties_get(ppts, prop_name);
 		obs_property_set_visible(p, enabled);
 	}
 
+	// log rotation only applies to NDJSON and delta logs
+	const char *save_mode = obs_data_get_string(settings, "save_detections_mode");
+	const bool delta = strcmp(save_mode, "delta") == 0;
+	const bool ndjson = delta || strcmp(save_mode, "ndjson") == 0;
+	obs_property_set_visible(obs_properties_get(ppts, "save_detections_max_mb"),
+				 enabled && ndjson);
+	obs_property_set_visible(obs_properties_get(ppts, "save_detections_rotate_minutes"),
+				 enabled && ndjson);
+	// only the previews composited on the CPU are scaled
+	obs_property_set_visible(obs_properties_get(ppts, "preview_scale"),
+				 enabled &&
+					 strcmp(obs_data_get_string(settings, "preview_mode"),
+						"overlay") != 0);
+
+	// push clients can ask for deltas too
+	const bool delta_used = delta || obs_data_get_bool(settings, "push_output");
+	for (const char *prop_name : {"delta_pixel_tolerance", "delta_iou_tolerance",
+				      "delta_score_band", "delta_keyframe_seconds"}) {
+		obs_property_set_visible(obs_properties_get(ppts, prop_name),
+					 enabled && delta_used);
+	}
+
 	return true;
 }
 
@@ -116,7 +275,7 @@ void read_model_config_json_and_set_class_names(const char *model_file, obs_prop
 			std::vector<std::string> labels = j["names"];
 			set_class_names_on_object_category(
 				obs_properties_get(props_, "object_category"), labels);
-			tf_->classNames = labels;
+			set_class_names(tf_, tf_->classNames, labels);
 		} else {
 			obs_data_set_string(settings, "error",
 					    "JSON file does not contain 'names' field");
@@ -134,12 +293,53 @@ obs_properties_t *detect_filter_properties(void *data)
 	obs_properties_add_bool(props, "inference_enabled", obs_module_text("ToggleInference"));
 
 	obs_properties_add_bool(props, "preview", obs_module_text("Preview"));
+	obs_property_t *preview_mode =
+		obs_properties_add_list(props, "preview_mode", obs_module_text("PreviewMode"),
+					OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(preview_mode, obs_module_text("PreviewModeOverlay"),
+				     "overlay");
+	obs_property_list_add_string(preview_mode, obs_module_text("PreviewModeFrame"), "frame");
+	obs_property_list_add_string(preview_mode, obs_module_text("PreviewModeTransparent"),
+				     "transparent");
+	obs_property_set_long_description(preview_mode, obs_module_text("PreviewModeInfo"));
+	obs_property_set_modified_callback(preview_mode, enable_advanced_settings);
+	obs_property_t *preview_scale =
+		obs_properties_add_list(props, "preview_scale", obs_module_text("PreviewScale"),
+					OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(preview_scale, obs_module_text("PreviewScaleFull"), 1);
+	obs_property_list_add_int(preview_scale, obs_module_text("PreviewScaleHalf"), 2);
+	obs_property_list_add_int(preview_scale, obs_module_text("PreviewScaleQuarter"), 4);
+	obs_property_set_long_description(preview_scale, obs_module_text("PreviewScaleInfo"));
+	obs_property_t *preview_max_fps = obs_properties_add_int_slider(
+		props, "preview_max_fps", obs_module_text("PreviewMaxFps"), 0, 60, 1);
+	obs_property_set_long_description(preview_max_fps, obs_module_text("PreviewMaxFpsInfo"));
+
+	obs_properties_add_bool(props, "tracking", obs_module_text("TrackObjects"));
+
+	obs_property_t *roi_inference = obs_properties_add_bool(props, "roi_inference",
+								 obs_module_text("RoiInference"));
+	obs_property_set_long_description(roi_inference, obs_module_text("RoiInferenceInfo"));
+	obs_properties_add_int_slider(props, "full_frame_interval",
+				      obs_module_text("FullFrameInterval"), 1, 60, 1);
+
+	obs_property_t *motion_gate =
+		obs_properties_add_bool(props, "motion_gate", obs_module_text("MotionGate"));
+	obs_property_set_long_description(motion_gate, obs_module_text("MotionGateInfo"));
+	obs_properties_add_float_slider(props, "motion_threshold",
+					obs_module_text("MotionThreshold"), 0.0, 10.0, 0.1);
+	obs_properties_add_float_slider(props, "motion_max_stale",
+					obs_module_text("MotionMaxStale"), 0.5, 60.0, 0.5);
+	obs_properties_add_bool(props, "motion_in_crop", obs_module_text("MotionInCrop"));
+
+	obs_property_t *scene_cut =
+		obs_properties_add_bool(props, "scene_cut", obs_module_text("SceneCutDetection"));
+	obs_property_set_long_description(scene_cut, obs_module_text("SceneCutDetectionInfo"));
 
 	obs_property_t *object_category =
 		obs_properties_add_list(props, "object_category", obs_module_text("ObjectCategory"),
 					OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
 	set_class_names_on_object_category(object_category, edgeyolo_cpp::COCO_CLASSES);
-	tf->classNames = edgeyolo_cpp::COCO_CLASSES;
+	set_class_names(tf, tf->classNames, edgeyolo_cpp::COCO_CLASSES);
 
 	obs_property_t *advanced =
 		obs_properties_add_bool(props, "advanced", obs_module_text("Advanced"));
@@ -174,6 +374,11 @@ obs_properties_t *detect_filter_properties(void *data)
 		props, "detected_object", obs_module_text("DetectedObject"), OBS_TEXT_DEFAULT);
 	obs_property_set_enabled(detected_obj_prop, false);
 
+	// read from the filter when the properties are shown or refreshed, not from the settings
+	obs_properties_add_text(props, "stats", stats_description(tf).c_str(), OBS_TEXT_INFO);
+	obs_properties_add_button2(props, "stats_refresh", obs_module_text("StatsRefresh"),
+				   stats_refresh_clicked, tf);
+
 	obs_properties_add_float_slider(props, "threshold", obs_module_text("ConfThreshold"), 0.0,
 					1.0, 0.025);
 
@@ -182,13 +387,54 @@ obs_properties_t *detect_filter_properties(void *data)
 
 	obs_properties_add_path(props, "save_detections_path",
 				obs_module_text("SaveDetectionsPath"), OBS_PATH_FILE_SAVE,
-				"JSON file (*.json);;All files (*.*)", nullptr);
+				"JSON file (*.json);;NDJSON file (*.ndjson);;All files (*.*)",
+				nullptr);
+	obs_property_t *save_detections_mode = obs_properties_add_list(
+		props, "save_detections_mode", obs_module_text("SaveDetectionsMode"),
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(save_detections_mode,
+				     obs_module_text("SaveDetectionsSnapshot"), "snapshot");
+	obs_property_list_add_string(save_detections_mode,
+				     obs_module_text("SaveDetectionsCompact"), "compact");
+	obs_property_list_add_string(save_detections_mode, obs_module_text("SaveDetectionsNdjson"),
+				     "ndjson");
+	obs_property_list_add_string(save_detections_mode, obs_module_text("SaveDetectionsDelta"),
+				     "delta");
+	obs_property_set_long_description(save_detections_mode,
+					  obs_module_text("SaveDetectionsModeInfo"));
+	obs_properties_add_int(props, "save_detections_max_mb",
+			       obs_module_text("SaveDetectionsMaxMB"), 1, 4096, 1);
+	obs_properties_add_int(props, "save_detections_rotate_minutes",
+			       obs_module_text("SaveDetectionsRotateMinutes"), 0, 10080, 1);
+	obs_property_set_modified_callback(save_detections_mode, enable_advanced_settings);
+	obs_property_t *shm_output =
+		obs_properties_add_bool(props, "shm_output", obs_module_text("ShmOutput"));
+	obs_property_set_long_description(shm_output, obs_module_text("ShmOutputInfo"));
+	obs_property_t *push_output =
+		obs_properties_add_bool(props, "push_output", obs_module_text("PushOutput"));
+	obs_property_set_long_description(push_output, obs_module_text("PushOutputInfo"));
+	obs_property_set_modified_callback(push_output, enable_advanced_settings);
+	obs_properties_add_int(props, "delta_pixel_tolerance",
+			       obs_module_text("DeltaPixelTolerance"), 0, 1000, 1);
+	obs_properties_add_float_slider(props, "delta_iou_tolerance",
+					obs_module_text("DeltaIouTolerance"), 0.0, 1.0, 0.01);
+	obs_properties_add_float_slider(props, "delta_score_band",
+					obs_module_text("DeltaScoreBand"), 0.0, 1.0, 0.01);
+	obs_property_t *delta_keyframe_seconds =
+		obs_properties_add_int(props, "delta_keyframe_seconds",
+				       obs_module_text("DeltaKeyframeSeconds"), 0, 3600, 1);
+	obs_property_set_long_description(delta_keyframe_seconds,
+					  obs_module_text("DeltaInfo"));
+	obs_property_t *record_sidecar =
+		obs_properties_add_bool(props, "record_sidecar", obs_module_text("RecordSidecar"));
+	obs_property_set_long_description(record_sidecar, obs_module_text("RecordSidecarInfo"));
 
 	obs_property_t *p_use_gpu =
 		obs_properties_add_list(props, "useGPU", obs_module_text("InferenceDevice"),
 					OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
 
 	obs_property_list_add_string(p_use_gpu, obs_module_text("CPU"), USEGPU_CPU);
+	obs_property_list_add_string(p_use_gpu, obs_module_text("CPUXNNPACK"), USEGPU_XNNPACK);
 #if defined(__linux__) && defined(__x86_64__)
 	obs_property_list_add_string(p_use_gpu, obs_module_text("GPUTensorRT"), USEGPU_TENSORRT);
 #endif
@@ -199,7 +445,17 @@ obs_properties_t *detect_filter_properties(void *data)
 	obs_property_list_add_string(p_use_gpu, obs_module_text("CoreML"), USEGPU_COREML);
 #endif
 
-	obs_properties_add_int_slider(props, "numThreads", obs_module_text("NumThreads"), 0, 8, 1);
+	obs_property_t *ep_options = obs_properties_add_text(
+		props, "ep_options", obs_module_text("ExecutionProviderOptions"), OBS_TEXT_DEFAULT);
+	obs_property_set_long_description(ep_options,
+					  obs_module_text("ExecutionProviderOptionsInfo"));
+
+	obs_property_t *num_threads = obs_properties_add_int_slider(
+		props, "numThreads", obs_module_text("NumThreads"), 0, 8, 1);
+	obs_property_set_long_description(num_threads, obs_module_text("NumThreadsAutoTune"));
+
+	obs_properties_add_button2(props, "autotune", obs_module_text("AutoTune"),
+				   autotune_clicked, tf);
 
 	obs_property_t *model_size =
 		obs_properties_add_list(props, "model_size", obs_module_text("ModelSize"),
@@ -212,6 +468,11 @@ obs_properties_t *detect_filter_properties(void *data)
 	obs_property_list_add_string(model_size, obs_module_text("ExternalModel"),
 				     EXTERNAL_MODEL_SIZE);
 
+	obs_properties_add_bool(props, "quantized_model", obs_module_text("QuantizedModel"));
+
+	obs_properties_add_bool(props, "graph_preprocessing",
+				obs_module_text("GraphPreprocessing"));
+
 	obs_properties_add_path(props, "external_model_file", obs_module_text("ModelPath"),
 				OBS_PATH_FILE, "ONNX files (*.onnx);;all files (*.*)",
 				nullptr);
@@ -230,12 +491,14 @@ obs_properties_t *detect_filter_properties(void *data)
 					set_class_names_on_object_category(
 						obs_properties_get(props_, "object_category"),
 						yunet::FACE_CLASSES);
-					tf_->classNames = yunet::FACE_CLASSES;
+					set_class_names(tf_, tf_->classNames,
+							yunet::FACE_CLASSES);
 				} else {
 					set_class_names_on_object_category(
 						obs_properties_get(props_, "object_category"),
 						edgeyolo_cpp::COCO_CLASSES);
-					tf_->classNames = edgeyolo_cpp::COCO_CLASSES;
+					set_class_names(tf_, tf_->classNames,
+							edgeyolo_cpp::COCO_CLASSES);
 				}
 			} else {
 				const char *model_file =
@@ -265,6 +528,71 @@ obs_properties_t *detect_filter_properties(void *data)
 		},
 		tf);
 
+	obs_property_t *cascade =
+		obs_properties_add_bool(props, "cascade", obs_module_text("CascadeStage"));
+	obs_property_set_long_description(cascade, obs_module_text("CascadeStageInfo"));
+	obs_property_t *cascade_model =
+		obs_properties_add_list(props, "cascade_model", obs_module_text("CascadeModel"),
+					OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(cascade_model, obs_module_text("FaceDetect"),
+				     FACE_DETECT_MODEL_SIZE);
+	obs_property_list_add_string(cascade_model, obs_module_text("ExternalModel"),
+				     EXTERNAL_MODEL_SIZE);
+	obs_properties_add_path(props, "cascade_model_file", obs_module_text("CascadeModelPath"),
+				OBS_PATH_FILE, "ONNX files (*.onnx);;all files (*.*)", nullptr);
+	obs_properties_add_float_slider(props, "cascade_threshold",
+					obs_module_text("CascadeThreshold"), 0.0, 1.0, 0.025);
+
+	obs_property_set_modified_callback(cascade_model, [](obs_properties_t *props_,
+							     obs_property_t *, obs_data_t *settings) {
+		const bool is_external =
+			strcmp(obs_data_get_string(settings, "cascade_model"), EXTERNAL_MODEL_SIZE) ==
+			0;
+		obs_property_set_visible(obs_properties_get(props_, "cascade_model_file"),
+					 is_external);
+		return true;
+	});
+
+	obs_property_t *scheduler_priority =
+		obs_properties_add_list(props, "scheduler_priority", obs_module_text("Priority"),
+					OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(scheduler_priority, obs_module_text("PriorityLow"), -1);
+	obs_property_list_add_int(scheduler_priority, obs_module_text("PriorityNormal"), 0);
+	obs_property_list_add_int(scheduler_priority, obs_module_text("PriorityHigh"), 1);
+	obs_property_set_long_description(scheduler_priority, obs_module_text("PriorityInfo"));
+	obs_properties_add_bool(props, "pause_when_hidden", obs_module_text("PauseWhenHidden"));
+	obs_property_t *channel_primary =
+		obs_properties_add_bool(props, "channel_primary", obs_module_text("ChannelPrimary"));
+	obs_property_set_long_description(channel_primary, obs_module_text("ChannelPrimaryInfo"));
+	obs_property_t *pipelined =
+		obs_properties_add_bool(props, "pipelined", obs_module_text("Pipelined"));
+	obs_property_set_long_description(pipelined, obs_module_text("PipelinedInfo"));
+
+	obs_property_t *presence_gate =
+		obs_properties_add_bool(props, "presence_gate", obs_module_text("PresenceGate"));
+	obs_property_set_long_description(presence_gate, obs_module_text("PresenceGateInfo"));
+	obs_property_t *presence_gate_model = obs_properties_add_list(
+		props, "presence_gate_model", obs_module_text("PresenceGateModel"),
+		OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(presence_gate_model, obs_module_text("SmallFast"), "small");
+	obs_property_list_add_string(presence_gate_model, obs_module_text("PresenceClassifier"),
+				     EXTERNAL_MODEL_SIZE);
+	obs_properties_add_path(props, "presence_gate_model_file",
+				obs_module_text("PresenceGateModelPath"), OBS_PATH_FILE,
+				"ONNX files (*.onnx);;all files (*.*)", nullptr);
+	obs_properties_add_float_slider(props, "presence_threshold",
+					obs_module_text("PresenceThreshold"), 0.0, 1.0, 0.025);
+
+	obs_property_set_modified_callback(presence_gate_model, [](obs_properties_t *props_,
+								   obs_property_t *,
+								   obs_data_t *settings) {
+		const bool is_external = strcmp(obs_data_get_string(settings, "presence_gate_model"),
+						EXTERNAL_MODEL_SIZE) == 0;
+		obs_property_set_visible(obs_properties_get(props_, "presence_gate_model_file"),
+					 is_external);
+		return true;
+	});
+
 	std::string basic_info =
 		std::regex_replace(PLUGIN_INFO_TEMPLATE, std::regex("%1"), PLUGIN_VERSION);
 	obs_properties_add_text(props, "info", basic_info.c_str(), OBS_TEXT_INFO);
@@ -284,12 +612,48 @@ void detect_filter_defaults(obs_data_t *settings)
 #else
 	obs_data_set_default_string(settings, "useGPU", USEGPU_CPU);
 #endif
+	obs_data_set_default_string(settings, "ep_options", "");
 	obs_data_set_default_int(settings, "numThreads", 1);
 	obs_data_set_default_bool(settings, "preview", true);
+	obs_data_set_default_string(settings, "preview_mode", "overlay");
+	obs_data_set_default_int(settings, "preview_scale", 1);
+	obs_data_set_default_int(settings, "preview_max_fps", 0);
+	obs_data_set_default_bool(settings, "tracking", false);
+	obs_data_set_default_bool(settings, "roi_inference", false);
+	obs_data_set_default_int(settings, "full_frame_interval", 10);
+	obs_data_set_default_bool(settings, "motion_gate", false);
+	obs_data_set_default_double(settings, "motion_threshold", 0.5);
+	obs_data_set_default_double(settings, "motion_max_stale", 5.0);
+	obs_data_set_default_bool(settings, "motion_in_crop", true);
+	obs_data_set_default_bool(settings, "scene_cut", false);
+	obs_data_set_default_bool(settings, "cascade", false);
+	obs_data_set_default_string(settings, "cascade_model", FACE_DETECT_MODEL_SIZE);
+	obs_data_set_default_string(settings, "cascade_model_file", "");
+	obs_data_set_default_double(settings, "cascade_threshold", 0.5);
+	obs_data_set_default_bool(settings, "presence_gate", false);
+	obs_data_set_default_int(settings, "scheduler_priority", 0);
+	obs_data_set_default_bool(settings, "pause_when_hidden", false);
+	obs_data_set_default_bool(settings, "channel_primary", false);
+	obs_data_set_default_bool(settings, "pipelined", false);
+	obs_data_set_default_string(settings, "presence_gate_model", "small");
+	obs_data_set_default_string(settings, "presence_gate_model_file", "");
+	obs_data_set_default_double(settings, "presence_threshold", 0.3);
 	obs_data_set_default_double(settings, "threshold", 0.5);
 	obs_data_set_default_string(settings, "model_size", "small");
+	obs_data_set_default_bool(settings, "quantized_model", false);
+	obs_data_set_default_bool(settings, "graph_preprocessing", false);
 	obs_data_set_default_int(settings, "object_category", -1);
 	obs_data_set_default_string(settings, "save_detections_path", "");
+	obs_data_set_default_string(settings, "save_detections_mode", "snapshot");
+	obs_data_set_default_int(settings, "save_detections_max_mb", 50);
+	obs_data_set_default_int(settings, "save_detections_rotate_minutes", 60);
+	obs_data_set_default_bool(settings, "shm_output", false);
+	obs_data_set_default_bool(settings, "push_output", false);
+	obs_data_set_default_int(settings, "delta_pixel_tolerance", 8);
+	obs_data_set_default_double(settings, "delta_iou_tolerance", 0.9);
+	obs_data_set_default_double(settings, "delta_score_band", 0.1);
+	obs_data_set_default_int(settings, "delta_keyframe_seconds", 10);
+	obs_data_set_default_bool(settings, "record_sidecar", false);
 	obs_data_set_default_bool(settings, "crop_group", false);
 	obs_data_set_default_int(settings, "crop_left", 0);
 	obs_data_set_default_int(settings, "crop_right", 0);
@@ -297,6 +661,138 @@ void detect_filter_defaults(obs_data_t *settings)
 	obs_data_set_default_int(settings, "crop_bottom", 0);
 }
 
+// Everything a session depends on, filters loading a model with the same key share one session
+static std::string shared_model_key(const struct detect_filter *tf, const file_name_t &model_path,
+				    const std::string &kind, const std::string &options)
+{
+	return kind + ":" + std::filesystem::path(model_path).u8string() + "|" + tf->useGPU + "|" +
+	       tf->epOptions + "|threads=" + std::to_string(tf->numThreads) +
+	       (options.empty() ? "" : "|" + options);
+}
+
+// (Re)load the second stage with the first stage's device settings, a cascade that fails to
+// load is logged and left off, the first stage keeps running
+static void load_cascade_model(struct detect_filter *tf)
+{
+	std::unique_lock<std::mutex> lock(tf->modelMutex);
+	tf->cascadeModel.reset();
+	if (!tf->cascadeEnabled) {
+		return;
+	}
+
+	std::string model_file;
+	if (tf->cascadeModelName == FACE_DETECT_MODEL_SIZE) {
+		char *path = obs_module_file("models/face_detection_yunet_2023mar.onnx");
+		if (path) {
+			model_file = path;
+			bfree(path);
+		}
+		set_class_names(tf, tf->cascadeClassNames, yunet::FACE_CLASSES);
+	} else {
+		model_file = tf->cascadeModelFile;
+		std::filesystem::path labels_file(model_file);
+		labels_file.replace_extension(".json");
+		std::ifstream labels(labels_file);
+		const nlohmann::json j = nlohmann::json::parse(labels, nullptr, false);
+		if (j.is_discarded() || !j.contains("names")) {
+			obs_log(LOG_ERROR, "Cascade model needs class names in %s",
+				labels_file.string().c_str());
+			return;
+		}
+		set_class_names(tf, tf->cascadeClassNames,
+				j["names"].get<std::vector<std::string>>());
+	}
+	if (model_file.empty()) {
+		obs_log(LOG_ERROR, "Cascade model file not found");
+		return;
+	}
+
+	const file_name_t model_path = std::filesystem::path(model_file).native();
+	const bool is_yunet = tf->cascadeModelName == FACE_DETECT_MODEL_SIZE;
+	const int num_classes = (int)class_names(tf).cascade->size();
+	try {
+		tf->cascadeModel = InferenceService::instance().acquire(
+			shared_model_key(tf, model_path, is_yunet ? "yunet" : "edgeyolo",
+					 "classes=" + std::to_string(num_classes)),
+			[&]() -> std::unique_ptr<ONNXRuntimeModel> {
+				if (is_yunet) {
+					return std::make_unique<yunet::YuNetONNX>(
+						model_path, tf->numThreads, 50, tf->numThreads,
+						tf->useGPU, 0, false, 0.45f, tf->cascadeThreshold,
+						nullptr, tf->epOptions);
+				}
+				return std::make_unique<edgeyolo_cpp::EdgeYOLOONNXRuntime>(
+					model_path, tf->numThreads, num_classes, tf->numThreads,
+					tf->useGPU, 0, false, 0.45f, tf->cascadeThreshold, nullptr,
+					tf->epOptions);
+			});
+		obs_log(LOG_INFO, "Cascade model loaded: %s (input %dx%d)", model_file.c_str(),
+			tf->cascadeModel->inputSize().width, tf->cascadeModel->inputSize().height);
+	} catch (const std::exception &e) {
+		obs_log(LOG_ERROR, "Failed to load cascade model: %s", e.what());
+		tf->cascadeModel.reset();
+	}
+}
+
+// (Re)load the presence gate model, like the cascade it is left off if it fails to load
+static void load_presence_gate_model(struct detect_filter *tf)
+{
+	std::unique_lock<std::mutex> lock(tf->modelMutex);
+	tf->presenceGateModel.reset();
+	tf->presenceGate.reset();
+	tf->presenceDetected = false;
+	if (!tf->presenceGateEnabled) {
+		return;
+	}
+
+	std::string model_file;
+	if (tf->presenceGateModelName == "small") {
+		if (tf->modelSize == "small") {
+			// every check would cost as much as the detection it could save
+			obs_log(LOG_WARNING,
+				"The presence gate is off, its model is the detector itself. Use a "
+				"presence classifier or a larger detector.");
+			return;
+		}
+		char *path = obs_module_file("models/edgeyolo_tiny_lrelu_coco_256x416.onnx");
+		if (path) {
+			model_file = path;
+			bfree(path);
+		}
+	} else {
+		model_file = tf->presenceGateModelFile;
+	}
+	if (model_file.empty()) {
+		obs_log(LOG_ERROR, "Presence gate model file not found");
+		return;
+	}
+
+	const file_name_t model_path = std::filesystem::path(model_file).native();
+	const bool is_detector = tf->presenceGateModelName == "small";
+	const int num_classes = (int)edgeyolo_cpp::COCO_CLASSES.size();
+	try {
+		// the small detector gate shares its session with a small model detector filter
+		tf->presenceGateModel = InferenceService::instance().acquire(
+			shared_model_key(tf, model_path, is_detector ? "edgeyolo" : "presence",
+					 is_detector ? "classes=" + std::to_string(num_classes) : ""),
+			[&]() -> std::unique_ptr<ONNXRuntimeModel> {
+				if (is_detector) {
+					return std::make_unique<edgeyolo_cpp::EdgeYOLOONNXRuntime>(
+						model_path, tf->numThreads, num_classes, tf->numThreads,
+						tf->useGPU, 0, false, 0.45f, tf->presenceThreshold,
+						nullptr, tf->epOptions);
+				}
+				return std::make_unique<PresenceClassifier>(model_path, tf->numThreads,
+									    tf->numThreads, tf->useGPU,
+									    tf->epOptions);
+			});
+		obs_log(LOG_INFO, "Presence gate model loaded: %s", model_file.c_str());
+	} catch (const std::exception &e) {
+		obs_log(LOG_ERROR, "Failed to load presence gate model: %s", e.what());
+		tf->presenceGateModel.reset();
+	}
+}
+
 void detect_filter_update(void *data, obs_data_t *settings)
 {
 	obs_log(LOG_INFO, "Detect filter update");
@@ -319,9 +815,92 @@ void detect_filter_update(void *data, obs_data_t *settings)
 	}
 
 	tf->preview = obs_data_get_bool(settings, "preview");
+	const char *previewModeName = obs_data_get_string(settings, "preview_mode");
+	const PreviewMode previewMode = strcmp(previewModeName, "frame") == 0 ? PreviewMode::Frame
+					: strcmp(previewModeName, "transparent") == 0
+						? PreviewMode::Transparent
+						: PreviewMode::Overlay;
+	const int previewScale = (int)obs_data_get_int(settings, "preview_scale");
+	const int newPreviewScale = previewScale == 2 || previewScale == 4 ? previewScale : 1;
+	if (previewMode != tf->previewMode || newPreviewScale != tf->previewScale) {
+		// the stats compare the setting in use
+		tf->stats.preview_updates = 0;
+		tf->stats.preview_skips = 0;
+		tf->stats.preview_ns = 0;
+	}
+	tf->previewMode = previewMode;
+	tf->previewScale = newPreviewScale;
+	const int previewMaxFps = (int)obs_data_get_int(settings, "preview_max_fps");
+	tf->previewIntervalNs = previewMaxFps > 0 ? 1000000000ull / previewMaxFps : 0;
+	const bool newTracking = obs_data_get_bool(settings, "tracking");
+	tf->roiInference = obs_data_get_bool(settings, "roi_inference");
+	tf->fullFrameInterval = (int)obs_data_get_int(settings, "full_frame_interval");
+	tf->motionGate = obs_data_get_bool(settings, "motion_gate");
+	// the slider is in percent
+	tf->motionThreshold = (float)obs_data_get_double(settings, "motion_threshold") / 100.0f;
+	tf->motionMaxStale = (float)obs_data_get_double(settings, "motion_max_stale");
+	tf->motionInCrop = obs_data_get_bool(settings, "motion_in_crop");
+	tf->sceneCutDetection = obs_data_get_bool(settings, "scene_cut");
+	tf->schedulerPriority = (int)obs_data_get_int(settings, "scheduler_priority");
+	tf->pauseWhenHidden = obs_data_get_bool(settings, "pause_when_hidden");
+	tf->channelPrimary = obs_data_get_bool(settings, "channel_primary");
+
+	const bool newPipelined = obs_data_get_bool(settings, "pipelined");
+	if (newPipelined != tf->pipelined) {
+		// the stage threads are started for one mode, the frames in flight are dropped
+		const bool restart = tf->inference_thread.joinable();
+		if (restart) {
+			stop_inference_threads(tf);
+		}
+		tf->pipelined = newPipelined;
+		if (restart) {
+			tf->should_stop = false;
+			start_inference_threads(tf);
+		}
+	}
 	tf->conf_threshold = (float)obs_data_get_double(settings, "threshold");
 	tf->objectCategory = (int)obs_data_get_int(settings, "object_category");
 	tf->saveDetectionsPath = obs_data_get_string(settings, "save_detections_path");
+	output::DeltaConfig deltaConfig;
+	deltaConfig.pixel_tolerance = (float)obs_data_get_int(settings, "delta_pixel_tolerance");
+	deltaConfig.iou_tolerance = (float)obs_data_get_double(settings, "delta_iou_tolerance");
+	deltaConfig.score_band = (float)obs_data_get_double(settings, "delta_score_band");
+	deltaConfig.keyframe_interval_ns =
+		(uint64_t)obs_data_get_int(settings, "delta_keyframe_seconds") * 1000000000ull;
+	deltaConfig.tracked = newTracking;
+	{
+		output::WriterConfig writerConfig;
+		writerConfig.path = tf->saveDetectionsPath;
+		const std::string mode = obs_data_get_string(settings, "save_detections_mode");
+		writerConfig.mode = mode == "ndjson"    ? output::WriteMode::Ndjson
+				    : mode == "delta"   ? output::WriteMode::Delta
+				    : mode == "compact" ? output::WriteMode::Compact
+							: output::WriteMode::Snapshot;
+		writerConfig.max_bytes =
+			(uint64_t)obs_data_get_int(settings, "save_detections_max_mb") << 20;
+		writerConfig.max_age = std::chrono::minutes(
+			obs_data_get_int(settings, "save_detections_rotate_minutes"));
+		writerConfig.delta = deltaConfig;
+		tf->detectionWriter.configure(writerConfig);
+	}
+	tf->shmOutput = obs_data_get_bool(settings, "shm_output");
+	if (!tf->shmOutput) {
+		tf->shmPublisher.close();
+	}
+	{
+		// the last filter to let go stops the server, not under the lock
+		std::shared_ptr<output::PushServer> released;
+		const bool pushOutput = obs_data_get_bool(settings, "push_output");
+		std::lock_guard<std::mutex> lock(tf->pushServerLock);
+		tf->pushDeltaConfig = deltaConfig;
+		if (pushOutput && !tf->pushServer) {
+			tf->pushServer = output::PushServer::acquire();
+		} else if (!pushOutput) {
+			released.swap(tf->pushServer);
+		}
+	}
+	// the tick starts and stops the sidecar with the recording
+	tf->recordSidecar = obs_data_get_bool(settings, "record_sidecar");
 	tf->crop_enabled = obs_data_get_bool(settings, "crop_group");
 	tf->crop_left = (int)obs_data_get_int(settings, "crop_left");
 	tf->crop_right = (int)obs_data_get_int(settings, "crop_right");
@@ -330,27 +909,48 @@ void detect_filter_update(void *data, obs_data_t *settings)
 	tf->minAreaThreshold = (int)obs_data_get_int(settings, "min_size_threshold");
 
 	const std::string newUseGpu = obs_data_get_string(settings, "useGPU");
+	const std::string newEpOptions = obs_data_get_string(settings, "ep_options");
 	const uint32_t newNumThreads = (uint32_t)obs_data_get_int(settings, "numThreads");
 	const std::string newModelSize = obs_data_get_string(settings, "model_size");
+	const bool newQuantizedModel = obs_data_get_bool(settings, "quantized_model");
+	const bool newGraphPreprocessing = obs_data_get_bool(settings, "graph_preprocessing");
+	const bool sessionTuningChanged = tf->session_tuning_changed.exchange(false);
 
 	bool reinitialize = false;
-	if (tf->useGPU != newUseGpu || tf->numThreads != newNumThreads ||
-	    tf->modelSize != newModelSize) {
+	if (tf->useGPU != newUseGpu || tf->epOptions != newEpOptions ||
+	    tf->numThreads != newNumThreads ||
+	    tf->modelSize != newModelSize || tf->quantizedModel != newQuantizedModel ||
+	    tf->graphPreprocessing != newGraphPreprocessing || sessionTuningChanged) {
 		obs_log(LOG_INFO, "Reinitializing model");
 		reinitialize = true;
 
 		std::unique_lock<std::mutex> lock(tf->modelMutex);
 
 		char *modelFilepath_rawPtr = nullptr;
+		const char *edgeyoloModel = nullptr;
 		if (newModelSize == "small") {
-			modelFilepath_rawPtr =
-				obs_module_file("models/edgeyolo_tiny_lrelu_coco_256x416.onnx");
+			edgeyoloModel = "models/edgeyolo_tiny_lrelu_coco_256x416";
 		} else if (newModelSize == "medium") {
-			modelFilepath_rawPtr =
-				obs_module_file("models/edgeyolo_tiny_lrelu_coco_480x800.onnx");
+			edgeyoloModel = "models/edgeyolo_tiny_lrelu_coco_480x800";
 		} else if (newModelSize == "large") {
-			modelFilepath_rawPtr =
-				obs_module_file("models/edgeyolo_tiny_lrelu_coco_736x1280.onnx");
+			edgeyoloModel = "models/edgeyolo_tiny_lrelu_coco_736x1280";
+		}
+
+		if (edgeyoloModel != nullptr) {
+			if (newQuantizedModel) {
+				// quantized variants are optional, see docs/quantize_model.md
+				modelFilepath_rawPtr = obs_module_file(
+					(std::string(edgeyoloModel) + "_int8.onnx").c_str());
+				if (modelFilepath_rawPtr == nullptr) {
+					obs_log(LOG_WARNING,
+						"Quantized model %s_int8.onnx not found, using float model",
+						edgeyoloModel);
+				}
+			}
+			if (modelFilepath_rawPtr == nullptr) {
+				modelFilepath_rawPtr = obs_module_file(
+					(std::string(edgeyoloModel) + ".onnx").c_str());
+			}
 		} else if (newModelSize == FACE_DETECT_MODEL_SIZE) {
 			modelFilepath_rawPtr =
 				obs_module_file("models/face_detection_yunet_2023mar.onnx");
@@ -388,14 +988,18 @@ void detect_filter_update(void *data, obs_data_t *settings)
 		bfree(modelFilepath_rawPtr);
 
 		tf->useGPU = newUseGpu;
+		tf->epOptions = newEpOptions;
 		tf->numThreads = newNumThreads;
 		tf->modelSize = newModelSize;
+		tf->quantizedModel = newQuantizedModel;
+		tf->graphPreprocessing = newGraphPreprocessing;
 
 		int onnxruntime_device_id_ = 0;
-		bool onnxruntime_use_parallel_ = true;
+		// these CNNs are a single chain of operators, inter-op parallelism only adds overhead
+		bool onnxruntime_use_parallel_ = false;
 		float nms_th_ = 0.45f;
 		int num_classes_ = (int)edgeyolo_cpp::COCO_CLASSES.size();
-		tf->classNames = edgeyolo_cpp::COCO_CLASSES;
+		set_class_names(tf, tf->classNames, edgeyolo_cpp::COCO_CLASSES);
 
 		if (tf->modelSize == EXTERNAL_MODEL_SIZE) {
 #ifdef _WIN32
@@ -412,7 +1016,7 @@ void detect_filter_update(void *data, obs_data_t *settings)
 				if (j.contains("names")) {
 					std::vector<std::string> labels = j["names"];
 					num_classes_ = (int)labels.size();
-					tf->classNames = labels;
+					set_class_names(tf, tf->classNames, labels);
 				} else {
 					obs_log(LOG_ERROR,
 						"JSON file does not contain 'labels' field");
@@ -429,27 +1033,48 @@ void detect_filter_update(void *data, obs_data_t *settings)
 			}
 		} else if (tf->modelSize == FACE_DETECT_MODEL_SIZE) {
 			num_classes_ = 1;
-			tf->classNames = yunet::FACE_CLASSES;
+			set_class_names(tf, tf->classNames, yunet::FACE_CLASSES);
 		}
 
+		// 0 threads: use the auto-tune result for this model, ORT defaults if there is none
+		SessionTuning tuning;
+		const bool tuned = tf->numThreads == 0 && tf->useGPU == USEGPU_CPU &&
+				   load_session_tuning(tf->modelFilepath, tuning);
+
+		const bool is_yunet = tf->modelSize == FACE_DETECT_MODEL_SIZE;
+		const std::string key = shared_model_key(
+			tf, tf->modelFilepath, is_yunet ? "yunet" : "edgeyolo",
+			"classes=" + std::to_string(num_classes_) +
+				(tf->graphPreprocessing ? "|graph" : "") +
+				(tuned ? "|" + tuning.describe() : ""));
+		tf->modelKey = key;
+
 		try {
 			// 确保在重置模型时没有其他线程在使用它
-			if (tf->onnxruntimemodel) {
-				tf->onnxruntimemodel.reset();
-			}
-			if (tf->modelSize == FACE_DETECT_MODEL_SIZE) {
-				tf->onnxruntimemodel = std::make_unique<yunet::YuNetONNX>(
-					tf->modelFilepath, tf->numThreads, 50, tf->numThreads,
-					tf->useGPU, onnxruntime_device_id_,
-					onnxruntime_use_parallel_, nms_th_, tf->conf_threshold);
-			} else {
-				tf->onnxruntimemodel =
-					std::make_unique<edgeyolo_cpp::EdgeYOLOONNXRuntime>(
+			tf->onnxruntimemodel.reset();
+			tf->onnxruntimemodel = InferenceService::instance().acquire(key, [&]() {
+				std::unique_ptr<ONNXRuntimeModel> model;
+				if (is_yunet) {
+					model = std::make_unique<yunet::YuNetONNX>(
+						tf->modelFilepath, tf->numThreads, 50, tf->numThreads,
+						tf->useGPU, onnxruntime_device_id_,
+						onnxruntime_use_parallel_, nms_th_, tf->conf_threshold,
+						tuned ? &tuning : nullptr, tf->epOptions);
+				} else {
+					model = std::make_unique<edgeyolo_cpp::EdgeYOLOONNXRuntime>(
 						tf->modelFilepath, tf->numThreads, num_classes_,
 						tf->numThreads, tf->useGPU, onnxruntime_device_id_,
-						onnxruntime_use_parallel_, nms_th_,
-						tf->conf_threshold);
-			}
+						onnxruntime_use_parallel_, nms_th_, tf->conf_threshold,
+						tuned ? &tuning : nullptr, tf->epOptions);
+				}
+				if (tf->graphPreprocessing) {
+					char *cache_dir = obs_module_config_path("model-cache");
+					const std::string cache_dir_str = cache_dir ? cache_dir : "";
+					bfree(cache_dir);
+					model->enableGraphPreprocessing(cache_dir_str);
+				}
+				return model;
+			});
 			obs_data_set_string(settings, "error", "");
 		} catch (const std::exception &e) {
 			obs_log(LOG_ERROR, "Failed to load model: %s", e.what());
@@ -462,18 +1087,89 @@ void detect_filter_update(void *data, obs_data_t *settings)
 		tf->isDisabled = false;
 	}
 
-	if (tf->onnxruntimemodel) {
-		std::unique_lock<std::mutex> lock(tf->modelMutex);
-		tf->onnxruntimemodel->setBBoxConfThresh(tf->conf_threshold);
+	const bool newCascade = obs_data_get_bool(settings, "cascade");
+	const std::string newCascadeModel = obs_data_get_string(settings, "cascade_model");
+	const std::string newCascadeModelFile = obs_data_get_string(settings, "cascade_model_file");
+	tf->cascadeThreshold = (float)obs_data_get_double(settings, "cascade_threshold");
+	if (reinitialize || newCascade != tf->cascadeEnabled ||
+	    newCascadeModel != tf->cascadeModelName || newCascadeModelFile != tf->cascadeModelFile) {
+		tf->cascadeEnabled = newCascade;
+		tf->cascadeModelName = newCascadeModel;
+		tf->cascadeModelFile = newCascadeModelFile;
+		load_cascade_model(tf);
+	}
+
+	const bool newPresenceGate = obs_data_get_bool(settings, "presence_gate");
+	const std::string newPresenceGateModel = obs_data_get_string(settings, "presence_gate_model");
+	const std::string newPresenceGateModelFile =
+		obs_data_get_string(settings, "presence_gate_model_file");
+	tf->presenceThreshold = (float)obs_data_get_double(settings, "presence_threshold");
+	if (reinitialize || newPresenceGate != tf->presenceGateEnabled ||
+	    newPresenceGateModel != tf->presenceGateModelName ||
+	    newPresenceGateModelFile != tf->presenceGateModelFile) {
+		tf->presenceGateEnabled = newPresenceGate;
+		tf->presenceGateModelName = newPresenceGateModel;
+		tf->presenceGateModelFile = newPresenceGateModelFile;
+		load_presence_gate_model(tf);
+	}
+
+	if (reinitialize || newTracking != tf->tracking) {
+		// a new model has new ids, a disabled tracker must not resume stale tracks
+		std::lock_guard<std::mutex> lock(tf->trackerLock);
+		tf->tracker.reset();
+	}
+	tf->tracking = newTracking;
+	// new settings may have moved the crop or the model, start from the whole frame
+	tf->force_full_frame = true;
+
+	{
+		// filters detecting with the same session on the same crop share the detections
+		std::string channelKey;
+		if (tf->onnxruntimemodel) {
+			std::lock_guard<std::mutex> model_lock(tf->modelMutex);
+			channelKey = tf->modelKey;
+			if (tf->crop_enabled) {
+				channelKey += "|crop=" + std::to_string(tf->crop_left) + "," +
+					      std::to_string(tf->crop_top) + "," +
+					      std::to_string(tf->crop_right) + "," +
+					      std::to_string(tf->crop_bottom);
+			}
+		}
+		std::lock_guard<std::mutex> lock(tf->channelLock);
+		tf->channelKey = channelKey;
 	}
 
 	if (reinitialize) {
 		obs_log(LOG_INFO, "Detect Filter Options:");
 		obs_log(LOG_INFO, "  Source: %s", obs_source_get_name(tf->source));
-		obs_log(LOG_INFO, "  Inference Device: %s", tf->useGPU.c_str());
+		obs_log(LOG_INFO, "  Inference Device: %s (running on %s)", tf->useGPU.c_str(),
+			tf->onnxruntimemodel ? tf->onnxruntimemodel->executionProvider().c_str()
+					     : "none");
+		obs_log(LOG_INFO, "  Execution Provider Options: %s", tf->epOptions.c_str());
 		obs_log(LOG_INFO, "  Num Threads: %d", tf->numThreads);
 		obs_log(LOG_INFO, "  Model Size: %s", tf->modelSize.c_str());
-		obs_log(LOG_INFO, "  Preview: %s", tf->preview ? "true" : "false");
+		obs_log(LOG_INFO, "  Quantized Model: %s", tf->quantizedModel ? "true" : "false");
+		obs_log(LOG_INFO, "  Graph Preprocessing: %s",
+			tf->onnxruntimemodel && tf->onnxruntimemodel->usesGraphPreprocessing()
+				? "true"
+				: "false");
+		obs_log(LOG_INFO, "  Preview: %s (%s, 1/%d scale, %d fps max)",
+			tf->preview ? "true" : "false", previewModeName, tf->previewScale,
+			previewMaxFps);
+		obs_log(LOG_INFO, "  Tracking: %s", tf->tracking ? "true" : "false");
+		obs_log(LOG_INFO, "  ROI Inference: %s (full frame every %d runs)",
+			tf->roiInference ? "true" : "false", tf->fullFrameInterval);
+		obs_log(LOG_INFO, "  Motion Gate: %s (%.1f%% changed, at least every %.1f s)",
+			tf->motionGate ? "true" : "false", tf->motionThreshold * 100.0f,
+			tf->motionMaxStale);
+		obs_log(LOG_INFO, "  Scene Cut Detection: %s",
+			tf->sceneCutDetection ? "true" : "false");
+		obs_log(LOG_INFO, "  Cascade: %s", tf->cascadeModel ? tf->cascadeModelName.c_str()
+								   : "none");
+		obs_log(LOG_INFO, "  Pipelined: %s", tf->pipelined ? "true" : "false");
+		obs_log(LOG_INFO, "  Presence Gate: %s (threshold %.2f)",
+			tf->presenceGateModel ? tf->presenceGateModelName.c_str() : "none",
+			tf->presenceThreshold);
 		obs_log(LOG_INFO, "  Threshold: %.2f", tf->conf_threshold);
 		obs_log(LOG_INFO, "  Object Category: %s",
 			obs_data_get_string(settings, "object_category"));
@@ -494,22 +1190,18 @@ void detect_filter_update(void *data, obs_data_t *settings)
 	tf->inferenceEnabled = new_inference_enabled;
 	}
 
+// the scheduler follows the source's visibility on every tick, a source leaving the program
+// keeps its filter running at the preview or hidden rate
 void detect_filter_activate(void *data)
 {
+	UNUSED_PARAMETER(data);
 	obs_log(LOG_INFO, "Detect filter activated");
-	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
-	if (tf) {
-		tf->isDisabled = false;
-	}
 }
 
 void detect_filter_deactivate(void *data)
 {
+	UNUSED_PARAMETER(data);
 	obs_log(LOG_INFO, "Detect filter deactivated");
-	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
-	if (tf) {
-		tf->isDisabled = true;
-	}
 }
 
 /**                   FILTER CORE                     */
@@ -522,12 +1214,54 @@ void *detect_filter_create(obs_data_t *settings, obs_source_t *source)
 
 	// 初始化所有成员变量
 	tf->source = source;
+	// the statistics used to be written into the settings, stale ones would still be shown
+	obs_data_erase(settings, "stats");
 	tf->texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
 	tf->stagesurface = nullptr;
-	tf->lastDetectedObjectId = -1;
+	tf->previewTexture = nullptr;
+	tf->previewTextureGeneration = 0;
+	tf->previewFrameMode = PreviewMode::Frame;
+	tf->previewTextureMode = PreviewMode::Frame;
+	tf->latestResult = nullptr;
+	tf->resultSequence = 0;
+	signal_handler_add(obs_source_get_signal_handler(source),
+			   "void detections(ptr source, ptr result, string json)");
+	proc_handler_t *ph = obs_source_get_proc_handler(source);
+	proc_handler_add(ph, "void get_detections(out string json, out int sequence)",
+			 get_detections_proc, tf);
+	proc_handler_add(ph, "void get_detections_result(out ptr result)",
+			 get_detections_result_proc, tf);
 	tf->last_inference_time = std::chrono::steady_clock::time_point();
 	tf->inferenceEnabled = false;
 	tf->preview = true;
+	tf->previewMode = PreviewMode::Overlay;
+	tf->previewScale = 1;
+	tf->previewIntervalNs = 0;
+	tf->tracking = false;
+	tf->roiInference = false;
+	tf->fullFrameInterval = 10;
+	tf->framesSinceFullFrame = 0;
+	tf->motionGate = false;
+	tf->motionThreshold = 0.005f;
+	tf->motionMaxStale = 5.0f;
+	tf->motionInCrop = true;
+	tf->sceneCutDetection = false;
+	tf->cascadeEnabled = false;
+	tf->cascadeThreshold = 0.5f;
+	tf->presenceGateEnabled = false;
+	tf->presenceThreshold = 0.3f;
+	tf->presenceDetected = false;
+	tf->schedulerId = scheduler::InferenceScheduler::instance().registerFilter();
+	tf->schedulerPriority = 0;
+	tf->pauseWhenHidden = false;
+	tf->channelPrimary = false;
+	tf->channelInput = nullptr;
+	tf->classNames = std::make_shared<const std::vector<std::string>>();
+	tf->cascadeClassNames = std::make_shared<const std::vector<std::string>>();
+	tf->pipelined = false;
+	tf->last_gate_log = std::chrono::steady_clock::now();
+	tf->last_stats_update = std::chrono::steady_clock::time_point();
+	tf->last_sidecar_check = std::chrono::steady_clock::time_point();
 	tf->conf_threshold = 0.5f;
 	tf->objectCategory = -1;
 	tf->saveDetectionsPath = "";
@@ -540,6 +1274,8 @@ void *detect_filter_create(obs_data_t *settings, obs_source_t *source)
 	tf->useGPU = "CPU";
 	tf->numThreads = 1;
 	tf->modelSize = "small";
+	tf->quantizedModel = false;
+	tf->graphPreprocessing = false;
 	tf->isDisabled = false;
 	tf->onnxruntimemodel = nullptr;
 	tf->should_stop = false;
@@ -553,13 +1289,7 @@ void *detect_filter_create(obs_data_t *settings, obs_source_t *source)
 
 	detect_filter_update(tf, settings);
 
-	// 启动推理线程
-	try {
-		tf->inference_thread = std::thread(inference_worker, tf);
-		obs_log(LOG_INFO, "Inference thread started successfully");
-	} catch (const std::exception &e) {
-		obs_log(LOG_ERROR, "Failed to start inference thread: %s", e.what());
-	}
+	start_inference_threads(tf);
 
 	return tf;
 }
@@ -571,32 +1301,47 @@ void detect_filter_destroy(void *data)
 	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
 
 	if (tf) {
-		tf->isDisabled = true;
-		tf->should_stop = true;  // 设置停止标志
-
-		// 唤醒推理线程（以防它正在等待）
+		// no more frames from the siblings, and the siblings take over this filter's role
 		{
-			std::lock_guard<std::mutex> lock(tf->queue_mutex);
-			tf->queue_condition.notify_all();
+			std::lock_guard<std::mutex> lock(tf->channelLock);
+			if (tf->sourceChannel) {
+				tf->sourceChannel->leave(tf->schedulerId);
+				tf->sourceChannel.reset();
+			}
 		}
 
-		// 等待推理线程结束
-		if (tf->inference_thread.joinable()) {
-			try {
-				tf->inference_thread.join();
-				obs_log(LOG_INFO, "Inference thread joined successfully");
-			} catch (const std::exception &e) {
-				obs_log(LOG_ERROR, "Error joining inference thread: %s", e.what());
-			}
+		tf->isDisabled = true;
+		stop_inference_threads(tf);
+
+		scheduler::InferenceScheduler::instance().unregisterFilter(tf->schedulerId);
+
+		// auto-tune checks should_stop between candidates
+		if (tf->autotune_thread.joinable()) {
+			tf->autotune_thread.join();
 		}
 
 		// 等待模型不再被使用后再清理
 		{
 			std::unique_lock<std::mutex> lock(tf->modelMutex);
 			tf->onnxruntimemodel.reset();  // 显式重置模型
+			tf->cascadeModel.reset();
+			tf->presenceGateModel.reset();
+			for (input_slot &slot : tf->inputSlots) {
+				slot.input.reset();
+				slot.model.reset();
+			}
+		}
+
+		if (tf->latestResult) {
+			tf->latestResult->release(tf->latestResult);
+			tf->latestResult = nullptr;
 		}
 
 		obs_enter_graphics();
+		tf->overlayRenderer.destroy();
+		if (tf->previewTexture) {
+			gs_texture_destroy(tf->previewTexture);
+		}
 		if (tf->texrender) {
 			gs_texrender_destroy(tf->texrender);
 		}
@@ -610,222 +1355,1199 @@ void detect_filter_destroy(void *data)
 	}
 }
 
-// 异步推理线程函数
-void inference_worker(struct detect_filter *tf)
+// The boxes of a result in a preview composited at 1/scale of the frame size
+static std::vector<Object> scale_objects(const std::vector<Object> &objects, int scale)
 {
-	obs_log(LOG_INFO, "Starting inference worker thread");
-	tf->thread_running = true;
-	
-	while (!tf->should_stop) {
-		cv::Mat frame;
-		{
-			std::unique_lock<std::mutex> lock(tf->queue_mutex);
-			if (tf->frame_queue.empty()) {
-				// 等待新帧或停止信号
-				tf->queue_condition.wait(lock, [&tf] { 
-					return !tf->frame_queue.empty() || tf->should_stop.load(); 
-				});
-				
-				if (tf->should_stop && tf->frame_queue.empty()) {
-					break;
-				}
-			}
-			
-			if (!tf->frame_queue.empty()) {
-				frame = tf->frame_queue.front();
-				tf->frame_queue.pop();
-			}
+	std::vector<Object> scaled = objects;
+	for (Object &obj : scaled) {
+		obj.rect.x /= scale;
+		obj.rect.y /= scale;
+		obj.rect.width /= scale;
+		obj.rect.height /= scale;
+	}
+	return scaled;
+}
+
+// always: not decimated, for the updates that take stale boxes away
+static void render_preview(struct detect_filter *tf, const cv::Mat &frame,
+			   const std::vector<Object> &objects, bool always = false)
+{
+	// decimated on its own, however often results come in
+	const uint64_t start_ns = os_gettime_ns();
+	if (!always && tf->previewIntervalNs > 0 &&
+	    start_ns - tf->lastPreviewNs < tf->previewIntervalNs) {
+		tf->stats.preview_skips++;
+		return;
+	}
+	tf->lastPreviewNs = start_ns;
+
+	const PreviewMode mode = tf->previewMode;
+	// composited at a fraction of the frame size, OBS scales it back up
+	const int scale = mode == PreviewMode::Overlay ? 1 : tf->previewScale;
+	const cv::Rect cropRect(tf->crop_left / scale, tf->crop_top / scale,
+				(frame.cols - tf->crop_left - tf->crop_right) / scale,
+				(frame.rows - tf->crop_top - tf->crop_bottom) / scale);
+	// cascade results are labeled with the second stage's classes
+	std::vector<Object> parents, children;
+	for (const Object &obj : objects) {
+		(obj.parent_id != 0 ? children : parents).push_back(obj);
+	}
+	if (scale > 1) {
+		parents = scale_objects(parents, scale);
+		children = scale_objects(children, scale);
+	}
+	const class_name_tables names = class_names(tf);
+	const bool drawChildren = !children.empty() && !names.cascade->empty();
+	uint64_t bytes = 0;
+
+	if (mode == PreviewMode::Overlay) {
+		// only the geometry is made here, the video render draws it over the live source
+		auto geometry = std::make_shared<overlay::OverlayGeometry>(frame.cols, frame.rows);
+		if (tf->crop_enabled) {
+			geometry->addDashedRect(cropRect, 5.0f, 15.0f, overlay::rgba(0, 255, 0));
+		}
+		geometry->addObjects(parents, *names.names);
+		if (drawChildren) {
+			geometry->addObjects(children, *names.cascade);
+		}
+		geometry->addMarkers();
+		// in memory and in the vertex buffers
+		bytes = 2 * (geometry->solid().size() * sizeof(overlay::SolidVertex) +
+			     geometry->text().size() * sizeof(overlay::TextVertex));
+		std::lock_guard<std::mutex> lock(tf->outputLock);
+		tf->overlayGeometry = std::move(geometry);
+	} else {
+		std::lock_guard<std::mutex> lock(tf->outputLock);
+		// drawn in BGRA straight into the reused preview buffer, past the copy only the
+		// pixels under the overlay are touched
+		cv::Mat &draw_frame = tf->outputPreviewBGRA;
+		const cv::Size size(std::max(frame.cols / scale, 1),
+				    std::max(frame.rows / scale, 1));
+		if (mode == PreviewMode::Transparent) {
+			// the video render puts it over the live source
+			draw_frame.create(size, CV_8UC4);
+			draw_frame.setTo(cv::Scalar::all(0));
+		} else if (scale == 1) {
+			frame.copyTo(draw_frame);
+		} else {
+			cv::resize(frame, draw_frame, size, 0, 0, cv::INTER_AREA);
 		}
-		
-		if (!frame.empty()) {
-			// 执行推理
-			std::vector<Object> objects;
-			
-			{
-				// 使用模型进行推理
-				std::unique_lock<std::mutex> lock(tf->modelMutex, std::try_to_lock);
-				if (lock.owns_lock() && tf->onnxruntimemodel) {
-					try {
-						cv::Mat inferenceFrame;
-						cv::Rect cropRect(0, 0, frame.cols, frame.rows);
-						if (tf->crop_enabled) {
-							cropRect = cv::Rect(tf->crop_left, tf->crop_top,
-									    frame.cols - tf->crop_left - tf->crop_right,
-									    frame.rows - tf->crop_top - tf->crop_bottom);
-							cv::cvtColor(frame(cropRect), inferenceFrame, cv::COLOR_BGRA2BGR);
-						} else {
-							cv::cvtColor(frame, inferenceFrame, cv::COLOR_BGRA2BGR);
-						}
-
-						// 设置置信度阈值
-						tf->onnxruntimemodel->setBBoxConfThresh(tf->conf_threshold);
-						objects = tf->onnxruntimemodel->inference(inferenceFrame);
-						tf->last_inference_time = std::chrono::steady_clock::now();
-
-						obs_log(LOG_INFO, "Inference returned %d objects (before filtering)", objects.size());
-
-						if (tf->crop_enabled) {
-							for (Object &obj : objects) {
-								obj.rect.x += (float)cropRect.x;
-								obj.rect.y += (float)cropRect.y;
-							}
-						}
-
-						if (tf->objectCategory != -1) {
-							std::vector<Object> filtered_objects;
-							for (const Object &obj : objects) {
-								if (obj.label == tf->objectCategory) {
-									filtered_objects.push_back(obj);
-								}
-							}
-							objects = filtered_objects;
-							obs_log(LOG_INFO, "After category filter: %d objects", objects.size());
-						}
-
-						if (!tf->saveDetectionsPath.empty()) {
-							std::ofstream detectionsFile(tf->saveDetectionsPath);
-							if (detectionsFile.is_open()) {
-								nlohmann::json j;
-								for (const Object &obj : objects) {
-									nlohmann::json obj_json;
-									obj_json["label"] = obj.label;
-									obj_json["confidence"] = obj.prob;
-									obj_json["rect"] = {{"x", obj.rect.x},
-											    {"y", obj.rect.y},
-											    {"width", obj.rect.width},
-											    {"height", obj.rect.height}};
-									obj_json["id"] = obj.id;
-									j.push_back(obj_json);
-								}
-								detectionsFile << j.dump(4);
-								detectionsFile.close();
-							}
-						}
-					} catch (const std::exception &e) {
-						obs_log(LOG_ERROR, "Inference error: %s", e.what());
-					}
-				}
-			}
-			
-			// 处理检测结果
-			if (objects.size() > 0 && tf->lastDetectedObjectId != objects[0].label) {
-				tf->lastDetectedObjectId = objects[0].label;
-				obs_source_t *source = tf->source;
-				if (source) {
-					obs_data_t *source_settings = obs_source_get_settings(source);
-					if (source_settings) {
-						obs_data_set_string(source_settings, "detected_object",
-								    tf->classNames[objects[0].label].c_str());
-						obs_data_release(source_settings);
-					}
-				}
-			} else if (objects.empty() && tf->lastDetectedObjectId != -1) {
-				tf->lastDetectedObjectId = -1;
-				obs_source_t *source = tf->source;
-				if (source) {
-					obs_data_t *source_settings = obs_source_get_settings(source);
-					if (source_settings) {
-						obs_data_set_string(source_settings, "detected_object", "");
-						obs_data_release(source_settings);
-					}
-				}
-			}
-			
-			// 绘制检测结果
-			if (tf->preview) {
-				cv::Mat result_frame = frame.clone();
-				cv::Mat draw_frame;
-				cv::cvtColor(result_frame, draw_frame, cv::COLOR_BGRA2BGR);
-
-				cv::Rect cropRect(0, 0, frame.cols, frame.rows);
-				if (tf->crop_enabled) {
-					cropRect = cv::Rect(tf->crop_left, tf->crop_top,
-							    frame.cols - tf->crop_left - tf->crop_right,
-							    frame.rows - tf->crop_top - tf->crop_bottom);
-					drawDashedRectangle(draw_frame, cropRect, cv::Scalar(0, 255, 0), 5, 8, 15);
-				}
-				
-				if (objects.size() > 0) {
-					draw_objects(draw_frame, objects, tf->classNames);
-					obs_log(LOG_INFO, "Drew %d boxes on frame", objects.size());
-				}
 
-				{
-					std::lock_guard<std::mutex> lock(tf->outputLock);
-					cv::cvtColor(draw_frame, tf->outputPreviewBGRA, cv::COLOR_BGR2BGRA);
-				}
-			}
+		if (tf->crop_enabled) {
+			drawDashedRectangle(draw_frame, cropRect, cv::Scalar(0, 255, 0, 255),
+					    std::max(5 / scale, 1), 8, 15 / scale);
 		}
+
+		draw_objects(draw_frame, parents, *names.names);
+		if (drawChildren) {
+			draw_objects(draw_frame, children, *names.cascade);
+		}
+
+		// the crosshair and circle at the centre, drawn here so that the render path only
+		// uploads
+		const cv::Point center(draw_frame.cols / 2, draw_frame.rows / 2);
+		const int thickness = std::max(2 / scale, 1);
+		cv::line(draw_frame, center - cv::Point(30 / scale, 0),
+			 center + cv::Point(30 / scale, 0), cv::Scalar(0, 255, 0, 255), thickness);
+		cv::line(draw_frame, center - cv::Point(0, 30 / scale),
+			 center + cv::Point(0, 30 / scale), cv::Scalar(0, 255, 0, 255), thickness);
+		cv::circle(draw_frame, center, 50 / scale, cv::Scalar(0, 0, 255, 255), thickness);
+
+		tf->previewFrameSize = frame.size();
+		tf->previewFrameMode = mode;
+		tf->previewGeneration++;
+		// the buffer and the texture
+		bytes = 2 * draw_frame.total() * draw_frame.elemSize();
 	}
-	
-	obs_log(LOG_INFO, "Stopping inference worker thread");
-	tf->thread_running = false;
+
+	tf->stats.preview_updates++;
+	tf->stats.preview_ns += os_gettime_ns() - start_ns;
+	tf->stats.preview_bytes = bytes;
+	tf->stats.preview_full_bytes = 2 * frame.total() * frame.elemSize();
 }
 
-void detect_filter_video_tick(void *data, float seconds)
+static void log_presence_gate(struct detect_filter *tf)
 {
-	UNUSED_PARAMETER(seconds);
-
-	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
+	const uint64_t checks = tf->stats.gate_checks;
+	const uint64_t hits = tf->stats.gate_hits;
+	const uint64_t runs = tf->stats.inferences;
+	const double gate_ms = (double)tf->stats.gate_ns / 1e6;
+	const double detector_ms = runs > 0 ? (double)tf->stats.detector_ns / 1e6 / runs : 0.0;
+	// every closed gate saved one detector run, at the price of all the gate runs
+	const double saved_ms = (double)(checks - hits) * detector_ms - gate_ms;
+	obs_log(LOG_INFO,
+		"Presence gate: %llu checks, %.1f%% opened, %.2f ms per check, %.2f ms per "
+		"detection, %.1f s of inference saved",
+		(unsigned long long)checks, checks > 0 ? 100.0 * hits / checks : 0.0,
+		checks > 0 ? gate_ms / checks : 0.0, detector_ms, saved_ms / 1000.0);
+}
 
-	if (!tf) {
-		return;
+// Run the presence gate model on the (cropped) frame, returns whether the detector should run
+static bool check_presence(struct detect_filter *tf, const cv::Mat &bgra)
+{
+	const uint64_t start_ns = os_gettime_ns();
+
+	// the frame is scaled down before the conversion, the gate model sees little of it anyway
+	const cv::Size input = tf->presenceGateModel->inputSize();
+	const double scale = std::min({1.0, (double)input.width / bgra.cols,
+				       (double)input.height / bgra.rows});
+	cv::Mat small, bgr;
+	cv::resize(bgra, small,
+		   cv::Size(std::max(1, (int)(bgra.cols * scale)),
+			    std::max(1, (int)(bgra.rows * scale))),
+		   0, 0, cv::INTER_AREA);
+	cv::cvtColor(small, bgr, cv::COLOR_BGRA2BGR);
+
+	// a detector gate reports the best score of the wanted category, when the main model
+	// uses the same classes
+	const float close_threshold =
+		std::max(tf->presenceThreshold - tf->PRESENCE_CLOSE_MARGIN, 0.0f);
+	const bool coco_category = tf->presenceGateModelName == "small" &&
+				   tf->modelSize != FACE_DETECT_MODEL_SIZE &&
+				   tf->modelSize != EXTERNAL_MODEL_SIZE && tf->objectCategory != -1;
+	float probability = 0.0f;
+	for (const Object &obj : tf->presenceGateModel->inference(bgr, close_threshold)) {
+		if (!coco_category || obj.label == tf->objectCategory) {
+			probability = std::max(probability, obj.prob);
+		}
 	}
 
-	static bool last_inference_state = false;
-	if (last_inference_state != tf->inferenceEnabled) {
-		last_inference_state = tf->inferenceEnabled;
-		obs_log(LOG_INFO, "Inference state changed to: %s", tf->inferenceEnabled ? "ENABLED" : "DISABLED");
+	tf->presenceGate.setThresholds(tf->presenceThreshold, close_threshold);
+	const bool open = tf->presenceGate.update(probability);
+	tf->stats.gate_checks++;
+	if (open) {
+		tf->stats.gate_hits++;
 	}
+	tf->stats.gate_ns += os_gettime_ns() - start_ns;
 
-	if (tf->isDisabled) {
-		obs_log(LOG_WARNING, "Filter is disabled, skipping tick");
-		return;
+	const auto now = std::chrono::steady_clock::now();
+	if (now - tf->last_gate_log >= std::chrono::minutes(1)) {
+		tf->last_gate_log = now;
+		log_presence_gate(tf);
 	}
+	return open;
+}
 
-	if (!tf->source || !obs_source_enabled(tf->source)) {
-		return;
-	}
+static std::shared_ptr<channel::SourceChannel> source_channel(struct detect_filter *tf)
+{
+	std::lock_guard<std::mutex> lock(tf->channelLock);
+	return tf->sourceChannel;
+}
 
-	uint32_t width, height;
-	if (!getRGBAFromStageSurface(tf, width, height)) {
-		return;
-	}
+static std::shared_ptr<output::PushServer> push_server(struct detect_filter *tf,
+						       output::DeltaConfig &delta_config)
+{
+	std::lock_guard<std::mutex> lock(tf->pushServerLock);
+	delta_config = tf->pushDeltaConfig;
+	return tf->pushServer;
+}
 
-	cv::Mat imageBGRA;
+// Make the result the latest for the proc handlers and send the "detections" signal
+static void publish_result(struct detect_filter *tf, const std::vector<Object> &objects,
+			   uint64_t timestamp_ns, const cv::Size &frame_size)
+{
+	const class_name_tables names = class_names(tf);
+	const obs_detect_result *result;
+	const obs_detect_result *previous;
 	{
-		std::lock_guard<std::mutex> lock(tf->inputBGRALock);
-		if (tf->inputBGRA.empty()) {
+		std::lock_guard<std::mutex> lock(tf->resultLock);
+		result = output::createResult(objects, ++tf->resultSequence, timestamp_ns,
+					      frame_size, names.outputNames(), tf->tracking);
+		// one reference for the filter, the other one for the signal
+		result->retain(result);
+		previous = tf->latestResult;
+		tf->latestResult = result;
+	}
+	if (previous) {
+		previous->release(previous);
+	}
+
+	calldata_t cd = {};
+	calldata_set_ptr(&cd, "source", tf->source);
+	calldata_set_ptr(&cd, "result", (void *)result);
+	calldata_set_string(&cd, "json", result->json);
+	signal_handler_signal(obs_source_get_signal_handler(tf->source), "detections", &cd);
+	calldata_free(&cd);
+	result->release(result);
+}
+
+static void get_detections_proc(void *data, calldata_t *cd)
+{
+	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
+	std::lock_guard<std::mutex> lock(tf->resultLock);
+	const obs_detect_result *result = tf->latestResult;
+	calldata_set_string(cd, "json", result ? result->json : "");
+	calldata_set_int(cd, "sequence", result ? (long long)result->sequence : 0);
+}
+
+static void get_detections_result_proc(void *data, calldata_t *cd)
+{
+	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
+	std::lock_guard<std::mutex> lock(tf->resultLock);
+	const obs_detect_result *result = tf->latestResult;
+	// the caller releases it
+	if (result) {
+		result->retain(result);
+	}
+	calldata_set_ptr(cd, "result", (void *)result);
+}
+
+// Called on the detecting sibling's worker thread, queues the detections like a captured frame
+static void receive_shared_detections(struct detect_filter *tf,
+				      const std::shared_ptr<const channel::SharedDetections> &detections)
+{
+	if (tf->should_stop || !tf->inferenceEnabled) {
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(tf->queue_mutex);
+		// 只保留最新的一帧，丢弃旧帧以避免延迟
+		while (!tf->frame_queue.empty()) {
+			tf->frame_queue.pop();
+		}
+		tf->frame_queue.push({detections->bgra, detections->timestamp_ns,
+				      tf->stats.scene_cuts.load(), detections});
+	}
+	tf->queue_condition.notify_one();
+}
+
+// Wait for a free input slot and (re)create its tensors for the model, -1 when stopping
+static int acquire_input_slot(struct detect_filter *tf, const std::shared_ptr<SharedModel> &model)
+{
+	std::unique_lock<std::mutex> lock(tf->inputSlotLock);
+	int slot = -1;
+	tf->inputSlotFree.wait(lock, [&] {
+		for (size_t i = 0; i < tf->inputSlots.size(); ++i) {
+			if (!tf->inputSlots[i].busy) {
+				slot = (int)i;
+				return true;
+			}
+		}
+		return tf->should_stop.load();
+	});
+	if (slot < 0) {
+		return -1;
+	}
+	input_slot &input = tf->inputSlots[slot];
+	input.busy = true;
+	if (input.model != model || !input.input) {
+		input.model = model;
+		input.input = model->createInput();
+	}
+	return slot;
+}
+
+static void release_input_slot(struct detect_filter *tf, int slot)
+{
+	{
+		std::lock_guard<std::mutex> lock(tf->inputSlotLock);
+		tf->inputSlots[slot].busy = false;
+	}
+	tf->inputSlotFree.notify_one();
+}
+
+static void update_average(std::atomic<double> &average, double value)
+{
+	const double previous = average.load();
+	average = previous == 0.0 ? value : previous + 0.1 * (value - previous);
+}
+
+// Stage 1, on the worker thread: plan the run and preprocess the frame into an input slot.
+// Returns false when the frame is dropped.
+static bool prepare_detection(struct detect_filter *tf, detection_job &job)
+{
+	const cv::Mat &frame = job.frame.bgra;
+
+	// 使用模型进行推理
+	// waits for the post stage of the previous frame, which holds the lock for the cascade
+	std::unique_lock<std::mutex> lock(tf->modelMutex);
+	if (!tf->onnxruntimemodel) {
+		return false;
+	}
+	job.model = tf->onnxruntimemodel;
+
+	job.cropRect = cv::Rect(0, 0, frame.cols, frame.rows);
+	if (tf->crop_enabled) {
+		job.cropRect = cv::Rect(tf->crop_left, tf->crop_top,
+					frame.cols - tf->crop_left - tf->crop_right,
+					frame.rows - tf->crop_top - tf->crop_bottom);
+	}
+	const cv::Rect &cropRect = job.cropRect;
+	const double timestamp = (double)job.frame.timestamp_ns / 1e9;
+	const cv::Size inputSize = job.model->inputSize();
+
+	// detections from a sibling on the same source only need this filter's post-filters; a
+	// filter detecting for siblings searches the whole crop with every class, so their
+	// results do not depend on its own tracks and gate
+	job.shared = job.frame.detections != nullptr;
+	if (!job.shared) {
+		job.sourceChannel = source_channel(tf);
+	}
+	job.publishes = job.sourceChannel && job.sourceChannel->hasSubscribers(tf->schedulerId);
+
+	// tracked objects only need a look at their surroundings, the whole frame is searched
+	// every few runs (or on request) for new ones
+	const bool refreshRequested = tf->force_full_frame.exchange(false);
+	if (!job.shared && !job.publishes && tf->tracking && tf->roiInference &&
+	    !refreshRequested && tf->framesSinceFullFrame + 1 < tf->fullFrameInterval) {
+		std::vector<Object> predicted;
+		{
+			std::lock_guard<std::mutex> tracker_lock(tf->trackerLock);
+			predicted = tf->tracker.predict(timestamp);
+		}
+		job.roiTracks = predicted.size();
+		const double fullFrameScale = std::min((double)inputSize.width / cropRect.width,
+						       (double)inputSize.height / cropRect.height);
+		tracker::packMosaic(tracker::expandRegions(predicted, cropRect, tf->ROI_EXPANSION,
+							   tf->ROI_MIN_SIZE),
+				    inputSize, fullFrameScale, job.tiles);
+	}
+	if (!job.shared) {
+		tf->framesSinceFullFrame = job.tiles.empty() ? 0 : tf->framesSinceFullFrame + 1;
+	}
+
+	// while the detector keeps finding objects it runs directly, otherwise the presence gate
+	// decides whether it runs at all
+	const bool detectorRuns =
+		!job.shared && (!tf->presenceGateModel || job.publishes || tf->presenceDetected ||
+				check_presence(tf, frame(cropRect)));
+	if (!detectorRuns) {
+		return true;
+	}
+
+	cv::Mat inputBGRA = frame(cropRect);
+	if (!job.tiles.empty()) {
+		cv::Mat mosaic;
+		tracker::renderMosaic(frame, inputSize, job.tiles, mosaic);
+		inputBGRA = mosaic;
+	}
+	cv::Mat inferenceFrame;
+	if (job.model->usesGraphPreprocessing()) {
+		// the graph slices the crop and the BGR channels itself
+		inferenceFrame = inputBGRA;
+	} else {
+		cv::cvtColor(inputBGRA, inferenceFrame, cv::COLOR_BGRA2BGR);
+	}
+
+	// 设置置信度阈值
+	// ByteTrack also associates the low score detections
+	job.threshold = tf->conf_threshold;
+	if (tf->tracking) {
+		std::lock_guard<std::mutex> tracker_lock(tf->trackerLock);
+		job.threshold = std::min(job.threshold, tf->tracker.config().low_threshold);
+	}
+	if (job.publishes) {
+		job.threshold = std::min(job.threshold,
+					 job.sourceChannel->detectionThreshold(tf->schedulerId));
+	}
+
+	// the job holds its own reference to the model, so the post stage of the frames in
+	// flight does not wait for this one to get a slot
+	lock.unlock();
+	job.slot = acquire_input_slot(tf, job.model);
+	if (job.slot < 0) {
+		return false;
+	}
+	try {
+		job.model->prepare(inferenceFrame, *tf->inputSlots[job.slot].input);
+	} catch (...) {
+		release_input_slot(tf, job.slot);
+		throw;
+	}
+	return true;
+}
+
+// Stage 2, on the worker or the run thread: run the model on the prepared slot
+static bool run_detection(struct detect_filter *tf, detection_job &job)
+{
+	if (job.slot < 0) {
+		return true;
+	}
+	const uint64_t detector_start_ns = os_gettime_ns();
+	bool ok = true;
+	try {
+		job.objects = job.model->run(*tf->inputSlots[job.slot].input, job.threshold);
+	} catch (const std::exception &e) {
+		obs_log(LOG_ERROR, "Inference error: %s", e.what());
+		ok = false;
+	}
+	release_input_slot(tf, job.slot);
+	job.run_ns = os_gettime_ns() - detector_start_ns;
+	tf->stats.detector_ns += job.run_ns;
+	tf->stats.inferences++;
+	return ok;
+}
+
+// Stage 3, on the worker or the post thread: map, filter and track the detections, then
+// report and draw them
+static void finish_detection(struct detect_filter *tf, detection_job &job)
+{
+	const uint64_t post_start_ns = os_gettime_ns();
+	const cv::Mat &frame = job.frame.bgra;
+	const cv::Rect &cropRect = job.cropRect;
+	const double timestamp = (double)job.frame.timestamp_ns / 1e9;
+	std::vector<Object> &objects = job.objects;
+
+	{
+		// the cascade model belongs to the filter settings like the detector
+		std::unique_lock<std::mutex> lock(tf->modelMutex);
+		try {
+			tf->last_inference_time = std::chrono::steady_clock::now();
+
+			obs_log(LOG_DEBUG, "Inference returned %zu objects (before filtering)",
+				objects.size());
+
+			if (job.shared) {
+				objects = job.frame.detections->objects;
+			} else if (!job.tiles.empty()) {
+				objects = tracker::mapMosaicDetections(objects, job.tiles);
+				int roiPixels = 0;
+				for (const tracker::MosaicTile &tile : job.tiles) {
+					roiPixels += tile.source.area();
+				}
+				obs_log(LOG_DEBUG, "ROI inference: %zu tiles, %.1f%% of the frame",
+					job.tiles.size(), 100.0 * roiPixels / cropRect.area());
+			} else if (tf->crop_enabled) {
+				for (Object &obj : objects) {
+					obj.rect.x += (float)cropRect.x;
+					obj.rect.y += (float)cropRect.y;
+				}
+			}
+
+			if (job.publishes && job.slot >= 0) {
+				auto published = std::make_shared<channel::SharedDetections>(
+					channel::SharedDetections{frame, job.frame.timestamp_ns, objects});
+				job.sourceChannel->publishDetections(tf->schedulerId, published);
+				std::lock_guard<std::mutex> objects_lock(tf->lastObjectsLock);
+				tf->lastShared = published;
+			}
+
+			// the detections may have been made for a lower threshold
+			float ownThreshold = tf->conf_threshold;
+			if (tf->tracking) {
+				std::lock_guard<std::mutex> tracker_lock(tf->trackerLock);
+				ownThreshold =
+					std::min(ownThreshold, tf->tracker.config().low_threshold);
+			}
+			objects.erase(std::remove_if(objects.begin(), objects.end(),
+						     [&](const Object &obj) {
+							     return obj.prob < ownThreshold;
+						     }),
+				      objects.end());
+
+			if (tf->objectCategory != -1) {
+				std::vector<Object> filtered_objects;
+				for (const Object &obj : objects) {
+					if (obj.label == tf->objectCategory) {
+						filtered_objects.push_back(obj);
+					}
+				}
+				objects = filtered_objects;
+				obs_log(LOG_DEBUG, "After category filter: %zu objects",
+					objects.size());
+			}
+			if (tf->minAreaThreshold > 0) {
+				// the "Min. Object Area" setting, in frame pixels
+				objects.erase(std::remove_if(objects.begin(), objects.end(),
+							     [&](const Object &obj) {
+								     return obj.rect.area() <
+									    tf->minAreaThreshold;
+							     }),
+					      objects.end());
+			}
+			tf->presenceDetected = !objects.empty();
+
+			// a cut resets the tracker under its lock, checking there keeps the detections
+			// of the previous shot out of the new tracks and results
+			{
+				std::lock_guard<std::mutex> tracker_lock(tf->trackerLock);
+				if (job.frame.scene != tf->stats.scene_cuts) {
+					obs_log(LOG_DEBUG, "Dropping detections from before a scene cut");
+					return;
+				}
+				if (tf->tracking) {
+					// stable ids, only tracked objects are reported
+					tf->tracker.setHighThreshold(tf->conf_threshold);
+					objects = tf->tracker.update(objects, timestamp);
+				}
+			}
+			if (!job.tiles.empty() && objects.size() < job.roiTracks) {
+				// a track was not found around its prediction, look everywhere
+				tf->force_full_frame = true;
+			}
+
+			if (tf->cascadeModel && !objects.empty()) {
+				const std::vector<Object> children = cascade::runCascade(
+					*tf->cascadeModel, tf->cascadeThreshold, frame, objects,
+					tf->cascadeConfig);
+				objects.insert(objects.end(), children.begin(), children.end());
+			}
+			{
+				// a cut clears the cache after counting, see on_scene_cut
+				std::lock_guard<std::mutex> objects_lock(tf->lastObjectsLock);
+				if (job.frame.scene == tf->stats.scene_cuts) {
+					tf->lastObjects = objects;
+				}
+			}
+
+			// written on the writer's thread
+			tf->detectionWriter.submit(objects, job.frame.timestamp_ns);
+			const class_name_tables names = class_names(tf);
+			if (tf->shmOutput) {
+				tf->shmPublisher.publish(objects, job.frame.timestamp_ns, frame.size(),
+							 names.outputNames(), tf->tracking);
+			}
+			tf->sidecarRecorder.submit(objects, job.frame.timestamp_ns, frame.size(),
+						   tf->tracking);
+			output::DeltaConfig deltaConfig;
+			if (std::shared_ptr<output::PushServer> pushServer =
+				    push_server(tf, deltaConfig)) {
+				obs_source_t *parent = obs_filter_get_parent(tf->source);
+				pushServer->publish(parent ? obs_source_get_name(parent) : "",
+						    obs_source_get_name(tf->source), objects,
+						    job.frame.timestamp_ns, frame.size(),
+						    names.outputNames(), deltaConfig);
+			}
+		} catch (const std::exception &e) {
+			obs_log(LOG_ERROR, "Inference error: %s", e.what());
 			return;
 		}
-		imageBGRA = tf->inputBGRA.clone();
+	}
+
+	// 处理检测结果
+	// the detected_object property follows at the stats rate, see update_stats_text
+	publish_result(tf, objects, job.frame.timestamp_ns, frame.size());
+
+	// 绘制检测结果
+	// with tracking the video tick draws the predicted boxes on every frame
+	if (tf->preview && !tf->tracking) {
+		render_preview(tf, frame, objects);
+		obs_log(LOG_DEBUG, "Drew %zu boxes on frame", objects.size());
+	}
+
+	// the scheduler budgets the work of a frame, the latency includes the waits in between
+	const uint64_t post_ns = os_gettime_ns() - post_start_ns;
+	scheduler::InferenceScheduler::instance().reportRun(
+		tf->schedulerId, (double)(job.prepare_ns + job.run_ns + post_ns) / 1e9);
+	update_average(tf->stats.prepare_ms, (double)job.prepare_ns / 1e6);
+	update_average(tf->stats.run_ms, (double)job.run_ns / 1e6);
+	update_average(tf->stats.post_ms, (double)post_ns / 1e6);
+	update_average(tf->stats.latency_ms,
+		       (double)(os_gettime_ns() - job.frame.timestamp_ns) / 1e6);
+}
+
+void inference_worker(struct detect_filter *tf)
+{
+	obs_log(LOG_INFO, "Starting inference worker thread (%s)",
+		tf->pipelined ? "pipelined" : "serial");
+	tf->thread_running = true;
+	
+	while (!tf->should_stop) {
+		inference_frame queued{cv::Mat(), 0, 0};
+		{
+			std::unique_lock<std::mutex> lock(tf->queue_mutex);
+			if (tf->frame_queue.empty()) {
+				// 等待新帧或停止信号
+				tf->queue_condition.wait(lock, [&tf] { 
+					return !tf->frame_queue.empty() || tf->should_stop.load(); 
+				});
+				
+				if (tf->should_stop && tf->frame_queue.empty()) {
+					break;
+				}
+			}
+			
+			if (!tf->frame_queue.empty()) {
+				queued = tf->frame_queue.front();
+				tf->frame_queue.pop();
+			}
+		}
+
+		if (queued.bgra.empty()) {
+			continue;
+		}
+
+		// 执行推理
+		const uint64_t prepare_start_ns = os_gettime_ns();
+		detection_job job;
+		job.frame = std::move(queued);
+		try {
+			if (!prepare_detection(tf, job)) {
+				continue;
+			}
+		} catch (const std::exception &e) {
+			obs_log(LOG_ERROR, "Inference error: %s", e.what());
+			continue;
+		}
+		job.prepare_ns = os_gettime_ns() - prepare_start_ns;
+
+		if (tf->pipelined) {
+			// waits while both input slots are taken, newer frames replace the queued one
+			tf->preparedJobs.push(std::move(job), tf->should_stop);
+		} else if (run_detection(tf, job)) {
+			finish_detection(tf, job);
+		}
+	}
+	
+	obs_log(LOG_INFO, "Stopping inference worker thread");
+	tf->thread_running = false;
+}
+
+static void run_worker(struct detect_filter *tf)
+{
+	detection_job job;
+	while (tf->preparedJobs.pop(job, tf->should_stop)) {
+		if (run_detection(tf, job)) {
+			tf->detectedJobs.push(std::move(job), tf->should_stop);
+		}
+	}
+}
+
+static void post_worker(struct detect_filter *tf)
+{
+	detection_job job;
+	while (tf->detectedJobs.pop(job, tf->should_stop)) {
+		finish_detection(tf, job);
+	}
+}
+
+static void start_inference_threads(struct detect_filter *tf)
+{
+	// 启动推理线程
+	try {
+		tf->inference_thread = std::thread(inference_worker, tf);
+		if (tf->pipelined) {
+			tf->run_thread = std::thread(run_worker, tf);
+			tf->post_thread = std::thread(post_worker, tf);
+		}
+		obs_log(LOG_INFO, "Inference thread started successfully");
+	} catch (const std::exception &e) {
+		obs_log(LOG_ERROR, "Failed to start inference thread: %s", e.what());
+	}
+}
+
+// Stop and join the threads, leaves should_stop set
+static void stop_inference_threads(struct detect_filter *tf)
+{
+	tf->should_stop = true;  // 设置停止标志
+
+	// 唤醒推理线程（以防它正在等待）
+	{
+		std::lock_guard<std::mutex> lock(tf->queue_mutex);
+		tf->queue_condition.notify_all();
+	}
+	tf->preparedJobs.wake();
+	tf->detectedJobs.wake();
+	{
+		std::lock_guard<std::mutex> lock(tf->inputSlotLock);
+		tf->inputSlotFree.notify_all();
+	}
+
+	// 等待推理线程结束
+	for (std::thread *thread : {&tf->inference_thread, &tf->run_thread, &tf->post_thread}) {
+		if (thread->joinable()) {
+			try {
+				thread->join();
+			} catch (const std::exception &e) {
+				obs_log(LOG_ERROR, "Error joining inference thread: %s", e.what());
+			}
+		}
+	}
+	obs_log(LOG_INFO, "Inference threads joined successfully");
+
+	// jobs left between the stages still hold their input slots
+	tf->preparedJobs.clear();
+	tf->detectedJobs.clear();
+	std::lock_guard<std::mutex> lock(tf->inputSlotLock);
+	for (input_slot &slot : tf->inputSlots) {
+		slot.busy = false;
+	}
+}
+
+static scheduler::Visibility source_visibility(struct detect_filter *tf)
+{
+	obs_source_t *parent = obs_filter_get_parent(tf->source);
+	if (parent && obs_source_active(parent)) {
+		return scheduler::Visibility::Program;
+	}
+	if (parent && obs_source_showing(parent)) {
+		return scheduler::Visibility::Preview;
+	}
+	return scheduler::Visibility::Hidden;
+}
+
+static void update_stats_text(struct detect_filter *tf)
+{
+	const uint64_t inferences = tf->stats.inferences;
+	const uint64_t motion_skips = tf->stats.motion_skips;
+	std::string text = std::string(obs_module_text("StatsInferences")) + ": " +
+			   std::to_string(inferences);
+	if (tf->motionGate || motion_skips > 0) {
+		text += ", " + std::string(obs_module_text("StatsMotionSkips")) + ": " +
+			std::to_string(motion_skips);
+	}
+	const double latency_ms = tf->stats.latency_ms;
+	if (latency_ms > 0.0) {
+		// pipelined, the latency approaches the sum of the stages and the throughput the
+		// slowest one
+		char latency[96];
+		snprintf(latency, sizeof(latency), "%.0f ms (%s %.1f / %.1f / %.1f ms)", latency_ms,
+			 obs_module_text("StatsStages"), tf->stats.prepare_ms.load(),
+			 tf->stats.run_ms.load(), tf->stats.post_ms.load());
+		text += ", " + std::string(obs_module_text("StatsLatency")) + ": " + latency;
+	}
+	const uint64_t gate_checks = tf->stats.gate_checks;
+	if (gate_checks > 0) {
+		char open_rate[32];
+		snprintf(open_rate, sizeof(open_rate), "%.1f%%",
+			 100.0 * (double)tf->stats.gate_hits / (double)gate_checks);
+		text += ", " + std::string(obs_module_text("StatsPresenceGate")) + ": " + open_rate;
+	}
+	const uint64_t preview_updates = tf->stats.preview_updates;
+	if (tf->preview && preview_updates > 0) {
+		// skipped updates saved their drawing time, smaller previews their memory
+		const uint64_t preview_skips = tf->stats.preview_skips;
+		const double update_ms = (double)tf->stats.preview_ns / 1e6 / preview_updates;
+		const double mb = (double)tf->stats.preview_bytes / (1024.0 * 1024.0);
+		const double full_mb = (double)tf->stats.preview_full_bytes / (1024.0 * 1024.0);
+		char preview[192];
+		snprintf(preview, sizeof(preview),
+			 "%.2f ms x %llu, %llu %s (%.1f s %s), %.1f MB (%.1f MB %s)", update_ms,
+			 (unsigned long long)preview_updates, (unsigned long long)preview_skips,
+			 obs_module_text("StatsPreviewSkipped"),
+			 (double)preview_skips * update_ms / 1000.0, obs_module_text("StatsSaved"),
+			 mb, std::max(full_mb - mb, 0.0), obs_module_text("StatsSaved"));
+		text += ", " + std::string(obs_module_text("StatsPreview")) + ": " + preview;
+	}
+	if (tf->sceneCutDetection) {
+		text += ", " + std::string(obs_module_text("StatsSceneCuts")) + ": " +
+			std::to_string(tf->stats.scene_cuts.load());
+		std::lock_guard<std::mutex> lock(tf->stats.scene_cut_lock);
+		if (!tf->stats.scene_cut_times_ns.empty()) {
+			const double since =
+				(double)(os_gettime_ns() - tf->stats.scene_cut_times_ns.back()) / 1e9;
+			char seconds[32];
+			snprintf(seconds, sizeof(seconds), "%.1f", since);
+			text += " (" + std::string(obs_module_text("StatsLastSceneCut")) + ": " +
+				seconds + " s)";
+		}
+	}
+
+	// records the outputs lost to a slow disk or client, only shown once there are some
+	uint64_t push_dropped = 0;
+	{
+		std::lock_guard<std::mutex> lock(tf->pushServerLock);
+		if (tf->pushServer) {
+			push_dropped = tf->pushServer->dropped();
+		}
+	}
+	const uint64_t log_dropped = tf->detectionWriter.dropped();
+	const uint64_t sidecar_dropped = tf->sidecarRecorder.dropped();
+	const uint64_t total_dropped = log_dropped + push_dropped + sidecar_dropped;
+	if (total_dropped > tf->stats.dropped_logged) {
+		obs_log(LOG_WARNING,
+			"Dropped %llu output records (log %llu, push %llu, recording %llu in total)",
+			(unsigned long long)(total_dropped - tf->stats.dropped_logged),
+			(unsigned long long)log_dropped, (unsigned long long)push_dropped,
+			(unsigned long long)sidecar_dropped);
+	}
+	tf->stats.dropped_logged = total_dropped;
+	if (total_dropped > 0) {
+		char dropped[128];
+		snprintf(dropped, sizeof(dropped), "%s %llu, %s %llu, %s %llu",
+			 obs_module_text("StatsDroppedLog"), (unsigned long long)log_dropped,
+			 obs_module_text("StatsDroppedPush"), (unsigned long long)push_dropped,
+			 obs_module_text("StatsDroppedRecording"),
+			 (unsigned long long)sidecar_dropped);
+		text += ", " + std::string(obs_module_text("StatsDropped")) + ": " + dropped;
+	}
+
+	// the first detected object, written here at the stats rate rather than for every result
+	std::string detectedObject;
+	{
+		std::lock_guard<std::mutex> lock(tf->resultLock);
+		if (tf->latestResult && tf->latestResult->count > 0) {
+			detectedObject = tf->latestResult->objects[0].label;
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(tf->stats.text_lock);
+		tf->stats.text = std::move(text);
+	}
+
+	if (detectedObject != tf->detectedObjectText) {
+		obs_data_t *source_settings = obs_source_get_settings(tf->source);
+		if (source_settings) {
+			obs_data_set_string(source_settings, "detected_object",
+					    detectedObject.c_str());
+			obs_data_release(source_settings);
+		}
+		tf->detectedObjectText = detectedObject;
+	}
+}
+
+// true if the frame looks like the last one sent to inference, its thumbnail is the reference
+// for the next comparison otherwise
+static bool motion_gate_skip(struct detect_filter *tf, const cv::Mat &frame, double elapsed_s)
+{
+	// requested refreshes and stale results are never held back
+	bool still = false;
+	if (!tf->force_full_frame && elapsed_s < tf->motionMaxStale) {
+		cv::Rect roi(0, 0, tf->lumaThumbnail.cols, tf->lumaThumbnail.rows);
+		if (tf->motionInCrop && tf->crop_enabled) {
+			const double scale = (double)tf->lumaThumbnail.cols / frame.cols;
+			roi = cv::Rect(cvFloor(tf->crop_left * scale), cvFloor(tf->crop_top * scale),
+				       cvCeil((frame.cols - tf->crop_left - tf->crop_right) * scale),
+				       cvCeil((frame.rows - tf->crop_top - tf->crop_bottom) * scale));
+		}
+		still = tf->motionDetector.changedFraction(tf->lumaThumbnail, roi,
+							   tf->MOTION_PIXEL_THRESHOLD) <
+			tf->motionThreshold;
+	}
+
+	if (!still) {
+		tf->motionDetector.setReference(tf->lumaThumbnail);
+	}
+	return still;
+}
+
+// Cascade results are not tracked, they move with the predicted box of their parent until the
+// next detection
+static void attach_cascade_children(std::vector<Object> &tracked,
+				    const std::vector<Object> &detected)
+{
+	const size_t num_tracked = tracked.size();
+	for (const Object &child : detected) {
+		if (child.parent_id == 0) {
+			continue;
+		}
+		auto parent = std::find_if(detected.begin(), detected.end(), [&](const Object &obj) {
+			return obj.parent_id == 0 && obj.id == child.parent_id;
+		});
+		auto predicted = std::find_if(tracked.begin(), tracked.begin() + num_tracked,
+					      [&](const Object &obj) {
+						      return obj.id == child.parent_id;
+					      });
+		if (parent == detected.end() || predicted == tracked.begin() + num_tracked) {
+			continue;
+		}
+		Object moved = child;
+		moved.rect.x += predicted->rect.x - parent->rect.x;
+		moved.rect.y += predicted->rect.y - parent->rect.y;
+		tracked.push_back(moved);
+	}
+}
+
+// The siblings taking this filter's detections get the held ones again with the new frame
+static void republish_shared_detections(struct detect_filter *tf,
+					const std::shared_ptr<channel::SourceChannel> &sourceChannel,
+					const cv::Mat &frame, uint64_t timestamp_ns)
+{
+	std::shared_ptr<const channel::SharedDetections> last;
+	{
+		std::lock_guard<std::mutex> lock(tf->lastObjectsLock);
+		last = tf->lastShared;
+	}
+	if (!last || !sourceChannel || !sourceChannel->hasSubscribers(tf->schedulerId)) {
+		return;
+	}
+	auto published = std::make_shared<channel::SharedDetections>(
+		channel::SharedDetections{frame, timestamp_ns, last->objects});
+	sourceChannel->publishDetections(tf->schedulerId, published);
+	std::lock_guard<std::mutex> lock(tf->lastObjectsLock);
+	tf->lastShared = published;
+}
+
+static void on_scene_cut(struct detect_filter *tf, const cv::Mat &frame, uint64_t timestamp_ns)
+{
+	obs_log(LOG_INFO, "Scene cut at %.3f s", (double)timestamp_ns / 1e9);
+	{
+		// the worker checks the cut count under the same lock before it updates the tracker
+		std::lock_guard<std::mutex> lock(tf->trackerLock);
+		tf->stats.scene_cuts++;
+		tf->tracker.reset();
+	}
+	{
+		std::lock_guard<std::mutex> lock(tf->stats.scene_cut_lock);
+		tf->stats.scene_cut_times_ns.push_back(timestamp_ns);
+		while (tf->stats.scene_cut_times_ns.size() > filter_stats::SCENE_CUT_HISTORY) {
+			tf->stats.scene_cut_times_ns.pop_front();
+		}
+	}
+	{
+		std::lock_guard<std::mutex> lock(tf->lastObjectsLock);
+		tf->lastObjects.clear();
+		tf->lastShared.reset();
+	}
+	tf->force_full_frame = true;
+
+	if (tf->preview && !tf->tracking) {
+		// no stale boxes over the new shot while it is being detected
+		render_preview(tf, frame, {}, true);
+	}
+}
+
+// Starts a sidecar when OBS starts recording and finishes it when the recording stops. The
+// outputs are looked at about once a second, so a sidecar starts up to a second late; its
+// start_ns still is the recording's first frame.
+static void update_sidecar(struct detect_filter *tf)
+{
+	output::RecordingState recording;
+	if (tf->recordSidecar) {
+		const auto now = std::chrono::steady_clock::now();
+		if (now - tf->last_sidecar_check < std::chrono::seconds(1)) {
+			return;
+		}
+		tf->last_sidecar_check = now;
+		output::SidecarRecorder::activeRecording(recording);
+	} else {
+		// looked for at once when turned on again
+		tf->last_sidecar_check = std::chrono::steady_clock::time_point();
+	}
+	if (recording.path == tf->sidecarRecordingPath) {
+		return;
+	}
+	tf->sidecarRecordingPath = recording.path;
+	if (recording.path.empty()) {
+		tf->sidecarRecorder.stop();
+		return;
+	}
+
+	obs_source_t *parent = obs_filter_get_parent(tf->source);
+	struct obs_video_info ovi = {};
+	obs_get_video_info(&ovi);
+	output::SidecarInfo info;
+	info.path = output::SidecarRecorder::sidecarPath(
+		recording.path, parent ? obs_source_get_name(parent) : "",
+		obs_source_get_name(tf->source));
+	info.start_ns = recording.start_ns;
+	info.fps_num = ovi.fps_num;
+	info.fps_den = ovi.fps_den;
+	info.video_width = ovi.output_width;
+	info.video_height = ovi.output_height;
+	const class_name_tables names = class_names(tf);
+	info.labels = *names.names;
+	info.cascade_labels = *names.cascade;
+	tf->sidecarRecorder.start(info);
+}
+
+// The source or filter whose output the filter captures, past the filters below it that leave
+// the video as it is: disabled filters and Detect filters without a preview. Filters with the
+// same input see the same frames and can share them.
+static obs_source_t *channel_input(struct detect_filter *tf)
+{
+	obs_source_t *parent = obs_filter_get_parent(tf->source);
+	obs_source_t *input = obs_filter_get_target(tf->source);
+	while (input && input != parent) {
+		if (obs_source_enabled(input)) {
+			if (strcmp(obs_source_get_unversioned_id(input), "detect-filter") != 0) {
+				break;
+			}
+			const detect_filter *below = (const detect_filter *)obs_obj_get_data(input);
+			if (!below || below->preview) {
+				break;
+			}
+		}
+		input = obs_filter_get_target(input);
+	}
+	return input;
+}
+
+void detect_filter_video_tick(void *data, float seconds)
+{
+	UNUSED_PARAMETER(seconds);
+
+	struct detect_filter *tf = reinterpret_cast<detect_filter *>(data);
+
+	if (!tf) {
+		return;
+	}
+
+	static bool last_inference_state = false;
+	if (last_inference_state != tf->inferenceEnabled) {
+		last_inference_state = tf->inferenceEnabled;
+		obs_log(LOG_INFO, "Inference state changed to: %s", tf->inferenceEnabled ? "ENABLED" : "DISABLED");
+	}
+
+	// the sidecar follows the recording even while the filter is off
+	update_sidecar(tf);
+
+	if (tf->isDisabled) {
+		obs_log(LOG_WARNING, "Filter is disabled, skipping tick");
+		return;
+	}
+
+	if (!tf->source || !obs_source_enabled(tf->source)) {
+		return;
+	}
+
+	std::shared_ptr<channel::SourceChannel> sourceChannel = source_channel(tf);
+	obs_source_t *input = channel_input(tf);
+	if (sourceChannel && input != tf->channelInput) {
+		// moved in the filter chain, or a filter below started or stopped changing the video
+		std::lock_guard<std::mutex> lock(tf->channelLock);
+		tf->sourceChannel->leave(tf->schedulerId);
+		tf->sourceChannel.reset();
+		sourceChannel.reset();
+	}
+	if (!sourceChannel) {
+		if (input) {
+			tf->channelInput = input;
+			sourceChannel = channel::SourceChannel::join(
+				input, tf->schedulerId,
+				[tf](const std::shared_ptr<const channel::SharedDetections> &detections) {
+					receive_shared_detections(tf, detections);
+				});
+			std::lock_guard<std::mutex> lock(tf->channelLock);
+			tf->sourceChannel = sourceChannel;
+		}
+	}
+	if (tf->shmOutput && !tf->shmPublisher.isOpen() && !tf->shmPublisher.failed()) {
+		obs_source_t *parent = obs_filter_get_parent(tf->source);
+		if (parent) {
+			tf->shmPublisher.open(obs_source_get_name(parent));
+		}
+	}
+	bool detects = true;
+	if (sourceChannel) {
+		std::string channelKey;
+		{
+			std::lock_guard<std::mutex> lock(tf->channelLock);
+			channelKey = tf->channelKey;
+		}
+		float threshold = tf->conf_threshold;
+		if (tf->tracking) {
+			std::lock_guard<std::mutex> lock(tf->trackerLock);
+			threshold = std::min(threshold, tf->tracker.config().low_threshold);
+		}
+		// without a model or with inference off the filter only shares the capture
+		const bool detecting = tf->onnxruntimemodel && tf->inferenceEnabled;
+		sourceChannel->update(tf->schedulerId, detecting ? channelKey : std::string(),
+				      threshold, tf->channelPrimary);
+		detects = sourceChannel->runsDetection(tf->schedulerId);
+	}
+
+	cv::Mat imageBGRA;
+	uint64_t timestamp_ns = 0;
+	if (!sourceChannel || sourceChannel->capturesFrames(tf->schedulerId)) {
+		uint32_t width, height;
+		if (!getRGBAFromStageSurface(tf, width, height)) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(tf->inputBGRALock);
+			if (tf->inputBGRA.empty()) {
+				return;
+			}
+			imageBGRA = tf->inputBGRA.clone();
+		}
+		// the frame's place on the video clock, which recordings are timed by
+		timestamp_ns = obs_get_video_frame_time();
+		if (sourceChannel) {
+			sourceChannel->publishFrame(imageBGRA, timestamp_ns);
+		}
+	} else {
+		// a sibling rendered and read back the source this frame, or the last one
+		if (!sourceChannel->latestFrame(imageBGRA, timestamp_ns)) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(tf->inputBGRALock);
+		imageBGRA.copyTo(tf->inputBGRA);
 	}
 
 	if (!tf->onnxruntimemodel) {
 		obs_log(LOG_WARNING, "Model not loaded, showing original image");
 		if (tf->preview) {
-			std::lock_guard<std::mutex> lock(tf->outputLock);
-			tf->outputPreviewBGRA = imageBGRA.clone();
+			// no boxes of a model that is gone, only the markers
+			render_preview(tf, imageBGRA, {});
 		}
 		return;
 	}
 
+	const auto stats_now = std::chrono::steady_clock::now();
+	if (stats_now - tf->last_stats_update >= std::chrono::seconds(1)) {
+		tf->last_stats_update = stats_now;
+		update_stats_text(tf);
+	}
+
+	bool thumbnail_ready = false;
+	bool scene_cut = false;
+	if (tf->sceneCutDetection) {
+		MotionDetector::makeThumbnail(imageBGRA, tf->lumaThumbnail);
+		thumbnail_ready = true;
+		scene_cut = tf->sceneCutDetector.update(tf->lumaThumbnail, tf->SCENE_CUT_THRESHOLD);
+		if (scene_cut) {
+			on_scene_cut(tf, imageBGRA, timestamp_ns);
+		}
+	}
+
+	if (tf->tracking && tf->preview) {
+		// boxes follow their tracks on the frames between detections
+		std::vector<Object> tracked;
+		{
+			std::lock_guard<std::mutex> lock(tf->trackerLock);
+			tracked = tf->tracker.predict((double)timestamp_ns / 1e9);
+		}
+		if (tf->cascadeModel) {
+			std::lock_guard<std::mutex> lock(tf->lastObjectsLock);
+			attach_cascade_children(tracked, tf->lastObjects);
+		}
+		render_preview(tf, imageBGRA, tracked);
+	}
+
 	// 将帧添加到推理队列（仅当推理启用且队列未满时）
-	if (tf->inferenceEnabled) {
+	// auto-tune needs the CPU to itself for its measurements
+	// a sibling detecting for this filter queues its results, see receive_shared_detections
+	if (tf->inferenceEnabled && !tf->autotune_running && detects) {
 		auto now = std::chrono::steady_clock::now();
 		auto elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
 			now - tf->last_inference_time).count();
 		
-		if (elapsed_ms >= tf->MIN_INFERENCE_INTERVAL_MS) {
+		// the new shot is detected right away instead of after the rate limit
+		// the scheduler shares the inference budget out by visibility and priority
+		const bool due = scene_cut || scheduler::InferenceScheduler::instance().shouldRun(
+						      tf->schedulerId, source_visibility(tf),
+						      tf->schedulerPriority, tf->pauseWhenHidden, now);
+		if (due && tf->motionGate && !thumbnail_ready) {
+			MotionDetector::makeThumbnail(imageBGRA, tf->lumaThumbnail);
+		}
+
+		if (due && tf->motionGate &&
+		    motion_gate_skip(tf, imageBGRA, (double)elapsed_ms / 1000.0)) {
+			// nothing moved, the last detections still hold for this frame
+			tf->stats.motion_skips++;
+			std::vector<Object> objects;
+			{
+				std::lock_guard<std::mutex> lock(tf->lastObjectsLock);
+				objects = tf->lastObjects;
+			}
+			if (tf->tracking) {
+				// keeps the tracks alive past max_lost_seconds while the scene is still,
+				// cascade results are not tracked
+				objects.erase(std::remove_if(objects.begin(), objects.end(),
+							     [](const Object &obj) {
+								     return obj.parent_id != 0;
+							     }),
+					      objects.end());
+				std::lock_guard<std::mutex> lock(tf->trackerLock);
+				tf->tracker.update(objects, (double)timestamp_ns / 1e9);
+			} else if (tf->preview) {
+				render_preview(tf, imageBGRA, objects);
+			}
+			republish_shared_detections(tf, sourceChannel, imageBGRA, timestamp_ns);
+		} else if (due) {
 			// 检查队列大小，避免无限增长
 			{
 				std::lock_guard<std::mutex> lock(tf->queue_mutex);
 				// 只保留最新的一帧，丢弃旧帧以避免延迟
-				while (tf->frame_queue.size() > 1) {
+				// frames from before a cut would only be dropped by the worker
+				while (tf->frame_queue.size() > (scene_cut ? 0u : 1u)) {
 					tf->frame_queue.pop();
 				}
 				// 添加新帧到队列
-				tf->frame_queue.push(imageBGRA.clone());
+				tf->frame_queue.push(
+					{imageBGRA.clone(), timestamp_ns, tf->stats.scene_cuts.load()});
 			}
 			// 通知推理线程有新帧可用
 			tf->queue_condition.notify_one();
@@ -833,6 +2555,16 @@ void detect_filter_video_tick(void *data, float seconds)
 	}
 }
 
+// The CPU preview, scaled up to the source size
+static void draw_preview_texture(struct detect_filter *tf, uint32_t width, uint32_t height)
+{
+	gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+	gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), tf->previewTexture);
+	while (gs_effect_loop(effect, "Draw")) {
+		gs_draw_sprite(tf->previewTexture, 0, width, height);
+	}
+}
+
 void detect_filter_video_render(void *data, gs_effect_t *_effect)
 {
 	UNUSED_PARAMETER(_effect);
@@ -861,73 +2593,75 @@ void detect_filter_video_render(void *data, gs_effect_t *_effect)
 		return;
 	}
 
-	// 获取预览输出或原始输入
-	cv::Mat outputBGRA;
-	{
+	const PreviewMode mode = tf->previewMode;
+	if (mode == PreviewMode::Overlay) {
+		std::shared_ptr<const overlay::OverlayGeometry> geometry;
+		{
+			std::lock_guard<std::mutex> lock(tf->outputLock);
+			geometry = tf->overlayGeometry;
+		}
+		// the source goes through as it is, the boxes are drawn on top of it
+		if (!obs_source_process_filter_begin(tf->source, GS_RGBA,
+						     OBS_ALLOW_DIRECT_RENDERING)) {
+			return;
+		}
+		obs_source_process_filter_end(tf->source, obs_get_base_effect(OBS_EFFECT_DEFAULT),
+					      width, height);
+		tf->overlayRenderer.draw(geometry, width, height);
+		return;
+	}
+
+	// the texture is only updated when the worker published a new preview, every other render
+	// draws it as it is
+	const uint64_t generation = tf->previewGeneration.load();
+	if (generation != tf->previewTextureGeneration) {
 		std::lock_guard<std::mutex> lock(tf->outputLock);
-		if (!tf->outputPreviewBGRA.empty() &&
-		    (uint32_t)tf->outputPreviewBGRA.cols == width &&
-		    (uint32_t)tf->outputPreviewBGRA.rows == height) {
-			outputBGRA = tf->outputPreviewBGRA.clone(); // 使用处理后的图像（带检测框）
-		} else {
-			// 如果没有预览输出，则尝试使用输入图像
-			std::lock_guard<std::mutex> lock_input(tf->inputBGRALock);
-			if (!tf->inputBGRA.empty()) {
-				outputBGRA = tf->inputBGRA.clone();
+		const cv::Mat &preview = tf->outputPreviewBGRA;
+		if (!preview.empty()) {
+			if (!tf->previewTexture ||
+			    gs_texture_get_width(tf->previewTexture) != (uint32_t)preview.cols ||
+			    gs_texture_get_height(tf->previewTexture) != (uint32_t)preview.rows) {
+				if (tf->previewTexture) {
+					gs_texture_destroy(tf->previewTexture);
+				}
+				tf->previewTexture = gs_texture_create(
+					preview.cols, preview.rows, GS_BGRA, 1, nullptr, GS_DYNAMIC);
 			}
+			if (tf->previewTexture) {
+				gs_texture_set_image(tf->previewTexture, preview.data,
+						     (uint32_t)preview.step, false);
+			}
+			tf->previewTextureFrameSize = tf->previewFrameSize;
+			tf->previewTextureMode = tf->previewFrameMode;
 		}
+		tf->previewTextureGeneration = tf->previewGeneration.load();
 	}
 
-	// 如果仍然没有图像数据，则跳过过滤器
-	if (outputBGRA.empty()) {
-		obs_source_skip_video_filter(tf->source);
+	// until a preview of this size and mode comes in the source shows as it is
+	const bool current = tf->previewTexture && tf->previewTextureMode == mode &&
+			     tf->previewTextureFrameSize == cv::Size((int)width, (int)height);
+
+	if (mode == PreviewMode::Transparent) {
+		if (!obs_source_process_filter_begin(tf->source, GS_RGBA,
+						     OBS_ALLOW_DIRECT_RENDERING)) {
+			return;
+		}
+		obs_source_process_filter_end(tf->source, obs_get_base_effect(OBS_EFFECT_DEFAULT),
+					      width, height);
+		if (current) {
+			// drawn on transparent black, premultiplied
+			gs_blend_state_push();
+			gs_enable_blending(true);
+			gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+			draw_preview_texture(tf, width, height);
+			gs_blend_state_pop();
+		}
 		return;
 	}
 
-	// 转换颜色空间并绘制图形
-	cv::Mat frameBGR;
-	cv::cvtColor(outputBGRA, frameBGR, cv::COLOR_BGRA2BGR);
-
-	// 始终绘制十字和圆圈
-	int center_x = frameBGR.cols / 2;
-	int center_y = frameBGR.rows / 2;
-
-	cv::Scalar cross_color = cv::Scalar(0, 255, 0);
-	cv::Scalar circle_color = cv::Scalar(0, 0, 255);
-
-	cv::line(frameBGR, cv::Point(center_x - 30, center_y), 
-		 cv::Point(center_x + 30, center_y), cross_color, 2);
-	cv::line(frameBGR, cv::Point(center_x, center_y - 30), 
-		 cv::Point(center_x, center_y + 30), cross_color, 2);
-
-	int circle_radius = 50;
-	cv::circle(frameBGR, cv::Point(center_x, center_y), circle_radius, circle_color, 2);
-
-	// 创建一个新的矩阵来存储最终结果，避免修改原始数据
-	cv::Mat finalOutputBGRA;
-	cv::cvtColor(frameBGR, finalOutputBGRA, cv::COLOR_BGR2BGRA);
-
-	if (!finalOutputBGRA.empty() && finalOutputBGRA.data) {
-		// 确保数据大小正确
-		size_t expected_size = width * height * 4; // 4 bytes per pixel for BGRA
-		if (finalOutputBGRA.total() * finalOutputBGRA.elemSize() >= expected_size) {
-			gs_texture_t *tex = gs_texture_create(width, height, GS_BGRA, 1,
-							      (const uint8_t **)&finalOutputBGRA.data, 0);
-			if (tex) {
-				gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
-				gs_technique_t *tech = gs_effect_get_technique(effect, "Draw");
-				gs_eparam_t *image_param = gs_effect_get_param_by_name(effect, "image");
-
-				gs_effect_set_texture(image_param, tex);
-
-				gs_technique_begin(tech);
-				gs_technique_begin_pass(tech, 0);
-				gs_draw_sprite(tex, 0, 0, 0);
-				gs_technique_end_pass(tech);
-				gs_technique_end(tech);
-
-				gs_texture_destroy(tex);
-			}
-		}
+	if (!current) {
+		obs_source_skip_video_filter(tf->source);
+		return;
 	}
-}
\ No newline at end of file
+	draw_preview_texture(tf, width, height);
+}
@@ -11,6 +11,7 @@
 #include <opencv2/imgproc.hpp>
 
 #include "ort-model/ONNXRuntimeModel.h"
+#include "kernels/kernels.h"
 
 namespace edgeyolo_cpp {
 /**
@@ -24,10 +25,11 @@ class AbcEdgeYOLO : public ONNXRuntimeModel {
 public:
 	AbcEdgeYOLO(file_name_t path_to_model, int intra_op_num_threads, int inter_op_num_threads,
 		    const std::string &use_gpu_, int device_id, bool use_parallel, float nms_th,
-		    float conf_th, int num_classes = 80)
+		    float conf_th, int num_classes = 80, const SessionTuning *tuning = nullptr,
+		    const std::string &ep_options = std::string())
 		: ONNXRuntimeModel(path_to_model, intra_op_num_threads, num_classes,
 				   inter_op_num_threads, use_gpu_, device_id, use_parallel, nms_th,
-				   conf_th)
+				   conf_th, tuning, ep_options)
 	{
 		if (this->output_shapes_.empty()) {
 			throw std::runtime_error("No output shapes available");
@@ -63,20 +65,15 @@ protected:
 			return;
 		}
 
+		const auto score_kernel = kernels().max_scaled_score;
 		for (int idx = 0; idx < num_array; ++idx) {
 			const int basic_pos = idx * (num_classes_ + 5);
 
 			float box_objectness = feat_ptr[basic_pos + 4];
 			int class_id = 0;
-			float max_class_score = 0.0;
-			for (int class_idx = 0; class_idx < num_classes_; ++class_idx) {
-				float box_cls_score = feat_ptr[basic_pos + 5 + class_idx];
-				float box_prob = box_objectness * box_cls_score;
-				if (box_prob > max_class_score) {
-					class_id = class_idx;
-					max_class_score = box_prob;
-				}
-			}
+			float max_class_score = score_kernel(feat_ptr + basic_pos + 5,
+							     num_classes_, box_objectness,
+							     &class_id);
 			if (max_class_score > prob_threshold) {
 				float x_center = feat_ptr[basic_pos + 0];
 				float y_center = feat_ptr[basic_pos + 1];
@@ -5,16 +5,16 @@ namespace edgeyolo_cpp {
 EdgeYOLOONNXRuntime::EdgeYOLOONNXRuntime(file_name_t path_to_model, int intra_op_num_threads,
 					 int num_classes, int inter_op_num_threads,
 					 const std::string &use_gpu_, int device_id,
-					 bool use_parallel, float nms_th, float conf_th)
+					 bool use_parallel, float nms_th, float conf_th,
+					 const SessionTuning *tuning,
+					 const std::string &ep_options)
 	: AbcEdgeYOLO(path_to_model, intra_op_num_threads, inter_op_num_threads, use_gpu_,
-		      device_id, use_parallel, nms_th, conf_th, num_classes)
+		      device_id, use_parallel, nms_th, conf_th, num_classes, tuning, ep_options)
 {
 }
 
-std::vector<Object> EdgeYOLOONNXRuntime::inference(const cv::Mat &frame)
+std::vector<Object> EdgeYOLOONNXRuntime::decode(const cv::Size &frame_size)
 {
-	ONNXRuntimeModel::inference(frame, 0);
-
 	if (this->output_buffer_.empty()) {
 		return {};
 	}
@@ -28,11 +28,11 @@ std::vector<Object> EdgeYOLOONNXRuntime::inference(const cv::Mat &frame)
 		return {};
 	}
 
-	float scale = std::min((float)input_w_[0] / (float)frame.cols,
-			     (float)input_h_[0] / (float)frame.rows);
+	float scale = std::min((float)input_w_[0] / (float)frame_size.width,
+			     (float)input_h_[0] / (float)frame_size.height);
 	std::vector<Object> objects;
 	decode_outputs(net_pred, this->num_array_, objects, this->bbox_conf_thresh_, scale,
-		       frame.cols, frame.rows);
+		       frame_size.width, frame_size.height);
 	return objects;
 }
 
@@ -19,8 +19,11 @@ public:
 	EdgeYOLOONNXRuntime(file_name_t path_to_model, int intra_op_num_threads,
 			    int num_classes = 80, int inter_op_num_threads = 1,
 			    const std::string &use_gpu_ = "", int device_id = 0,
-			    bool use_parallel = false, float nms_th = 0.45f, float conf_th = 0.3f);
-	std::vector<Object> inference(const cv::Mat &frame) override;
+			    bool use_parallel = false, float nms_th = 0.45f, float conf_th = 0.3f,
+			    const SessionTuning *tuning = nullptr,
+			    const std::string &ep_options = std::string());
+protected:
+	std::vector<Object> decode(const cv::Size &frame_size) override;
 };
 
 } // namespace edgeyolo_cpp
@@ -0,0 +1,47 @@
+#include "PresenceGate.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+PresenceClassifier::PresenceClassifier(file_name_t path_to_model, int intra_op_num_threads,
+				       int inter_op_num_threads, const std::string &use_gpu_,
+				       const std::string &ep_options)
+	: ONNXRuntimeModel(path_to_model, intra_op_num_threads, 1, inter_op_num_threads, use_gpu_,
+			   0, false, 0.45f, 0.0f, nullptr, ep_options)
+{
+	size_t count = 1;
+	for (int64_t dim : output_shapes_[0]) {
+		count *= (size_t)std::max<int64_t>(dim, 1);
+	}
+	if (count != 1 && count != 2) {
+		throw std::runtime_error("Presence classifier must have 1 or 2 output values");
+	}
+}
+
+std::vector<Object> PresenceClassifier::decode(const cv::Size &frame_size)
+{
+	size_t count = 1;
+	for (int64_t dim : output_shapes_[0]) {
+		count *= (size_t)std::max<int64_t>(dim, 1);
+	}
+	const float *output = (const float *)output_buffer_[0].get();
+	const float probability = std::clamp(output[count - 1], 0.0f, 1.0f);
+
+	Object presence;
+	presence.rect = cv::Rect_<float>(0.0f, 0.0f, (float)frame_size.width,
+					 (float)frame_size.height);
+	presence.label = 0;
+	presence.prob = probability;
+	presence.id = 0;
+	return {presence};
+}
+
+bool PresenceGate::update(float probability)
+{
+	if (open_) {
+		open_ = probability >= close_threshold_;
+	} else {
+		open_ = probability >= open_threshold_;
+	}
+	return open_;
+}
@@ -0,0 +1,52 @@
+#ifndef PRESENCE_GATE_H
+#define PRESENCE_GATE_H
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+#include <string>
+
+#include "ort-model/ONNXRuntimeModel.h"
+
+/**
+ * A binary image classifier for the presence gate. The model takes the same input as the
+ * detectors (BGR, 0..255, letterboxed NCHW) and has one output: either the presence
+ * probability alone, or two probabilities [absent, present].
+ */
+class PresenceClassifier : public ONNXRuntimeModel {
+public:
+	PresenceClassifier(file_name_t path_to_model, int intra_op_num_threads,
+			   int inter_op_num_threads = 1, const std::string &use_gpu_ = "",
+			   const std::string &ep_options = std::string());
+
+protected:
+	// One object covering the frame, its prob is the presence probability
+	std::vector<Object> decode(const cv::Size &frame_size) override;
+};
+
+/**
+ * Hysteresis on the presence probability: the gate opens at the open threshold and only
+ * closes again below the (lower) close threshold, so a probability hovering around one
+ * threshold does not toggle the detector on every frame.
+ */
+class PresenceGate {
+public:
+	void setThresholds(float open_threshold, float close_threshold)
+	{
+		open_threshold_ = open_threshold;
+		close_threshold_ = close_threshold;
+	}
+
+	// Feed the probability of the current frame, returns whether the detector should run
+	bool update(float probability);
+
+	bool isOpen() const { return open_; }
+	void reset() { open_ = false; }
+
+private:
+	float open_threshold_ = 0.5f;
+	float close_threshold_ = 0.4f;
+	bool open_ = false;
+};
+
+#endif /* PRESENCE_GATE_H */
@@ -0,0 +1,201 @@
+#include "kernels-variants.h"
+
+#ifdef DETECT_KERNELS_X86
+
+#include <immintrin.h>
+
+namespace {
+
+DETECT_TARGET("avx2")
+void hwc_u8_to_chw_f32_avx2(const uint8_t *src, size_t src_step, int width, int height,
+			    int src_channels, float *dst)
+{
+	if (src_channels != 3 && src_channels != 4) {
+		scalar_kernel_table.hwc_u8_to_chw_f32(src, src_step, width, height, src_channels,
+						      dst);
+		return;
+	}
+
+	const __m128i shuffle =
+		src_channels == 4
+			? _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)
+			: _mm_setr_epi8(0, 3, 6, 9, 1, 4, 7, 10, 2, 5, 8, 11, -1, -1, -1, -1);
+	// two 16 byte loads per 8 pixels, BGR rows need 2 extra pixels for the second load
+	const int lookahead = src_channels == 4 ? 8 : 10;
+	const size_t plane = (size_t)width * (size_t)height;
+
+	for (int y = 0; y < height; ++y) {
+		const uint8_t *row = src + (size_t)y * src_step;
+		float *dst_b = dst + (size_t)y * (size_t)width;
+		float *dst_g = dst_b + plane;
+		float *dst_r = dst_g + plane;
+		int x = 0;
+		for (; x + lookahead <= width; x += 8) {
+			const uint8_t *p = row + x * src_channels;
+			const __m128i s0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p),
+							    shuffle);
+			const __m128i s1 = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *)(p + 4 * src_channels)), shuffle);
+			// [B0-3 B4-7 G0-3 G4-7] and [R0-3 R4-7 ...]
+			const __m128i bg = _mm_unpacklo_epi32(s0, s1);
+			const __m128i ra = _mm_unpackhi_epi32(s0, s1);
+			_mm256_storeu_ps(dst_b + x, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(bg)));
+			_mm256_storeu_ps(dst_g + x, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(
+							    _mm_srli_si128(bg, 8))));
+			_mm256_storeu_ps(dst_r + x, _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(ra)));
+		}
+		hwc_u8_to_chw_f32_tail(row, x, width, src_channels, dst_b, dst_g, dst_r);
+	}
+}
+
+DETECT_TARGET("avx2")
+float max_scaled_score_avx2(const float *scores, int count, float scale, int *best_index)
+{
+	const __m256 vscale = _mm256_set1_ps(scale);
+	__m256 vmax = _mm256_setzero_ps();
+	int i = 0;
+	for (; i + 8 <= count; i += 8) {
+		// operand order keeps NaN products out of the running max, like the scalar '>'
+		vmax = _mm256_max_ps(_mm256_mul_ps(vscale, _mm256_loadu_ps(scores + i)), vmax);
+	}
+	float lanes[8];
+	_mm256_storeu_ps(lanes, vmax);
+	float best = 0.0f;
+	for (float lane : lanes) {
+		if (lane > best) {
+			best = lane;
+		}
+	}
+	for (; i < count; ++i) {
+		const float p = scale * scores[i];
+		if (p > best) {
+			best = p;
+		}
+	}
+
+	*best_index = 0;
+	if (!(best > 0.0f)) {
+		return 0.0f;
+	}
+	for (int k = 0; k < count; ++k) {
+		if (scale * scores[k] == best) {
+			*best_index = k;
+			break;
+		}
+	}
+	return best;
+}
+
+DETECT_TARGET("avx2")
+bool any_iou_above_avx2(const float *x0, const float *y0, const float *x1, const float *y1,
+			const float *area, size_t count, const float box[4], float box_area,
+			float threshold)
+{
+	const __m256 bx0 = _mm256_set1_ps(box[0]);
+	const __m256 by0 = _mm256_set1_ps(box[1]);
+	const __m256 bx1 = _mm256_set1_ps(box[2]);
+	const __m256 by1 = _mm256_set1_ps(box[3]);
+	const __m256 barea = _mm256_set1_ps(box_area);
+	const __m256 thresh = _mm256_set1_ps(threshold);
+	const __m256 zero = _mm256_setzero_ps();
+
+	size_t j = 0;
+	for (; j + 8 <= count; j += 8) {
+		const __m256 iw = _mm256_sub_ps(_mm256_min_ps(bx1, _mm256_loadu_ps(x1 + j)),
+						_mm256_max_ps(bx0, _mm256_loadu_ps(x0 + j)));
+		const __m256 ih = _mm256_sub_ps(_mm256_min_ps(by1, _mm256_loadu_ps(y1 + j)),
+						_mm256_max_ps(by0, _mm256_loadu_ps(y0 + j)));
+		const __m256 valid = _mm256_and_ps(_mm256_cmp_ps(iw, zero, _CMP_GT_OQ),
+						   _mm256_cmp_ps(ih, zero, _CMP_GT_OQ));
+		const __m256 inter = _mm256_and_ps(valid, _mm256_mul_ps(iw, ih));
+		const __m256 uni =
+			_mm256_sub_ps(_mm256_add_ps(barea, _mm256_loadu_ps(area + j)), inter);
+		const __m256 hit = _mm256_and_ps(
+			_mm256_cmp_ps(uni, zero, _CMP_GT_OQ),
+			_mm256_cmp_ps(_mm256_div_ps(inter, uni), thresh, _CMP_GT_OQ));
+		if (_mm256_movemask_ps(hit) != 0) {
+			return true;
+		}
+	}
+	return scalar_kernel_table.any_iou_above(x0 + j, y0 + j, x1 + j, y1 + j, area + j,
+						 count - j, box, box_area, threshold);
+}
+
+DETECT_TARGET("avx2")
+inline __m256i blend_half_avx2(__m256i o16, __m256i d16, __m256i a16)
+{
+	const __m256i v = _mm256_add_epi16(
+		_mm256_mullo_epi16(o16, a16),
+		_mm256_mullo_epi16(d16, _mm256_sub_epi16(_mm256_set1_epi16(255), a16)));
+	const __m256i t = _mm256_add_epi16(v, _mm256_set1_epi16(128));
+	return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+DETECT_TARGET("avx2")
+void bgra_blend_over_avx2(uint8_t *dst, const uint8_t *overlay, size_t count)
+{
+	const __m256i alpha_shuffle = _mm256_broadcastsi128_si256(
+		_mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15));
+	const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+	const __m256i zero = _mm256_setzero_si256();
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const __m256i d = _mm256_loadu_si256((const __m256i *)(dst + i * 4));
+		const __m256i o = _mm256_loadu_si256((const __m256i *)(overlay + i * 4));
+		const __m256i a = _mm256_shuffle_epi8(o, alpha_shuffle);
+		const __m256i ov = _mm256_or_si256(o, alpha_mask);
+		// unpack and pack both work per 128-bit lane, so the pixel order is preserved
+		const __m256i lo = blend_half_avx2(_mm256_unpacklo_epi8(ov, zero),
+						   _mm256_unpacklo_epi8(d, zero),
+						   _mm256_unpacklo_epi8(a, zero));
+		const __m256i hi = blend_half_avx2(_mm256_unpackhi_epi8(ov, zero),
+						   _mm256_unpackhi_epi8(d, zero),
+						   _mm256_unpackhi_epi8(a, zero));
+		_mm256_storeu_si256((__m256i *)(dst + i * 4), _mm256_packus_epi16(lo, hi));
+	}
+	scalar_kernel_table.bgra_blend_over(dst + i * 4, overlay + i * 4, count - i);
+}
+
+DETECT_TARGET("avx2")
+size_t count_absdiff_above_avx2(const uint8_t *a, const uint8_t *b, size_t count,
+				uint8_t threshold)
+{
+	const __m256i thr = _mm256_set1_epi8((char)threshold);
+	const __m256i zero = _mm256_setzero_si256();
+
+	size_t i = 0;
+	size_t within = 0;
+	while (i + 32 <= count) {
+		__m256i acc = zero;
+		for (int block = 0; block < 255 && i + 32 <= count; ++block, i += 32) {
+			const __m256i va = _mm256_loadu_si256((const __m256i *)(a + i));
+			const __m256i vb = _mm256_loadu_si256((const __m256i *)(b + i));
+			const __m256i diff =
+				_mm256_or_si256(_mm256_subs_epu8(va, vb), _mm256_subs_epu8(vb, va));
+			acc = _mm256_sub_epi8(acc,
+					      _mm256_cmpeq_epi8(_mm256_subs_epu8(diff, thr), zero));
+		}
+		const __m256i sums = _mm256_sad_epu8(acc, zero);
+		const __m128i half = _mm_add_epi64(_mm256_castsi256_si128(sums),
+						   _mm256_extracti128_si256(sums, 1));
+		within += (size_t)_mm_cvtsi128_si32(half) +
+			  (size_t)_mm_cvtsi128_si32(_mm_srli_si128(half, 8));
+	}
+	return i - within +
+	       scalar_kernel_table.count_absdiff_above(a + i, b + i, count - i, threshold);
+}
+
+} // namespace
+
+const detect_kernels avx2_kernel_table = {
+	"avx2",
+	hwc_u8_to_chw_f32_avx2,
+	hwc_u8_to_chw_u8_sse42,
+	max_scaled_score_avx2,
+	any_iou_above_avx2,
+	bgra_blend_over_avx2,
+	count_absdiff_above_avx2,
+};
+
+#endif // DETECT_KERNELS_X86
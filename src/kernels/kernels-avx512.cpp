@@ -0,0 +1,224 @@
+#include "kernels-variants.h"
+
+#ifdef DETECT_KERNELS_X86
+
+#include <immintrin.h>
+
+namespace {
+
+#define AVX512_TARGET DETECT_TARGET("avx512f,avx512bw")
+
+// GCC's unmasked forms of some intrinsics merge into _mm512_undefined_*(), which its own
+// uninitialized warnings flag once inlined. The zero-masked forms with every lane selected
+// compile to the same instructions.
+constexpr __mmask16 ALL_LANES = 0xFFFF;
+
+AVX512_TARGET
+inline __m512 u8_to_ps(__m128i v)
+{
+	return _mm512_maskz_cvtepi32_ps(ALL_LANES, _mm512_maskz_cvtepu8_epi32(ALL_LANES, v));
+}
+
+AVX512_TARGET
+void hwc_u8_to_chw_f32_avx512(const uint8_t *src, size_t src_step, int width, int height,
+			      int src_channels, float *dst)
+{
+	if (src_channels != 3 && src_channels != 4) {
+		scalar_kernel_table.hwc_u8_to_chw_f32(src, src_step, width, height, src_channels,
+						      dst);
+		return;
+	}
+
+	const __m128i shuffle =
+		src_channels == 4
+			? _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)
+			: _mm_setr_epi8(0, 3, 6, 9, 1, 4, 7, 10, 2, 5, 8, 11, -1, -1, -1, -1);
+	// four 16 byte loads per 16 pixels, BGR rows need 2 extra pixels for the last load
+	const int lookahead = src_channels == 4 ? 16 : 18;
+	const size_t step4 = (size_t)src_channels * 4;
+	const size_t plane = (size_t)width * (size_t)height;
+
+	for (int y = 0; y < height; ++y) {
+		const uint8_t *row = src + (size_t)y * src_step;
+		float *dst_b = dst + (size_t)y * (size_t)width;
+		float *dst_g = dst_b + plane;
+		float *dst_r = dst_g + plane;
+		int x = 0;
+		for (; x + lookahead <= width; x += 16) {
+			const uint8_t *p = row + x * src_channels;
+			const __m128i s0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p),
+							    shuffle);
+			const __m128i s1 = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *)(p + step4)), shuffle);
+			const __m128i s2 = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *)(p + 2 * step4)), shuffle);
+			const __m128i s3 = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *)(p + 3 * step4)), shuffle);
+			// [B0-3 B4-7 G0-3 G4-7] / [R0-3 R4-7 ...] for each half of the 16 pixels
+			const __m128i bg_a = _mm_unpacklo_epi32(s0, s1);
+			const __m128i ra_a = _mm_unpackhi_epi32(s0, s1);
+			const __m128i bg_b = _mm_unpacklo_epi32(s2, s3);
+			const __m128i ra_b = _mm_unpackhi_epi32(s2, s3);
+			_mm512_storeu_ps(dst_b + x, u8_to_ps(_mm_unpacklo_epi64(bg_a, bg_b)));
+			_mm512_storeu_ps(dst_g + x, u8_to_ps(_mm_unpackhi_epi64(bg_a, bg_b)));
+			_mm512_storeu_ps(dst_r + x, u8_to_ps(_mm_unpacklo_epi64(ra_a, ra_b)));
+		}
+		hwc_u8_to_chw_f32_tail(row, x, width, src_channels, dst_b, dst_g, dst_r);
+	}
+}
+
+AVX512_TARGET
+float max_scaled_score_avx512(const float *scores, int count, float scale, int *best_index)
+{
+	const __m512 vscale = _mm512_set1_ps(scale);
+	__m512 vmax = _mm512_setzero_ps();
+	int i = 0;
+	for (; i + 16 <= count; i += 16) {
+		// operand order keeps NaN products out of the running max, like the scalar '>'
+		vmax = _mm512_maskz_max_ps(
+			ALL_LANES, _mm512_mul_ps(vscale, _mm512_loadu_ps(scores + i)), vmax);
+	}
+	float lanes[16];
+	_mm512_storeu_ps(lanes, vmax);
+	float best = 0.0f;
+	for (float lane : lanes) {
+		if (lane > best) {
+			best = lane;
+		}
+	}
+	for (; i < count; ++i) {
+		const float p = scale * scores[i];
+		if (p > best) {
+			best = p;
+		}
+	}
+
+	*best_index = 0;
+	if (!(best > 0.0f)) {
+		return 0.0f;
+	}
+	for (int k = 0; k < count; ++k) {
+		if (scale * scores[k] == best) {
+			*best_index = k;
+			break;
+		}
+	}
+	return best;
+}
+
+AVX512_TARGET
+bool any_iou_above_avx512(const float *x0, const float *y0, const float *x1, const float *y1,
+			  const float *area, size_t count, const float box[4], float box_area,
+			  float threshold)
+{
+	const __m512 bx0 = _mm512_set1_ps(box[0]);
+	const __m512 by0 = _mm512_set1_ps(box[1]);
+	const __m512 bx1 = _mm512_set1_ps(box[2]);
+	const __m512 by1 = _mm512_set1_ps(box[3]);
+	const __m512 barea = _mm512_set1_ps(box_area);
+	const __m512 thresh = _mm512_set1_ps(threshold);
+	const __m512 zero = _mm512_setzero_ps();
+
+	size_t j = 0;
+	for (; j + 16 <= count; j += 16) {
+		const __m512 iw =
+			_mm512_sub_ps(_mm512_maskz_min_ps(ALL_LANES, bx1, _mm512_loadu_ps(x1 + j)),
+				      _mm512_maskz_max_ps(ALL_LANES, bx0, _mm512_loadu_ps(x0 + j)));
+		const __m512 ih =
+			_mm512_sub_ps(_mm512_maskz_min_ps(ALL_LANES, by1, _mm512_loadu_ps(y1 + j)),
+				      _mm512_maskz_max_ps(ALL_LANES, by0, _mm512_loadu_ps(y0 + j)));
+		const __mmask16 valid = _mm512_cmp_ps_mask(iw, zero, _CMP_GT_OQ) &
+					_mm512_cmp_ps_mask(ih, zero, _CMP_GT_OQ);
+		const __m512 inter = _mm512_maskz_mul_ps(valid, iw, ih);
+		const __m512 uni =
+			_mm512_sub_ps(_mm512_add_ps(barea, _mm512_loadu_ps(area + j)), inter);
+		const __mmask16 hit = _mm512_mask_cmp_ps_mask(_mm512_cmp_ps_mask(uni, zero,
+										 _CMP_GT_OQ),
+							      _mm512_div_ps(inter, uni), thresh,
+							      _CMP_GT_OQ);
+		if (hit != 0) {
+			return true;
+		}
+	}
+	return scalar_kernel_table.any_iou_above(x0 + j, y0 + j, x1 + j, y1 + j, area + j,
+						 count - j, box, box_area, threshold);
+}
+
+AVX512_TARGET
+inline __m512i blend_half_avx512(__m512i o16, __m512i d16, __m512i a16)
+{
+	const __m512i v = _mm512_add_epi16(
+		_mm512_mullo_epi16(o16, a16),
+		_mm512_mullo_epi16(d16, _mm512_sub_epi16(_mm512_set1_epi16(255), a16)));
+	const __m512i t = _mm512_add_epi16(v, _mm512_set1_epi16(128));
+	return _mm512_srli_epi16(_mm512_add_epi16(t, _mm512_srli_epi16(t, 8)), 8);
+}
+
+AVX512_TARGET
+void bgra_blend_over_avx512(uint8_t *dst, const uint8_t *overlay, size_t count)
+{
+	const __m512i alpha_shuffle = _mm512_maskz_broadcast_i32x4(
+		ALL_LANES, _mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15));
+	const __m512i alpha_mask = _mm512_set1_epi32((int)0xFF000000);
+	const __m512i zero = _mm512_setzero_si512();
+
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const __m512i d = _mm512_loadu_si512((const void *)(dst + i * 4));
+		const __m512i o = _mm512_loadu_si512((const void *)(overlay + i * 4));
+		const __m512i a = _mm512_shuffle_epi8(o, alpha_shuffle);
+		const __m512i ov = _mm512_or_si512(o, alpha_mask);
+		// unpack and pack both work per 128-bit lane, so the pixel order is preserved
+		const __m512i lo = blend_half_avx512(_mm512_unpacklo_epi8(ov, zero),
+						     _mm512_unpacklo_epi8(d, zero),
+						     _mm512_unpacklo_epi8(a, zero));
+		const __m512i hi = blend_half_avx512(_mm512_unpackhi_epi8(ov, zero),
+						     _mm512_unpackhi_epi8(d, zero),
+						     _mm512_unpackhi_epi8(a, zero));
+		_mm512_storeu_si512((void *)(dst + i * 4), _mm512_packus_epi16(lo, hi));
+	}
+	scalar_kernel_table.bgra_blend_over(dst + i * 4, overlay + i * 4, count - i);
+}
+
+AVX512_TARGET
+size_t count_absdiff_above_avx512(const uint8_t *a, const uint8_t *b, size_t count,
+				  uint8_t threshold)
+{
+	const __m512i thr = _mm512_set1_epi8((char)threshold);
+
+	const __m512i zero = _mm512_setzero_si512();
+
+	size_t i = 0;
+	size_t above = 0;
+	while (i + 64 <= count) {
+		__m512i acc = zero;
+		for (int block = 0; block < 255 && i + 64 <= count; ++block, i += 64) {
+			const __m512i va = _mm512_loadu_si512((const void *)(a + i));
+			const __m512i vb = _mm512_loadu_si512((const void *)(b + i));
+			const __m512i diff =
+				_mm512_or_si512(_mm512_subs_epu8(va, vb), _mm512_subs_epu8(vb, va));
+			acc = _mm512_sub_epi8(acc, _mm512_movm_epi8(_mm512_cmpgt_epu8_mask(diff, thr)));
+		}
+		uint64_t sums[8];
+		_mm512_storeu_si512((void *)sums, _mm512_sad_epu8(acc, zero));
+		for (uint64_t sum : sums) {
+			above += (size_t)sum;
+		}
+	}
+	return above +
+	       scalar_kernel_table.count_absdiff_above(a + i, b + i, count - i, threshold);
+}
+
+} // namespace
+
+const detect_kernels avx512_kernel_table = {
+	"avx512",
+	hwc_u8_to_chw_f32_avx512,
+	hwc_u8_to_chw_u8_sse42,
+	max_scaled_score_avx512,
+	any_iou_above_avx512,
+	bgra_blend_over_avx512,
+	count_absdiff_above_avx512,
+};
+
+#endif // DETECT_KERNELS_X86
@@ -0,0 +1,100 @@
+#include "kernels-variants.h"
+
+namespace {
+
+void hwc_u8_to_chw_f32_scalar(const uint8_t *src, size_t src_step, int width, int height,
+			      int src_channels, float *dst)
+{
+	const size_t plane = (size_t)width * (size_t)height;
+	for (int y = 0; y < height; ++y) {
+		const uint8_t *row = src + (size_t)y * src_step;
+		float *dst_b = dst + (size_t)y * (size_t)width;
+		float *dst_g = dst_b + plane;
+		float *dst_r = dst_g + plane;
+		for (int x = 0; x < width; ++x) {
+			const uint8_t *px = row + (size_t)x * (size_t)src_channels;
+			dst_b[x] = (float)px[0];
+			dst_g[x] = (float)px[1];
+			dst_r[x] = (float)px[2];
+		}
+	}
+}
+
+void hwc_u8_to_chw_u8_scalar(const uint8_t *src, size_t src_step, int width, int height,
+			     int src_channels, uint8_t *dst, uint8_t xor_mask)
+{
+	const size_t plane = (size_t)width * (size_t)height;
+	for (int y = 0; y < height; ++y) {
+		uint8_t *dst_b = dst + (size_t)y * (size_t)width;
+		hwc_u8_to_chw_u8_tail(src + (size_t)y * src_step, 0, width, src_channels, dst_b,
+				      dst_b + plane, dst_b + 2 * plane, xor_mask);
+	}
+}
+
+float max_scaled_score_scalar(const float *scores, int count, float scale, int *best_index)
+{
+	float best = 0.0f;
+	int best_i = 0;
+	for (int i = 0; i < count; ++i) {
+		const float p = scale * scores[i];
+		if (p > best) {
+			best = p;
+			best_i = i;
+		}
+	}
+	*best_index = best_i;
+	return best;
+}
+
+bool any_iou_above_scalar(const float *x0, const float *y0, const float *x1, const float *y1,
+			  const float *area, size_t count, const float box[4], float box_area,
+			  float threshold)
+{
+	for (size_t j = 0; j < count; ++j) {
+		const float iw = (box[2] < x1[j] ? box[2] : x1[j]) - (box[0] > x0[j] ? box[0] : x0[j]);
+		const float ih = (box[3] < y1[j] ? box[3] : y1[j]) - (box[1] > y0[j] ? box[1] : y0[j]);
+		const float inter = (iw > 0.0f && ih > 0.0f) ? iw * ih : 0.0f;
+		const float uni = box_area + area[j] - inter;
+		if (uni > 0.0f && inter / uni > threshold) {
+			return true;
+		}
+	}
+	return false;
+}
+
+void bgra_blend_over_scalar(uint8_t *dst, const uint8_t *overlay, size_t count)
+{
+	for (size_t i = 0; i < count; ++i) {
+		uint8_t *d = dst + i * 4;
+		const uint8_t *o = overlay + i * 4;
+		const unsigned a = o[3];
+		for (int c = 0; c < 3; ++c) {
+			const unsigned v = (unsigned)o[c] * a + (unsigned)d[c] * (255u - a);
+			d[c] = (uint8_t)DETECT_DIV255(v);
+		}
+		d[3] = (uint8_t)(a + DETECT_DIV255((unsigned)d[3] * (255u - a)));
+	}
+}
+
+size_t count_absdiff_above_scalar(const uint8_t *a, const uint8_t *b, size_t count,
+				  uint8_t threshold)
+{
+	size_t above = 0;
+	for (size_t i = 0; i < count; ++i) {
+		const int diff = (int)a[i] - (int)b[i];
+		above += (size_t)((diff < 0 ? -diff : diff) > (int)threshold);
+	}
+	return above;
+}
+
+} // namespace
+
+const detect_kernels scalar_kernel_table = {
+	"scalar",
+	hwc_u8_to_chw_f32_scalar,
+	hwc_u8_to_chw_u8_scalar,
+	max_scaled_score_scalar,
+	any_iou_above_scalar,
+	bgra_blend_over_scalar,
+	count_absdiff_above_scalar,
+};
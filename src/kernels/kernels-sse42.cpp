@@ -0,0 +1,247 @@
+#include "kernels-variants.h"
+
+#ifdef DETECT_KERNELS_X86
+
+#include <immintrin.h>
+
+namespace {
+
+DETECT_TARGET("sse4.2")
+void hwc_u8_to_chw_f32_sse42(const uint8_t *src, size_t src_step, int width, int height,
+			     int src_channels, float *dst)
+{
+	if (src_channels != 3 && src_channels != 4) {
+		scalar_kernel_table.hwc_u8_to_chw_f32(src, src_step, width, height, src_channels,
+						      dst);
+		return;
+	}
+
+	const __m128i shuffle =
+		src_channels == 4
+			? _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)
+			: _mm_setr_epi8(0, 3, 6, 9, 1, 4, 7, 10, 2, 5, 8, 11, -1, -1, -1, -1);
+	// one 16 byte load per 4 pixels, BGR rows need 2 extra pixels so the load stays inside
+	const int lookahead = src_channels == 4 ? 4 : 6;
+	const size_t plane = (size_t)width * (size_t)height;
+
+	for (int y = 0; y < height; ++y) {
+		const uint8_t *row = src + (size_t)y * src_step;
+		float *dst_b = dst + (size_t)y * (size_t)width;
+		float *dst_g = dst_b + plane;
+		float *dst_r = dst_g + plane;
+		int x = 0;
+		for (; x + lookahead <= width; x += 4) {
+			const __m128i v = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *)(row + x * src_channels)),
+				shuffle);
+			_mm_storeu_ps(dst_b + x, _mm_cvtepi32_ps(_mm_cvtepu8_epi32(v)));
+			_mm_storeu_ps(dst_g + x,
+				      _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 4))));
+			_mm_storeu_ps(dst_r + x,
+				      _mm_cvtepi32_ps(_mm_cvtepu8_epi32(_mm_srli_si128(v, 8))));
+		}
+		hwc_u8_to_chw_f32_tail(row, x, width, src_channels, dst_b, dst_g, dst_r);
+	}
+}
+
+} // namespace
+
+DETECT_TARGET("sse4.2")
+void hwc_u8_to_chw_u8_sse42(const uint8_t *src, size_t src_step, int width, int height,
+			    int src_channels, uint8_t *dst, uint8_t xor_mask)
+{
+	if (src_channels != 3 && src_channels != 4) {
+		scalar_kernel_table.hwc_u8_to_chw_u8(src, src_step, width, height, src_channels,
+						     dst, xor_mask);
+		return;
+	}
+
+	const __m128i shuffle =
+		src_channels == 4
+			? _mm_setr_epi8(0, 4, 8, 12, 1, 5, 9, 13, 2, 6, 10, 14, 3, 7, 11, 15)
+			: _mm_setr_epi8(0, 3, 6, 9, 1, 4, 7, 10, 2, 5, 8, 11, -1, -1, -1, -1);
+	const __m128i vxor = _mm_set1_epi8((char)xor_mask);
+	// four 16 byte loads per 16 pixels, BGR rows need 2 extra pixels for the last load
+	const int lookahead = src_channels == 4 ? 16 : 18;
+	const size_t step4 = (size_t)src_channels * 4;
+	const size_t plane = (size_t)width * (size_t)height;
+
+	for (int y = 0; y < height; ++y) {
+		const uint8_t *row = src + (size_t)y * src_step;
+		uint8_t *dst_b = dst + (size_t)y * (size_t)width;
+		uint8_t *dst_g = dst_b + plane;
+		uint8_t *dst_r = dst_g + plane;
+		int x = 0;
+		for (; x + lookahead <= width; x += 16) {
+			const uint8_t *p = row + x * src_channels;
+			const __m128i s0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)p),
+							    shuffle);
+			const __m128i s1 = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *)(p + step4)), shuffle);
+			const __m128i s2 = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *)(p + 2 * step4)), shuffle);
+			const __m128i s3 = _mm_shuffle_epi8(
+				_mm_loadu_si128((const __m128i *)(p + 3 * step4)), shuffle);
+			const __m128i bg_a = _mm_unpacklo_epi32(s0, s1);
+			const __m128i ra_a = _mm_unpackhi_epi32(s0, s1);
+			const __m128i bg_b = _mm_unpacklo_epi32(s2, s3);
+			const __m128i ra_b = _mm_unpackhi_epi32(s2, s3);
+			_mm_storeu_si128((__m128i *)(dst_b + x),
+					 _mm_xor_si128(_mm_unpacklo_epi64(bg_a, bg_b), vxor));
+			_mm_storeu_si128((__m128i *)(dst_g + x),
+					 _mm_xor_si128(_mm_unpackhi_epi64(bg_a, bg_b), vxor));
+			_mm_storeu_si128((__m128i *)(dst_r + x),
+					 _mm_xor_si128(_mm_unpacklo_epi64(ra_a, ra_b), vxor));
+		}
+		hwc_u8_to_chw_u8_tail(row, x, width, src_channels, dst_b, dst_g, dst_r, xor_mask);
+	}
+}
+
+namespace {
+
+DETECT_TARGET("sse4.2")
+float max_scaled_score_sse42(const float *scores, int count, float scale, int *best_index)
+{
+	const __m128 vscale = _mm_set1_ps(scale);
+	__m128 vmax = _mm_setzero_ps();
+	int i = 0;
+	for (; i + 4 <= count; i += 4) {
+		// operand order keeps NaN products out of the running max, like the scalar '>'
+		vmax = _mm_max_ps(_mm_mul_ps(vscale, _mm_loadu_ps(scores + i)), vmax);
+	}
+	float lanes[4];
+	_mm_storeu_ps(lanes, vmax);
+	float best = 0.0f;
+	for (float lane : lanes) {
+		if (lane > best) {
+			best = lane;
+		}
+	}
+	for (; i < count; ++i) {
+		const float p = scale * scores[i];
+		if (p > best) {
+			best = p;
+		}
+	}
+
+	*best_index = 0;
+	if (!(best > 0.0f)) {
+		return 0.0f;
+	}
+	for (int k = 0; k < count; ++k) {
+		if (scale * scores[k] == best) {
+			*best_index = k;
+			break;
+		}
+	}
+	return best;
+}
+
+DETECT_TARGET("sse4.2")
+bool any_iou_above_sse42(const float *x0, const float *y0, const float *x1, const float *y1,
+			 const float *area, size_t count, const float box[4], float box_area,
+			 float threshold)
+{
+	const __m128 bx0 = _mm_set1_ps(box[0]);
+	const __m128 by0 = _mm_set1_ps(box[1]);
+	const __m128 bx1 = _mm_set1_ps(box[2]);
+	const __m128 by1 = _mm_set1_ps(box[3]);
+	const __m128 barea = _mm_set1_ps(box_area);
+	const __m128 thresh = _mm_set1_ps(threshold);
+	const __m128 zero = _mm_setzero_ps();
+
+	size_t j = 0;
+	for (; j + 4 <= count; j += 4) {
+		const __m128 iw = _mm_sub_ps(_mm_min_ps(bx1, _mm_loadu_ps(x1 + j)),
+					     _mm_max_ps(bx0, _mm_loadu_ps(x0 + j)));
+		const __m128 ih = _mm_sub_ps(_mm_min_ps(by1, _mm_loadu_ps(y1 + j)),
+					     _mm_max_ps(by0, _mm_loadu_ps(y0 + j)));
+		const __m128 valid = _mm_and_ps(_mm_cmpgt_ps(iw, zero), _mm_cmpgt_ps(ih, zero));
+		const __m128 inter = _mm_and_ps(valid, _mm_mul_ps(iw, ih));
+		const __m128 uni = _mm_sub_ps(_mm_add_ps(barea, _mm_loadu_ps(area + j)), inter);
+		const __m128 hit = _mm_and_ps(_mm_cmpgt_ps(uni, zero),
+					      _mm_cmpgt_ps(_mm_div_ps(inter, uni), thresh));
+		if (_mm_movemask_ps(hit) != 0) {
+			return true;
+		}
+	}
+	return scalar_kernel_table.any_iou_above(x0 + j, y0 + j, x1 + j, y1 + j, area + j,
+						 count - j, box, box_area, threshold);
+}
+
+DETECT_TARGET("sse4.2")
+inline __m128i blend_half_sse42(__m128i o16, __m128i d16, __m128i a16)
+{
+	const __m128i v = _mm_add_epi16(
+		_mm_mullo_epi16(o16, a16),
+		_mm_mullo_epi16(d16, _mm_sub_epi16(_mm_set1_epi16(255), a16)));
+	const __m128i t = _mm_add_epi16(v, _mm_set1_epi16(128));
+	return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+DETECT_TARGET("sse4.2")
+void bgra_blend_over_sse42(uint8_t *dst, const uint8_t *overlay, size_t count)
+{
+	const __m128i alpha_shuffle =
+		_mm_setr_epi8(3, 3, 3, 3, 7, 7, 7, 7, 11, 11, 11, 11, 15, 15, 15, 15);
+	const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+	const __m128i zero = _mm_setzero_si128();
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const __m128i d = _mm_loadu_si128((const __m128i *)(dst + i * 4));
+		const __m128i o = _mm_loadu_si128((const __m128i *)(overlay + i * 4));
+		const __m128i a = _mm_shuffle_epi8(o, alpha_shuffle);
+		// blending 255 into the alpha channel gives a + (255 - a) * dst alpha / 255
+		const __m128i ov = _mm_or_si128(o, alpha_mask);
+		const __m128i lo = blend_half_sse42(_mm_unpacklo_epi8(ov, zero),
+						    _mm_unpacklo_epi8(d, zero),
+						    _mm_unpacklo_epi8(a, zero));
+		const __m128i hi = blend_half_sse42(_mm_unpackhi_epi8(ov, zero),
+						    _mm_unpackhi_epi8(d, zero),
+						    _mm_unpackhi_epi8(a, zero));
+		_mm_storeu_si128((__m128i *)(dst + i * 4), _mm_packus_epi16(lo, hi));
+	}
+	scalar_kernel_table.bgra_blend_over(dst + i * 4, overlay + i * 4, count - i);
+}
+
+DETECT_TARGET("sse4.2")
+size_t count_absdiff_above_sse42(const uint8_t *a, const uint8_t *b, size_t count,
+				 uint8_t threshold)
+{
+	const __m128i thr = _mm_set1_epi8((char)threshold);
+	const __m128i zero = _mm_setzero_si128();
+
+	// per-lane counters of the positions at or below the threshold, summed up before
+	// they can wrap
+	size_t i = 0;
+	size_t within = 0;
+	while (i + 16 <= count) {
+		__m128i acc = zero;
+		for (int block = 0; block < 255 && i + 16 <= count; ++block, i += 16) {
+			const __m128i va = _mm_loadu_si128((const __m128i *)(a + i));
+			const __m128i vb = _mm_loadu_si128((const __m128i *)(b + i));
+			const __m128i diff = _mm_or_si128(_mm_subs_epu8(va, vb), _mm_subs_epu8(vb, va));
+			acc = _mm_sub_epi8(acc, _mm_cmpeq_epi8(_mm_subs_epu8(diff, thr), zero));
+		}
+		const __m128i sums = _mm_sad_epu8(acc, zero);
+		within += (size_t)_mm_cvtsi128_si32(sums) +
+			  (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+	}
+	return i - within +
+	       scalar_kernel_table.count_absdiff_above(a + i, b + i, count - i, threshold);
+}
+
+} // namespace
+
+const detect_kernels sse42_kernel_table = {
+	"sse4.2",
+	hwc_u8_to_chw_f32_sse42,
+	hwc_u8_to_chw_u8_sse42,
+	max_scaled_score_sse42,
+	any_iou_above_sse42,
+	bgra_blend_over_sse42,
+	count_absdiff_above_sse42,
+};
+
+#endif // DETECT_KERNELS_X86
@@ -0,0 +1,57 @@
+#ifndef DETECT_KERNELS_VARIANTS_H
+#define DETECT_KERNELS_VARIANTS_H
+
+#include "kernels.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define DETECT_KERNELS_X86 1
+#endif
+
+// The SIMD variants are compiled with per-function target attributes instead of per-file
+// compiler flags, so the rest of the plugin keeps targeting the baseline ISA and universal
+// (x86_64 + arm64) macOS builds keep working. MSVC accepts the intrinsics without flags.
+#if defined(__GNUC__) || defined(__clang__)
+#define DETECT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define DETECT_TARGET(isa)
+#endif
+
+// Exact rounding division by 255 for 0 <= v <= 255 * 255, shared by all blend variants
+#define DETECT_DIV255(v) (((v) + 128 + (((v) + 128) >> 8)) >> 8)
+
+// Scalar tail shared by the SIMD pre-processing variants
+static inline void hwc_u8_to_chw_f32_tail(const uint8_t *row, int x, int width, int src_channels,
+					  float *dst_b, float *dst_g, float *dst_r)
+{
+	for (; x < width; ++x) {
+		const uint8_t *px = row + (size_t)x * (size_t)src_channels;
+		dst_b[x] = (float)px[0];
+		dst_g[x] = (float)px[1];
+		dst_r[x] = (float)px[2];
+	}
+}
+
+static inline void hwc_u8_to_chw_u8_tail(const uint8_t *row, int x, int width, int src_channels,
+					 uint8_t *dst_b, uint8_t *dst_g, uint8_t *dst_r,
+					 uint8_t xor_mask)
+{
+	for (; x < width; ++x) {
+		const uint8_t *px = row + (size_t)x * (size_t)src_channels;
+		dst_b[x] = (uint8_t)(px[0] ^ xor_mask);
+		dst_g[x] = (uint8_t)(px[1] ^ xor_mask);
+		dst_r[x] = (uint8_t)(px[2] ^ xor_mask);
+	}
+}
+
+extern const detect_kernels scalar_kernel_table;
+#ifdef DETECT_KERNELS_X86
+extern const detect_kernels sse42_kernel_table;
+extern const detect_kernels avx2_kernel_table;
+extern const detect_kernels avx512_kernel_table;
+
+// 8-bit planes are bound by memory bandwidth, the wider variants share the SSE4.2 one
+void hwc_u8_to_chw_u8_sse42(const uint8_t *src, size_t src_step, int width, int height,
+			    int src_channels, uint8_t *dst, uint8_t xor_mask);
+#endif
+
+#endif /* DETECT_KERNELS_VARIANTS_H */
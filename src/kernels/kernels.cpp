@@ -0,0 +1,118 @@
+#include "kernels-variants.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#if defined(DETECT_KERNELS_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#include <obs.h>
+
+#include "plugin-support.h"
+
+namespace {
+
+struct cpu_features {
+	bool sse42 = false;
+	bool avx2 = false;
+	bool avx512 = false;
+};
+
+cpu_features detect_cpu_features()
+{
+	cpu_features features;
+#if defined(DETECT_KERNELS_X86) && defined(_MSC_VER)
+	int info[4];
+	__cpuid(info, 0);
+	const int max_leaf = info[0];
+	if (max_leaf < 1) {
+		return features;
+	}
+	__cpuid(info, 1);
+	features.sse42 = (info[2] & (1 << 20)) != 0;
+	const bool osxsave = (info[2] & (1 << 27)) != 0;
+	const bool avx = (info[2] & (1 << 28)) != 0;
+	// the OS has to save the YMM (and ZMM) state for us to use the wide registers
+	const unsigned long long xcr0 = (osxsave && avx) ? _xgetbv(0) : 0;
+	if (max_leaf >= 7) {
+		__cpuidex(info, 7, 0);
+		features.avx2 = (xcr0 & 0x6) == 0x6 && (info[1] & (1 << 5)) != 0;
+		features.avx512 = (xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16)) != 0 &&
+				  (info[1] & (1 << 30)) != 0;
+	}
+#elif defined(DETECT_KERNELS_X86)
+	__builtin_cpu_init();
+	features.sse42 = __builtin_cpu_supports("sse4.2");
+	features.avx2 = __builtin_cpu_supports("avx2");
+	features.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+#endif
+	return features;
+}
+
+std::atomic<const detect_kernels *> selected_kernels{&scalar_kernel_table};
+
+} // namespace
+
+const detect_kernels &kernels()
+{
+	return *selected_kernels.load(std::memory_order_relaxed);
+}
+
+const detect_kernels &scalar_kernels()
+{
+	return scalar_kernel_table;
+}
+
+std::vector<const detect_kernels *> supported_kernel_variants()
+{
+	std::vector<const detect_kernels *> variants = {&scalar_kernel_table};
+#ifdef DETECT_KERNELS_X86
+	const cpu_features features = detect_cpu_features();
+	if (features.sse42) {
+		variants.push_back(&sse42_kernel_table);
+	}
+	if (features.avx2) {
+		variants.push_back(&avx2_kernel_table);
+	}
+	if (features.avx512) {
+		variants.push_back(&avx512_kernel_table);
+	}
+#endif
+	return variants;
+}
+
+void detect_kernels_init(void)
+{
+	const std::vector<const detect_kernels *> variants = supported_kernel_variants();
+	const detect_kernels *selected = variants.back();
+
+	// OBS_DETECT_KERNELS=scalar|sse4.2|avx2|avx512 forces a (supported) variant
+	const char *forced = getenv("OBS_DETECT_KERNELS");
+	if (forced != nullptr && forced[0] != '\0') {
+		bool found = false;
+		for (const detect_kernels *variant : variants) {
+			if (strcmp(variant->name, forced) == 0) {
+				selected = variant;
+				found = true;
+			}
+		}
+		if (!found) {
+			obs_log(LOG_WARNING, "Kernel variant '%s' is not supported on this CPU",
+				forced);
+		}
+	}
+
+	selected_kernels.store(selected, std::memory_order_relaxed);
+
+	std::string available;
+	for (const detect_kernels *variant : variants) {
+		available += available.empty() ? "" : ", ";
+		available += variant->name;
+	}
+	obs_log(LOG_INFO, "Selected '%s' kernels (supported: %s)", selected->name,
+		available.c_str());
+}
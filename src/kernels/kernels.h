@@ -0,0 +1,82 @@
+#ifndef DETECT_KERNELS_H
+#define DETECT_KERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Table of the hot per-pixel / per-box kernels.
+ *
+ * Every variant must produce exactly the same results as the scalar reference, the SIMD
+ * variants only change how fast they get there.
+ */
+struct detect_kernels {
+	const char *name;
+
+	/**
+	 * Convert interleaved 8-bit BGR or BGRA pixels (the alpha channel is ignored) into
+	 * planar float CHW layout, as expected by the model input tensor.
+	 */
+	void (*hwc_u8_to_chw_f32)(const uint8_t *src, size_t src_step, int width, int height,
+				  int src_channels, float *dst);
+
+	/**
+	 * Same as hwc_u8_to_chw_f32 but keeps 8-bit planes, XOR-ing every value with `xor_mask`
+	 * (0 for uint8 tensors, 0x80 to shift into the int8 range).
+	 */
+	void (*hwc_u8_to_chw_u8)(const uint8_t *src, size_t src_step, int width, int height,
+				 int src_channels, uint8_t *dst, uint8_t xor_mask);
+
+	/**
+	 * Find the largest `scale * scores[i]`. Returns the max (0 if no product is positive) and
+	 * writes the first index reaching it to `best_index`.
+	 */
+	float (*max_scaled_score)(const float *scores, int count, float scale, int *best_index);
+
+	/**
+	 * Check whether `box` (x0, y0, x1, y1) overlaps any of the `count` boxes, given as
+	 * structure-of-arrays, with an IoU above `threshold`.
+	 */
+	bool (*any_iou_above)(const float *x0, const float *y0, const float *x1, const float *y1,
+			      const float *area, size_t count, const float box[4], float box_area,
+			      float threshold);
+
+	/**
+	 * Composite a straight-alpha BGRA overlay over a BGRA destination ("source over"),
+	 * `count` pixels. The destination's alpha is composited too, so an overlay drawn on
+	 * transparent black comes out premultiplied.
+	 */
+	void (*bgra_blend_over)(uint8_t *dst, const uint8_t *overlay, size_t count);
+
+	/**
+	 * Count the positions where two 8-bit buffers differ by more than `threshold`.
+	 */
+	size_t (*count_absdiff_above)(const uint8_t *a, const uint8_t *b, size_t count,
+				      uint8_t threshold);
+};
+
+/**
+ * @brief The selected kernel variant (scalar until detect_kernels_init has run).
+ */
+const detect_kernels &kernels();
+
+/**
+ * @brief The scalar reference kernels.
+ */
+const detect_kernels &scalar_kernels();
+
+/**
+ * @brief All kernel variants the host CPU can run, scalar first.
+ */
+std::vector<const detect_kernels *> supported_kernel_variants();
+
+extern "C" {
+/**
+ * @brief Detect the CPU features once and select the best kernel variant.
+ * Called from obs_module_load, logs the selected variant.
+ */
+void detect_kernels_init(void);
+}
+
+#endif /* DETECT_KERNELS_H */
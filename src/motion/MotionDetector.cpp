@@ -0,0 +1,38 @@
+#include "MotionDetector.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+
+#include "kernels/kernels.h"
+
+void MotionDetector::makeThumbnail(const cv::Mat &bgra, cv::Mat &thumbnail)
+{
+	const int width = std::min(THUMBNAIL_WIDTH, bgra.cols);
+	const int height = std::max(1, (int)((int64_t)bgra.rows * width / std::max(bgra.cols, 1)));
+	cv::Mat small;
+	// area averaging also takes the sensor noise out of the difference
+	cv::resize(bgra, small, cv::Size(width, height), 0, 0, cv::INTER_AREA);
+	cv::cvtColor(small, thumbnail, cv::COLOR_BGRA2GRAY);
+}
+
+double MotionDetector::changedFraction(const cv::Mat &thumbnail, const cv::Rect &roi,
+				       uint8_t pixel_threshold) const
+{
+	if (reference_.empty() || reference_.size() != thumbnail.size()) {
+		return 1.0;
+	}
+	const cv::Rect area = roi & cv::Rect(0, 0, thumbnail.cols, thumbnail.rows);
+	if (area.area() == 0) {
+		return 0.0;
+	}
+
+	const detect_kernels &k = kernels();
+	size_t changed = 0;
+	for (int y = area.y; y < area.y + area.height; ++y) {
+		changed += k.count_absdiff_above(thumbnail.ptr<uint8_t>(y) + area.x,
+						 reference_.ptr<uint8_t>(y) + area.x,
+						 (size_t)area.width, pixel_threshold);
+	}
+	return (double)changed / (double)area.area();
+}
@@ -0,0 +1,37 @@
+#ifndef MOTION_DETECTOR_H
+#define MOTION_DETECTOR_H
+
+#include <opencv2/core.hpp>
+
+/**
+ * Frame differencing on a tiny luma thumbnail, cheap enough to run on every captured frame.
+ *
+ * The thumbnail is compared with a reference, normally the thumbnail of the last frame that
+ * went to inference, so slow changes add up instead of slipping under the threshold frame by
+ * frame.
+ */
+class MotionDetector {
+public:
+	static constexpr int THUMBNAIL_WIDTH = 160;
+
+	// Downscaled 8-bit luma copy of a BGRA frame, THUMBNAIL_WIDTH wide
+	static void makeThumbnail(const cv::Mat &bgra, cv::Mat &thumbnail);
+
+	/**
+	 * Fraction of the thumbnail pixels inside roi that differ from the reference by more
+	 * than pixel_threshold.
+	 *
+	 * @param roi In thumbnail coordinates, clipped to the thumbnail.
+	 * @return 1 when there is no reference of the same size.
+	 */
+	double changedFraction(const cv::Mat &thumbnail, const cv::Rect &roi,
+			       uint8_t pixel_threshold) const;
+
+	void setReference(const cv::Mat &thumbnail) { thumbnail.copyTo(reference_); }
+	void reset() { reference_.release(); }
+
+private:
+	cv::Mat reference_;
+};
+
+#endif /* MOTION_DETECTOR_H */
@@ -0,0 +1,34 @@
+#include "SceneCutDetector.h"
+
+#include <cmath>
+
+bool SceneCutDetector::update(const cv::Mat &thumbnail, float threshold)
+{
+	if (thumbnail.empty()) {
+		return false;
+	}
+
+	std::array<uint32_t, HISTOGRAM_BINS> counts{};
+	for (int y = 0; y < thumbnail.rows; ++y) {
+		const uint8_t *row = thumbnail.ptr<uint8_t>(y);
+		for (int x = 0; x < thumbnail.cols; ++x) {
+			counts[row[x] * HISTOGRAM_BINS / 256]++;
+		}
+	}
+	std::array<float, HISTOGRAM_BINS> histogram{};
+	const float total = (float)thumbnail.total();
+	for (int i = 0; i < HISTOGRAM_BINS; ++i) {
+		histogram[i] = (float)counts[i] / total;
+	}
+
+	float distance = 0.0f;
+	for (int i = 0; i < HISTOGRAM_BINS; ++i) {
+		distance += std::fabs(histogram[i] - previous_[i]);
+	}
+	distance *= 0.5f;
+
+	const bool cut = has_previous_ && distance > threshold;
+	previous_ = histogram;
+	has_previous_ = true;
+	return cut;
+}
@@ -0,0 +1,34 @@
+#ifndef SCENE_CUT_DETECTOR_H
+#define SCENE_CUT_DETECTOR_H
+
+#include <opencv2/core.hpp>
+
+#include <array>
+
+/**
+ * Hard cut detection from the luma histograms of consecutive thumbnails.
+ *
+ * A histogram ignores motion inside the picture, a cut to a different shot changes the
+ * brightness distribution as a whole.
+ */
+class SceneCutDetector {
+public:
+	static constexpr int HISTOGRAM_BINS = 32;
+
+	/**
+	 * Compare the thumbnail with the one from the previous call.
+	 *
+	 * @param threshold Total variation distance of the normalized histograms (0..1) above
+	 *                  which the change counts as a cut.
+	 * @return false for the first thumbnail.
+	 */
+	bool update(const cv::Mat &thumbnail, float threshold);
+
+	void reset() { has_previous_ = false; }
+
+private:
+	std::array<float, HISTOGRAM_BINS> previous_{};
+	bool has_previous_ = false;
+};
+
+#endif /* SCENE_CUT_DETECTOR_H */
@@ -29,48 +29,146 @@ void create_config_folder()
 	}
 }
 
-int getConfig(config_t **config)
+int getConfig(config_t **config, bool create = false)
 {
 	create_config_folder(); // ensure the config folder exists
 
 	// Get the config file
 	char *config_file_path = obs_module_config_path("config.ini");
 
-	int ret = config_open(config, config_file_path, CONFIG_OPEN_EXISTING);
+	// writers create the file on first use, readers fall back to their defaults
+	int ret = config_open(config, config_file_path,
+			      create ? CONFIG_OPEN_ALWAYS : CONFIG_OPEN_EXISTING);
 	if (ret != CONFIG_SUCCESS) {
 		obs_log(LOG_INFO, "Failed to open config file %s", config_file_path);
+		bfree(config_file_path);
 		return OBS_BGREMOVAL_CONFIG_FAIL;
 	}
+	bfree(config_file_path);
 
 	return OBS_BGREMOVAL_CONFIG_SUCCESS;
 }
 
-int getFlagFromConfig(const char *name, bool *returnValue, bool defaultValue)
+namespace {
+
+const char *const CONFIG_SECTION = "config";
+
+template<typename Read> int readConfig(const char *section, const char *name, Read read)
 {
-	// Get the config file
 	config_t *config;
 	if (getConfig(&config) != OBS_BGREMOVAL_CONFIG_SUCCESS) {
-		*returnValue = defaultValue;
 		return OBS_BGREMOVAL_CONFIG_FAIL;
 	}
 
-	*returnValue = config_get_bool(config, "config", name);
+	int ret = OBS_BGREMOVAL_CONFIG_FAIL;
+	if (config_has_user_value(config, section, name) && read(config)) {
+		ret = OBS_BGREMOVAL_CONFIG_SUCCESS;
+	}
 	config_close(config);
 
-	return OBS_BGREMOVAL_CONFIG_SUCCESS;
+	return ret;
 }
 
-int setFlagInConfig(const char *name, const bool value)
+template<typename Write> int writeConfig(Write write)
 {
-	// Get the config file
 	config_t *config;
-	if (getConfig(&config) != OBS_BGREMOVAL_CONFIG_SUCCESS) {
+	if (getConfig(&config, true) != OBS_BGREMOVAL_CONFIG_SUCCESS) {
 		return OBS_BGREMOVAL_CONFIG_FAIL;
 	}
 
-	config_set_bool(config, "config", name, value);
-	config_save(config);
+	write(config);
+	// write to a temporary file first so a crash cannot leave a truncated config behind
+	const int ret = config_save_safe(config, "tmp", nullptr) == CONFIG_SUCCESS
+				? OBS_BGREMOVAL_CONFIG_SUCCESS
+				: OBS_BGREMOVAL_CONFIG_FAIL;
 	config_close(config);
 
-	return OBS_BGREMOVAL_CONFIG_SUCCESS;
+	return ret;
+}
+
+} // namespace
+
+int getFlagFromConfig(const char *name, bool *returnValue, bool defaultValue)
+{
+	*returnValue = defaultValue;
+	return readConfig(CONFIG_SECTION, name, [&](config_t *config) {
+		*returnValue = config_get_bool(config, CONFIG_SECTION, name);
+		return true;
+	});
+}
+
+int setFlagInConfig(const char *name, const bool value)
+{
+	return writeConfig(
+		[&](config_t *config) { config_set_bool(config, CONFIG_SECTION, name, value); });
+}
+
+int getIntFromConfig(const char *name, int64_t *returnValue, int64_t defaultValue)
+{
+	*returnValue = defaultValue;
+	return readConfig(CONFIG_SECTION, name, [&](config_t *config) {
+		*returnValue = config_get_int(config, CONFIG_SECTION, name);
+		return true;
+	});
+}
+
+int setIntInConfig(const char *name, int64_t value)
+{
+	return writeConfig(
+		[&](config_t *config) { config_set_int(config, CONFIG_SECTION, name, value); });
+}
+
+int getDoubleFromConfig(const char *name, double *returnValue, double defaultValue)
+{
+	*returnValue = defaultValue;
+	return readConfig(CONFIG_SECTION, name, [&](config_t *config) {
+		*returnValue = config_get_double(config, CONFIG_SECTION, name);
+		return true;
+	});
+}
+
+int setDoubleInConfig(const char *name, double value)
+{
+	return writeConfig(
+		[&](config_t *config) { config_set_double(config, CONFIG_SECTION, name, value); });
+}
+
+int getStringFromConfig(const char *name, std::string *returnValue,
+			const std::string &defaultValue)
+{
+	*returnValue = defaultValue;
+	return readConfig(CONFIG_SECTION, name, [&](config_t *config) {
+		const char *value = config_get_string(config, CONFIG_SECTION, name);
+		*returnValue = value ? value : "";
+		return true;
+	});
+}
+
+int setStringInConfig(const char *name, const std::string &value)
+{
+	return writeConfig([&](config_t *config) {
+		config_set_string(config, CONFIG_SECTION, name, value.c_str());
+	});
+}
+
+int getJsonFromConfig(const char *section, const char *name, nlohmann::json *returnValue)
+{
+	return readConfig(section, name, [&](config_t *config) {
+		const char *value = config_get_string(config, section, name);
+		nlohmann::json parsed = nlohmann::json::parse(value ? value : "", nullptr, false);
+		if (parsed.is_discarded()) {
+			obs_log(LOG_WARNING, "Ignoring malformed config value %s.%s", section, name);
+			return false;
+		}
+		*returnValue = std::move(parsed);
+		return true;
+	});
+}
+
+int setJsonInConfig(const char *section, const char *name, const nlohmann::json &value)
+{
+	const std::string serialized = value.dump();
+	return writeConfig([&](config_t *config) {
+		config_set_string(config, section, name, serialized.c_str());
+	});
 }
@@ -1,6 +1,11 @@
 #ifndef OBS_CONFIG_UTILS_H
 #define OBS_CONFIG_UTILS_H
 
+#include <cstdint>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
 enum {
 	OBS_BGREMOVAL_CONFIG_SUCCESS = 0,
 	OBS_BGREMOVAL_CONFIG_FAIL = 1,
@@ -27,4 +32,91 @@ int getFlagFromConfig(const char *name, bool *returnValue, bool defaultValue);
  */
 int setFlagInConfig(const char *name, const bool value);
 
+/**
+ * Get an integer from the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param returnValue The value of the config item, defaultValue if it is not set.
+ * @param defaultValue The default value of the config item.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config item was found,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int getIntFromConfig(const char *name, int64_t *returnValue, int64_t defaultValue);
+
+/**
+ * Set an integer in the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param value The value of the config item.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config item was saved,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int setIntInConfig(const char *name, int64_t value);
+
+/**
+ * Get a floating point number from the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param returnValue The value of the config item, defaultValue if it is not set.
+ * @param defaultValue The default value of the config item.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config item was found,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int getDoubleFromConfig(const char *name, double *returnValue, double defaultValue);
+
+/**
+ * Set a floating point number in the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param value The value of the config item.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config item was saved,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int setDoubleInConfig(const char *name, double value);
+
+/**
+ * Get a string from the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param returnValue The value of the config item, defaultValue if it is not set.
+ * @param defaultValue The default value of the config item.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config item was found,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int getStringFromConfig(const char *name, std::string *returnValue,
+			const std::string &defaultValue);
+
+/**
+ * Set a string in the module configuration file.
+ *
+ * @param name The name of the config item.
+ * @param value The value of the config item.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config item was saved,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int setStringInConfig(const char *name, const std::string &value);
+
+/**
+ * Get a structured value, stored as JSON, from a section of the module configuration file.
+ * Sections keep collections of values, e.g. one entry per model, apart from the flags.
+ *
+ * @param section The config section, e.g. "autotune".
+ * @param name The name of the config item.
+ * @param returnValue The parsed value of the config item, left untouched if it is not set.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config item was found and parsed,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int getJsonFromConfig(const char *section, const char *name, nlohmann::json *returnValue);
+
+/**
+ * Set a structured value, stored as JSON, in a section of the module configuration file.
+ *
+ * @param section The config section, e.g. "autotune".
+ * @param name The name of the config item.
+ * @param value The value of the config item.
+ * @return OBS_BGREMOVAL_CONFIG_SUCCESS if the config item was saved,
+ * OBS_BGREMOVAL_CONFIG_FAIL otherwise.
+ */
+int setJsonInConfig(const char *section, const char *name, const nlohmann::json &value);
+
 #endif /* OBS_CONFIG_UTILS_H */
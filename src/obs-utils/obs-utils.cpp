@@ -63,7 +63,8 @@ bool getRGBAFromStageSurface(filter_data *tf, uint32_t &width, uint32_t &height)
 	}
 	{
 		std::lock_guard<std::mutex> lock(tf->inputBGRALock);
-		tf->inputBGRA = cv::Mat(height, width, CV_8UC4, video_data, linesize);
+		// copy out before unmapping, the mapped memory is gone afterwards; the buffer is reused
+		cv::Mat(height, width, CV_8UC4, video_data, linesize).copyTo(tf->inputBGRA);
 	}
 	gs_stagesurface_unmap(tf->stagesurface);
 	return true;
@@ -0,0 +1,246 @@
+#include "ExecutionProviders.h"
+
+#include "plugin-support.h"
+#include "consts.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+
+struct execution_provider {
+	const char *device;   // USEGPU_* value
+	const char *ort_name; // as listed by Ort::GetAvailableProviders()
+	void (*append)(Ort::SessionOptions &session_options, const ExecutionProviderOptions &options,
+		       int device_id, int num_threads);
+};
+
+std::string trim(const std::string &s)
+{
+	const size_t begin = s.find_first_not_of(" \t");
+	if (begin == std::string::npos) {
+		return std::string();
+	}
+	return s.substr(begin, s.find_last_not_of(" \t") - begin + 1);
+}
+
+void append_cpu(Ort::SessionOptions &session_options, const ExecutionProviderOptions &options,
+		int device_id, int num_threads)
+{
+	UNUSED_PARAMETER(device_id);
+	UNUSED_PARAMETER(num_threads);
+	// the CPU provider is always registered last by ONNX Runtime, only its arena is tunable
+	auto arena = options.find("use_arena");
+	if (arena != options.end()) {
+		if (arena->second == "0") {
+			session_options.DisableCpuMemArena();
+		} else {
+			session_options.EnableCpuMemArena();
+		}
+	}
+}
+
+void append_xnnpack(Ort::SessionOptions &session_options, const ExecutionProviderOptions &options,
+		    int device_id, int num_threads)
+{
+	UNUSED_PARAMETER(device_id);
+	ExecutionProviderOptions xnnpack_options = options;
+	if (xnnpack_options.count("intra_op_num_threads") == 0) {
+		const int threads =
+			num_threads > 0 ? num_threads : (int)std::thread::hardware_concurrency();
+		xnnpack_options["intra_op_num_threads"] = std::to_string(std::max(threads, 1));
+	}
+	session_options.AppendExecutionProvider("XNNPACK", xnnpack_options);
+	// XNNPACK runs its own thread pool, a spinning ORT pool next to it only steals cores
+	session_options.SetIntraOpNumThreads(1);
+	session_options.AddConfigEntry("session.intra_op.allow_spinning", "0");
+}
+
+template<typename T>
+void update_provider_options(T *provider_options,
+			     OrtStatus *(ORT_API_CALL *update)(T *, const char *const *,
+							       const char *const *, size_t),
+			     const ExecutionProviderOptions &options)
+{
+	std::vector<const char *> keys, values;
+	for (const auto &option : options) {
+		keys.push_back(option.first.c_str());
+		values.push_back(option.second.c_str());
+	}
+	Ort::ThrowOnError(update(provider_options, keys.data(), values.data(), keys.size()));
+}
+
+void append_cuda(Ort::SessionOptions &session_options, const ExecutionProviderOptions &options,
+		 int device_id, int num_threads)
+{
+	UNUSED_PARAMETER(num_threads);
+	const OrtApi &api = Ort::GetApi();
+	OrtCUDAProviderOptionsV2 *cuda_options = nullptr;
+	Ort::ThrowOnError(api.CreateCUDAProviderOptions(&cuda_options));
+	std::unique_ptr<OrtCUDAProviderOptionsV2, decltype(api.ReleaseCUDAProviderOptions)> guard(
+		cuda_options, api.ReleaseCUDAProviderOptions);
+
+	ExecutionProviderOptions all_options = options;
+	all_options.emplace("device_id", std::to_string(device_id));
+	update_provider_options(cuda_options, api.UpdateCUDAProviderOptions, all_options);
+	session_options.AppendExecutionProvider_CUDA_V2(*cuda_options);
+}
+
+void append_tensorrt(Ort::SessionOptions &session_options, const ExecutionProviderOptions &options,
+		     int device_id, int num_threads)
+{
+	const OrtApi &api = Ort::GetApi();
+	OrtTensorRTProviderOptionsV2 *trt_options = nullptr;
+	Ort::ThrowOnError(api.CreateTensorRTProviderOptions(&trt_options));
+	std::unique_ptr<OrtTensorRTProviderOptionsV2, decltype(api.ReleaseTensorRTProviderOptions)>
+		guard(trt_options, api.ReleaseTensorRTProviderOptions);
+
+	ExecutionProviderOptions all_options = options;
+	all_options.emplace("device_id", std::to_string(device_id));
+	update_provider_options(trt_options, api.UpdateTensorRTProviderOptions, all_options);
+	session_options.AppendExecutionProvider_TensorRT_V2(*trt_options);
+	// nodes TensorRT cannot take still run on the GPU
+	append_cuda(session_options, ExecutionProviderOptions(), device_id, num_threads);
+}
+
+void append_dml(Ort::SessionOptions &session_options, const ExecutionProviderOptions &options,
+		int device_id, int num_threads)
+{
+	UNUSED_PARAMETER(session_options);
+	UNUSED_PARAMETER(options);
+	UNUSED_PARAMETER(device_id);
+	UNUSED_PARAMETER(num_threads);
+	throw std::runtime_error("DirectML (DML) support is currently not available");
+}
+
+void append_coreml(Ort::SessionOptions &session_options, const ExecutionProviderOptions &options,
+		   int device_id, int num_threads)
+{
+	UNUSED_PARAMETER(device_id);
+	UNUSED_PARAMETER(num_threads);
+	session_options.AppendExecutionProvider("CoreML", options);
+}
+
+const execution_provider execution_providers[] = {
+	{USEGPU_CPU, "CPUExecutionProvider", append_cpu},
+	{USEGPU_XNNPACK, "XnnpackExecutionProvider", append_xnnpack},
+#ifndef DISABLE_ONNXRUNTIME_GPU
+	{USEGPU_CUDA, "CUDAExecutionProvider", append_cuda},
+	{USEGPU_TENSORRT, "TensorrtExecutionProvider", append_tensorrt},
+#endif
+	{USEGPU_DML, "DmlExecutionProvider", append_dml},
+	{USEGPU_COREML, "CoreMLExecutionProvider", append_coreml},
+};
+
+const execution_provider *find_provider(const std::string &device)
+{
+	for (const execution_provider &provider : execution_providers) {
+		if (device == provider.device) {
+			return &provider;
+		}
+	}
+	return nullptr;
+}
+
+std::string available_provider_names()
+{
+	std::string names;
+	for (const std::string &name : Ort::GetAvailableProviders()) {
+		names += (names.empty() ? "" : ", ") + name;
+	}
+	return names;
+}
+
+} // namespace
+
+ExecutionProviderOptions parseExecutionProviderOptions(const std::string &text)
+{
+	ExecutionProviderOptions options;
+	std::istringstream entries(text);
+	std::string entry;
+	while (std::getline(entries, entry, ';')) {
+		const size_t eq = entry.find('=');
+		if (eq == std::string::npos) {
+			continue;
+		}
+		const std::string key = trim(entry.substr(0, eq));
+		if (!key.empty()) {
+			options[key] = trim(entry.substr(eq + 1));
+		}
+	}
+	return options;
+}
+
+bool isExecutionProviderAvailable(const std::string &device)
+{
+	const execution_provider *provider = find_provider(device);
+	if (provider == nullptr) {
+		return false;
+	}
+	const std::vector<std::string> available = Ort::GetAvailableProviders();
+	return std::find(available.begin(), available.end(), provider->ort_name) !=
+	       available.end();
+}
+
+std::string appendExecutionProvider(Ort::SessionOptions &session_options, const std::string &device,
+				    const ExecutionProviderOptions &options, int device_id,
+				    int num_threads)
+{
+	const execution_provider *provider = find_provider(device);
+	if (provider == nullptr) {
+		obs_log(LOG_WARNING, "Unknown inference device '%s', using CPU", device.c_str());
+		return USEGPU_CPU;
+	}
+	if (!isExecutionProviderAvailable(device)) {
+		obs_log(LOG_WARNING,
+			"%s is not available in this ONNX Runtime build (available: %s), using CPU",
+			provider->ort_name, available_provider_names().c_str());
+		return USEGPU_CPU;
+	}
+
+	try {
+		provider->append(session_options, options, device_id, num_threads);
+	} catch (const std::exception &e) {
+		obs_log(LOG_WARNING, "Cannot initialize %s, using CPU: %s", provider->ort_name,
+			e.what());
+		return USEGPU_CPU;
+	}
+	obs_log(LOG_INFO, "Using %s (%zu options)", provider->ort_name, options.size());
+	return provider->device;
+}
+
+void ORT_API_CALL forwardOrtLog(void *param, OrtLoggingLevel severity, const char *category,
+				const char *logid, const char *code_location, const char *message)
+{
+	UNUSED_PARAMETER(param);
+	UNUSED_PARAMETER(category);
+	UNUSED_PARAMETER(logid);
+	UNUSED_PARAMETER(code_location);
+
+	// " Node(s) placed on [XnnpackExecutionProvider]. Number of nodes: 12" followed by one
+	// "  OpType (node name)" line per node, or " All nodes placed on [...]"
+	if (strstr(message, "placed on [") != nullptr) {
+		std::istringstream lines(message);
+		std::string line;
+		bool summary = true;
+		while (std::getline(lines, line)) {
+			if (!line.empty()) {
+				obs_log(summary ? LOG_INFO : LOG_DEBUG, "%s", trim(line).c_str());
+				summary = false;
+			}
+		}
+		return;
+	}
+
+	if (severity >= ORT_LOGGING_LEVEL_ERROR) {
+		obs_log(LOG_ERROR, "ONNX Runtime: %s", message);
+	} else if (severity == ORT_LOGGING_LEVEL_WARNING) {
+		obs_log(LOG_WARNING, "ONNX Runtime: %s", message);
+	}
+}
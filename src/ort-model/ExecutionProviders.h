@@ -0,0 +1,48 @@
+#ifndef EXECUTION_PROVIDERS_H
+#define EXECUTION_PROVIDERS_H
+
+#include <onnxruntime_cxx_api.h>
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+typedef std::unordered_map<std::string, std::string> ExecutionProviderOptions;
+
+/**
+ * Parse execution provider options written as "key=value;key=value".
+ * Whitespace around keys and values is ignored, entries without '=' are skipped.
+ */
+ExecutionProviderOptions parseExecutionProviderOptions(const std::string &text);
+
+/**
+ * Whether the execution provider for a device id (a USEGPU_* value) is compiled into the
+ * ONNX Runtime library that was loaded. The CPU provider is always available.
+ */
+bool isExecutionProviderAvailable(const std::string &device);
+
+/**
+ * Append the execution provider for a device id (a USEGPU_* value) to the session options.
+ *
+ * Unknown devices, providers missing from this ONNX Runtime build and providers that fail to
+ * initialize fall back to the CPU provider with a warning.
+ *
+ * @param session_options The options of the session that is about to be created.
+ * @param device The device id, e.g. "xnnpack".
+ * @param options Provider options, passed to ONNX Runtime as they are.
+ * @param device_id GPU index for the GPU providers.
+ * @param num_threads The intra-op thread count requested for the session.
+ * @return The device id that was actually appended.
+ */
+std::string appendExecutionProvider(Ort::SessionOptions &session_options, const std::string &device,
+				    const ExecutionProviderOptions &options, int device_id,
+				    int num_threads);
+
+/**
+ * ONNX Runtime logging callback: forwards warnings and errors to the OBS log, and the
+ * per-provider node placement that verbose sessions print when they are created.
+ */
+void ORT_API_CALL forwardOrtLog(void *param, OrtLoggingLevel severity, const char *category,
+				const char *logid, const char *code_location, const char *message);
+
+#endif /* EXECUTION_PROVIDERS_H */
@@ -0,0 +1,139 @@
+#include "InferenceService.h"
+
+#include <obs.h>
+
+#include "plugin-support.h"
+
+SharedModel::SharedModel(const std::string &key, std::unique_ptr<ONNXRuntimeModel> model)
+	: key_(key),
+	  model_(std::move(model))
+{
+	worker_ = std::thread(&SharedModel::worker, this);
+}
+
+SharedModel::~SharedModel()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+	}
+	queued_.notify_all();
+	worker_.join();
+	obs_log(LOG_INFO, "Released shared model %s (%llu runs, %.2f frames per run)",
+		key_.c_str(), (unsigned long long)runs_,
+		runs_ > 0 ? (double)frames_ / (double)runs_ : 0.0);
+}
+
+std::vector<Object> SharedModel::submit(Request &request)
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	queue_.push_back(&request);
+	queued_.notify_one();
+	finished_.wait(lock, [&] { return request.done; });
+	if (request.error) {
+		std::rethrow_exception(request.error);
+	}
+	return std::move(request.objects);
+}
+
+void SharedModel::worker()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	for (;;) {
+		queued_.wait(lock, [&] { return stop_ || !queue_.empty(); });
+		if (queue_.empty()) {
+			return;
+		}
+
+		// the prepared inputs that queued up during the last run go into this one
+		std::vector<Request *> batch{queue_.front()};
+		queue_.pop_front();
+		while (batch[0]->input != nullptr && !queue_.empty() &&
+		       queue_.front()->input != nullptr &&
+		       batch.size() < (size_t)model_->maxBatch()) {
+			batch.push_back(queue_.front());
+			queue_.pop_front();
+		}
+
+		lock.unlock();
+		serve(batch);
+		lock.lock();
+
+		runs_++;
+		frames_ += batch.size();
+		for (Request *request : batch) {
+			request->done = true;
+		}
+		finished_.notify_all();
+	}
+}
+
+// a failed run is passed on to every filter whose frame was in it
+void SharedModel::serve(const std::vector<Request *> &batch)
+{
+	try {
+		if (batch[0]->frame != nullptr) {
+			model_->setBBoxConfThresh(batch[0]->conf_threshold);
+			batch[0]->objects = model_->inference(*batch[0]->frame);
+			return;
+		}
+		std::vector<ModelInput *> inputs;
+		std::vector<float> thresholds;
+		for (Request *request : batch) {
+			inputs.push_back(request->input);
+			thresholds.push_back(request->conf_threshold);
+		}
+		std::vector<std::vector<Object>> results = model_->runBatch(inputs, thresholds);
+		for (size_t i = 0; i < batch.size(); i++) {
+			batch[i]->objects = std::move(results[i]);
+		}
+	} catch (...) {
+		for (Request *request : batch) {
+			request->error = std::current_exception();
+		}
+	}
+}
+
+std::vector<Object> SharedModel::inference(const cv::Mat &frame, float conf_threshold)
+{
+	Request request;
+	request.frame = &frame;
+	request.conf_threshold = conf_threshold;
+	return submit(request);
+}
+
+std::vector<Object> SharedModel::run(ModelInput &input, float conf_threshold)
+{
+	Request request;
+	request.input = &input;
+	request.conf_threshold = conf_threshold;
+	return submit(request);
+}
+
+InferenceService &InferenceService::instance()
+{
+	static InferenceService service;
+	return service;
+}
+
+std::shared_ptr<SharedModel> InferenceService::acquire(const std::string &key,
+							const Factory &create)
+{
+	// loading under the lock keeps two filters from loading the same model at once
+	std::lock_guard<std::mutex> lock(mutex_);
+	for (auto it = models_.begin(); it != models_.end();) {
+		it = it->second.expired() ? models_.erase(it) : std::next(it);
+	}
+
+	std::shared_ptr<SharedModel> model = models_[key].lock();
+	if (model) {
+		obs_log(LOG_INFO, "Sharing model %s with %ld other filter(s)", key.c_str(),
+			model.use_count() - 1);
+		return model;
+	}
+
+	model = std::make_shared<SharedModel>(key, create());
+	models_[key] = model;
+	obs_log(LOG_INFO, "Loaded shared model %s", key.c_str());
+	return model;
+}
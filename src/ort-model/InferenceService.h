@@ -0,0 +1,100 @@
+#ifndef INFERENCE_SERVICE_H
+#define INFERENCE_SERVICE_H
+
+#include <opencv2/core.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ONNXRuntimeModel.h"
+
+/**
+ * A model session shared by all the filters that load the same model with the same settings.
+ *
+ * The session and its tensors are not thread-safe, so one worker thread per model does all the
+ * runs, in the order the filters asked for them, so a filter with a fast loop cannot starve the
+ * others. Frames prepared by different filters that are waiting together go into one session
+ * run when the model has a dynamic batch dimension (up to ONNXRuntimeModel::MAX_BATCH).
+ */
+class SharedModel {
+public:
+	SharedModel(const std::string &key, std::unique_ptr<ONNXRuntimeModel> model);
+	~SharedModel();
+
+	// Run the model on one frame with this caller's confidence threshold
+	std::vector<Object> inference(const cv::Mat &frame, float conf_threshold);
+
+	// Two step inference on the caller's input tensors, see ONNXRuntimeModel::prepare. Only
+	// run() goes through the worker, preparing the next frame does not hold up the others.
+	std::unique_ptr<ModelInput> createInput() const { return model_->createInput(); }
+	void prepare(const cv::Mat &frame, ModelInput &input) { model_->prepare(frame, input); }
+	std::vector<Object> run(ModelInput &input, float conf_threshold);
+
+	cv::Size inputSize() const { return model_->inputSize(); }
+	bool usesGraphPreprocessing() const { return model_->usesGraphPreprocessing(); }
+	const std::string &executionProvider() const { return model_->executionProvider(); }
+	int maxBatch() const { return model_->maxBatch(); }
+
+private:
+	// A run waiting for the worker, on the stack of the filter thread that waits for it
+	struct Request {
+		// either a prepared input, batched with the inputs queued behind it,
+		ModelInput *input = nullptr;
+		// or a whole frame, preprocessed into the model's own tensors and run alone
+		const cv::Mat *frame = nullptr;
+		float conf_threshold = 0.0f;
+		std::vector<Object> objects;
+		std::exception_ptr error;
+		bool done = false;
+	};
+	std::vector<Object> submit(Request &request);
+	void worker();
+	void serve(const std::vector<Request *> &batch);
+
+	std::string key_;
+	std::unique_ptr<ONNXRuntimeModel> model_;
+
+	std::mutex mutex_;
+	std::condition_variable queued_;
+	std::condition_variable finished_;
+	std::deque<Request *> queue_;
+	bool stop_ = false;
+	// session runs and the frames they carried, logged on release
+	uint64_t runs_ = 0;
+	uint64_t frames_ = 0;
+	std::thread worker_;
+};
+
+/**
+ * Module-wide registry of the loaded models. A model lives as long as a filter holds it, the
+ * next filter asking for the same key after that loads it again.
+ */
+class InferenceService {
+public:
+	using Factory = std::function<std::unique_ptr<ONNXRuntimeModel>()>;
+
+	static InferenceService &instance();
+
+	/**
+	 * The model for key, created with create() if no filter holds it. Exceptions from
+	 * create() are passed on.
+	 *
+	 * @param key Everything the session depends on: model file, device, provider options,
+	 *            threads and preprocessing.
+	 */
+	std::shared_ptr<SharedModel> acquire(const std::string &key, const Factory &create);
+
+private:
+	std::mutex mutex_;
+	std::map<std::string, std::weak_ptr<SharedModel>> models_;
+};
+
+#endif /* INFERENCE_SERVICE_H */
@@ -3,23 +3,90 @@
 #include <opencv2/core.hpp>
 #include <opencv2/imgproc.hpp>
 
-#ifdef _WIN32
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
-#include <dml_provider_factory.h>
-#endif
-
 #include "plugin-support.h"
+#include "consts.h"
+#include "kernels/kernels.h"
+#include "PreprocessGraph.h"
+#include "ExecutionProviders.h"
 
 #include <obs.h>
 #include <stdexcept>
 #include <algorithm>
+#include <array>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+size_t tensor_element_size(ONNXTensorElementDataType type)
+{
+	switch (type) {
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+		return sizeof(float);
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+		return sizeof(uint16_t);
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+		return sizeof(uint8_t);
+	default:
+		return 0;
+	}
+}
+
+const char *tensor_element_name(ONNXTensorElementDataType type)
+{
+	switch (type) {
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT:
+		return "float";
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16:
+		return "float16";
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+		return "uint8";
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+		return "int8";
+	default:
+		return "unsupported";
+	}
+}
+
+// Pixel values are integers 0..255, so a lookup table gives the exact half-float bits
+const uint16_t *u8_to_fp16_table()
+{
+	static const std::array<uint16_t, 256> table = [] {
+		std::array<uint16_t, 256> t{};
+		for (unsigned v = 1; v < 256; ++v) {
+			unsigned e = 0;
+			while ((v >> (e + 1)) != 0) {
+				++e;
+			}
+			const unsigned mantissa = (v << (10 - e)) & 0x3FF;
+			t[v] = (uint16_t)(((e + 15) << 10) | mantissa);
+		}
+		return t;
+	}();
+	return table.data();
+}
+
+// Elements of one frame, 0 when a dimension other than the batch is not fixed
+size_t frame_element_count(const std::vector<int64_t> &shape)
+{
+	size_t count = 1;
+	for (int64_t dim : shape) {
+		if (dim <= 0) {
+			return 0;
+		}
+		count *= (size_t)dim;
+	}
+	return count;
+}
+
+} // namespace
 
 ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_threads,
 				   int num_classes, int inter_op_num_threads,
 				   const std::string &use_gpu_, int device_id, bool use_parallel,
-				   float nms_th, float conf_th)
+				   float nms_th, float conf_th, const SessionTuning *tuning,
+				   const std::string &ep_options)
 	: intra_op_num_threads_(intra_op_num_threads),
 	  inter_op_num_threads_(inter_op_num_threads),
 	  use_gpu(use_gpu_),
@@ -29,31 +96,52 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 	  bbox_conf_thresh_(conf_th),
 	  num_classes_(num_classes)
 {
-	try {
+	auto make_session_options = [&](const std::string &device) {
 		Ort::SessionOptions session_options;
 
 		session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
-		if (this->use_parallel_) {
-			session_options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
-			session_options.SetInterOpNumThreads(this->inter_op_num_threads_);
+		if (tuning != nullptr) {
+			// measured settings from auto-tune replace the thread arguments
+			tuning->apply(session_options);
+			this->use_parallel_ = tuning->parallel;
+			this->intra_op_num_threads_ = tuning->intra_op_threads;
+			this->inter_op_num_threads_ = tuning->inter_op_threads;
+			obs_log(LOG_INFO, "Using tuned session settings: %s",
+				tuning->describe().c_str());
 		} else {
-			session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+			if (this->use_parallel_) {
+				session_options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+				session_options.SetInterOpNumThreads(this->inter_op_num_threads_);
+			} else {
+				session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+			}
+			session_options.SetIntraOpNumThreads(this->intra_op_num_threads_);
 		}
-		session_options.SetIntraOpNumThreads(this->intra_op_num_threads_);
+		// verbose while the session is created so the node placement reaches the log,
+		// runs are back at warning level (see inference)
+		session_options.SetLogSeverityLevel(ORT_LOGGING_LEVEL_VERBOSE);
 
-#ifdef _WIN32
-		if (this->use_gpu == "cuda") {
-			OrtCUDAProviderOptions cuda_option;
-			cuda_option.device_id = this->device_id_;
-			session_options.AppendExecutionProvider_CUDA(cuda_option);
-		}
-		if (this->use_gpu == "dml") {
-			obs_log(LOG_WARNING, "DirectML (DML) support is currently not available, falling back to CPU");
-			obs_log(LOG_INFO, "Please check back later for DML support updates");
-		}
-#endif
+		this->execution_provider_ =
+			appendExecutionProvider(session_options, device,
+						parseExecutionProviderOptions(ep_options),
+						this->device_id_, this->intra_op_num_threads_);
+		return session_options;
+	};
 
-		this->session_ = Ort::Session(this->env_, path_to_model.c_str(), session_options);
+	try {
+		try {
+			this->session_ = Ort::Session(this->env_, path_to_model.c_str(),
+						      make_session_options(this->use_gpu));
+		} catch (const std::exception &e) {
+			if (this->execution_provider_ == USEGPU_CPU) {
+				throw;
+			}
+			// e.g. provider libraries that are present but cannot find their runtime
+			obs_log(LOG_WARNING, "Cannot create session with %s, retrying on CPU: %s",
+				this->execution_provider_.c_str(), e.what());
+			this->session_ = Ort::Session(this->env_, path_to_model.c_str(),
+						      make_session_options(USEGPU_CPU));
+		}
 	} catch (std::exception &e) {
 		obs_log(LOG_ERROR, "Cannot load model: %s", e.what());
 		throw e;
@@ -62,6 +150,8 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 	Ort::AllocatorWithDefaultOptions ort_alloc;
 
 	size_t num_input = this->session_.GetInputCount();
+	// several frames go into one run only if every input and output has a free batch dimension
+	bool batchable = true;
 
 	for (size_t i = 0; i < num_input; i++) {
 		auto input_info = this->session_.GetInputTypeInfo(i);
@@ -69,6 +159,12 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 		auto input_shape = input_shape_info.GetShape();
 		auto input_tensor_type = input_shape_info.GetElementType();
 
+		// a dynamic batch dimension runs one frame at a time, see runBatch
+		batchable = batchable && !input_shape.empty() && input_shape[0] < 0;
+		if (!input_shape.empty() && input_shape[0] < 0) {
+			input_shape[0] = 1;
+		}
+
 		if (input_shape.size() >= 4) {
 			this->input_h_.push_back((int)(input_shape[2]));
 			this->input_w_.push_back((int)(input_shape[3]));
@@ -78,9 +174,24 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 			throw std::runtime_error("Invalid input shape, expected NCHW format");
 		}
 
+		const size_t input_element_size = tensor_element_size(input_tensor_type);
+		if (input_element_size == 0) {
+			obs_log(LOG_ERROR, "Unsupported input element type: %d", (int)input_tensor_type);
+			throw std::runtime_error(
+				"Unsupported input element type, expected float, float16, uint8 or int8");
+		}
+		this->input_type_.push_back(input_tensor_type);
+		this->input_shapes_.push_back(input_shape);
+
 		this->input_name_.push_back(
 			std::string(this->session_.GetInputNameAllocated(i, ort_alloc).get()));
-		size_t input_byte_count = sizeof(float) * input_shape_info.GetElementCount();
+		size_t input_byte_count = input_element_size * frame_element_count(input_shape);
+		if (input_byte_count == 0) {
+			obs_log(LOG_ERROR, "Input %zu has dynamic dimensions besides the batch",
+				i);
+			throw std::runtime_error("Unsupported dynamic input shape");
+		}
+		this->input_bytes_.push_back(input_byte_count);
 		std::unique_ptr<uint8_t[]> input_buffer =
 			std::make_unique<uint8_t[]>(input_byte_count);
 		auto input_memory_info =
@@ -91,7 +202,8 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 			input_shape.size(), input_tensor_type));
 		this->input_buffer_.push_back(std::move(input_buffer));
 
-		obs_log(LOG_INFO, "Input name: %s", this->input_name_[i].c_str());
+		obs_log(LOG_INFO, "Input name: %s (%s)", this->input_name_[i].c_str(),
+			tensor_element_name(input_tensor_type));
 		obs_log(LOG_INFO, "Input shape: %d %d %d %d", input_shape[0],
 			input_shape.size() > 1 ? input_shape[1] : 0,
 			input_shape.size() > 2 ? input_shape[2] : 0,
@@ -106,15 +218,27 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 		auto output_shape = output_shape_info.GetShape();
 		auto output_tensor_type = output_shape_info.GetElementType();
 
+		if (output_tensor_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT) {
+			obs_log(LOG_ERROR, "Unsupported output element type: %d",
+				(int)output_tensor_type);
+			throw std::runtime_error("Unsupported output element type, expected float");
+		}
+
+		batchable = batchable && !output_shape.empty() && output_shape[0] < 0;
+		if (!output_shape.empty() && output_shape[0] < 0) {
+			output_shape[0] = 1;
+		}
 		this->output_shapes_.push_back(output_shape);
 
-		size_t output_element_count = output_shape_info.GetElementCount();
+		size_t output_element_count = frame_element_count(output_shape);
+		batchable = batchable && output_element_count != 0;
 		if (output_element_count == 0) {
 			obs_log(LOG_WARNING, "Output %zu has element count 0, using fallback", i);
 			output_element_count = 1024 * 1024;
 		}
 		
 		size_t output_byte_count = sizeof(float) * output_element_count;
+		this->output_bytes_.push_back(output_byte_count);
 		std::unique_ptr<uint8_t[]> output_buffer =
 			std::make_unique<uint8_t[]>(output_byte_count);
 		auto output_memory_info =
@@ -135,9 +259,15 @@ ONNXRuntimeModel::ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_t
 		}
 		obs_log(LOG_INFO, "Output element count: %zu", output_element_count);
 	}
+
+	if (batchable) {
+		this->max_batch_ = MAX_BATCH;
+		obs_log(LOG_INFO, "Dynamic batch dimension, running up to %d frames at once",
+			this->max_batch_);
+	}
 }
 
-cv::Mat ONNXRuntimeModel::static_resize(const cv::Mat &img, const int input_index)
+cv::Mat ONNXRuntimeModel::static_resize(const cv::Mat &img, const int input_index) const
 {
 	if (input_index < 0 || (size_t)input_index >= input_w_.size() || 
 	    (size_t)input_index >= input_h_.size()) {
@@ -155,15 +285,16 @@ cv::Mat ONNXRuntimeModel::static_resize(const cv::Mat &img, const int input_inde
 			     (float)input_h_[input_index] / (float)img.rows);
 	int unpad_w = (int)(r * (float)img.cols);
 	int unpad_h = (int)(r * (float)img.rows);
-	cv::Mat re(unpad_h, unpad_w, CV_8UC3);
+	cv::Mat re(unpad_h, unpad_w, img.type());
 	cv::resize(img, re, re.size());
-	cv::Mat out(input_h_[input_index], input_w_[input_index], CV_8UC3,
-		    cv::Scalar(114, 114, 114));
+	cv::Mat out(input_h_[input_index], input_w_[input_index], img.type(),
+		    cv::Scalar::all(114));
 	re.copyTo(out(cv::Rect(0, 0, re.cols, re.rows)));
 	return out;
 }
 
-void ONNXRuntimeModel::blobFromImage(const cv::Mat &img, float *blob_data)
+void ONNXRuntimeModel::blobFromImage(const cv::Mat &img, const int input_index,
+				     uint8_t *blob_data, std::vector<uint8_t> &scratch) const
 {
 	if (blob_data == nullptr) {
 		obs_log(LOG_ERROR, "blob_data is null");
@@ -174,17 +305,160 @@ void ONNXRuntimeModel::blobFromImage(const cv::Mat &img, float *blob_data)
 		throw std::invalid_argument("Input image cannot be empty");
 	}
 
-	size_t channels = 3;
-	size_t img_h = img.rows;
-	size_t img_w = img.cols;
-	for (size_t c = 0; c < channels; ++c) {
-		for (size_t h = 0; h < img_h; ++h) {
-			for (size_t w = 0; w < img_w; ++w) {
-				blob_data[(int)(c * img_w * img_h + h * img_w + w)] =
-					(float)img.ptr<cv::Vec3b>((int)h)[(int)w][(int)c];
+	// write straight into the tensor's element type, quantized models skip the float pass
+	const detect_kernels &k = kernels();
+	switch (this->input_type_[input_index]) {
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+		k.hwc_u8_to_chw_u8(img.data, img.step, img.cols, img.rows, img.channels(),
+				   blob_data, 0);
+		break;
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8:
+		// shift 0..255 to -128..127, the usual zero point of int8 image inputs
+		k.hwc_u8_to_chw_u8(img.data, img.step, img.cols, img.rows, img.channels(),
+				   blob_data, 0x80);
+		break;
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: {
+		const size_t count = (size_t)img.cols * (size_t)img.rows * 3;
+		scratch.resize(count);
+		k.hwc_u8_to_chw_u8(img.data, img.step, img.cols, img.rows, img.channels(),
+				   scratch.data(), 0);
+		const uint16_t *table = u8_to_fp16_table();
+		uint16_t *half_data = (uint16_t *)blob_data;
+		for (size_t i = 0; i < count; ++i) {
+			half_data[i] = table[scratch[i]];
+		}
+		break;
+	}
+	default:
+		k.hwc_u8_to_chw_f32(img.data, img.step, img.cols, img.rows, img.channels(),
+				    (float *)blob_data);
+		break;
+	}
+}
+
+bool ONNXRuntimeModel::enableGraphPreprocessing(const std::string &cache_dir)
+{
+	if (this->input_name_.size() != 1) {
+		obs_log(LOG_WARNING,
+			"Graph preprocessing needs a single input model, using C++ preprocessing");
+		return false;
+	}
+	const ONNXTensorElementDataType type = this->input_type_[0];
+	const std::string model = build_preprocess_model(type, input_w_[0], input_h_[0]);
+	if (model.empty()) {
+		obs_log(LOG_WARNING,
+			"Graph preprocessing is not available for %s inputs, using C++ preprocessing",
+			tensor_element_name(type));
+		return false;
+	}
+
+	// the optimized graph depends on the ONNX Runtime version and the model input
+	std::filesystem::path cached;
+	if (!cache_dir.empty()) {
+		cached = std::filesystem::u8path(cache_dir) /
+			 ("preprocess-v1-ort" + std::to_string(ORT_API_VERSION) + "-" +
+			  tensor_element_name(type) + "-" + std::to_string(input_w_[0]) + "x" +
+			  std::to_string(input_h_[0]) + ".onnx");
+	}
+
+	Ort::SessionOptions session_options;
+	session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+	session_options.SetIntraOpNumThreads(this->intra_op_num_threads_);
+
+	std::error_code ec;
+	if (!cached.empty() && std::filesystem::exists(cached, ec)) {
+		try {
+			// already optimized when it was saved
+			session_options.SetGraphOptimizationLevel(
+				GraphOptimizationLevel::ORT_DISABLE_ALL);
+			this->preprocess_session_ =
+				Ort::Session(this->env_, cached.c_str(), session_options);
+			this->graph_preprocessing_ = true;
+			obs_log(LOG_INFO, "Loaded cached preprocessing graph %s",
+				cached.u8string().c_str());
+			return true;
+		} catch (const std::exception &e) {
+			obs_log(LOG_WARNING, "Cannot load cached preprocessing graph, rebuilding: %s",
+				e.what());
+		}
+	}
+
+	try {
+		// extended, not all: layout transformations would tie the cache to this CPU
+		session_options.SetGraphOptimizationLevel(
+			GraphOptimizationLevel::ORT_ENABLE_EXTENDED);
+		if (!cached.empty()) {
+			std::filesystem::create_directories(cached.parent_path(), ec);
+			if (!ec) {
+				session_options.SetOptimizedModelFilePath(cached.c_str());
 			}
 		}
+		this->preprocess_session_ =
+			Ort::Session(this->env_, model.data(), model.size(), session_options);
+	} catch (const std::exception &e) {
+		obs_log(LOG_WARNING, "Cannot create preprocessing graph, using C++ preprocessing: %s",
+			e.what());
+		return false;
 	}
+	this->graph_preprocessing_ = true;
+	obs_log(LOG_INFO, "Preprocessing frames in the ONNX graph (%s %dx%d)",
+		tensor_element_name(type), input_w_[0], input_h_[0]);
+	return true;
+}
+
+void ONNXRuntimeModel::preprocessInGraph(const cv::Mat &frame, const int input_index,
+					 Ort::Value &output)
+{
+	// feed the whole underlying frame and let the graph slice the ROI (e.g. the crop),
+	// only frames with padded rows need a copy
+	cv::Size whole;
+	cv::Point offset;
+	frame.locateROI(whole, offset);
+	const uint8_t *frame_data = frame.datastart;
+	cv::Mat packed;
+	if (frame.step != (size_t)whole.width * 4) {
+		packed = frame.clone();
+		frame_data = packed.data;
+		whole = packed.size();
+		offset = cv::Point(0, 0);
+	}
+
+	const int input_w = input_w_[input_index];
+	const int input_h = input_h_[input_index];
+	const float r = std::min((float)input_w / (float)frame.cols,
+				 (float)input_h / (float)frame.rows);
+	const int unpad_w = (int)(r * (float)frame.cols);
+	const int unpad_h = (int)(r * (float)frame.rows);
+	if (unpad_w <= 0 || unpad_h <= 0) {
+		obs_log(LOG_ERROR, "Frame %dx%d is too small to preprocess", frame.cols,
+			frame.rows);
+		throw std::invalid_argument("Frame too small to preprocess");
+	}
+
+	std::array<int64_t, 4> frame_shape = {1, whole.height, whole.width, 4};
+	std::array<int64_t, 4> roi_starts = {0, offset.y, offset.x, 0};
+	std::array<int64_t, 4> roi_ends = {1, offset.y + frame.rows, offset.x + frame.cols, 3};
+	std::array<int64_t, 4> resize_sizes = {1, unpad_h, unpad_w, 3};
+	std::array<int64_t, 8> pads = {0, 0, 0, 0, 0, input_h - unpad_h, input_w - unpad_w, 0};
+	const int64_t vector4 = 4;
+	const int64_t vector8 = 8;
+
+	auto memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+	Ort::Value inputs[] = {
+		Ort::Value::CreateTensor<uint8_t>(memory_info, (uint8_t *)frame_data,
+						  (size_t)whole.area() * 4, frame_shape.data(),
+						  frame_shape.size()),
+		Ort::Value::CreateTensor<int64_t>(memory_info, roi_starts.data(), 4, &vector4, 1),
+		Ort::Value::CreateTensor<int64_t>(memory_info, roi_ends.data(), 4, &vector4, 1),
+		Ort::Value::CreateTensor<int64_t>(memory_info, resize_sizes.data(), 4, &vector4,
+						  1),
+		Ort::Value::CreateTensor<int64_t>(memory_info, pads.data(), 8, &vector8, 1),
+	};
+
+	// the graph writes straight into the detection model's input tensor
+	Ort::RunOptions run_options;
+	this->preprocess_session_.Run(run_options, PREPROCESS_INPUT_NAMES, inputs,
+				      std::size(inputs), &PREPROCESS_OUTPUT_NAME, &output, 1);
 }
 
 float ONNXRuntimeModel::intersection_area(const Object &a, const Object &b)
@@ -234,32 +508,35 @@ void ONNXRuntimeModel::nms_sorted_bboxes(const std::vector<Object> &objects,
 
 	const size_t n = objects.size();
 
-	std::vector<float> areas(n);
-	for (size_t i = 0; i < n; ++i) {
-		areas[i] = objects[i].rect.area();
-	}
+	// picked boxes as structure-of-arrays for the vectorized IoU check
+	std::vector<float> x0, y0, x1, y1, areas;
+	x0.reserve(n);
+	y0.reserve(n);
+	x1.reserve(n);
+	y1.reserve(n);
+	areas.reserve(n);
 
+	const detect_kernels &k = kernels();
 	for (size_t i = 0; i < n; ++i) {
-		const Object &a = objects[i];
-		const size_t picked_size = picked.size();
-
-		int keep = 1;
-		for (size_t j = 0; j < picked_size; ++j) {
-			const Object &b = objects[picked[j]];
-
-			float inter_area = this->intersection_area(a, b);
-			float union_area = areas[i] + areas[picked[j]] - inter_area;
-			
-			if (union_area > 0 && inter_area / union_area > nms_threshold)
-				keep = 0;
-		}
+		const cv::Rect_<float> &r = objects[i].rect;
+		const float box[4] = {r.x, r.y, r.x + r.width, r.y + r.height};
+		const float area = r.area();
 
-		if (keep)
+		if (!k.any_iou_above(x0.data(), y0.data(), x1.data(), y1.data(), areas.data(),
+				     picked.size(), box, area, nms_threshold)) {
 			picked.push_back((int)i);
+			x0.push_back(box[0]);
+			y0.push_back(box[1]);
+			x1.push_back(box[2]);
+			y1.push_back(box[3]);
+			areas.push_back(area);
+		}
 	}
 }
 
-void ONNXRuntimeModel::inference(const cv::Mat &frame, const int input_index)
+void ONNXRuntimeModel::preprocessInput(const cv::Mat &frame, const int input_index,
+				       uint8_t *blob_data, Ort::Value &tensor,
+				       std::vector<uint8_t> &scratch)
 {
 	if (input_index < 0 || (size_t)input_index >= input_buffer_.size()) {
 		obs_log(LOG_ERROR, "Invalid input_index in inference: %d", input_index);
@@ -270,11 +547,63 @@ void ONNXRuntimeModel::inference(const cv::Mat &frame, const int input_index)
 		throw std::invalid_argument("Input frame cannot be empty");
 	}
 
-	cv::Mat pr_img = this->static_resize(frame, input_index);
+	if (this->graph_preprocessing_ && frame.type() == CV_8UC4) {
+		preprocessInGraph(frame, input_index, tensor);
+	} else {
+		cv::Mat pr_img = this->static_resize(frame, input_index);
+
+		blobFromImage(pr_img, input_index, blob_data, scratch);
+	}
+}
+
+void ONNXRuntimeModel::inference(const cv::Mat &frame, const int input_index)
+{
+	preprocessInput(frame, input_index, this->input_buffer_[input_index].get(),
+			this->input_tensor_[input_index], this->blob_scratch_);
+	runSession(this->input_tensor_);
+}
+
+std::vector<Object> ONNXRuntimeModel::inference(const cv::Mat &frame)
+{
+	inference(frame, 0);
+	return decode(frame.size());
+}
+
+std::unique_ptr<ModelInput> ONNXRuntimeModel::createInput() const
+{
+	auto input = std::make_unique<ModelInput>();
+	auto memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+	for (size_t i = 0; i < this->input_shapes_.size(); i++) {
+		const std::vector<int64_t> &shape = this->input_shapes_[i];
+		size_t element_count = 1;
+		for (int64_t dim : shape) {
+			element_count *= (size_t)std::max<int64_t>(dim, 1);
+		}
+		const size_t byte_count = tensor_element_size(this->input_type_[i]) * element_count;
+		input->buffers.push_back(std::make_unique<uint8_t[]>(byte_count));
+		input->tensors.push_back(Ort::Value::CreateTensor(memory_info,
+								  input->buffers.back().get(),
+								  byte_count, shape.data(),
+								  shape.size(), this->input_type_[i]));
+	}
+	return input;
+}
 
-	float *blob_data = (float *)(this->input_buffer_[input_index].get());
-	blobFromImage(pr_img, blob_data);
+void ONNXRuntimeModel::prepare(const cv::Mat &frame, ModelInput &input)
+{
+	// only the caller's tensors are written, the graph session allows concurrent runs
+	preprocessInput(frame, 0, input.buffers[0].get(), input.tensors[0], input.scratch);
+	input.frame_size = frame.size();
+}
 
+std::vector<Object> ONNXRuntimeModel::run(ModelInput &input)
+{
+	runSession(input.tensors);
+	return decode(input.frame_size);
+}
+
+void ONNXRuntimeModel::runSession(std::vector<Ort::Value> &inputs)
+{
 	std::vector<const char *> input_names;
 	for (size_t i = 0; i < this->input_name_.size(); i++) {
 		input_names.push_back(this->input_name_[i].c_str());
@@ -286,7 +615,83 @@ void ONNXRuntimeModel::inference(const cv::Mat &frame, const int input_index)
 	}
 
 	Ort::RunOptions run_options;
-	this->session_.Run(run_options, input_names.data(), this->input_tensor_.data(),
-			   this->input_tensor_.size(), output_names.data(),
-			   this->output_tensor_.data(), this->output_tensor_.size());
+	run_options.SetRunLogSeverityLevel(ORT_LOGGING_LEVEL_WARNING);
+	this->session_.Run(run_options, input_names.data(), inputs.data(), inputs.size(),
+			   output_names.data(), this->output_tensor_.data(),
+			   this->output_tensor_.size());
+}
+
+std::vector<std::vector<Object>>
+ONNXRuntimeModel::runBatch(const std::vector<ModelInput *> &inputs,
+			   const std::vector<float> &conf_thresholds)
+{
+	const size_t n = inputs.size();
+	if (n == 0 || n > (size_t)this->max_batch_ || conf_thresholds.size() != n) {
+		obs_log(LOG_ERROR, "Invalid batch of %zu frames, the model takes up to %d", n,
+			this->max_batch_);
+		throw std::invalid_argument("Invalid batch size");
+	}
+	if (n == 1) {
+		setBBoxConfThresh(conf_thresholds[0]);
+		return {run(*inputs[0])};
+	}
+
+	// the frames' tensors one after the other along the batch dimension
+	auto memory_info = Ort::MemoryInfo::CreateCpu(OrtDeviceAllocator, OrtMemTypeDefault);
+	this->batch_buffers_.resize(this->input_shapes_.size());
+	std::vector<Ort::Value> batch_inputs;
+	for (size_t i = 0; i < this->input_shapes_.size(); i++) {
+		const size_t frame_bytes = this->input_bytes_[i];
+		std::vector<uint8_t> &buffer = this->batch_buffers_[i];
+		buffer.resize(frame_bytes * n);
+		for (size_t f = 0; f < n; f++) {
+			memcpy(buffer.data() + f * frame_bytes, inputs[f]->buffers[i].get(),
+			       frame_bytes);
+		}
+		std::vector<int64_t> shape = this->input_shapes_[i];
+		shape[0] = (int64_t)n;
+		batch_inputs.push_back(Ort::Value::CreateTensor(memory_info, buffer.data(),
+								buffer.size(), shape.data(),
+								shape.size(),
+								this->input_type_[i]));
+	}
+
+	std::vector<const char *> input_names;
+	for (size_t i = 0; i < this->input_name_.size(); i++) {
+		input_names.push_back(this->input_name_[i].c_str());
+	}
+	std::vector<const char *> output_names;
+	for (size_t i = 0; i < this->output_name_.size(); i++) {
+		output_names.push_back(this->output_name_[i].c_str());
+	}
+
+	Ort::RunOptions run_options;
+	run_options.SetRunLogSeverityLevel(ORT_LOGGING_LEVEL_WARNING);
+	std::vector<Ort::Value> batch_outputs =
+		this->session_.Run(run_options, input_names.data(), batch_inputs.data(),
+				   batch_inputs.size(), output_names.data(), output_names.size());
+	for (size_t i = 0; i < batch_outputs.size(); i++) {
+		const size_t elements =
+			batch_outputs[i].GetTensorTypeAndShapeInfo().GetElementCount();
+		if (elements * sizeof(float) != this->output_bytes_[i] * n) {
+			obs_log(LOG_ERROR, "Output %zu has %zu elements for a batch of %zu", i,
+				elements, n);
+			throw std::runtime_error("Unexpected batch output size");
+		}
+	}
+
+	// decode() reads the single frame output buffers, so each frame's slice goes through them
+	std::vector<std::vector<Object>> results;
+	for (size_t f = 0; f < n; f++) {
+		for (size_t i = 0; i < batch_outputs.size(); i++) {
+			const size_t frame_bytes = this->output_bytes_[i];
+			memcpy(this->output_buffer_[i].get(),
+			       (const uint8_t *)batch_outputs[i].GetTensorData<float>() +
+				       f * frame_bytes,
+			       frame_bytes);
+		}
+		setBBoxConfThresh(conf_thresholds[f]);
+		results.push_back(decode(inputs[f]->frame_size));
+	}
+	return results;
 }
@@ -12,13 +12,24 @@
 #include <cmath>
 
 #include "types.hpp"
+#include "SessionTuning.h"
+#include "ExecutionProviders.h"
+
+// Input tensors of one preprocessed frame, owned by the caller of ONNXRuntimeModel::prepare
+struct ModelInput {
+	std::vector<std::unique_ptr<uint8_t[]>> buffers;
+	std::vector<Ort::Value> tensors;
+	std::vector<uint8_t> scratch;
+	cv::Size frame_size;
+};
 
 class ONNXRuntimeModel {
 public:
 	ONNXRuntimeModel(file_name_t path_to_model, int intra_op_num_threads, int num_classes,
 			 int inter_op_num_threads = 1, const std::string &use_gpu_ = "",
 			 int device_id = 0, bool use_parallel = false, float nms_th = 0.45f,
-			 float conf_th = 0.3f);
+			 float conf_th = 0.3f, const SessionTuning *tuning = nullptr,
+			 const std::string &ep_options = std::string());
 	virtual ~ONNXRuntimeModel() {
 		input_tensor_.clear();
 		output_tensor_.clear();
@@ -29,11 +40,45 @@ public:
 	void setBBoxConfThresh(float thresh) { this->bbox_conf_thresh_ = thresh; }
 	void setNmsThresh(float thresh) { this->nms_thresh_ = thresh; }
 
-	virtual std::vector<Object> inference(const cv::Mat &frame) = 0;
+	// Preprocess, run and decode one frame
+	std::vector<Object> inference(const cv::Mat &frame);
+
+	// The same in two steps on caller owned input tensors, so one frame can be preprocessed
+	// while another one runs. prepare() may run concurrently with run(), two runs may not.
+	std::unique_ptr<ModelInput> createInput() const;
+	void prepare(const cv::Mat &frame, ModelInput &input);
+	std::vector<Object> run(ModelInput &input);
+
+	// Run up to maxBatch() prepared frames in one session run, each decoded with its own
+	// confidence threshold. Models without a dynamic batch dimension take one frame.
+	std::vector<std::vector<Object>> runBatch(const std::vector<ModelInput *> &inputs,
+						  const std::vector<float> &conf_thresholds);
+	int maxBatch() const { return max_batch_; }
+	static constexpr int MAX_BATCH = 8;
+
+	// Letterbox BGRA frames with an ONNX preprocessing graph instead of static_resize and
+	// blobFromImage, the optimized graph is cached in cache_dir when it is not empty.
+	// Returns false, keeping the C++ preprocessing, if the model input is not supported.
+	bool enableGraphPreprocessing(const std::string &cache_dir);
+	bool usesGraphPreprocessing() const { return graph_preprocessing_; }
+
+	// Width and height of the (first) image input
+	cv::Size inputSize() const { return cv::Size(input_w_[0], input_h_[0]); }
+
+	// The device the session actually runs on, "cpu" when the requested provider fell back
+	const std::string &executionProvider() const { return execution_provider_; }
 
 protected:
-	cv::Mat static_resize(const cv::Mat &img, const int input_index);
-	void blobFromImage(const cv::Mat &img, float *blob_data);
+	// The objects found by the last run, in the coordinates of a frame of frame_size
+	virtual std::vector<Object> decode(const cv::Size &frame_size) = 0;
+
+	cv::Mat static_resize(const cv::Mat &img, const int input_index) const;
+	void blobFromImage(const cv::Mat &img, const int input_index, uint8_t *blob_data,
+			   std::vector<uint8_t> &scratch) const;
+	void preprocessInGraph(const cv::Mat &frame, const int input_index, Ort::Value &output);
+	void preprocessInput(const cv::Mat &frame, const int input_index, uint8_t *blob_data,
+			     Ort::Value &tensor, std::vector<uint8_t> &scratch);
+	void runSession(std::vector<Ort::Value> &inputs);
 	float intersection_area(const Object &a, const Object &b);
 	void qsort_descent_inplace(std::vector<Object> &faceobjects, int left, int right);
 	void qsort_descent_inplace(std::vector<Object> &objects);
@@ -52,17 +97,29 @@ protected:
 	int intra_op_num_threads_;
 	int device_id_;
 	std::string use_gpu;
+	std::string execution_provider_;
 
 	Ort::Session session_{nullptr};
-	Ort::Env env_{ORT_LOGGING_LEVEL_WARNING, "Default"};
+	Ort::Session preprocess_session_{nullptr};
+	bool graph_preprocessing_ = false;
+	Ort::Env env_{ORT_LOGGING_LEVEL_WARNING, "Default", forwardOrtLog, nullptr};
 
 	std::vector<Ort::Value> input_tensor_;
 	std::vector<Ort::Value> output_tensor_;
+	std::vector<ONNXTensorElementDataType> input_type_;
+	std::vector<std::vector<int64_t>> input_shapes_;
+	std::vector<uint8_t> blob_scratch_;
 	std::vector<std::string> input_name_;
 	std::vector<std::string> output_name_;
 	std::vector<std::unique_ptr<uint8_t[]>> input_buffer_;
 	std::vector<std::unique_ptr<uint8_t[]>> output_buffer_;
 	std::vector<Ort::ShapeInferContext::Ints> output_shapes_;
+
+	// bytes of one frame per input and output, and the concatenated inputs of runBatch
+	std::vector<size_t> input_bytes_;
+	std::vector<size_t> output_bytes_;
+	std::vector<std::vector<uint8_t>> batch_buffers_;
+	int max_batch_ = 1;
 };
 
 #endif
@@ -0,0 +1,153 @@
+#include "PreprocessGraph.h"
+
+#include <initializer_list>
+#include <vector>
+
+namespace {
+
+// Just enough of the protobuf wire format to write an ONNX ModelProto without
+// depending on protobuf / onnx, field numbers are from onnx.proto
+class proto_message {
+public:
+	proto_message &varint(int field, uint64_t value)
+	{
+		tag(field, 0);
+		put_varint(value);
+		return *this;
+	}
+
+	proto_message &bytes(int field, const std::string &value)
+	{
+		tag(field, 2);
+		put_varint(value.size());
+		data_ += value;
+		return *this;
+	}
+
+	proto_message &message(int field, const proto_message &value)
+	{
+		return bytes(field, value.data_);
+	}
+
+	const std::string &data() const { return data_; }
+
+private:
+	void tag(int field, int wire_type) { put_varint(((uint64_t)field << 3) | wire_type); }
+
+	void put_varint(uint64_t value)
+	{
+		while (value >= 0x80) {
+			data_.push_back((char)(value | 0x80));
+			value >>= 7;
+		}
+		data_.push_back((char)value);
+	}
+
+	std::string data_;
+};
+
+enum onnx_attribute_type {
+	ATTRIBUTE_INT = 2,
+	ATTRIBUTE_STRING = 3,
+	ATTRIBUTE_INTS = 7,
+};
+
+proto_message int_attribute(const char *name, int64_t value)
+{
+	return proto_message().bytes(1, name).varint(3, (uint64_t)value).varint(20, ATTRIBUTE_INT);
+}
+
+proto_message string_attribute(const char *name, const std::string &value)
+{
+	return proto_message().bytes(1, name).bytes(4, value).varint(20, ATTRIBUTE_STRING);
+}
+
+proto_message ints_attribute(const char *name, std::initializer_list<int64_t> values)
+{
+	proto_message attribute;
+	attribute.bytes(1, name);
+	for (int64_t v : values) {
+		attribute.varint(8, (uint64_t)v);
+	}
+	return attribute.varint(20, ATTRIBUTE_INTS);
+}
+
+proto_message node(const char *op_type, std::initializer_list<const char *> inputs,
+		   const char *output, std::initializer_list<proto_message> attributes = {})
+{
+	proto_message n;
+	for (const char *input : inputs) {
+		n.bytes(1, input);
+	}
+	n.bytes(2, output).bytes(3, std::string(op_type) + "_" + output).bytes(4, op_type);
+	for (const proto_message &attribute : attributes) {
+		n.message(5, attribute);
+	}
+	return n;
+}
+
+// dims are fixed sizes, or symbolic when given a name
+struct dim {
+	int64_t value;
+	const char *param;
+};
+
+proto_message value_info(const char *name, int elem_type, std::initializer_list<dim> dims)
+{
+	proto_message shape;
+	for (const dim &d : dims) {
+		shape.message(1, d.param ? proto_message().bytes(2, d.param)
+					 : proto_message().varint(1, (uint64_t)d.value));
+	}
+	const proto_message tensor = proto_message().varint(1, (uint64_t)elem_type).message(2, shape);
+	return proto_message().bytes(1, name).message(2, proto_message().message(1, tensor));
+}
+
+} // namespace
+
+std::string build_preprocess_model(ONNXTensorElementDataType output_type, int64_t width,
+				   int64_t height)
+{
+	if (output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT &&
+	    output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16 &&
+	    output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8) {
+		return std::string();
+	}
+	// ONNXTensorElementDataType uses the TensorProto.DataType values
+	const int u8 = ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+	const int i64 = ONNX_TENSOR_ELEMENT_DATA_TYPE_INT64;
+	const bool cast = output_type != ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8;
+
+	proto_message graph;
+	graph.message(1, node("Slice", {"frame", "roi_starts", "roi_ends"}, "bgr"));
+	// half_pixel is what cv::resize INTER_LINEAR does
+	graph.message(1, node("Resize", {"bgr", "", "", "resize_sizes"}, "resized",
+			      {string_attribute("mode", "linear"),
+			       string_attribute("coordinate_transformation_mode", "half_pixel")}));
+	graph.message(1, node("Pad", {"resized", "pads", "pad_value"}, "padded"));
+	graph.message(1, node("Transpose", {"padded"}, cast ? "planar" : PREPROCESS_OUTPUT_NAME,
+			      {ints_attribute("perm", {0, 3, 1, 2})}));
+	if (cast) {
+		graph.message(1, node("Cast", {"planar"}, PREPROCESS_OUTPUT_NAME,
+				      {int_attribute("to", output_type)}));
+	}
+	graph.bytes(2, "obs_detect_preprocess");
+	// scalar uint8 114, the letterbox color of static_resize
+	graph.message(5, proto_message().varint(2, (uint64_t)u8).bytes(8, "pad_value").bytes(
+				 9, std::string(1, (char)114)));
+	graph.message(11, value_info("frame", u8,
+				     {{1, nullptr}, {0, "height"}, {0, "width"}, {4, nullptr}}));
+	graph.message(11, value_info("roi_starts", i64, {{4, nullptr}}));
+	graph.message(11, value_info("roi_ends", i64, {{4, nullptr}}));
+	graph.message(11, value_info("resize_sizes", i64, {{4, nullptr}}));
+	graph.message(11, value_info("pads", i64, {{8, nullptr}}));
+	graph.message(12, value_info(PREPROCESS_OUTPUT_NAME, output_type,
+				     {{1, nullptr}, {3, nullptr}, {height, nullptr}, {width, nullptr}}));
+
+	proto_message model;
+	model.varint(1, 8); // IR version 8 goes with opset 18
+	model.bytes(2, "obs-detect");
+	model.message(7, graph);
+	model.message(8, proto_message().bytes(1, "").varint(2, 18));
+	return model.data();
+}
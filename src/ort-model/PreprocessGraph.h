@@ -0,0 +1,32 @@
+#ifndef PREPROCESS_GRAPH_H
+#define PREPROCESS_GRAPH_H
+
+#include <onnxruntime_cxx_api.h>
+
+#include <cstdint>
+#include <string>
+
+// Inputs of the preprocessing graph, in the order they are fed to the session
+static const char *const PREPROCESS_INPUT_NAMES[] = {"frame", "roi_starts", "roi_ends",
+						      "resize_sizes", "pads"};
+static const char *const PREPROCESS_OUTPUT_NAME = "images";
+
+/**
+ * Build a serialized ONNX model that letterboxes a BGRA frame into a detection model input:
+ *
+ *   frame [1,H,W,4] uint8 -> Slice (ROI and BGR channels) -> Resize (linear)
+ *   -> Pad (114) -> Transpose (NHWC to NCHW) -> Cast -> images [1,3,height,width]
+ *
+ * This is the graph equivalent of static_resize + blobFromImage, so ONNX Runtime's kernels
+ * and thread pool do the conversion. The frame size is dynamic: the ROI, the resized size and
+ * the padding are int64 inputs computed per frame.
+ *
+ * @param output_type Element type of the model input, float, float16 or uint8.
+ * @param width Width of the model input.
+ * @param height Height of the model input.
+ * @return The ModelProto bytes, empty if output_type is not supported.
+ */
+std::string build_preprocess_model(ONNXTensorElementDataType output_type, int64_t width,
+				   int64_t height);
+
+#endif /* PREPROCESS_GRAPH_H */
@@ -0,0 +1,268 @@
+#include "SessionTuning.h"
+
+#include "plugin-support.h"
+#include "ExecutionProviders.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <vector>
+
+namespace {
+
+// a candidate has to beat the current best by this much to count as faster, not as noise
+constexpr double MIN_IMPROVEMENT = 0.97;
+constexpr int WARMUP_RUNS = 3;
+constexpr int TIMED_RUNS = 15;
+
+void fill_synthetic(Ort::Value &value, uint32_t &seed)
+{
+	auto info = value.GetTensorTypeAndShapeInfo();
+	const size_t count = info.GetElementCount();
+	auto next = [&seed] {
+		// xorshift32, image-like values without pulling in <random>
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		return seed & 0xFF;
+	};
+	switch (info.GetElementType()) {
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT: {
+		float *data = value.GetTensorMutableData<float>();
+		for (size_t i = 0; i < count; ++i) {
+			data[i] = (float)next();
+		}
+		break;
+	}
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT16: {
+		// 128.0 .. 255.875
+		uint16_t *data = (uint16_t *)value.GetTensorMutableRawData();
+		for (size_t i = 0; i < count; ++i) {
+			data[i] = (uint16_t)(0x5800 | (next() << 2));
+		}
+		break;
+	}
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_UINT8:
+	case ONNX_TENSOR_ELEMENT_DATA_TYPE_INT8: {
+		uint8_t *data = (uint8_t *)value.GetTensorMutableRawData();
+		for (size_t i = 0; i < count; ++i) {
+			data[i] = (uint8_t)next();
+		}
+		break;
+	}
+	default:
+		// other inputs keep whatever the allocator returned, only timing matters here
+		break;
+	}
+}
+
+// median run time in milliseconds
+double time_candidate(Ort::Env &env, const file_name_t &model_path, const SessionTuning &tuning)
+{
+	Ort::SessionOptions session_options;
+	session_options.SetGraphOptimizationLevel(GraphOptimizationLevel::ORT_ENABLE_ALL);
+	tuning.apply(session_options);
+	Ort::Session session(env, model_path.c_str(), session_options);
+
+	Ort::AllocatorWithDefaultOptions allocator;
+	std::vector<std::string> input_names, output_names;
+	std::vector<Ort::Value> inputs;
+	uint32_t seed = 0x2545F491;
+	for (size_t i = 0; i < session.GetInputCount(); ++i) {
+		auto info = session.GetInputTypeInfo(i).GetTensorTypeAndShapeInfo();
+		std::vector<int64_t> shape = info.GetShape();
+		for (size_t d = 0; d < shape.size(); ++d) {
+			// dynamic batch / channels get 1, dynamic spatial dimensions a typical size
+			if (shape[d] <= 0) {
+				shape[d] = d < 2 ? 1 : 320;
+			}
+		}
+		inputs.push_back(Ort::Value::CreateTensor(allocator, shape.data(), shape.size(),
+							  info.GetElementType()));
+		fill_synthetic(inputs.back(), seed);
+		input_names.push_back(session.GetInputNameAllocated(i, allocator).get());
+	}
+	for (size_t i = 0; i < session.GetOutputCount(); ++i) {
+		output_names.push_back(session.GetOutputNameAllocated(i, allocator).get());
+	}
+	std::vector<const char *> input_ptrs, output_ptrs;
+	for (const std::string &name : input_names) {
+		input_ptrs.push_back(name.c_str());
+	}
+	for (const std::string &name : output_names) {
+		output_ptrs.push_back(name.c_str());
+	}
+
+	Ort::RunOptions run_options;
+	auto run = [&] {
+		session.Run(run_options, input_ptrs.data(), inputs.data(), inputs.size(),
+			    output_ptrs.data(), output_ptrs.size());
+	};
+	for (int i = 0; i < WARMUP_RUNS; ++i) {
+		run();
+	}
+	std::vector<double> times;
+	for (int i = 0; i < TIMED_RUNS; ++i) {
+		const auto start = std::chrono::steady_clock::now();
+		run();
+		times.push_back(std::chrono::duration<double, std::milli>(
+					std::chrono::steady_clock::now() - start)
+					.count());
+	}
+	std::nth_element(times.begin(), times.begin() + TIMED_RUNS / 2, times.end());
+	return times[TIMED_RUNS / 2];
+}
+
+} // namespace
+
+void SessionTuning::apply(Ort::SessionOptions &session_options) const
+{
+	if (this->parallel) {
+		session_options.SetExecutionMode(ExecutionMode::ORT_PARALLEL);
+		session_options.SetInterOpNumThreads(this->inter_op_threads);
+	} else {
+		session_options.SetExecutionMode(ExecutionMode::ORT_SEQUENTIAL);
+	}
+	session_options.SetIntraOpNumThreads(this->intra_op_threads);
+	session_options.AddConfigEntry("session.intra_op.allow_spinning",
+				       this->allow_spinning ? "1" : "0");
+	session_options.AddConfigEntry("session.inter_op.allow_spinning",
+				       this->allow_spinning ? "1" : "0");
+	if (this->memory_pattern) {
+		session_options.EnableMemPattern();
+	} else {
+		session_options.DisableMemPattern();
+	}
+	if (this->cpu_arena) {
+		session_options.EnableCpuMemArena();
+	} else {
+		session_options.DisableCpuMemArena();
+	}
+}
+
+std::string SessionTuning::describe() const
+{
+	char text[160];
+	snprintf(text, sizeof(text),
+		 "%s, intra-op threads %d, inter-op threads %d, spinning %s, memory pattern %s, "
+		 "arena %s",
+		 this->parallel ? "parallel" : "sequential", this->intra_op_threads,
+		 this->parallel ? this->inter_op_threads : 1, this->allow_spinning ? "on" : "off",
+		 this->memory_pattern ? "on" : "off", this->cpu_arena ? "on" : "off");
+	return text;
+}
+
+nlohmann::json SessionTuning::toJson() const
+{
+	return {{"parallel", this->parallel},
+		{"intra_op_threads", this->intra_op_threads},
+		{"inter_op_threads", this->inter_op_threads},
+		{"allow_spinning", this->allow_spinning},
+		{"memory_pattern", this->memory_pattern},
+		{"cpu_arena", this->cpu_arena}};
+}
+
+bool SessionTuning::fromJson(const nlohmann::json &j, SessionTuning &tuning)
+{
+	try {
+		SessionTuning t;
+		t.parallel = j.at("parallel").get<bool>();
+		t.intra_op_threads = j.at("intra_op_threads").get<int>();
+		t.inter_op_threads = j.at("inter_op_threads").get<int>();
+		t.allow_spinning = j.at("allow_spinning").get<bool>();
+		t.memory_pattern = j.at("memory_pattern").get<bool>();
+		t.cpu_arena = j.at("cpu_arena").get<bool>();
+		if (t.intra_op_threads < 0 || t.inter_op_threads < 1) {
+			return false;
+		}
+		tuning = t;
+		return true;
+	} catch (const nlohmann::json::exception &) {
+		return false;
+	}
+}
+
+std::string modelFileHash(const file_name_t &path)
+{
+	std::ifstream file(path, std::ios::binary);
+	if (!file) {
+		return std::string();
+	}
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	std::vector<char> buffer(1 << 16);
+	while (file) {
+		file.read(buffer.data(), (std::streamsize)buffer.size());
+		const std::streamsize n = file.gcount();
+		for (std::streamsize i = 0; i < n; ++i) {
+			hash = (hash ^ (uint8_t)buffer[(size_t)i]) * 0x100000001b3ULL;
+		}
+	}
+	char hex[17];
+	snprintf(hex, sizeof(hex), "%016llx", (unsigned long long)hash);
+	return hex;
+}
+
+bool autotuneSession(const file_name_t &model_path, int max_threads,
+		     const std::atomic<bool> &cancel, SessionTuning &best, double &best_ms)
+{
+	Ort::Env env(ORT_LOGGING_LEVEL_WARNING, "AutoTune", forwardOrtLog, nullptr);
+
+	auto measure = [&](const SessionTuning &candidate, double &ms) {
+		try {
+			ms = time_candidate(env, model_path, candidate);
+			obs_log(LOG_INFO, "Auto-tune: %s: %.2f ms", candidate.describe().c_str(), ms);
+			return true;
+		} catch (const std::exception &e) {
+			obs_log(LOG_WARNING, "Auto-tune: %s failed: %s",
+				candidate.describe().c_str(), e.what());
+			return false;
+		}
+	};
+	// keep the candidate if it is faster, toggles must beat the noise margin
+	auto try_candidate = [&](const SessionTuning &candidate, double margin) {
+		double ms = 0.0;
+		if (!cancel && measure(candidate, ms) && ms < best_ms * margin) {
+			best = candidate;
+			best_ms = ms;
+		}
+	};
+
+	best = SessionTuning();
+	if (!measure(best, best_ms)) {
+		return false;
+	}
+
+	max_threads = std::max(max_threads, 1);
+	for (int threads = 2; threads <= max_threads; threads *= 2) {
+		SessionTuning candidate = best;
+		candidate.intra_op_threads = threads;
+		try_candidate(candidate, 1.0);
+	}
+	if ((max_threads & (max_threads - 1)) != 0) {
+		SessionTuning candidate = best;
+		candidate.intra_op_threads = max_threads;
+		try_candidate(candidate, 1.0);
+	}
+
+	SessionTuning candidate = best;
+	candidate.parallel = true;
+	candidate.inter_op_threads = 2;
+	try_candidate(candidate, MIN_IMPROVEMENT);
+
+	candidate = best;
+	candidate.allow_spinning = false;
+	try_candidate(candidate, MIN_IMPROVEMENT);
+
+	candidate = best;
+	candidate.memory_pattern = false;
+	try_candidate(candidate, MIN_IMPROVEMENT);
+
+	candidate = best;
+	candidate.cpu_arena = false;
+	try_candidate(candidate, MIN_IMPROVEMENT);
+
+	return !cancel;
+}
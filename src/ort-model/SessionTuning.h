@@ -0,0 +1,52 @@
+#ifndef SESSION_TUNING_H
+#define SESSION_TUNING_H
+
+#include <onnxruntime_cxx_api.h>
+#include <nlohmann/json.hpp>
+
+#include <atomic>
+#include <string>
+
+#include "types.hpp"
+
+// CPU session settings that are worth measuring rather than guessing
+struct SessionTuning {
+	bool parallel = false;
+	int intra_op_threads = 1;
+	int inter_op_threads = 1;
+	bool allow_spinning = true;
+	bool memory_pattern = true;
+	bool cpu_arena = true;
+
+	void apply(Ort::SessionOptions &session_options) const;
+	std::string describe() const;
+
+	nlohmann::json toJson() const;
+	static bool fromJson(const nlohmann::json &j, SessionTuning &tuning);
+};
+
+/**
+ * Hash of the model file contents (64-bit FNV-1a, hex), identifies the model a tuning
+ * result belongs to regardless of where the file lives.
+ *
+ * @return The hash, empty if the file cannot be read.
+ */
+std::string modelFileHash(const file_name_t &path);
+
+/**
+ * Benchmark session settings for a model on synthetic input and pick the fastest.
+ *
+ * Thread counts are searched first, then execution mode, spinning, memory pattern and arena
+ * are each toggled and kept only when they are measurably faster.
+ *
+ * @param model_path The model to tune.
+ * @param max_threads Upper bound for the intra-op thread count.
+ * @param cancel Checked between candidates, tuning stops when it becomes true.
+ * @param best The fastest settings found.
+ * @param best_ms Median run time of the fastest settings.
+ * @return false if tuning was cancelled or the model cannot run.
+ */
+bool autotuneSession(const file_name_t &model_path, int max_threads,
+		     const std::atomic<bool> &cancel, SessionTuning &best, double &best_ms);
+
+#endif /* SESSION_TUNING_H */
@@ -14,6 +14,8 @@ struct Object {
 	int label;
 	float prob;
 	uint64_t id;
+	// id of the object a cascade stage found this one in, 0 for first stage objects
+	uint64_t parent_id = 0;
 };
 
 struct GridAndStride {
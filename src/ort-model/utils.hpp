@@ -6,6 +6,7 @@
 #include <string>
 #include <opencv2/opencv.hpp>
 #include "types.hpp"
+#include "overlay/GlyphAtlas.h"
 
 static std::vector<std::string> read_class_labels_file(file_name_t file_name)
 {
@@ -52,9 +53,11 @@ const float color_list[80][3] = {
 	{0.714f, 0.714f, 0.714f}, {0.857f, 0.857f, 0.857f}, {0.000f, 0.447f, 0.741f},
 	{0.314f, 0.717f, 0.741f}, {0.50f, 0.5f, 0.0f}};
 
-static void draw_objects(cv::Mat bgr, const std::vector<Object> &objects,
+// Draws on 8-bit BGR or BGRA images, labels are blended from the cached glyph atlas
+static void draw_objects(cv::Mat image, const std::vector<Object> &objects,
 			 const std::vector<std::string> &class_names)
 {
+	const overlay::GlyphAtlas &atlas = overlay::GlyphAtlas::instance();
 	for (size_t i = 0; i < objects.size(); i++) {
 		const Object &obj = objects[i];
 
@@ -70,34 +73,33 @@ static void draw_objects(cv::Mat bgr, const std::vector<Object> &objects,
 			txt_color = cv::Scalar(255, 255, 255);
 		}
 
-		cv::rectangle(bgr, obj.rect, color * 255, 2);
+		// opaque on BGRA
+		const cv::Scalar opaque(0, 0, 0, 255);
+		cv::rectangle(image, obj.rect, color * 255 + opaque, 2);
 
 		char text[256];
 		snprintf(text, sizeof(text), "%s %.1f%%", class_names[obj.label].c_str(),
 			 obj.prob * 100);
 
-		int baseLine = 0;
-		cv::Size label_size =
-			cv::getTextSize(text, cv::FONT_HERSHEY_SIMPLEX, 0.4, 1, &baseLine);
+		int baseLine = atlas.descent();
+		cv::Size label_size(atlas.textWidth(text), atlas.ascent());
 
-		cv::Scalar txt_bk_color = color * 0.7 * 255;
+		cv::Scalar txt_bk_color = color * 0.7 * 255 + opaque;
 
 		int x = (int)(obj.rect.x);
 		int y = (int)(obj.rect.y + 1);
-		if (y > bgr.rows)
-			y = bgr.rows;
+		if (y > image.rows)
+			y = image.rows;
 
-		cv::rectangle(bgr,
+		cv::rectangle(image,
 			      cv::Rect(cv::Point(x, y),
 				       cv::Size(label_size.width, label_size.height + baseLine)),
 			      txt_bk_color, -1);
 
-		cv::putText(bgr, text, cv::Point(x, y + label_size.height),
-			    cv::FONT_HERSHEY_SIMPLEX, 0.4, txt_color, 1);
+		atlas.drawText(image, cv::Point(x, y + label_size.height), text, txt_color);
 
 		snprintf(text, sizeof(text), "ID: %d", (int)obj.id);
-		cv::putText(bgr, text, cv::Point(x, y + label_size.height + 15),
-			    cv::FONT_HERSHEY_SIMPLEX, 0.4, txt_color, 1);
+		atlas.drawText(image, cv::Point(x, y + label_size.height + 15), text, txt_color);
 	}
 }
 
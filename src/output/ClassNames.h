@@ -0,0 +1,31 @@
+#ifndef CLASS_NAMES_H
+#define CLASS_NAMES_H
+
+#include <string>
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+namespace output {
+
+/**
+ * The class names of a filter's models. Objects a cascade stage found, those with a parent,
+ * carry label ids of the cascade model and are named from its classes.
+ */
+struct ClassNames {
+	const std::vector<std::string> &first_stage;
+	const std::vector<std::string> &cascade;
+
+	// The class name of an object, "" if its model has none for its label id
+	const std::string &name(const Object &obj) const
+	{
+		static const std::string none;
+		const std::vector<std::string> &names = obj.parent_id != 0 ? cascade : first_stage;
+		return obj.label >= 0 && (size_t)obj.label < names.size() ? names[obj.label]
+									   : none;
+	}
+};
+
+} // namespace output
+
+#endif /* CLASS_NAMES_H */
@@ -0,0 +1,145 @@
+#include "DeltaEncoder.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace output {
+
+namespace {
+
+uint64_t mix(uint64_t value)
+{
+	// splitmix64 finalizer
+	value ^= value >> 30;
+	value *= 0xbf58476d1ce4e5b9ull;
+	value ^= value >> 27;
+	value *= 0x94d049bb133111ebull;
+	return value ^ (value >> 31);
+}
+
+float iou(const cv::Rect_<float> &a, const cv::Rect_<float> &b)
+{
+	const float overlap = (a & b).area();
+	const float total = a.area() + b.area() - overlap;
+	return total > 0.0f ? overlap / total : 1.0f;
+}
+
+} // namespace
+
+void DeltaEncoder::configure(const DeltaConfig &config)
+{
+	if (config != config_) {
+		config_ = config;
+		reset();
+	}
+}
+
+void DeltaEncoder::reset()
+{
+	started_ = false;
+	sent_.clear();
+}
+
+void DeltaEncoder::computeKeys(const std::vector<Object> &objects)
+{
+	keys_.clear();
+	ordinals_.clear();
+	parent_keys_.clear();
+	for (const Object &obj : objects) {
+		if (config_.tracked && obj.id != 0) {
+			keys_.push_back(obj.id);
+			continue;
+		}
+		// untracked ids change with the scores, children go by their parent's key instead;
+		// the cascade stage appends them after the parents
+		uint64_t parent = obj.parent_id;
+		if (!config_.tracked && parent != 0) {
+			auto found = parent_keys_.find(parent);
+			parent = found != parent_keys_.end() ? found->second : 0;
+		}
+		const uint64_t group = mix(parent * 0x9e3779b97f4a7c15ull + (uint32_t)obj.label);
+		const uint64_t ordinal = ordinals_[group]++;
+		keys_.push_back(UNTRACKED_KEY | mix(group + ordinal));
+		if (!config_.tracked && obj.parent_id == 0 && obj.id != 0) {
+			parent_keys_[obj.id] = keys_.back();
+		}
+	}
+}
+
+bool DeltaEncoder::changed(const Object &sent, const Object &current) const
+{
+	if (sent.label != current.label || sent.parent_id != current.parent_id) {
+		return true;
+	}
+	const cv::Rect_<float> &a = sent.rect;
+	const cv::Rect_<float> &b = current.rect;
+	const float moved = std::max({std::fabs(a.x - b.x), std::fabs(a.y - b.y),
+				      std::fabs(a.x + a.width - b.x - b.width),
+				      std::fabs(a.y + a.height - b.y - b.height)});
+	// jitter of small boxes stays within the pixels, of large ones within the overlap
+	if (moved > config_.pixel_tolerance &&
+	    (config_.iou_tolerance <= 0.0f || iou(a, b) < config_.iou_tolerance)) {
+		return true;
+	}
+	return config_.score_band > 0.0f &&
+	       std::floor(sent.prob / config_.score_band) !=
+		       std::floor(current.prob / config_.score_band);
+}
+
+void DeltaEncoder::encode(const std::vector<Object> &objects, uint64_t timestamp_ns,
+			  Delta &delta)
+{
+	delta.keyframe = false;
+	delta.objects.clear();
+	delta.object_keys.clear();
+	delta.entered.clear();
+	delta.entered_keys.clear();
+	delta.updated.clear();
+	delta.updated_keys.clear();
+	delta.exited.clear();
+
+	computeKeys(objects);
+	round_++;
+
+	if (!started_ || (config_.keyframe_interval_ns > 0 &&
+			  timestamp_ns - keyframe_ns_ >= config_.keyframe_interval_ns)) {
+		started_ = true;
+		keyframe_ns_ = timestamp_ns;
+		sent_.clear();
+		delta.keyframe = true;
+		delta.objects = objects;
+		delta.object_keys = keys_;
+		for (size_t i = 0; i < objects.size(); ++i) {
+			sent_[keys_[i]] = {objects[i], round_};
+		}
+		return;
+	}
+
+	for (size_t i = 0; i < objects.size(); ++i) {
+		auto found = sent_.find(keys_[i]);
+		if (found == sent_.end()) {
+			sent_.emplace(keys_[i], Sent{objects[i], round_});
+			delta.entered.push_back(objects[i]);
+			delta.entered_keys.push_back(keys_[i]);
+			continue;
+		}
+		found->second.round = round_;
+		// compared with what was sent, slow drift adds up until it is sent
+		if (changed(found->second.object, objects[i])) {
+			found->second.object = objects[i];
+			delta.updated.push_back(objects[i]);
+			delta.updated_keys.push_back(keys_[i]);
+		}
+	}
+	for (auto it = sent_.begin(); it != sent_.end();) {
+		if (it->second.round != round_) {
+			delta.exited.push_back(it->first);
+			it = sent_.erase(it);
+		} else {
+			++it;
+		}
+	}
+	std::sort(delta.exited.begin(), delta.exited.end());
+}
+
+} // namespace output
@@ -0,0 +1,100 @@
+#ifndef DELTA_ENCODER_H
+#define DELTA_ENCODER_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+namespace output {
+
+struct DeltaConfig {
+	// an object is updated when an edge of its box moves further than this from where it was
+	// last sent and the box also overlaps that position less than iou_tolerance (0: any
+	// overlap); a box within either tolerance has not moved
+	float pixel_tolerance = 8.0f;
+	float iou_tolerance = 0.9f;
+	// or its confidence moves into another band of this width (0: never)
+	float score_band = 0.1f;
+	// a full snapshot this often, 0 for only the first one
+	uint64_t keyframe_interval_ns = 10'000'000'000ull;
+	// object ids are track ids; otherwise they only link cascade children to their parents
+	// within one result (NMS numbers them by score)
+	bool tracked = false;
+
+	bool operator==(const DeltaConfig &other) const
+	{
+		return pixel_tolerance == other.pixel_tolerance &&
+		       iou_tolerance == other.iou_tolerance && score_band == other.score_band &&
+		       keyframe_interval_ns == other.keyframe_interval_ns &&
+		       tracked == other.tracked;
+	}
+	bool operator!=(const DeltaConfig &other) const { return !(*this == other); }
+};
+
+// The changes of one result against what the consumer has been sent before
+struct Delta {
+	bool keyframe = false; // objects is the full list, the consumer starts over from it
+	std::vector<Object> objects;
+	std::vector<uint64_t> object_keys;
+	std::vector<Object> entered;
+	std::vector<uint64_t> entered_keys;
+	std::vector<Object> updated;
+	std::vector<uint64_t> updated_keys;
+	std::vector<uint64_t> exited;
+
+	bool empty() const
+	{
+		return !keyframe && entered.empty() && updated.empty() && exited.empty();
+	}
+};
+
+/**
+ * Turns a stream of results into enter, update and exit events for a consumer that keeps the
+ * objects it was sent, with a full snapshot on the first result and then periodically.
+ *
+ * Objects are matched by key: their track id, or for untracked objects (tracking off, cascade
+ * stage children) a key made of the parent's key, the label and the order among the objects
+ * with the same parent and label. Keys of untracked objects have the top bit set and never
+ * collide with track ids.
+ *
+ * One encoder serves one consumer: a result that is not encoded, e.g. dropped for a slow
+ * consumer, must not be skipped silently, call reset() instead so the next one is a keyframe.
+ */
+class DeltaEncoder {
+public:
+	static constexpr uint64_t UNTRACKED_KEY = 1ull << 63;
+
+	explicit DeltaEncoder(const DeltaConfig &config = DeltaConfig()) : config_(config) {}
+
+	const DeltaConfig &config() const { return config_; }
+	// A new configuration takes effect with a keyframe
+	void configure(const DeltaConfig &config);
+	void reset();
+
+	// The changes in objects since the last result, delta.empty() when there are none
+	void encode(const std::vector<Object> &objects, uint64_t timestamp_ns, Delta &delta);
+
+private:
+	struct Sent {
+		Object object; // as last sent
+		uint64_t round; // the last result it was in
+	};
+
+	bool changed(const Object &sent, const Object &current) const;
+	void computeKeys(const std::vector<Object> &objects);
+
+	DeltaConfig config_;
+	bool started_ = false;
+	uint64_t keyframe_ns_ = 0;
+	uint64_t round_ = 0;
+	std::unordered_map<uint64_t, Sent> sent_; // by key
+	std::vector<uint64_t> keys_;              // of the objects being encoded
+	std::unordered_map<uint64_t, uint64_t> ordinals_;
+	std::unordered_map<uint64_t, uint64_t> parent_keys_; // by the untracked parents' ids
+};
+
+} // namespace output
+
+#endif /* DELTA_ENCODER_H */
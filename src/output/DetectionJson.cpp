@@ -0,0 +1,165 @@
+#include "DetectionJson.h"
+
+#include <cmath>
+#include <cstdio>
+#include <iterator>
+
+namespace output {
+
+namespace {
+
+void append_float(std::string &out, float value)
+{
+	if (!std::isfinite(value)) {
+		out += "null";
+		return;
+	}
+	// float precision, the way the values were computed
+	char digits[32];
+	const int length = snprintf(digits, sizeof(digits), "%.7g", value);
+	for (int i = 0; i < length; ++i) {
+		// the UI may have switched the C locale to a decimal comma
+		out += digits[i] == ',' ? '.' : digits[i];
+	}
+}
+
+void append_newline(std::string &out, bool pretty, int depth)
+{
+	if (pretty) {
+		out += '\n';
+		out.append((size_t)depth * 4, ' ');
+	}
+}
+
+void append_key(std::string &out, const char *key, bool pretty)
+{
+	out += '"';
+	out += key;
+	out += pretty ? "\": " : "\":";
+}
+
+// keys, when given, adds the delta key of each object
+void append_objects(std::string &out, const std::vector<Object> &objects,
+		    const std::vector<uint64_t> *keys, bool pretty)
+{
+	// the layout of the former nlohmann::json dump(4), keys in the same sorted order
+	out += '[';
+	for (size_t i = 0; i < objects.size(); ++i) {
+		const Object &obj = objects[i];
+		if (i > 0) {
+			out += ',';
+		}
+		append_newline(out, pretty, 1);
+		out += '{';
+		append_newline(out, pretty, 2);
+		append_key(out, "confidence", pretty);
+		append_float(out, obj.prob);
+		out += ',';
+		append_newline(out, pretty, 2);
+		append_key(out, "id", pretty);
+		out += std::to_string(obj.id);
+		out += ',';
+		if (keys) {
+			append_newline(out, pretty, 2);
+			append_key(out, "key", pretty);
+			out += std::to_string((*keys)[i]);
+			out += ',';
+		}
+		append_newline(out, pretty, 2);
+		append_key(out, "label", pretty);
+		out += std::to_string(obj.label);
+		out += ',';
+		if (obj.parent_id != 0) {
+			append_newline(out, pretty, 2);
+			append_key(out, "parent_id", pretty);
+			out += std::to_string(obj.parent_id);
+			out += ',';
+		}
+		append_newline(out, pretty, 2);
+		append_key(out, "rect", pretty);
+		out += '{';
+		const std::pair<const char *, float> rect[] = {{"height", obj.rect.height},
+							       {"width", obj.rect.width},
+							       {"x", obj.rect.x},
+							       {"y", obj.rect.y}};
+		for (size_t r = 0; r < std::size(rect); ++r) {
+			if (r > 0) {
+				out += ',';
+			}
+			append_newline(out, pretty, 3);
+			append_key(out, rect[r].first, pretty);
+			append_float(out, rect[r].second);
+		}
+		append_newline(out, pretty, 2);
+		out += '}';
+		append_newline(out, pretty, 1);
+		out += '}';
+	}
+	if (!objects.empty()) {
+		append_newline(out, pretty, 0);
+	}
+	out += ']';
+}
+
+} // namespace
+
+void appendObjectsJson(std::string &out, const std::vector<Object> &objects, bool pretty)
+{
+	append_objects(out, objects, nullptr, pretty);
+}
+
+void appendDeltaJson(std::string &out, const Delta &delta)
+{
+	if (delta.keyframe) {
+		out += "\"keyframe\":true,\"objects\":";
+		append_objects(out, delta.objects, &delta.object_keys, false);
+		return;
+	}
+	out += "\"enter\":";
+	append_objects(out, delta.entered, &delta.entered_keys, false);
+	out += ",\"update\":";
+	append_objects(out, delta.updated, &delta.updated_keys, false);
+	out += ",\"exit\":[";
+	for (size_t i = 0; i < delta.exited.size(); ++i) {
+		if (i > 0) {
+			out += ',';
+		}
+		out += std::to_string(delta.exited[i]);
+	}
+	out += ']';
+}
+
+void appendJsonString(std::string &out, const std::string &value)
+{
+	out += '"';
+	for (const char c : value) {
+		switch (c) {
+		case '"':
+			out += "\\\"";
+			break;
+		case '\\':
+			out += "\\\\";
+			break;
+		case '\n':
+			out += "\\n";
+			break;
+		case '\r':
+			out += "\\r";
+			break;
+		case '\t':
+			out += "\\t";
+			break;
+		default:
+			if ((unsigned char)c < 0x20) {
+				char escaped[8];
+				snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+				out += escaped;
+			} else {
+				out += c;
+			}
+		}
+	}
+	out += '"';
+}
+
+} // namespace output
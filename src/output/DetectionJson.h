@@ -0,0 +1,31 @@
+#ifndef DETECTION_JSON_H
+#define DETECTION_JSON_H
+
+#include <string>
+#include <vector>
+
+#include "ort-model/types.hpp"
+#include "DeltaEncoder.h"
+
+namespace output {
+
+/**
+ * Append the objects as a JSON array to out, in the layout of the former nlohmann::json
+ * dump(4) with sorted keys when pretty, on one line otherwise. Written by hand so that out
+ * keeps its capacity from result to result.
+ */
+void appendObjectsJson(std::string &out, const std::vector<Object> &objects, bool pretty);
+
+/**
+ * Append the members of a delta, without the braces: "keyframe":true and "objects" for a
+ * keyframe, otherwise "enter" and "update" with the objects and "exit" with the keys that
+ * left. Every object carries its "key".
+ */
+void appendDeltaJson(std::string &out, const Delta &delta);
+
+// Append value as a quoted and escaped JSON string
+void appendJsonString(std::string &out, const std::string &value);
+
+} // namespace output
+
+#endif /* DETECTION_JSON_H */
@@ -0,0 +1,79 @@
+#include "DetectionResult.h"
+
+#include <atomic>
+
+#include "DetectionJson.h"
+
+namespace output {
+
+namespace {
+
+struct ResultBlock : obs_detect_result {
+	mutable std::atomic<int> references{1};
+	std::vector<obs_detect_object> object_storage;
+	std::vector<std::string> labels;
+	std::string json_storage;
+};
+
+void retain_result(const obs_detect_result *result)
+{
+	const ResultBlock *block = static_cast<const ResultBlock *>(result);
+	block->references.fetch_add(1, std::memory_order_relaxed);
+}
+
+void release_result(const obs_detect_result *result)
+{
+	const ResultBlock *block = static_cast<const ResultBlock *>(result);
+	if (block->references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+		delete block;
+	}
+}
+
+} // namespace
+
+const obs_detect_result *createResult(const std::vector<Object> &objects, uint64_t sequence,
+				      uint64_t timestamp_ns, const cv::Size &frame_size,
+				      const ClassNames &class_names, bool tracked)
+{
+	ResultBlock *block = new ResultBlock();
+	block->labels.reserve(objects.size());
+	block->object_storage.reserve(objects.size());
+	for (const Object &obj : objects) {
+		block->labels.push_back(class_names.name(obj));
+	}
+	for (size_t i = 0; i < objects.size(); ++i) {
+		const Object &obj = objects[i];
+		const ObjectIds ids = publishedIds(objects, i, tracked);
+		block->object_storage.push_back({obj.rect.x, obj.rect.y, obj.rect.width,
+						 obj.rect.height, obj.prob, obj.label,
+						 block->labels[i].c_str(), ids.track_id,
+						 ids.parent_id});
+	}
+
+	std::string &json = block->json_storage;
+	json += "{\"seq\":";
+	json += std::to_string(sequence);
+	json += ",\"timestamp_ns\":";
+	json += std::to_string(timestamp_ns);
+	json += ",\"width\":";
+	json += std::to_string(frame_size.width);
+	json += ",\"height\":";
+	json += std::to_string(frame_size.height);
+	json += ",\"objects\":";
+	appendObjectsJson(json, objects, false);
+	json += '}';
+
+	block->version = OBS_DETECT_RESULT_VERSION;
+	block->frame_width = (uint32_t)frame_size.width;
+	block->frame_height = (uint32_t)frame_size.height;
+	block->sequence = sequence;
+	block->timestamp_ns = timestamp_ns;
+	block->count = block->object_storage.size();
+	block->objects = block->object_storage.data();
+	block->json = block->json_storage.c_str();
+	block->retain = retain_result;
+	block->release = release_result;
+	return block;
+}
+
+} // namespace output
@@ -0,0 +1,28 @@
+#ifndef DETECTION_RESULT_H
+#define DETECTION_RESULT_H
+
+#include <opencv2/core/types.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ort-model/types.hpp"
+#include "ClassNames.h"
+#include "ObjectIds.h"
+#include "detection-result.h"
+
+namespace output {
+
+/**
+ * A new reference-counted result block for the signal and proc handlers, holding one reference
+ * for the caller. The objects, labels and JSON are copied into the block. tracked: the object
+ * ids are track ids, see publishedIds().
+ */
+const obs_detect_result *createResult(const std::vector<Object> &objects, uint64_t sequence,
+				      uint64_t timestamp_ns, const cv::Size &frame_size,
+				      const ClassNames &class_names, bool tracked);
+
+} // namespace output
+
+#endif /* DETECTION_RESULT_H */
@@ -0,0 +1,242 @@
+#include "DetectionWriter.h"
+
+#include <obs.h>
+
+#include <ctime>
+#include <filesystem>
+
+#include "plugin-support.h"
+#include "DetectionJson.h"
+
+namespace output {
+
+namespace {
+
+std::string rotated_name(const std::filesystem::path &path)
+{
+	const std::time_t now = std::time(nullptr);
+	std::tm local{};
+#ifdef _WIN32
+	localtime_s(&local, &now);
+#else
+	localtime_r(&now, &local);
+#endif
+	char stamp[32];
+	std::strftime(stamp, sizeof(stamp), "-%Y%m%d-%H%M%S", &local);
+	return path.stem().u8string() + stamp + path.extension().u8string();
+}
+
+} // namespace
+
+DetectionWriter::~DetectionWriter()
+{
+	configure(WriterConfig());
+}
+
+void DetectionWriter::configure(const WriterConfig &config)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (config == config_) {
+			return;
+		}
+		config_ = config;
+		generation_++;
+		// results meant for the previous file are not written to the new one
+		queue_.clear();
+		if (!config.path.empty()) {
+			if (!thread_.joinable()) {
+				stop_ = false;
+				thread_ = std::thread(&DetectionWriter::run, this);
+			}
+			return;
+		}
+		stop_ = true;
+	}
+	changed_.notify_all();
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+}
+
+void DetectionWriter::submit(const std::vector<Object> &objects, uint64_t timestamp_ns)
+{
+	const int64_t wall_time_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+					     std::chrono::system_clock::now().time_since_epoch())
+					     .count();
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (config_.path.empty()) {
+			return;
+		}
+		if (config_.mode != WriteMode::Ndjson && config_.mode != WriteMode::Delta) {
+			// only the newest snapshot matters
+			queue_.clear();
+		} else if (queue_.size() >= MAX_QUEUED) {
+			queue_.pop_front();
+			dropped_++;
+		}
+		queue_.push_back({next_sequence_++, timestamp_ns, wall_time_ms, objects});
+	}
+	changed_.notify_one();
+}
+
+void DetectionWriter::run()
+{
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true) {
+		changed_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+		if (queue_.empty()) {
+			break;
+		}
+		const Record record = std::move(queue_.front());
+		queue_.pop_front();
+		const WriterConfig config = config_;
+		const uint64_t generation = generation_;
+		lock.unlock();
+
+		if (generation != log_generation_) {
+			closeLog();
+			log_generation_ = generation;
+		}
+		if (config.mode == WriteMode::Ndjson || config.mode == WriteMode::Delta) {
+			appendRecord(config, record);
+		} else {
+			writeSnapshot(config, record);
+		}
+
+		lock.lock();
+	}
+	lock.unlock();
+	closeLog();
+}
+
+void DetectionWriter::writeSnapshot(const WriterConfig &config, const Record &record)
+{
+	buffer_.clear();
+	appendObjectsJson(buffer_, record.objects, config.mode == WriteMode::Snapshot);
+
+	const std::filesystem::path target = std::filesystem::u8path(config.path);
+	std::filesystem::path temp = target;
+	temp += ".tmp";
+	{
+		std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+		file.write(buffer_.data(), (std::streamsize)buffer_.size());
+		file.close();
+		if (!file) {
+			reportError("Cannot write " + temp.u8string());
+			return;
+		}
+	}
+	// replaces the target in one step, a reader opens either the old or the new file
+	std::error_code ec;
+	std::filesystem::rename(temp, target, ec);
+	if (ec) {
+		reportError("Cannot replace " + config.path + ": " + ec.message());
+		return;
+	}
+	last_error_.clear();
+}
+
+void DetectionWriter::appendRecord(const WriterConfig &config, const Record &record)
+{
+	const std::filesystem::path path = std::filesystem::u8path(config.path);
+	const auto now = std::chrono::steady_clock::now();
+	if (log_.is_open() &&
+	    (log_bytes_ >= config.max_bytes ||
+	     (config.max_age.count() > 0 && now - log_opened_ >= config.max_age))) {
+		closeLog();
+		std::error_code ec;
+		std::filesystem::rename(
+			path, path.parent_path() / std::filesystem::u8path(rotated_name(path)), ec);
+		if (ec) {
+			reportError("Cannot rotate " + config.path + ": " + ec.message());
+		}
+	}
+	if (!log_.is_open()) {
+		log_.open(path, std::ios::binary | std::ios::app);
+		if (!log_) {
+			reportError("Cannot open " + config.path);
+			return;
+		}
+		std::error_code ec;
+		const uintmax_t size = std::filesystem::file_size(path, ec);
+		log_bytes_ = ec ? 0 : (uint64_t)size;
+		log_opened_ = now;
+		// a delta log can be read from the start of any of its files
+		delta_encoder_.reset();
+	}
+
+	if (config.mode == WriteMode::Delta) {
+		if (!serializeDelta(config, record)) {
+			return;
+		}
+	} else {
+		serializeRecord(record);
+	}
+	buffer_ += '\n';
+	// one write per line, a reader following the file sees whole records
+	log_.write(buffer_.data(), (std::streamsize)buffer_.size());
+	log_.flush();
+	if (!log_) {
+		reportError("Cannot append to " + config.path);
+		closeLog();
+		// what the encoder counted as sent may not be in the file
+		delta_encoder_.reset();
+		return;
+	}
+	log_bytes_ += buffer_.size();
+	last_error_.clear();
+}
+
+void DetectionWriter::closeLog()
+{
+	if (log_.is_open()) {
+		log_.close();
+	}
+	log_.clear();
+}
+
+void DetectionWriter::reportError(const std::string &error)
+{
+	if (error != last_error_) {
+		obs_log(LOG_WARNING, "Detection writer: %s", error.c_str());
+		last_error_ = error;
+	}
+}
+
+void DetectionWriter::serializeRecord(const Record &record)
+{
+	buffer_.clear();
+	buffer_ += "{\"seq\":";
+	buffer_ += std::to_string(record.sequence);
+	buffer_ += ",\"timestamp_ns\":";
+	buffer_ += std::to_string(record.timestamp_ns);
+	buffer_ += ",\"time_ms\":";
+	buffer_ += std::to_string(record.wall_time_ms);
+	buffer_ += ",\"objects\":";
+	appendObjectsJson(buffer_, record.objects, false);
+	buffer_ += '}';
+}
+
+bool DetectionWriter::serializeDelta(const WriterConfig &config, const Record &record)
+{
+	delta_encoder_.configure(config.delta);
+	delta_encoder_.encode(record.objects, record.timestamp_ns, delta_);
+	if (delta_.empty()) {
+		return false;
+	}
+	buffer_.clear();
+	buffer_ += "{\"seq\":";
+	buffer_ += std::to_string(record.sequence);
+	buffer_ += ",\"timestamp_ns\":";
+	buffer_ += std::to_string(record.timestamp_ns);
+	buffer_ += ",\"time_ms\":";
+	buffer_ += std::to_string(record.wall_time_ms);
+	buffer_ += ',';
+	appendDeltaJson(buffer_, delta_);
+	buffer_ += '}';
+	return true;
+}
+
+} // namespace output
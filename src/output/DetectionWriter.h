@@ -0,0 +1,110 @@
+#ifndef DETECTION_WRITER_H
+#define DETECTION_WRITER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ort-model/types.hpp"
+#include "DeltaEncoder.h"
+
+namespace output {
+
+enum class WriteMode {
+	Snapshot, // the latest detections, pretty printed, replaced atomically
+	Compact,  // the same on one line
+	Ndjson,   // every result appended as one line, rotated by size and age
+	Delta,    // like Ndjson, but only the changes since the last line, see DeltaEncoder
+};
+
+struct WriterConfig {
+	std::string path; // empty: nothing is written
+	WriteMode mode = WriteMode::Snapshot;
+	// NDJSON files are rotated when they get larger or older than this, an age of 0 never
+	uint64_t max_bytes = 50ull << 20;
+	std::chrono::seconds max_age{std::chrono::hours(1)};
+	DeltaConfig delta;
+
+	bool operator==(const WriterConfig &other) const
+	{
+		return path == other.path && mode == other.mode && max_bytes == other.max_bytes &&
+		       max_age == other.max_age && delta == other.delta;
+	}
+	bool operator!=(const WriterConfig &other) const { return !(*this == other); }
+};
+
+/**
+ * Writes the detections of a filter to a file on its own thread, so a slow disk never holds up
+ * inference.
+ *
+ * Snapshots are written to a temporary file that is then renamed over the target, readers see
+ * either the previous or the new file, never a partial one; results that arrive while a write
+ * is running replace each other and only the newest is written. NDJSON records are queued up
+ * to a limit, past that the oldest are dropped and counted. Delta records are encoded as they
+ * are written, so a dropped result is only missing from the log, the events stay consistent;
+ * every new file starts with a keyframe, results without changes write no line.
+ */
+class DetectionWriter {
+public:
+	static constexpr size_t MAX_QUEUED = 64;
+
+	DetectionWriter() = default;
+	~DetectionWriter();
+
+	// Start, stop or switch the output; a new path or mode starts a new file
+	void configure(const WriterConfig &config);
+
+	// Queue one result, never blocks on the disk
+	void submit(const std::vector<Object> &objects, uint64_t timestamp_ns);
+
+	uint64_t dropped() const { return dropped_; }
+
+private:
+	struct Record {
+		uint64_t sequence;
+		uint64_t timestamp_ns; // video frame time of the frame
+		int64_t wall_time_ms;  // Unix time when the result was submitted
+		std::vector<Object> objects;
+	};
+
+	void run();
+	void writeSnapshot(const WriterConfig &config, const Record &record);
+	void appendRecord(const WriterConfig &config, const Record &record);
+	void closeLog();
+	void reportError(const std::string &error);
+
+	// the NDJSON line in buffer_, which keeps its capacity from record to record
+	void serializeRecord(const Record &record);
+	// the same for a delta, false when there is no change to write
+	bool serializeDelta(const WriterConfig &config, const Record &record);
+
+	std::mutex mutex_;
+	std::condition_variable changed_;
+	std::deque<Record> queue_;
+	WriterConfig config_;
+	uint64_t generation_ = 0; // counts configure() changes
+	uint64_t next_sequence_ = 0;
+	bool stop_ = false;
+	std::thread thread_;
+	std::atomic<uint64_t> dropped_{0};
+
+	// writer thread only
+	std::string buffer_;
+	std::ofstream log_;
+	uint64_t log_generation_ = 0;
+	uint64_t log_bytes_ = 0;
+	std::chrono::steady_clock::time_point log_opened_;
+	std::string last_error_; // logged once until the next success
+	DeltaEncoder delta_encoder_;
+	Delta delta_;
+};
+
+} // namespace output
+
+#endif /* DETECTION_WRITER_H */
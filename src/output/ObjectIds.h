@@ -0,0 +1,39 @@
+#ifndef OBJECT_IDS_H
+#define OBJECT_IDS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+namespace output {
+
+struct ObjectIds {
+	uint64_t track_id;
+	uint64_t parent_id;
+};
+
+/**
+ * The ids the outputs publish for objects[i]. While tracking is on they are the tracker's.
+ * Without it the detector numbers the objects of every result by score, which must not pass
+ * for track ids: the track id is 0 and a cascade child's parent id is its parent's position in
+ * objects, counting from 1.
+ */
+inline ObjectIds publishedIds(const std::vector<Object> &objects, size_t i, bool tracked)
+{
+	const Object &obj = objects[i];
+	if (tracked || obj.parent_id == 0) {
+		return {tracked ? obj.id : 0, obj.parent_id};
+	}
+	for (size_t j = 0; j < objects.size(); ++j) {
+		if (objects[j].parent_id == 0 && objects[j].id == obj.parent_id) {
+			return {0, j + 1};
+		}
+	}
+	return {0, 0};
+}
+
+} // namespace output
+
+#endif /* OBJECT_IDS_H */
@@ -0,0 +1,741 @@
+#include "PushServer.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+#include <obs.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+
+#include "plugin-support.h"
+#include "obs-utils/obs-config-utils.h"
+#include "DetectionJson.h"
+#include "WebSocket.h"
+#include "detection-shm.h"
+
+namespace output {
+
+namespace {
+
+#ifdef _WIN32
+using socket_t = SOCKET;
+const socket_t NO_SOCKET = INVALID_SOCKET;
+using pollfd_t = WSAPOLLFD;
+
+void close_socket(socket_t s)
+{
+	closesocket(s);
+}
+
+bool would_block()
+{
+	return WSAGetLastError() == WSAEWOULDBLOCK;
+}
+
+int poll_sockets(pollfd_t *fds, size_t count)
+{
+	return WSAPoll(fds, (ULONG)count, -1);
+}
+
+void set_nonblocking(socket_t s)
+{
+	u_long on = 1;
+	ioctlsocket(s, FIONBIO, &on);
+}
+
+const int SEND_FLAGS = 0;
+#else
+using socket_t = int;
+const socket_t NO_SOCKET = -1;
+using pollfd_t = struct pollfd;
+
+void close_socket(socket_t s)
+{
+	close(s);
+}
+
+bool would_block()
+{
+	return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+}
+
+int poll_sockets(pollfd_t *fds, size_t count)
+{
+	return poll(fds, (nfds_t)count, -1);
+}
+
+void set_nonblocking(socket_t s)
+{
+	fcntl(s, F_SETFL, fcntl(s, F_GETFL, 0) | O_NONBLOCK);
+#ifdef SO_NOSIGPIPE
+	int on = 1;
+	setsockopt(s, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+}
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+#endif
+
+// requests and commands longer than this close the connection
+constexpr size_t MAX_INPUT = 64 * 1024;
+
+std::mutex server_mutex;
+std::weak_ptr<PushServer> server;
+
+std::string default_socket_path()
+{
+#ifdef _WIN32
+	return std::string();
+#else
+	const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+	if (runtime_dir && *runtime_dir) {
+		return std::string(runtime_dir) + "/obs-detect.sock";
+	}
+	return "/tmp/obs-detect-" + std::to_string(getuid()) + ".sock";
+#endif
+}
+
+std::string lower(std::string text)
+{
+	std::transform(text.begin(), text.end(), text.begin(),
+		       [](unsigned char c) { return (char)std::tolower(c); });
+	return text;
+}
+
+// Whether a WebSocket client with this Origin header gets the detections, see PushServer
+bool origin_allowed(const std::string &origin, const std::string &allowed_origins)
+{
+	if (origin.empty()) {
+		return true;
+	}
+	const std::string page = lower(origin);
+	size_t begin = 0;
+	while (begin <= allowed_origins.size()) {
+		size_t end = allowed_origins.find(',', begin);
+		if (end == std::string::npos) {
+			end = allowed_origins.size();
+		}
+		std::string allowed = allowed_origins.substr(begin, end - begin);
+		allowed.erase(0, allowed.find_first_not_of(" \t"));
+		allowed.erase(allowed.find_last_not_of(" \t/") + 1);
+		if (allowed == "*" || (!allowed.empty() && lower(allowed) == page)) {
+			return true;
+		}
+		begin = end + 1;
+	}
+
+	const size_t scheme_end = page.find("://");
+	if (scheme_end == std::string::npos) {
+		// e.g. "null" for pages opened from a file
+		return false;
+	}
+	const std::string scheme = page.substr(0, scheme_end);
+	std::string host = page.substr(scheme_end + 3);
+	if (scheme != "http" && scheme != "https") {
+		return false;
+	}
+	if (host == "absolute") {
+		return true;
+	}
+	if (host.compare(0, 1, "[") == 0) {
+		host = host.substr(0, host.find(']') + 1);
+	} else {
+		host = host.substr(0, host.find(':'));
+	}
+	return host == "localhost" || host == "127.0.0.1" || host == "[::1]";
+}
+
+socket_t listen_tcp(int port)
+{
+	socket_t s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+	if (s == NO_SOCKET) {
+		return NO_SOCKET;
+	}
+	int on = 1;
+#ifdef _WIN32
+	setsockopt(s, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char *)&on, sizeof(on));
+#else
+	setsockopt(s, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+#endif
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons((uint16_t)port);
+	// only this computer, nothing is authenticated
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (bind(s, (const sockaddr *)&addr, sizeof(addr)) != 0 || listen(s, 16) != 0) {
+		close_socket(s);
+		return NO_SOCKET;
+	}
+	set_nonblocking(s);
+	return s;
+}
+
+#ifndef _WIN32
+// Whether the socket at addr was left behind by a server that is gone: nothing accepts on it
+bool socket_abandoned(const sockaddr_un &addr)
+{
+	struct stat st;
+	if (lstat(addr.sun_path, &st) != 0 || !S_ISSOCK(st.st_mode)) {
+		return false;
+	}
+	const socket_t probe = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (probe == NO_SOCKET) {
+		return false;
+	}
+	const bool refused = connect(probe, (const sockaddr *)&addr, sizeof(addr)) != 0 &&
+			     errno == ECONNREFUSED;
+	close_socket(probe);
+	return refused;
+}
+
+socket_t listen_unix(const std::string &path)
+{
+	sockaddr_un addr{};
+	if (path.size() >= sizeof(addr.sun_path)) {
+		errno = ENAMETOOLONG;
+		return NO_SOCKET;
+	}
+	socket_t s = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (s == NO_SOCKET) {
+		return NO_SOCKET;
+	}
+	addr.sun_family = AF_UNIX;
+	memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+	// left behind by an instance that did not stop; a live one, another OBS instance or a
+	// filter with the same socket path, keeps it and bind fails with EADDRINUSE
+	if (socket_abandoned(addr)) {
+		unlink(path.c_str());
+	}
+	if (bind(s, (const sockaddr *)&addr, sizeof(addr)) != 0 || listen(s, 16) != 0) {
+		close_socket(s);
+		return NO_SOCKET;
+	}
+	chmod(path.c_str(), 0600);
+	set_nonblocking(s);
+	return s;
+}
+#endif
+
+enum class ClientKind { Unix, WebSocket };
+enum class Format { Json, Binary, Delta };
+
+struct Client {
+	socket_t socket;
+	ClientKind kind;
+	const PushConfig *config;
+	bool ready;  // WebSocket clients after the handshake
+	Format format = Format::Json;
+	bool closing = false; // close once out is sent
+	bool closed = false;
+	std::set<std::string> sources; // empty: all
+	std::string in;
+	std::string out;
+	size_t out_offset = 0;
+	// the next message of each filter, a newer one replaces it
+	std::map<std::string, std::shared_ptr<const PushServer::Message>> pending;
+	uint64_t dropped = 0;
+	// delta format: what the client was sent of each filter
+	std::map<std::string, DeltaEncoder> encoders;
+	Delta delta;
+	std::string delta_json;
+
+	bool wants(const PushServer::Message &message) const
+	{
+		return ready && !closing && (sources.empty() || sources.count(message.source) != 0);
+	}
+
+	void command(const std::string &line)
+	{
+		const size_t space = line.find(' ');
+		const std::string verb = line.substr(0, space);
+		const std::string argument = space == std::string::npos ? std::string()
+									: line.substr(space + 1);
+		if (verb == "subscribe" && !argument.empty()) {
+			sources.insert(argument);
+		} else if (verb == "unsubscribe") {
+			sources.erase(argument);
+		} else if (verb == "binary") {
+			format = Format::Binary;
+		} else if (verb == "json") {
+			format = Format::Json;
+		} else if (verb == "delta") {
+			format = Format::Delta;
+		} else {
+			return;
+		}
+		// a delta client starts over from keyframes, it may have missed results
+		encoders.clear();
+	}
+
+	// The message in the client's format, null when there is nothing to send
+	const std::string *encode(const PushServer::Message &message)
+	{
+		if (format == Format::Binary) {
+			return &message.binary;
+		}
+		if (format == Format::Json) {
+			return &message.json;
+		}
+		DeltaEncoder &encoder = encoders[message.key];
+		encoder.configure(message.delta_config);
+		encoder.encode(message.objects, message.timestamp_ns, delta);
+		if (delta.empty()) {
+			return nullptr;
+		}
+		delta_json.assign(message.json, 0, message.json_head);
+		appendDeltaJson(delta_json, delta);
+		delta_json += '}';
+		return &delta_json;
+	}
+
+	void append(const PushServer::Message &message)
+	{
+		const std::string *encoded = encode(message);
+		if (!encoded) {
+			return;
+		}
+		const std::string &payload = *encoded;
+		const bool binary = format == Format::Binary;
+		if (kind == ClientKind::WebSocket) {
+			websocket::appendFrame(out, binary ? websocket::BINARY : websocket::TEXT,
+					       payload.data(), payload.size());
+		} else if (binary) {
+			const uint32_t size = (uint32_t)payload.size();
+			for (int i = 0; i < 4; ++i) {
+				out += (char)(size >> (i * 8));
+			}
+			out += payload;
+		} else {
+			out += payload;
+			out += '\n';
+		}
+	}
+
+	// Handle what arrived, false when the connection is to be closed
+	bool receive()
+	{
+		if (kind == ClientKind::Unix) {
+			size_t end;
+			while ((end = in.find('\n')) != std::string::npos) {
+				std::string line = in.substr(0, end);
+				if (!line.empty() && line.back() == '\r') {
+					line.pop_back();
+				}
+				command(line);
+				in.erase(0, end + 1);
+			}
+			return in.size() <= MAX_INPUT;
+		}
+
+		if (!ready) {
+			websocket::Request request;
+			const long length = websocket::parseRequest(in, request);
+			if (length < 0) {
+				out += "HTTP/1.1 400 Bad Request\r\nConnection: close\r\n\r\n";
+				closing = true;
+				return true;
+			}
+			if (length == 0) {
+				return in.size() <= MAX_INPUT;
+			}
+			if (!origin_allowed(request.origin, config->allowed_origins)) {
+				obs_log(LOG_WARNING,
+					"Push server: refused a WebSocket client from %s, see "
+					"push_allowed_origins",
+					request.origin.c_str());
+				out += "HTTP/1.1 403 Forbidden\r\nConnection: close\r\n\r\n";
+				closing = true;
+				return true;
+			}
+			in.erase(0, (size_t)length);
+			if (request.path.size() > 1) {
+				sources.insert(request.path.substr(1));
+			}
+			if (request.query.find("format=binary") != std::string::npos) {
+				format = Format::Binary;
+			} else if (request.query.find("format=delta") != std::string::npos) {
+				format = Format::Delta;
+			}
+			out += websocket::acceptResponse(request);
+			ready = true;
+		}
+
+		websocket::Frame frame;
+		long length;
+		while ((length = websocket::parseFrame(in, frame, MAX_INPUT)) > 0) {
+			in.erase(0, (size_t)length);
+			switch (frame.opcode) {
+			case websocket::TEXT:
+				command(frame.payload);
+				break;
+			case websocket::PING:
+				websocket::appendFrame(out, websocket::PONG, frame.payload.data(),
+						       frame.payload.size());
+				break;
+			case websocket::CLOSE:
+				websocket::appendFrame(out, websocket::CLOSE, frame.payload.data(),
+						       std::min<size_t>(frame.payload.size(), 2));
+				closing = true;
+				return true;
+			default:
+				break;
+			}
+		}
+		return length == 0;
+	}
+
+	// Send as much as the socket takes, false when the connection is to be closed
+	bool flush()
+	{
+		while (true) {
+			if (out_offset == out.size()) {
+				out.clear();
+				out_offset = 0;
+				if (closing) {
+					return false;
+				}
+				if (pending.empty()) {
+					return true;
+				}
+				append(*pending.begin()->second);
+				pending.erase(pending.begin());
+				if (out.empty()) {
+					// a delta without changes
+					continue;
+				}
+			}
+			const size_t size = std::min<size_t>(out.size() - out_offset, 1 << 20);
+			const int sent =
+				(int)send(socket, out.data() + out_offset, (int)size, SEND_FLAGS);
+			if (sent < 0) {
+				return would_block();
+			}
+			out_offset += (size_t)sent;
+		}
+	}
+};
+
+} // namespace
+
+std::shared_ptr<PushServer> PushServer::acquire()
+{
+	std::lock_guard<std::mutex> lock(server_mutex);
+	std::shared_ptr<PushServer> instance = server.lock();
+	if (!instance) {
+		PushConfig config;
+		int64_t port = PushConfig::DEFAULT_PORT;
+		getIntFromConfig("push_port", &port, PushConfig::DEFAULT_PORT);
+		config.port = (int)port;
+		getStringFromConfig("push_socket_path", &config.socket_path, "");
+		getStringFromConfig("push_allowed_origins", &config.allowed_origins, "");
+		instance = std::make_shared<PushServer>(config);
+		server = instance;
+	}
+	return instance;
+}
+
+PushServer::PushServer(const PushConfig &config) : config_(config)
+{
+#ifdef _WIN32
+	WSADATA wsa;
+	WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+	socket_t wake = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t length = sizeof(addr);
+	if (wake == NO_SOCKET || bind(wake, (const sockaddr *)&addr, sizeof(addr)) != 0 ||
+	    getsockname(wake, (sockaddr *)&addr, &length) != 0 ||
+	    connect(wake, (const sockaddr *)&addr, sizeof(addr)) != 0) {
+		obs_log(LOG_ERROR, "Push server: cannot create its wake-up socket");
+		if (wake != NO_SOCKET) {
+			close_socket(wake);
+		}
+		wake_socket_ = (intptr_t)NO_SOCKET;
+		return;
+	}
+	set_nonblocking(wake);
+	wake_socket_ = (intptr_t)wake;
+	thread_ = std::thread(&PushServer::run, this);
+}
+
+PushServer::~PushServer()
+{
+	stop_ = true;
+	wake();
+	if (thread_.joinable()) {
+		thread_.join();
+	}
+	if ((socket_t)wake_socket_ != NO_SOCKET) {
+		close_socket((socket_t)wake_socket_);
+	}
+#ifdef _WIN32
+	WSACleanup();
+#endif
+}
+
+void PushServer::wake()
+{
+	const char byte = 0;
+	// a full socket buffer already has the loop woken up
+	send((socket_t)wake_socket_, &byte, 1, 0);
+}
+
+void PushServer::publish(const std::string &source, const std::string &filter,
+			 const std::vector<Object> &objects, uint64_t timestamp_ns,
+			 const cv::Size &frame_size, const ClassNames &class_names,
+			 const DeltaConfig &delta_config)
+{
+	if (!thread_.joinable()) {
+		return;
+	}
+	auto message = std::make_shared<Message>();
+	message->key = source + '\n' + filter;
+	message->source = source;
+
+	uint64_t sequence;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		sequence = ++sequences_[message->key];
+	}
+
+	std::string &json = message->json;
+	json += "{\"source\":";
+	appendJsonString(json, source);
+	json += ",\"filter\":";
+	appendJsonString(json, filter);
+	json += ",\"seq\":";
+	json += std::to_string(sequence);
+	json += ",\"timestamp_ns\":";
+	json += std::to_string(timestamp_ns);
+	json += ",\"width\":";
+	json += std::to_string(frame_size.width);
+	json += ",\"height\":";
+	json += std::to_string(frame_size.height);
+	json += ',';
+	message->json_head = json.size();
+	json += "\"objects\":";
+	appendObjectsJson(json, objects, false);
+	json += '}';
+	message->objects = objects;
+	message->timestamp_ns = timestamp_ns;
+	message->delta_config = delta_config;
+
+	// the shared memory record, cut after the objects
+	obs_detect_shm_record record;
+	const size_t count = std::min<size_t>(objects.size(), OBS_DETECT_SHM_MAX_OBJECTS);
+	record.seq = 0;
+	record.sequence = sequence;
+	record.timestamp_ns = timestamp_ns;
+	record.frame_width = (uint32_t)frame_size.width;
+	record.frame_height = (uint32_t)frame_size.height;
+	record.count = (uint32_t)count;
+	record.total = (uint32_t)objects.size();
+	for (size_t i = 0; i < count; ++i) {
+		const Object &obj = objects[i];
+		obs_detect_shm_object &out = record.objects[i];
+		memset(&out, 0, sizeof(out));
+		out.x = obj.rect.x;
+		out.y = obj.rect.y;
+		out.width = obj.rect.width;
+		out.height = obj.rect.height;
+		out.score = obj.prob;
+		out.label_id = obj.label;
+		const ObjectIds ids = publishedIds(objects, i, delta_config.tracked);
+		out.track_id = ids.track_id;
+		out.parent_id = ids.parent_id;
+		strncpy(out.label, class_names.name(obj).c_str(), sizeof(out.label) - 1);
+	}
+	message->binary.assign(reinterpret_cast<const char *>(&record),
+			       offsetof(obs_detect_shm_record, objects) +
+				       count * sizeof(obs_detect_shm_object));
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		inbox_[message->key] = std::move(message);
+	}
+	wake();
+}
+
+void PushServer::run()
+{
+	std::vector<socket_t> listeners;
+	std::vector<ClientKind> listener_kinds;
+	std::string socket_path;
+
+	if (config_.port > 0) {
+		const socket_t s = listen_tcp(config_.port);
+		if (s != NO_SOCKET) {
+			listeners.push_back(s);
+			listener_kinds.push_back(ClientKind::WebSocket);
+			obs_log(LOG_INFO, "Push server: WebSocket on ws://127.0.0.1:%d/",
+				config_.port);
+		} else {
+			obs_log(LOG_WARNING, "Push server: cannot listen on port %d", config_.port);
+		}
+	}
+#ifndef _WIN32
+	if (config_.socket_path != "-") {
+		socket_path = config_.socket_path.empty() ? default_socket_path()
+							  : config_.socket_path;
+		const socket_t s = listen_unix(socket_path);
+		if (s != NO_SOCKET) {
+			listeners.push_back(s);
+			listener_kinds.push_back(ClientKind::Unix);
+			obs_log(LOG_INFO, "Push server: Unix socket %s", socket_path.c_str());
+		} else if (errno == EADDRINUSE) {
+			obs_log(LOG_WARNING,
+				"Push server: %s is in use by another OBS instance or program, "
+				"the Unix socket stays off; see push_socket_path",
+				socket_path.c_str());
+			socket_path.clear();
+		} else {
+			obs_log(LOG_WARNING, "Push server: cannot listen on %s: %s",
+				socket_path.c_str(), strerror(errno));
+			socket_path.clear();
+		}
+	}
+#endif
+
+	std::vector<std::unique_ptr<Client>> clients;
+	std::vector<pollfd_t> fds;
+	char buffer[16 * 1024];
+
+	while (!stop_) {
+		fds.clear();
+		fds.push_back({(socket_t)wake_socket_, POLLIN, 0});
+		for (socket_t listener : listeners) {
+			fds.push_back({listener, POLLIN, 0});
+		}
+		for (const std::unique_ptr<Client> &client : clients) {
+			const bool writing = client->out_offset < client->out.size() ||
+					     !client->pending.empty();
+			const short events = (short)(POLLIN | (writing ? POLLOUT : 0));
+			fds.push_back({client->socket, events, 0});
+		}
+		if (poll_sockets(fds.data(), fds.size()) < 0) {
+#ifndef _WIN32
+			if (errno == EINTR) {
+				continue;
+			}
+#endif
+			obs_log(LOG_ERROR, "Push server: poll failed, stopping");
+			break;
+		}
+
+		size_t fd = 0;
+		if (fds[fd++].revents & POLLIN) {
+			while (recv((socket_t)wake_socket_, buffer, sizeof(buffer), 0) > 0) {
+			}
+			std::map<std::string, std::shared_ptr<const Message>> inbox;
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				inbox.swap(inbox_);
+			}
+			for (const auto &entry : inbox) {
+				for (const std::unique_ptr<Client> &client : clients) {
+					if (!client->wants(*entry.second)) {
+						continue;
+					}
+					auto &slot = client->pending[entry.first];
+					if (slot) {
+						// the client did not take the previous one yet
+						client->dropped++;
+						dropped_++;
+					}
+					slot = entry.second;
+				}
+			}
+		}
+
+		for (size_t i = 0; i < listeners.size(); ++i, ++fd) {
+			if (!(fds[fd].revents & POLLIN)) {
+				continue;
+			}
+			socket_t s;
+			while ((s = accept(listeners[i], nullptr, nullptr)) != NO_SOCKET) {
+				set_nonblocking(s);
+				auto client = std::make_unique<Client>();
+				client->socket = s;
+				client->kind = listener_kinds[i];
+				client->config = &config_;
+				client->ready = client->kind == ClientKind::Unix;
+				clients.push_back(std::move(client));
+			}
+		}
+
+		const size_t polled = fds.size() - fd;
+		for (size_t i = 0; i < polled; ++i, ++fd) {
+			Client &client = *clients[i];
+			const short revents = fds[fd].revents;
+			if (revents & POLLIN) {
+				const int received =
+					(int)recv(client.socket, buffer, sizeof(buffer), 0);
+				if (received > 0) {
+					client.in.append(buffer, (size_t)received);
+					client.closed = !client.receive();
+				} else if (received == 0 || !would_block()) {
+					client.closed = true;
+				}
+			} else if (revents & (POLLERR | POLLHUP | POLLNVAL)) {
+				client.closed = true;
+			}
+		}
+		for (const std::unique_ptr<Client> &client : clients) {
+			if (!client->closed) {
+				client->closed = !client->flush();
+			}
+		}
+
+		for (const std::unique_ptr<Client> &client : clients) {
+			if (!client->closed) {
+				continue;
+			}
+			if (client->dropped > 0) {
+				obs_log(LOG_INFO, "Push server: client left, %llu results dropped",
+					(unsigned long long)client->dropped);
+			}
+			close_socket(client->socket);
+		}
+		clients.erase(std::remove_if(clients.begin(), clients.end(),
+					     [](const std::unique_ptr<Client> &client) {
+						     return client->closed;
+					     }),
+			      clients.end());
+	}
+
+	for (const std::unique_ptr<Client> &client : clients) {
+		close_socket(client->socket);
+	}
+	for (socket_t listener : listeners) {
+		close_socket(listener);
+	}
+#ifndef _WIN32
+	if (!socket_path.empty()) {
+		unlink(socket_path.c_str());
+	}
+#endif
+}
+
+} // namespace output
@@ -0,0 +1,104 @@
+#ifndef PUSH_SERVER_H
+#define PUSH_SERVER_H
+
+#include <opencv2/core/types.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ort-model/types.hpp"
+#include "ClassNames.h"
+#include "ObjectIds.h"
+#include "DeltaEncoder.h"
+
+namespace output {
+
+struct PushConfig {
+	static constexpr int DEFAULT_PORT = 4466;
+
+	int port = DEFAULT_PORT; // WebSocket on 127.0.0.1, 0 turns it off
+	// Unix domain socket, empty for the default path and "-" to turn it off; not on Windows
+	std::string socket_path;
+	// comma separated origins of the web pages that may connect besides the local ones, "*"
+	// for any page
+	std::string allowed_origins;
+};
+
+/**
+ * Pushes the detections of the filters to local clients, over a Unix domain socket and a
+ * WebSocket on localhost, from its own event loop thread.
+ *
+ * Clients get every source unless they subscribe to some: a WebSocket client connects to
+ * ws://127.0.0.1:<port>/<source name>, "/" for all, and adds "?format=binary" for binary frames
+ * or "?format=delta" for delta JSON; both kinds of clients can send "subscribe <source>",
+ * "unsubscribe <source>", "binary", "json" and "delta" (WebSocket text frames, lines on the
+ * Unix socket). JSON messages are one line, on the Unix socket ended by a newline; binary
+ * messages are an obs_detect_shm_record (see detection-shm.h) cut after its objects, on the
+ * Unix socket after a 32-bit little-endian length. Delta messages carry only the changes since
+ * the previous message the client got from the filter, see DeltaEncoder, and are left out when
+ * nothing changed.
+ *
+ * Any web page open in a browser on this computer can connect to 127.0.0.1, so browser clients
+ * (which send an Origin) are only accepted from local pages: http(s) on localhost, 127.0.0.1 or
+ * [::1], and OBS browser sources with local files (http://absolute), or from the origins in
+ * allowed_origins. Clients that are not browsers send no Origin and are accepted.
+ *
+ * A client that does not keep up gets the latest result of each filter when it is ready
+ * again, the ones in between are dropped and counted; publishing never waits for a client.
+ * Deltas are encoded for each client as they are sent, so they stay consistent across drops.
+ */
+class PushServer {
+public:
+	// The server shared by all filters, started with the module configuration for the first
+	static std::shared_ptr<PushServer> acquire();
+
+	explicit PushServer(const PushConfig &config);
+	~PushServer();
+	PushServer(const PushServer &) = delete;
+	PushServer &operator=(const PushServer &) = delete;
+
+	// delta_config.tracked also decides the ids in the binary records, see publishedIds()
+	void publish(const std::string &source, const std::string &filter,
+		     const std::vector<Object> &objects, uint64_t timestamp_ns,
+		     const cv::Size &frame_size, const ClassNames &class_names,
+		     const DeltaConfig &delta_config);
+
+	// Results dropped for slow clients
+	uint64_t dropped() const { return dropped_; }
+
+	struct Message {
+		std::string key; // source and filter, a newer message with the same key replaces it
+		std::string source;
+		std::string json;
+		std::string binary;
+		// for delta clients: the JSON up to the objects, and what it is encoded from
+		size_t json_head = 0;
+		std::vector<Object> objects;
+		uint64_t timestamp_ns = 0;
+		DeltaConfig delta_config;
+	};
+
+private:
+	void run();
+	void wake();
+
+	PushConfig config_;
+	std::thread thread_;
+	std::atomic<bool> stop_{false};
+	std::atomic<uint64_t> dropped_{0};
+	intptr_t wake_socket_; // a UDP socket connected to itself, wakes up the loop
+
+	std::mutex mutex_;
+	std::map<std::string, std::shared_ptr<const Message>> inbox_; // by key, latest only
+	std::map<std::string, uint64_t> sequences_;
+};
+
+} // namespace output
+
+#endif /* PUSH_SERVER_H */
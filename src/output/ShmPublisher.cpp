@@ -0,0 +1,311 @@
+#include "ShmPublisher.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <set>
+
+#ifndef _WIN32
+#include <signal.h>
+#endif
+
+#include "detection-shm.h"
+#include "plugin-support.h"
+
+static_assert(sizeof(obs_detect_shm_header) == 64, "shared memory header layout changed");
+static_assert(sizeof(obs_detect_shm_object) == 72, "shared memory object layout changed");
+static_assert(sizeof(obs_detect_shm_record) == 40 + 72 * OBS_DETECT_SHM_MAX_OBJECTS,
+	      "shared memory record layout changed");
+
+namespace output {
+
+namespace {
+
+// segment names taken by the publishers of this process
+std::mutex names_mutex;
+std::set<std::string> names_in_use;
+
+// numbered names tried for a source before giving up
+constexpr int MAX_NAMES = 16;
+
+// The n-th name for a source: the plain name, then the name with -2, -3, ...
+std::string numbered_name(const char *base, int n)
+{
+	if (n < 2) {
+		return base;
+	}
+	const std::string suffix = "-" + std::to_string(n);
+	const size_t length = std::min(strlen(base), OBS_DETECT_SHM_NAME_SIZE - 1 - suffix.size());
+	return std::string(base, length) + suffix;
+}
+
+// The first name from the n-th on that no publisher of this process uses, n is advanced to it
+std::string claim_name(const std::string &source_name, int &n)
+{
+	char base[OBS_DETECT_SHM_NAME_SIZE];
+	obs_detect_shm_name(source_name.c_str(), base, sizeof(base));
+
+	std::lock_guard<std::mutex> lock(names_mutex);
+	std::string name = numbered_name(base, n);
+	while (names_in_use.count(name) != 0) {
+		name = numbered_name(base, ++n);
+	}
+	names_in_use.insert(name);
+	return name;
+}
+
+void release_name(const std::string &name)
+{
+	std::lock_guard<std::mutex> lock(names_mutex);
+	names_in_use.erase(name);
+}
+
+enum class CreateResult { Created, Taken, Failed };
+
+#ifdef _WIN32
+CreateResult create_segment(const std::string &name, size_t size, HANDLE &mapping, void *&view)
+{
+	mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)size,
+				     name.c_str());
+	if (mapping && GetLastError() == ERROR_ALREADY_EXISTS) {
+		// another OBS instance publishes for a source of this name, the mapping goes away
+		// with its last handle, so it is never left behind
+		CloseHandle(mapping);
+		mapping = nullptr;
+		return CreateResult::Taken;
+	}
+	view = mapping ? MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size) : nullptr;
+	if (!view) {
+		obs_log(LOG_ERROR, "Cannot create the shared memory %s: error %lu", name.c_str(),
+			GetLastError());
+		if (mapping) {
+			CloseHandle(mapping);
+			mapping = nullptr;
+		}
+		return CreateResult::Failed;
+	}
+	return CreateResult::Created;
+}
+#else
+// Whether the segment was left behind by a writer that is gone, e.g. after a crash. A segment
+// that is still being set up, or whose writer runs, belongs to another instance.
+bool segment_abandoned(const std::string &name)
+{
+	const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+	if (fd < 0) {
+		return false;
+	}
+	bool abandoned = false;
+	struct stat st;
+	if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(obs_detect_shm_header)) {
+		void *view = mmap(nullptr, sizeof(obs_detect_shm_header), PROT_READ, MAP_SHARED,
+				  fd, 0);
+		if (view != MAP_FAILED) {
+			const obs_detect_shm_header *header =
+				static_cast<const obs_detect_shm_header *>(view);
+			if (header->magic == OBS_DETECT_SHM_MAGIC && header->writer_pid != 0) {
+				abandoned = kill((pid_t)header->writer_pid, 0) != 0 &&
+					    errno == ESRCH;
+			}
+			munmap(view, sizeof(obs_detect_shm_header));
+		}
+	}
+	::close(fd);
+	return abandoned;
+}
+
+CreateResult create_segment(const std::string &name, size_t size, void *&view)
+{
+	int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+	if (fd < 0 && errno == EEXIST) {
+		if (!segment_abandoned(name)) {
+			return CreateResult::Taken;
+		}
+		obs_log(LOG_INFO, "Removing the shared memory %s of a closed OBS instance",
+			name.c_str());
+		shm_unlink(name.c_str());
+		fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+		if (fd < 0 && errno == EEXIST) {
+			return CreateResult::Taken;
+		}
+	}
+	view = MAP_FAILED;
+	if (fd >= 0) {
+		if (ftruncate(fd, (off_t)size) == 0) {
+			view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		}
+		::close(fd);
+	}
+	if (view == MAP_FAILED) {
+		obs_log(LOG_ERROR, "Cannot create the shared memory %s: %s", name.c_str(),
+			strerror(errno));
+		if (fd >= 0) {
+			shm_unlink(name.c_str());
+		}
+		view = nullptr;
+		return CreateResult::Failed;
+	}
+	return CreateResult::Created;
+}
+#endif
+
+} // namespace
+
+ShmPublisher::~ShmPublisher()
+{
+	close();
+}
+
+bool ShmPublisher::open(const std::string &source_name)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	unmap();
+
+	const size_t size = sizeof(obs_detect_shm_header) +
+			    OBS_DETECT_SHM_SLOTS * sizeof(obs_detect_shm_record);
+	// a name that another OBS instance publishes under is left to it, the next one is tried
+	std::string name;
+	void *view = nullptr;
+#ifdef _WIN32
+	HANDLE mapping = nullptr;
+#endif
+	CreateResult result = CreateResult::Taken;
+	for (int n = 1; n <= MAX_NAMES && result == CreateResult::Taken; ++n) {
+		name = claim_name(source_name, n);
+#ifdef _WIN32
+		result = create_segment(name, size, mapping, view);
+#else
+		result = create_segment(name, size, view);
+#endif
+		if (result != CreateResult::Created) {
+			release_name(name);
+		}
+		if (result == CreateResult::Taken) {
+			obs_log(LOG_INFO, "The shared memory %s is used by another OBS instance",
+				name.c_str());
+		}
+	}
+	if (result != CreateResult::Created) {
+		if (result == CreateResult::Taken) {
+			obs_log(LOG_ERROR, "No free shared memory name for the source %s",
+				source_name.c_str());
+		}
+		failed_ = true;
+		return false;
+	}
+#ifdef _WIN32
+	mapping_ = mapping;
+#endif
+	view_ = view;
+	size_ = size;
+	name_ = name;
+	published_ = 0;
+
+	// new segments are zeroed, readers take it once the magic is set
+	obs_detect_shm_header *header = static_cast<obs_detect_shm_header *>(view_);
+	header->version = OBS_DETECT_SHM_VERSION;
+	header->header_size = sizeof(obs_detect_shm_header);
+	header->record_size = sizeof(obs_detect_shm_record);
+	header->slot_count = OBS_DETECT_SHM_SLOTS;
+	header->max_objects = OBS_DETECT_SHM_MAX_OBJECTS;
+#ifdef _WIN32
+	header->writer_pid = GetCurrentProcessId();
+#else
+	header->writer_pid = (uint64_t)getpid();
+#endif
+	obs_detect_shm_fence_release();
+	header->magic = OBS_DETECT_SHM_MAGIC;
+
+	obs_log(LOG_INFO, "Publishing detections in the shared memory %s", name_.c_str());
+	return true;
+}
+
+void ShmPublisher::close()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	unmap();
+	failed_ = false;
+}
+
+void ShmPublisher::unmap()
+{
+	if (!view_) {
+		return;
+	}
+#ifdef _WIN32
+	UnmapViewOfFile(view_);
+	CloseHandle(mapping_);
+	mapping_ = nullptr;
+#else
+	munmap(view_, size_);
+	shm_unlink(name_.c_str());
+#endif
+	release_name(name_);
+	view_ = nullptr;
+	size_ = 0;
+	name_.clear();
+}
+
+bool ShmPublisher::isOpen() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return view_ != nullptr;
+}
+
+bool ShmPublisher::failed() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return failed_;
+}
+
+std::string ShmPublisher::name() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return name_;
+}
+
+void ShmPublisher::publish(const std::vector<Object> &objects, uint64_t timestamp_ns,
+			   const cv::Size &frame_size, const ClassNames &class_names, bool tracked)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	if (!view_) {
+		return;
+	}
+	obs_detect_shm_header *header = static_cast<obs_detect_shm_header *>(view_);
+	obs_detect_shm_record *record = obs_detect_shm_slot(header, published_);
+
+	// odd while the record is written, readers retry until it is even again
+	const uint64_t seq = record->seq;
+	obs_detect_shm_store(&record->seq, seq + 1);
+	obs_detect_shm_fence_release();
+
+	record->sequence = published_ + 1;
+	record->timestamp_ns = timestamp_ns;
+	record->frame_width = (uint32_t)frame_size.width;
+	record->frame_height = (uint32_t)frame_size.height;
+	record->total = (uint32_t)objects.size();
+	record->count = (uint32_t)std::min<size_t>(objects.size(), OBS_DETECT_SHM_MAX_OBJECTS);
+	for (uint32_t i = 0; i < record->count; ++i) {
+		const Object &obj = objects[i];
+		obs_detect_shm_object &out = record->objects[i];
+		out.x = obj.rect.x;
+		out.y = obj.rect.y;
+		out.width = obj.rect.width;
+		out.height = obj.rect.height;
+		out.score = obj.prob;
+		out.label_id = obj.label;
+		const ObjectIds ids = publishedIds(objects, i, tracked);
+		out.track_id = ids.track_id;
+		out.parent_id = ids.parent_id;
+		strncpy(out.label, class_names.name(obj).c_str(), sizeof(out.label) - 1);
+		out.label[sizeof(out.label) - 1] = '\0';
+	}
+
+	obs_detect_shm_store(&record->seq, seq + 2);
+	published_++;
+	obs_detect_shm_store(&header->write_index, published_);
+}
+
+} // namespace output
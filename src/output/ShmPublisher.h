@@ -0,0 +1,69 @@
+#ifndef SHM_PUBLISHER_H
+#define SHM_PUBLISHER_H
+
+#include <opencv2/core/types.hpp>
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ort-model/types.hpp"
+#include "ClassNames.h"
+#include "ObjectIds.h"
+
+namespace output {
+
+/**
+ * Publishes the detections of a filter in a shared memory segment for other local processes,
+ * the layout and a reader are in detection-shm.h.
+ *
+ * Publishing copies one fixed-size record into the ring and never waits for the readers. The
+ * segment is removed when the publisher closes, readers that still map it keep the last
+ * records.
+ */
+class ShmPublisher {
+public:
+	ShmPublisher() = default;
+	~ShmPublisher();
+	ShmPublisher(const ShmPublisher &) = delete;
+	ShmPublisher &operator=(const ShmPublisher &) = delete;
+
+	/**
+	 * Create the segment named after the source, replacing the one this publisher had. When
+	 * another filter of this process or another OBS instance publishes for a source of the same
+	 * name, the segment gets a numbered name. A segment left behind by an instance that is gone
+	 * is replaced.
+	 *
+	 * @return false if the segment could not be created, the error is logged once and open()
+	 *         is not retried until close().
+	 */
+	bool open(const std::string &source_name);
+	void close();
+
+	bool isOpen() const;
+	bool failed() const;
+	std::string name() const;
+
+	// Publish one result, objects past OBS_DETECT_SHM_MAX_OBJECTS are only counted. tracked:
+	// the object ids are track ids, see publishedIds()
+	void publish(const std::vector<Object> &objects, uint64_t timestamp_ns,
+		     const cv::Size &frame_size, const ClassNames &class_names, bool tracked);
+
+private:
+	void unmap();
+
+	mutable std::mutex mutex_;
+	std::string name_;
+	void *view_ = nullptr;
+	size_t size_ = 0;
+#ifdef _WIN32
+	void *mapping_ = nullptr;
+#endif
+	uint64_t published_ = 0;
+	bool failed_ = false;
+};
+
+} // namespace output
+
+#endif /* SHM_PUBLISHER_H */
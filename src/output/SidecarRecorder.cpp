@@ -0,0 +1,259 @@
+#include "SidecarRecorder.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+
+#include "plugin-support.h"
+
+static_assert(sizeof(obs_detect_sidecar_header) == 128, "sidecar header layout changed");
+static_assert(sizeof(obs_detect_sidecar_frame) == 32, "sidecar frame layout changed");
+static_assert(sizeof(obs_detect_sidecar_object) == 40, "sidecar object layout changed");
+static_assert(sizeof(obs_detect_sidecar_index_entry) == 16, "sidecar index layout changed");
+
+namespace output {
+
+namespace {
+
+// the outputs the Record button starts, and the setting that holds their file
+const char *recording_path_setting(const char *output_id)
+{
+	if (strcmp(output_id, "ffmpeg_muxer") == 0 || strcmp(output_id, "mp4_output") == 0) {
+		return "path";
+	}
+	if (strcmp(output_id, "ffmpeg_output") == 0) {
+		// the custom FFmpeg output, also used for streaming when the URL is a network one
+		return "url";
+	}
+	return nullptr;
+}
+
+std::string file_name_part(const std::string &name)
+{
+	std::string part = name;
+	for (char &c : part) {
+		if (strchr("/\\:*?\"<>|", c) != nullptr || (unsigned char)c < 0x20) {
+			c = '_';
+		}
+	}
+	return part;
+}
+
+} // namespace
+
+SidecarRecorder::~SidecarRecorder()
+{
+	stop();
+}
+
+bool SidecarRecorder::activeRecording(RecordingState &state)
+{
+	state = RecordingState();
+	obs_enum_outputs(
+		[](void *param, obs_output_t *output) {
+			const char *key = recording_path_setting(obs_output_get_id(output));
+			if (!key || !obs_output_active(output)) {
+				return true;
+			}
+			obs_data_t *settings = obs_output_get_settings(output);
+			const std::string path = obs_data_get_string(settings, key);
+			obs_data_release(settings);
+			if (path.empty() || path.find("://") != std::string::npos) {
+				return true;
+			}
+			// the frames the output got so far go back to its first one
+			RecordingState *found = static_cast<RecordingState *>(param);
+			video_t *video = obs_output_video(output);
+			const uint64_t interval_ns = video ? video_output_get_frame_time(video) : 0;
+			const int total_frames = obs_output_get_total_frames(output);
+			const uint64_t frames = (uint64_t)std::max(total_frames, 0);
+			const uint64_t now_ns = obs_get_video_frame_time();
+			found->path = path;
+			found->start_ns = now_ns - std::min(now_ns, frames * interval_ns);
+			return false;
+		},
+		&state);
+	return !state.path.empty();
+}
+
+std::string SidecarRecorder::sidecarPath(const std::string &recording_path,
+					 const std::string &source_name,
+					 const std::string &filter_name)
+{
+	const std::filesystem::path recording = std::filesystem::u8path(recording_path);
+	const std::string name = recording.stem().u8string() + "." + file_name_part(source_name) +
+				 "." + file_name_part(filter_name) + ".detections";
+	return (recording.parent_path() / std::filesystem::u8path(name)).u8string();
+}
+
+void SidecarRecorder::start(const SidecarInfo &info)
+{
+	stop();
+	std::lock_guard<std::mutex> lock(mutex_);
+	path_ = info.path;
+	start_ns_ = info.start_ns;
+	stop_ = false;
+	queue_.clear();
+	thread_ = std::thread(&SidecarRecorder::run, this, info);
+}
+
+void SidecarRecorder::stop()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (!thread_.joinable()) {
+			return;
+		}
+		stop_ = true;
+	}
+	changed_.notify_all();
+	thread_.join();
+	std::lock_guard<std::mutex> lock(mutex_);
+	path_.clear();
+}
+
+void SidecarRecorder::submit(const std::vector<Object> &objects, uint64_t timestamp_ns,
+			     const cv::Size &frame_size, bool tracked)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (path_.empty() || stop_ || timestamp_ns < start_ns_) {
+			return;
+		}
+		if (queue_.size() >= MAX_QUEUED) {
+			queue_.pop_front();
+			dropped_++;
+		}
+		queue_.push_back({timestamp_ns, frame_size, objects, tracked});
+	}
+	changed_.notify_one();
+}
+
+void SidecarRecorder::run(SidecarInfo info)
+{
+	header_ = obs_detect_sidecar_header();
+	memcpy(header_.magic, OBS_DETECT_SIDECAR_MAGIC, sizeof(header_.magic));
+	header_.version = OBS_DETECT_SIDECAR_VERSION;
+	header_.header_size = sizeof(obs_detect_sidecar_header);
+	header_.frame_size = sizeof(obs_detect_sidecar_frame);
+	header_.object_size = sizeof(obs_detect_sidecar_object);
+	// cascade children are labelled from the cascade model's classes, which follow
+	cascade_label_offset_ = (int32_t)info.labels.size();
+	info.labels.insert(info.labels.end(), info.cascade_labels.begin(),
+			   info.cascade_labels.end());
+	header_.label_count = (uint32_t)info.labels.size();
+	header_.label_size = OBS_DETECT_SIDECAR_LABEL_SIZE;
+	header_.records_offset = sizeof(obs_detect_sidecar_header) +
+				 info.labels.size() * OBS_DETECT_SIDECAR_LABEL_SIZE;
+	header_.start_ns = info.start_ns;
+	header_.fps_num = info.fps_num;
+	header_.fps_den = info.fps_den;
+	header_.video_width = info.video_width;
+	header_.video_height = info.video_height;
+	index_.clear();
+	offset_ = header_.records_offset;
+	failed_ = false;
+
+	file_.open(std::filesystem::u8path(info.path), std::ios::binary | std::ios::trunc);
+	file_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+	for (const std::string &label : info.labels) {
+		char entry[OBS_DETECT_SIDECAR_LABEL_SIZE] = {};
+		strncpy(entry, label.c_str(), sizeof(entry) - 1);
+		file_.write(entry, sizeof(entry));
+	}
+	if (!file_) {
+		obs_log(LOG_WARNING, "Cannot create the detection sidecar %s", info.path.c_str());
+		failed_ = true;
+	} else {
+		obs_log(LOG_INFO, "Recording detections to %s", info.path.c_str());
+	}
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	while (true) {
+		changed_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+		if (queue_.empty()) {
+			break;
+		}
+		const Record record = std::move(queue_.front());
+		queue_.pop_front();
+		const bool drained = queue_.empty();
+		lock.unlock();
+
+		write(record);
+		// whole records reach the file while recording, a reader can follow it
+		if (drained && !failed_) {
+			file_.flush();
+		}
+
+		lock.lock();
+	}
+	lock.unlock();
+
+	finish(obs_get_video_frame_time());
+	file_.close();
+	file_.clear();
+	if (!failed_) {
+		obs_log(LOG_INFO, "Recorded %zu detection results to %s", index_.size(),
+			info.path.c_str());
+	}
+}
+
+void SidecarRecorder::write(const Record &record)
+{
+	if (failed_) {
+		return;
+	}
+	obs_detect_sidecar_frame frame{};
+	frame.timestamp_ns = record.timestamp_ns;
+	frame.sequence = index_.size() + 1;
+	frame.frame_width = (uint32_t)record.frame_size.width;
+	frame.frame_height = (uint32_t)record.frame_size.height;
+	frame.count = (uint32_t)record.objects.size();
+
+	objects_.clear();
+	for (size_t i = 0; i < record.objects.size(); ++i) {
+		const Object &obj = record.objects[i];
+		const int32_t label = obj.parent_id != 0 && obj.label >= 0
+					      ? obj.label + cascade_label_offset_
+					      : obj.label;
+		const ObjectIds ids = publishedIds(record.objects, i, record.tracked);
+		objects_.push_back({obj.rect.x, obj.rect.y, obj.rect.width, obj.rect.height,
+				    obj.prob, label, ids.track_id, ids.parent_id});
+	}
+
+	file_.write(reinterpret_cast<const char *>(&frame), sizeof(frame));
+	file_.write(reinterpret_cast<const char *>(objects_.data()),
+		    (std::streamsize)(objects_.size() * sizeof(obs_detect_sidecar_object)));
+	if (!file_) {
+		obs_log(LOG_WARNING, "Cannot write the detection sidecar, recording it stopped");
+		failed_ = true;
+		return;
+	}
+	index_.push_back({frame.timestamp_ns, offset_});
+	offset_ += sizeof(frame) + objects_.size() * sizeof(obs_detect_sidecar_object);
+}
+
+void SidecarRecorder::finish(uint64_t end_ns)
+{
+	if (failed_) {
+		return;
+	}
+	// the records are complete once the header points at the index
+	file_.write(reinterpret_cast<const char *>(index_.data()),
+		    (std::streamsize)(index_.size() * sizeof(obs_detect_sidecar_index_entry)));
+	file_.flush();
+	header_.frame_count = index_.size();
+	header_.index_offset = offset_;
+	header_.end_ns = end_ns;
+	file_.seekp(0);
+	file_.write(reinterpret_cast<const char *>(&header_), sizeof(header_));
+	file_.flush();
+	if (!file_) {
+		obs_log(LOG_WARNING, "Cannot write the detection sidecar index");
+		failed_ = true;
+	}
+}
+
+} // namespace output
@@ -0,0 +1,105 @@
+#ifndef SIDECAR_RECORDER_H
+#define SIDECAR_RECORDER_H
+
+#include <opencv2/core/types.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "ort-model/types.hpp"
+#include "ObjectIds.h"
+#include "detection-sidecar.h"
+
+namespace output {
+
+struct SidecarInfo {
+	std::string path;
+	uint64_t start_ns = 0; // video frame time of the recording's first frame
+	uint32_t fps_num = 0;
+	uint32_t fps_den = 1;
+	uint32_t video_width = 0;
+	uint32_t video_height = 0;
+	std::vector<std::string> labels;
+	// classes of the cascade model, after labels in the table
+	std::vector<std::string> cascade_labels;
+};
+
+// An OBS recording in progress
+struct RecordingState {
+	std::string path;      // the file being recorded
+	uint64_t start_ns = 0; // video frame time of its first frame
+};
+
+/**
+ * Writes the detections made while OBS records to a binary sidecar next to the recording, see
+ * detection-sidecar.h for the layout. Results are queued and written on the recorder's own
+ * thread, the index is added when the recording stops.
+ */
+class SidecarRecorder {
+public:
+	static constexpr size_t MAX_QUEUED = 256;
+
+	SidecarRecorder() = default;
+	~SidecarRecorder();
+
+	// The recording OBS is making, false when it is not recording
+	static bool activeRecording(RecordingState &state);
+
+	// The sidecar of a filter for a recording: next to it, named after the source and filter
+	static std::string sidecarPath(const std::string &recording_path,
+				       const std::string &source_name,
+				       const std::string &filter_name);
+
+	// Start a new sidecar, finishing the one being written first
+	void start(const SidecarInfo &info);
+	// Write the index and close the file, waits for the queued results
+	void stop();
+
+	// Queue one result, results before the start of the recording are skipped. tracked: the
+	// object ids are track ids, see publishedIds()
+	void submit(const std::vector<Object> &objects, uint64_t timestamp_ns,
+		    const cv::Size &frame_size, bool tracked);
+
+	uint64_t dropped() const { return dropped_; }
+
+private:
+	struct Record {
+		uint64_t timestamp_ns;
+		cv::Size frame_size;
+		std::vector<Object> objects;
+		bool tracked;
+	};
+
+	void run(SidecarInfo info);
+	void write(const Record &record);
+	void finish(uint64_t end_ns);
+
+	std::mutex mutex_;
+	std::condition_variable changed_;
+	std::deque<Record> queue_;
+	std::string path_; // empty while not recording
+	uint64_t start_ns_ = 0;
+	bool stop_ = false;
+	std::thread thread_;
+	std::atomic<uint64_t> dropped_{0};
+
+	// writer thread only
+	std::ofstream file_;
+	obs_detect_sidecar_header header_{};
+	std::vector<obs_detect_sidecar_index_entry> index_;
+	std::vector<obs_detect_sidecar_object> objects_;
+	uint64_t offset_ = 0;
+	int32_t cascade_label_offset_ = 0;
+	bool failed_ = false;
+};
+
+} // namespace output
+
+#endif /* SIDECAR_RECORDER_H */
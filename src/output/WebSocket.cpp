@@ -0,0 +1,243 @@
+#include "WebSocket.h"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cstring>
+
+namespace output {
+namespace websocket {
+
+namespace {
+
+const char *const HANDSHAKE_GUID = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// SHA-1 of the handshake key, RFC 3174; only used for Sec-WebSocket-Accept
+std::array<uint8_t, 20> sha1(const std::string &message)
+{
+	uint32_t h[5] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+	std::string data = message;
+	const uint64_t bits = (uint64_t)message.size() * 8;
+	data += (char)0x80;
+	while (data.size() % 64 != 56) {
+		data += (char)0;
+	}
+	for (int i = 7; i >= 0; --i) {
+		data += (char)(bits >> (i * 8));
+	}
+
+	auto rotl = [](uint32_t x, int n) { return (x << n) | (x >> (32 - n)); };
+	for (size_t chunk = 0; chunk < data.size(); chunk += 64) {
+		uint32_t w[80];
+		for (int i = 0; i < 16; ++i) {
+			const auto *p = reinterpret_cast<const uint8_t *>(&data[chunk + i * 4]);
+			w[i] = (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 |
+			       p[3];
+		}
+		for (int i = 16; i < 80; ++i) {
+			w[i] = rotl(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+		}
+		uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+		for (int i = 0; i < 80; ++i) {
+			uint32_t f, k;
+			if (i < 20) {
+				f = (b & c) | (~b & d);
+				k = 0x5a827999;
+			} else if (i < 40) {
+				f = b ^ c ^ d;
+				k = 0x6ed9eba1;
+			} else if (i < 60) {
+				f = (b & c) | (b & d) | (c & d);
+				k = 0x8f1bbcdc;
+			} else {
+				f = b ^ c ^ d;
+				k = 0xca62c1d6;
+			}
+			const uint32_t temp = rotl(a, 5) + f + e + k + w[i];
+			e = d;
+			d = c;
+			c = rotl(b, 30);
+			b = a;
+			a = temp;
+		}
+		h[0] += a;
+		h[1] += b;
+		h[2] += c;
+		h[3] += d;
+		h[4] += e;
+	}
+
+	std::array<uint8_t, 20> digest;
+	for (int i = 0; i < 20; ++i) {
+		digest[i] = (uint8_t)(h[i / 4] >> (24 - (i % 4) * 8));
+	}
+	return digest;
+}
+
+std::string base64(const uint8_t *data, size_t size)
+{
+	static const char *const alphabet =
+		"ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+	std::string out;
+	for (size_t i = 0; i < size; i += 3) {
+		const uint32_t n = (uint32_t)data[i] << 16 |
+				   (i + 1 < size ? (uint32_t)data[i + 1] << 8 : 0) |
+				   (i + 2 < size ? data[i + 2] : 0);
+		out += alphabet[(n >> 18) & 63];
+		out += alphabet[(n >> 12) & 63];
+		out += i + 1 < size ? alphabet[(n >> 6) & 63] : '=';
+		out += i + 2 < size ? alphabet[n & 63] : '=';
+	}
+	return out;
+}
+
+std::string lower(std::string text)
+{
+	std::transform(text.begin(), text.end(), text.begin(),
+		       [](unsigned char c) { return (char)std::tolower(c); });
+	return text;
+}
+
+std::string trim(const std::string &text)
+{
+	const size_t begin = text.find_first_not_of(" \t");
+	const size_t end = text.find_last_not_of(" \t\r");
+	return begin == std::string::npos ? std::string() : text.substr(begin, end - begin + 1);
+}
+
+std::string percent_decode(const std::string &text)
+{
+	std::string out;
+	for (size_t i = 0; i < text.size(); ++i) {
+		if (text[i] == '%' && i + 2 < text.size() &&
+		    std::isxdigit((unsigned char)text[i + 1]) &&
+		    std::isxdigit((unsigned char)text[i + 2])) {
+			out += (char)std::stoi(text.substr(i + 1, 2), nullptr, 16);
+			i += 2;
+		} else {
+			out += text[i];
+		}
+	}
+	return out;
+}
+
+} // namespace
+
+long parseRequest(const std::string &data, Request &request)
+{
+	const size_t end = data.find("\r\n\r\n");
+	if (end == std::string::npos) {
+		return 0;
+	}
+
+	size_t line_end = data.find("\r\n");
+	const std::string request_line = data.substr(0, line_end);
+	if (request_line.compare(0, 4, "GET ") != 0) {
+		return -1;
+	}
+	const size_t target_end = request_line.find(' ', 4);
+	const std::string target = request_line.substr(4, target_end - 4);
+	const size_t query = target.find('?');
+	request.path = percent_decode(target.substr(0, query));
+	request.query = query == std::string::npos ? std::string() : target.substr(query + 1);
+
+	bool upgrade = false;
+	request.key.clear();
+	request.origin.clear();
+	while (line_end < end) {
+		const size_t next = data.find("\r\n", line_end + 2);
+		const std::string line = data.substr(line_end + 2, next - line_end - 2);
+		line_end = next;
+		const size_t colon = line.find(':');
+		if (colon == std::string::npos) {
+			continue;
+		}
+		const std::string name = lower(trim(line.substr(0, colon)));
+		const std::string value = trim(line.substr(colon + 1));
+		if (name == "upgrade") {
+			upgrade = lower(value) == "websocket";
+		} else if (name == "sec-websocket-key") {
+			request.key = value;
+		} else if (name == "origin") {
+			request.origin = value;
+		}
+	}
+	if (!upgrade || request.key.empty()) {
+		return -1;
+	}
+	return (long)(end + 4);
+}
+
+std::string acceptResponse(const Request &request)
+{
+	const std::array<uint8_t, 20> digest = sha1(request.key + HANDSHAKE_GUID);
+	return "HTTP/1.1 101 Switching Protocols\r\n"
+	       "Upgrade: websocket\r\n"
+	       "Connection: Upgrade\r\n"
+	       "Sec-WebSocket-Accept: " +
+	       base64(digest.data(), digest.size()) + "\r\n\r\n";
+}
+
+void appendFrame(std::string &out, Opcode opcode, const char *payload, size_t size)
+{
+	out += (char)(0x80 | opcode);
+	if (size < 126) {
+		out += (char)size;
+	} else if (size <= 0xffff) {
+		out += (char)126;
+		out += (char)(size >> 8);
+		out += (char)size;
+	} else {
+		out += (char)127;
+		for (int i = 7; i >= 0; --i) {
+			out += (char)((uint64_t)size >> (i * 8));
+		}
+	}
+	out.append(payload, size);
+}
+
+long parseFrame(const std::string &data, Frame &frame, size_t max_payload)
+{
+	if (data.size() < 2) {
+		return 0;
+	}
+	const auto *bytes = reinterpret_cast<const uint8_t *>(data.data());
+	frame.fin = (bytes[0] & 0x80) != 0;
+	frame.opcode = (Opcode)(bytes[0] & 0x0f);
+	const bool masked = (bytes[1] & 0x80) != 0;
+	uint64_t size = bytes[1] & 0x7f;
+	size_t header = 2;
+	if (size == 126) {
+		header = 4;
+		if (data.size() < header) {
+			return 0;
+		}
+		size = (uint64_t)bytes[2] << 8 | bytes[3];
+	} else if (size == 127) {
+		header = 10;
+		if (data.size() < header) {
+			return 0;
+		}
+		size = 0;
+		for (int i = 0; i < 8; ++i) {
+			size = size << 8 | bytes[2 + i];
+		}
+	}
+	// clients must mask their frames
+	if (!masked || size > max_payload) {
+		return -1;
+	}
+	const size_t total = header + 4 + (size_t)size;
+	if (data.size() < total) {
+		return 0;
+	}
+	const uint8_t *mask = bytes + header;
+	frame.payload.resize((size_t)size);
+	for (size_t i = 0; i < size; ++i) {
+		frame.payload[i] = (char)(bytes[header + 4 + i] ^ mask[i % 4]);
+	}
+	return (long)total;
+}
+
+} // namespace websocket
+} // namespace output
@@ -0,0 +1,59 @@
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include <cstdint>
+#include <string>
+
+namespace output {
+namespace websocket {
+
+enum Opcode : uint8_t {
+	CONTINUATION = 0x0,
+	TEXT = 0x1,
+	BINARY = 0x2,
+	CLOSE = 0x8,
+	PING = 0x9,
+	PONG = 0xa,
+};
+
+// The upgrade request of a client, parsed by parseRequest()
+struct Request {
+	std::string path; // percent-decoded, without the query
+	std::string query;
+	std::string key;    // Sec-WebSocket-Key
+	std::string origin; // of the page for browser clients, empty for the others
+};
+
+/**
+ * Parse the HTTP upgrade request at the start of data.
+ *
+ * @return the length of the request including the blank line, 0 if it is not complete yet and
+ *         -1 if it is not a WebSocket upgrade.
+ */
+long parseRequest(const std::string &data, Request &request);
+
+// The 101 Switching Protocols response to a request
+std::string acceptResponse(const Request &request);
+
+// Append one unmasked (server to client) frame with the whole payload
+void appendFrame(std::string &out, Opcode opcode, const char *payload, size_t size);
+
+// A frame sent by a client, the payload unmasked
+struct Frame {
+	bool fin;
+	Opcode opcode;
+	std::string payload;
+};
+
+/**
+ * Take the first frame off data.
+ *
+ * @return the length of the frame, 0 if it is not complete yet and -1 if it is malformed or
+ *         larger than max_payload.
+ */
+long parseFrame(const std::string &data, Frame &frame, size_t max_payload);
+
+} // namespace websocket
+} // namespace output
+
+#endif /* WEBSOCKET_H */
@@ -0,0 +1,72 @@
+/*
+ * The detection results a Detect filter hands to other plugins and scripts through its signal
+ * and proc handlers. Plain C, include it in a C or C++ plugin as is.
+ *
+ * signal "void detections(ptr source, ptr result, string json)"
+ *	Sent from the filter's inference thread after every result. result is a
+ *	const struct obs_detect_result *, borrowed for the call; call retain() to keep it.
+ *
+ * proc "void get_detections(out string json, out int sequence)"
+ *	The latest result as compact JSON and its sequence, "" and 0 before the first one.
+ *
+ * proc "void get_detections_result(out ptr result)"
+ *	The latest result, NULL before the first one. The caller owns the returned reference
+ *	and must call release() on it.
+ *
+ *	proc_handler_t *ph = obs_source_get_proc_handler(filter);
+ *	calldata_t cd = {0};
+ *	proc_handler_call(ph, "get_detections_result", &cd);
+ *	const struct obs_detect_result *result = calldata_ptr(&cd, "result");
+ *	if (result) {
+ *		...
+ *		result->release(result);
+ *	}
+ *	calldata_free(&cd);
+ *
+ * A result never changes once published, it can be read from any thread.
+ *
+ * track_id is only set while the filter tracks objects, the detector's own numbering changes
+ * from result to result. An object a cascade stage found points at its parent with parent_id:
+ * the parent's track_id, or without tracking the parent's position in objects, counting from 1.
+ */
+
+#ifndef OBS_DETECT_RESULT_H
+#define OBS_DETECT_RESULT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OBS_DETECT_RESULT_VERSION 1u
+
+struct obs_detect_object {
+	float x, y, width, height; /* pixels in the source frame */
+	float score;
+	int32_t label_id;
+	const char *label; /* class name, "" if the model has none for label_id */
+	uint64_t track_id;  /* stable while tracking is on, 0 otherwise */
+	uint64_t parent_id; /* object a cascade stage found this one in, 0 for none, see above */
+};
+
+struct obs_detect_result {
+	uint32_t version; /* OBS_DETECT_RESULT_VERSION */
+	uint32_t frame_width;
+	uint32_t frame_height;
+	uint64_t sequence;     /* number of the result, counting from 1 */
+	uint64_t timestamp_ns; /* video frame time (obs_get_video_frame_time) of the frame */
+	size_t count;
+	const struct obs_detect_object *objects;
+	const char *json; /* the same as compact JSON */
+
+	void (*retain)(const struct obs_detect_result *result);
+	void (*release)(const struct obs_detect_result *result);
+};
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OBS_DETECT_RESULT_H */
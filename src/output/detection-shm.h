@@ -0,0 +1,317 @@
+/*
+ * Shared memory layout of the detections a detect filter publishes for other local processes,
+ * and a header-only reader for them. Plain C, include it in a C or C++ consumer as is.
+ *
+ * The segment is named after the filter's source, see obs_detect_shm_name(), with "-2", "-3",
+ * ... appended when another filter or OBS instance already publishes for a source of that name
+ * (the filter logs the name it uses). It holds a header followed by a ring of fixed-size records,
+ * each protected by a sequence lock: the filter makes the record's seq odd while writing it and
+ * even again when it is done, a reader copies the record and keeps the copy only if seq was the
+ * same even value before and after. Readers never block the filter and take no locks, a read
+ * that overlaps a write is simply retried.
+ *
+ * track_id is only set while the filter tracks objects, the detector's own numbering changes
+ * from result to result. An object a cascade stage found points at its parent with parent_id:
+ * the parent's track_id, or without tracking the parent's position in the record's objects,
+ * counting from 1.
+ *
+ *	struct obs_detect_shm_reader reader;
+ *	struct obs_detect_shm_record record;
+ *	if (obs_detect_shm_open("Video Capture Device", &reader) == 0) {
+ *		if (obs_detect_shm_read_latest(&reader, &record) == 0)
+ *			printf("%u objects\n", record.count);
+ *		obs_detect_shm_close(&reader);
+ *	}
+ */
+
+#ifndef OBS_DETECT_SHM_H
+#define OBS_DETECT_SHM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OBS_DETECT_SHM_MAGIC 0x4f424454u /* "OBDT" */
+#define OBS_DETECT_SHM_VERSION 1u
+#define OBS_DETECT_SHM_SLOTS 8u
+#define OBS_DETECT_SHM_MAX_OBJECTS 64u
+#define OBS_DETECT_SHM_LABEL_SIZE 32u
+
+/* name prefix, and the longest name including the terminating zero */
+#ifdef _WIN32
+#define OBS_DETECT_SHM_PREFIX "Local\\obs-detect-"
+#define OBS_DETECT_SHM_NAME_SIZE 64u
+#elif defined(__APPLE__)
+#define OBS_DETECT_SHM_PREFIX "/obs-detect-"
+#define OBS_DETECT_SHM_NAME_SIZE 32u /* PSHMNAMLEN is 31 */
+#else
+#define OBS_DETECT_SHM_PREFIX "/obs-detect-"
+#define OBS_DETECT_SHM_NAME_SIZE 64u
+#endif
+
+/* errors returned by the reader functions */
+#define OBS_DETECT_SHM_ERR_OPEN -1    /* no segment for this source */
+#define OBS_DETECT_SHM_ERR_FORMAT -2  /* not initialized yet, or another layout version */
+#define OBS_DETECT_SHM_ERR_EMPTY -3   /* nothing published yet */
+#define OBS_DETECT_SHM_ERR_BUSY -4    /* the record kept changing while it was read */
+#define OBS_DETECT_SHM_ERR_MISSED -5  /* the record was overwritten, the reader fell behind */
+
+struct obs_detect_shm_object {
+	float x, y, width, height; /* pixels in the source frame */
+	float score;
+	int32_t label_id;
+	uint64_t track_id;  /* stable while tracking is on, 0 otherwise */
+	uint64_t parent_id; /* object a cascade stage found this one in, 0 for none, see above */
+	char label[OBS_DETECT_SHM_LABEL_SIZE]; /* class name, zero terminated */
+};
+
+struct obs_detect_shm_record {
+	uint64_t seq;          /* sequence lock, odd while the record is written */
+	uint64_t sequence;     /* number of the result, counting from 1 */
+	uint64_t timestamp_ns; /* video frame time (obs_get_video_frame_time) of the frame */
+	uint32_t frame_width;
+	uint32_t frame_height;
+	uint32_t count; /* valid entries in objects */
+	uint32_t total; /* objects detected, more than count when they did not all fit */
+	struct obs_detect_shm_object objects[OBS_DETECT_SHM_MAX_OBJECTS];
+};
+
+struct obs_detect_shm_header {
+	uint32_t magic; /* OBS_DETECT_SHM_MAGIC once the segment is ready */
+	uint32_t version;
+	uint32_t header_size; /* offset of the first record */
+	uint32_t record_size;
+	uint32_t slot_count;
+	uint32_t max_objects;
+	uint64_t write_index; /* records published, the latest in slot (write_index - 1) % slots */
+	uint64_t writer_pid;
+	uint8_t reserved[24];
+};
+
+struct obs_detect_shm_reader {
+	const struct obs_detect_shm_header *header;
+	size_t size;
+#ifdef _WIN32
+	HANDLE mapping;
+#endif
+};
+
+/* acquire/release accesses to the words the writer and the readers synchronize on */
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+/* interlocked operations are full barriers, no separate fences are needed */
+static inline uint64_t obs_detect_shm_load(const volatile uint64_t *p)
+{
+	return (uint64_t)_InterlockedOr64((volatile __int64 *)p, 0);
+}
+static inline void obs_detect_shm_store(volatile uint64_t *p, uint64_t value)
+{
+	_InterlockedExchange64((volatile __int64 *)p, (__int64)value);
+}
+static inline void obs_detect_shm_fence_acquire(void) {}
+static inline void obs_detect_shm_fence_release(void) {}
+#else
+static inline uint64_t obs_detect_shm_load(const volatile uint64_t *p)
+{
+	return __atomic_load_n(p, __ATOMIC_ACQUIRE);
+}
+static inline void obs_detect_shm_store(volatile uint64_t *p, uint64_t value)
+{
+	__atomic_store_n(p, value, __ATOMIC_RELEASE);
+}
+static inline void obs_detect_shm_fence_acquire(void)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+}
+static inline void obs_detect_shm_fence_release(void)
+{
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+#endif
+
+/*
+ * The segment name for a source name: the prefix followed by the source name with everything
+ * but letters, digits, '-' and '_' replaced by '_', cut to OBS_DETECT_SHM_NAME_SIZE - 1.
+ */
+static inline void obs_detect_shm_name(const char *source_name, char *name, size_t size)
+{
+	size_t len = 0;
+	const char *c;
+
+	if (size == 0)
+		return;
+	for (c = OBS_DETECT_SHM_PREFIX; *c && len + 1 < size; c++)
+		name[len++] = *c;
+	if (size > OBS_DETECT_SHM_NAME_SIZE)
+		size = OBS_DETECT_SHM_NAME_SIZE;
+	for (c = source_name; *c && len + 1 < size; c++) {
+		const char ch = *c;
+		const int keep = (ch >= 'a' && ch <= 'z') || (ch >= 'A' && ch <= 'Z') ||
+				 (ch >= '0' && ch <= '9') || ch == '-' || ch == '_';
+		name[len++] = keep ? ch : '_';
+	}
+	name[len] = '\0';
+}
+
+static inline struct obs_detect_shm_record *
+obs_detect_shm_slot(const struct obs_detect_shm_header *header, uint64_t index)
+{
+	return (struct obs_detect_shm_record *)((char *)header + header->header_size +
+						(size_t)(index % header->slot_count) *
+							header->record_size);
+}
+
+static inline void obs_detect_shm_close(struct obs_detect_shm_reader *reader)
+{
+	if (reader->header) {
+#ifdef _WIN32
+		UnmapViewOfFile(reader->header);
+#else
+		munmap((void *)reader->header, reader->size);
+#endif
+	}
+#ifdef _WIN32
+	if (reader->mapping)
+		CloseHandle(reader->mapping);
+	reader->mapping = NULL;
+#endif
+	reader->header = NULL;
+	reader->size = 0;
+}
+
+/* Map the segment of a source read-only, 0 or an OBS_DETECT_SHM_ERR_ value */
+static inline int obs_detect_shm_open_name(const char *name, struct obs_detect_shm_reader *reader)
+{
+	const struct obs_detect_shm_header *header;
+
+	memset(reader, 0, sizeof(*reader));
+#ifdef _WIN32
+	reader->mapping = OpenFileMappingA(FILE_MAP_READ, FALSE, name);
+	if (!reader->mapping)
+		return OBS_DETECT_SHM_ERR_OPEN;
+	reader->header = (const struct obs_detect_shm_header *)MapViewOfFile(
+		reader->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (!reader->header) {
+		obs_detect_shm_close(reader);
+		return OBS_DETECT_SHM_ERR_OPEN;
+	}
+	{
+		MEMORY_BASIC_INFORMATION info;
+		VirtualQuery(reader->header, &info, sizeof(info));
+		reader->size = info.RegionSize;
+	}
+#else
+	{
+		struct stat st;
+		void *view;
+		const int fd = shm_open(name, O_RDONLY, 0);
+		if (fd < 0)
+			return OBS_DETECT_SHM_ERR_OPEN;
+		if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(*header)) {
+			close(fd);
+			return OBS_DETECT_SHM_ERR_FORMAT;
+		}
+		view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (view == MAP_FAILED)
+			return OBS_DETECT_SHM_ERR_OPEN;
+		reader->header = (const struct obs_detect_shm_header *)view;
+		reader->size = (size_t)st.st_size;
+	}
+#endif
+	header = reader->header;
+	obs_detect_shm_fence_acquire();
+	if (header->magic != OBS_DETECT_SHM_MAGIC || header->version != OBS_DETECT_SHM_VERSION ||
+	    header->record_size != sizeof(struct obs_detect_shm_record) ||
+	    header->slot_count == 0 ||
+	    (size_t)header->header_size + (size_t)header->slot_count * header->record_size >
+		    reader->size) {
+		obs_detect_shm_close(reader);
+		return OBS_DETECT_SHM_ERR_FORMAT;
+	}
+	return 0;
+}
+
+static inline int obs_detect_shm_open(const char *source_name, struct obs_detect_shm_reader *reader)
+{
+	char name[OBS_DETECT_SHM_NAME_SIZE];
+	obs_detect_shm_name(source_name, name, sizeof(name));
+	return obs_detect_shm_open_name(name, reader);
+}
+
+/* Results published so far, the sequence of the latest one */
+static inline uint64_t obs_detect_shm_write_index(const struct obs_detect_shm_reader *reader)
+{
+	return obs_detect_shm_load(&reader->header->write_index);
+}
+
+/*
+ * Copy the record with the given sequence (1 is the first result) while it is still in the
+ * ring, 0 or an OBS_DETECT_SHM_ERR_ value.
+ */
+static inline int obs_detect_shm_read(const struct obs_detect_shm_reader *reader,
+				      uint64_t sequence, struct obs_detect_shm_record *record)
+{
+	const struct obs_detect_shm_record *slot;
+	int attempt;
+
+	if (sequence == 0 || sequence > obs_detect_shm_write_index(reader))
+		return OBS_DETECT_SHM_ERR_EMPTY;
+	slot = obs_detect_shm_slot(reader->header, sequence - 1);
+	for (attempt = 0; attempt < 64; attempt++) {
+		const uint64_t before = obs_detect_shm_load(&slot->seq);
+		if (before & 1)
+			continue;
+		memcpy(record, slot, sizeof(*record));
+		obs_detect_shm_fence_acquire();
+		if (obs_detect_shm_load(&slot->seq) != before)
+			continue;
+		if (record->sequence != sequence)
+			return OBS_DETECT_SHM_ERR_MISSED;
+		if (record->count > OBS_DETECT_SHM_MAX_OBJECTS)
+			record->count = OBS_DETECT_SHM_MAX_OBJECTS;
+		return 0;
+	}
+	return OBS_DETECT_SHM_ERR_BUSY;
+}
+
+/* Copy the latest record, 0 or an OBS_DETECT_SHM_ERR_ value */
+static inline int obs_detect_shm_read_latest(const struct obs_detect_shm_reader *reader,
+					     struct obs_detect_shm_record *record)
+{
+	int attempt;
+
+	for (attempt = 0; attempt < 4; attempt++) {
+		const int result =
+			obs_detect_shm_read(reader, obs_detect_shm_write_index(reader), record);
+		/* overwritten by a newer result in between: read that one */
+		if (result != OBS_DETECT_SHM_ERR_MISSED)
+			return result;
+	}
+	return OBS_DETECT_SHM_ERR_BUSY;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OBS_DETECT_SHM_H */
@@ -0,0 +1,313 @@
+/*
+ * Layout of the detection sidecar a detect filter writes next to an OBS recording, and a
+ * header-only reader that maps it and seeks by timestamp. Plain C, include it in a C or C++
+ * tool as is. All fields are little-endian and naturally aligned, the file can be used in place
+ * through a memory mapping.
+ *
+ *	header				struct obs_detect_sidecar_header
+ *	labels				label_count x char[OBS_DETECT_SIDECAR_LABEL_SIZE]
+ *	frames, from records_offset	per result: struct obs_detect_sidecar_frame followed by
+ *					count x struct obs_detect_sidecar_object
+ *	index, at index_offset		frame_count x struct obs_detect_sidecar_index_entry
+ *
+ * Timestamps are the OBS video frame time (obs_get_video_frame_time(), the os_gettime_ns()
+ * clock) of the frame the detections were made on. start_ns is the frame time of the first
+ * frame of the recording, so a result belongs to the video frame at
+ * (timestamp_ns - start_ns) * fps_num / fps_den / 1e9.
+ *
+ * The label table holds the classes of the filter's model followed by those of its cascade
+ * model. Objects a cascade stage found have a parent_id, their label_id is offset by the count
+ * of the first model's classes.
+ *
+ * track_id is only set while the filter tracks objects, the detector's own numbering changes
+ * from result to result. parent_id is the parent's track_id, or without tracking the parent's
+ * position in the frame's objects, counting from 1.
+ *
+ * The index and frame_count are written when the recording stops. A file without them, still
+ * being written or cut short by a crash, is scanned once on open instead.
+ *
+ *	struct obs_detect_sidecar sidecar;
+ *	if (obs_detect_sidecar_open("Recording.Camera.Detect.detections", &sidecar) == 0) {
+ *		uint64_t at_1m30s = sidecar.header->start_ns + 90000000000ull;
+ *		int64_t i = obs_detect_sidecar_find(&sidecar, at_1m30s);
+ *		if (i >= 0) {
+ *			const struct obs_detect_sidecar_frame *frame =
+ *				obs_detect_sidecar_frame_at(&sidecar, (uint64_t)i);
+ *			printf("%u objects\n", frame->count);
+ *		}
+ *		obs_detect_sidecar_close(&sidecar);
+ *	}
+ */
+
+#ifndef OBS_DETECT_SIDECAR_H
+#define OBS_DETECT_SIDECAR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OBS_DETECT_SIDECAR_MAGIC "OBSDETSC"
+#define OBS_DETECT_SIDECAR_VERSION 1u
+#define OBS_DETECT_SIDECAR_LABEL_SIZE 32u
+
+/* errors returned by obs_detect_sidecar_open */
+#define OBS_DETECT_SIDECAR_ERR_OPEN -1   /* the file cannot be opened or mapped */
+#define OBS_DETECT_SIDECAR_ERR_FORMAT -2 /* not a sidecar, or another layout version */
+
+struct obs_detect_sidecar_header {
+	char magic[8]; /* OBS_DETECT_SIDECAR_MAGIC, not zero terminated */
+	uint32_t version;
+	uint32_t header_size;
+	uint32_t frame_size;  /* sizeof(struct obs_detect_sidecar_frame) */
+	uint32_t object_size; /* sizeof(struct obs_detect_sidecar_object) */
+	uint32_t label_count;
+	uint32_t label_size;
+	uint64_t records_offset; /* the first frame, after the labels */
+	uint64_t start_ns;       /* video frame time of the recording's first frame */
+	uint32_t fps_num;        /* the recording's frame rate */
+	uint32_t fps_den;
+	uint32_t video_width; /* the recording's output size */
+	uint32_t video_height;
+	uint64_t frame_count;  /* results in the file, 0 until the recording stops */
+	uint64_t index_offset; /* the index, 0 until the recording stops */
+	uint64_t end_ns;       /* video frame time when the recording stopped, 0 until then */
+	uint8_t reserved[40];
+};
+
+struct obs_detect_sidecar_frame {
+	uint64_t timestamp_ns; /* video frame time of the frame the detections were made on */
+	uint64_t sequence;     /* number of the result in this file, counting from 1 */
+	uint32_t frame_width;  /* size of the source frame the boxes are in */
+	uint32_t frame_height;
+	uint32_t count; /* objects following this record */
+	uint32_t reserved;
+};
+
+struct obs_detect_sidecar_object {
+	float x, y, width, height; /* pixels in the source frame */
+	float score;
+	int32_t label_id; /* into the label table, which may be shorter than the model's classes */
+	uint64_t track_id;  /* stable while tracking is on, 0 otherwise */
+	uint64_t parent_id; /* object a cascade stage found this one in, 0 for none, see above */
+};
+
+struct obs_detect_sidecar_index_entry {
+	uint64_t timestamp_ns;
+	uint64_t offset; /* of the frame record from the start of the file */
+};
+
+struct obs_detect_sidecar {
+	const struct obs_detect_sidecar_header *header;
+	const unsigned char *data;
+	size_t size;
+	const struct obs_detect_sidecar_index_entry *index;
+	uint64_t frame_count;
+	struct obs_detect_sidecar_index_entry *scanned; /* the index built for unfinished files */
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif
+};
+
+static inline void obs_detect_sidecar_close(struct obs_detect_sidecar *sidecar)
+{
+	if (sidecar->data) {
+#ifdef _WIN32
+		UnmapViewOfFile(sidecar->data);
+#else
+		munmap((void *)sidecar->data, sidecar->size);
+#endif
+	}
+#ifdef _WIN32
+	if (sidecar->mapping)
+		CloseHandle(sidecar->mapping);
+	if (sidecar->file && sidecar->file != INVALID_HANDLE_VALUE)
+		CloseHandle(sidecar->file);
+#endif
+	free(sidecar->scanned);
+	memset(sidecar, 0, sizeof(*sidecar));
+}
+
+/* Index the complete frame records of a file without an index, 0 or an error */
+static inline int obs_detect_sidecar_scan(struct obs_detect_sidecar *sidecar)
+{
+	const struct obs_detect_sidecar_header *header = sidecar->header;
+	uint64_t offset = header->records_offset;
+	uint64_t capacity = 0;
+
+	sidecar->frame_count = 0;
+	while (offset + sizeof(struct obs_detect_sidecar_frame) <= sidecar->size) {
+		const struct obs_detect_sidecar_frame *frame =
+			(const struct obs_detect_sidecar_frame *)(sidecar->data + offset);
+		const uint64_t objects_size =
+			(uint64_t)frame->count * sizeof(struct obs_detect_sidecar_object);
+		const uint64_t next = offset + sizeof(*frame) + objects_size;
+		/* a record the writer has not finished, or a torn one after a crash */
+		if (next > sidecar->size || frame->sequence != sidecar->frame_count + 1)
+			break;
+		if (sidecar->frame_count == capacity) {
+			struct obs_detect_sidecar_index_entry *grown;
+			capacity = capacity ? capacity * 2 : 1024;
+			grown = (struct obs_detect_sidecar_index_entry *)realloc(
+				sidecar->scanned, (size_t)capacity * sizeof(*grown));
+			if (!grown)
+				return OBS_DETECT_SIDECAR_ERR_OPEN;
+			sidecar->scanned = grown;
+		}
+		sidecar->scanned[sidecar->frame_count].timestamp_ns = frame->timestamp_ns;
+		sidecar->scanned[sidecar->frame_count].offset = offset;
+		sidecar->frame_count++;
+		offset = next;
+	}
+	sidecar->index = sidecar->scanned;
+	return 0;
+}
+
+/* Map a sidecar file read-only, 0 or an OBS_DETECT_SIDECAR_ERR_ value */
+static inline int obs_detect_sidecar_open(const char *path, struct obs_detect_sidecar *sidecar)
+{
+	const struct obs_detect_sidecar_header *header;
+
+	memset(sidecar, 0, sizeof(*sidecar));
+#ifdef _WIN32
+	{
+		LARGE_INTEGER size;
+		sidecar->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+					    NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if (sidecar->file == INVALID_HANDLE_VALUE || !GetFileSizeEx(sidecar->file, &size)) {
+			obs_detect_sidecar_close(sidecar);
+			return OBS_DETECT_SIDECAR_ERR_OPEN;
+		}
+		if ((uint64_t)size.QuadPart < sizeof(*header)) {
+			obs_detect_sidecar_close(sidecar);
+			return OBS_DETECT_SIDECAR_ERR_FORMAT;
+		}
+		sidecar->mapping =
+			CreateFileMappingA(sidecar->file, NULL, PAGE_READONLY, 0, 0, NULL);
+		sidecar->data = sidecar->mapping ? (const unsigned char *)MapViewOfFile(
+							   sidecar->mapping, FILE_MAP_READ, 0, 0, 0)
+						 : NULL;
+		if (!sidecar->data) {
+			obs_detect_sidecar_close(sidecar);
+			return OBS_DETECT_SIDECAR_ERR_OPEN;
+		}
+		sidecar->size = (size_t)size.QuadPart;
+	}
+#else
+	{
+		struct stat st;
+		void *view;
+		const int fd = open(path, O_RDONLY);
+		if (fd < 0)
+			return OBS_DETECT_SIDECAR_ERR_OPEN;
+		if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(*header)) {
+			close(fd);
+			return OBS_DETECT_SIDECAR_ERR_FORMAT;
+		}
+		view = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (view == MAP_FAILED)
+			return OBS_DETECT_SIDECAR_ERR_OPEN;
+		sidecar->data = (const unsigned char *)view;
+		sidecar->size = (size_t)st.st_size;
+	}
+#endif
+	header = (const struct obs_detect_sidecar_header *)sidecar->data;
+	sidecar->header = header;
+	if (memcmp(header->magic, OBS_DETECT_SIDECAR_MAGIC, sizeof(header->magic)) != 0 ||
+	    header->version != OBS_DETECT_SIDECAR_VERSION ||
+	    header->frame_size != sizeof(struct obs_detect_sidecar_frame) ||
+	    header->object_size != sizeof(struct obs_detect_sidecar_object) ||
+	    header->records_offset > sidecar->size ||
+	    (uint64_t)header->header_size + (uint64_t)header->label_count * header->label_size >
+		    header->records_offset) {
+		obs_detect_sidecar_close(sidecar);
+		return OBS_DETECT_SIDECAR_ERR_FORMAT;
+	}
+	if (header->index_offset != 0) {
+		const uint64_t index_size =
+			header->frame_count * sizeof(struct obs_detect_sidecar_index_entry);
+		if (header->index_offset + index_size <= sidecar->size) {
+			sidecar->index = (const struct obs_detect_sidecar_index_entry *)(
+				sidecar->data + header->index_offset);
+			sidecar->frame_count = header->frame_count;
+			return 0;
+		}
+	}
+	if (obs_detect_sidecar_scan(sidecar) != 0) {
+		obs_detect_sidecar_close(sidecar);
+		return OBS_DETECT_SIDECAR_ERR_OPEN;
+	}
+	return 0;
+}
+
+/* The frame record of result i, 0 <= i < frame_count; its objects follow it */
+static inline const struct obs_detect_sidecar_frame *
+obs_detect_sidecar_frame_at(const struct obs_detect_sidecar *sidecar, uint64_t i)
+{
+	return (const struct obs_detect_sidecar_frame *)(sidecar->data + sidecar->index[i].offset);
+}
+
+static inline const struct obs_detect_sidecar_object *
+obs_detect_sidecar_objects(const struct obs_detect_sidecar_frame *frame)
+{
+	return (const struct obs_detect_sidecar_object *)(frame + 1);
+}
+
+/*
+ * The result in effect at a video frame time: the last one made on a frame at or before
+ * timestamp_ns, -1 if the first result is later. A binary search of the index.
+ */
+static inline int64_t obs_detect_sidecar_find(const struct obs_detect_sidecar *sidecar,
+					      uint64_t timestamp_ns)
+{
+	uint64_t low = 0;
+	uint64_t high = sidecar->frame_count;
+
+	/* the first entry later than timestamp_ns */
+	while (low < high) {
+		const uint64_t mid = low + (high - low) / 2;
+		if (sidecar->index[mid].timestamp_ns <= timestamp_ns)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	return (int64_t)low - 1;
+}
+
+/* The class name of a label id, "" when the file has none for it */
+static inline const char *obs_detect_sidecar_label(const struct obs_detect_sidecar *sidecar,
+						   int32_t label_id)
+{
+	const struct obs_detect_sidecar_header *header = sidecar->header;
+	if (label_id < 0 || (uint32_t)label_id >= header->label_count)
+		return "";
+	return (const char *)(sidecar->data + header->header_size +
+			      (size_t)label_id * header->label_size);
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OBS_DETECT_SIDECAR_H */
@@ -0,0 +1,137 @@
+#include "GlyphAtlas.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "kernels/kernels.h"
+
+namespace overlay {
+
+namespace {
+
+constexpr int FONT_FACE = cv::FONT_HERSHEY_SIMPLEX;
+constexpr double FONT_SCALE = 0.4;
+constexpr int FONT_THICKNESS = 1;
+
+// BGRA rows go through the dispatched blend kernel, as a row of the color with the coverage as
+// its alpha in overlay
+void blend_row(const uint8_t *alpha, uint8_t *pixel, int width, int channels, const int *bgr,
+	       std::vector<uint8_t> &overlay)
+{
+	if (channels == 4) {
+		overlay.resize((size_t)width * 4);
+		for (int i = 0; i < width; ++i) {
+			uint8_t *o = overlay.data() + (size_t)i * 4;
+			o[0] = (uint8_t)bgr[0];
+			o[1] = (uint8_t)bgr[1];
+			o[2] = (uint8_t)bgr[2];
+			o[3] = alpha[i];
+		}
+		kernels().bgra_blend_over(pixel, overlay.data(), (size_t)width);
+		return;
+	}
+	for (int i = 0; i < width; ++i, pixel += channels) {
+		const int a = alpha[i];
+		if (a == 0) {
+			continue;
+		}
+		for (int ch = 0; ch < 3; ++ch) {
+			pixel[ch] = (uint8_t)((bgr[ch] * a + pixel[ch] * (255 - a) + 127) / 255);
+		}
+	}
+}
+
+} // namespace
+
+const GlyphAtlas &GlyphAtlas::instance()
+{
+	static const GlyphAtlas atlas;
+	return atlas;
+}
+
+GlyphAtlas::GlyphAtlas()
+{
+	std::string printable;
+	for (int c = FIRST; c <= LAST; ++c) {
+		printable += (char)c;
+	}
+	// the height and baseline of the font, the same for any text
+	int baseline = 0;
+	ascent_ = cv::getTextSize(printable, FONT_FACE, FONT_SCALE, FONT_THICKNESS, &baseline)
+			  .height;
+	descent_ = baseline;
+
+	int x = 0;
+	for (int c = FIRST; c <= LAST; ++c) {
+		const int advance = cv::getTextSize(std::string(1, (char)c), FONT_FACE, FONT_SCALE,
+						    FONT_THICKNESS, &baseline)
+					    .width;
+		glyphs_[c - FIRST] = {x, advance + 2 * PADDING, advance};
+		x += advance + 2 * PADDING;
+	}
+
+	coverage_ = cv::Mat::zeros(cellHeight(), x, CV_8UC1);
+	for (int c = FIRST; c <= LAST; ++c) {
+		const Glyph &cell = glyphs_[c - FIRST];
+		cv::putText(coverage_, std::string(1, (char)c),
+			    cv::Point(cell.x + PADDING, PADDING + ascent_), FONT_FACE, FONT_SCALE,
+			    cv::Scalar(255), FONT_THICKNESS, cv::LINE_AA);
+	}
+}
+
+const GlyphAtlas::Glyph &GlyphAtlas::glyph(char c) const
+{
+	const int code = (unsigned char)c;
+	return glyphs_[(code >= FIRST && code <= LAST ? code : '?') - FIRST];
+}
+
+cv::Mat GlyphAtlas::toneTexture() const
+{
+	cv::Mat texture(2 * coverage_.rows, coverage_.cols, CV_8UC4);
+	for (int y = 0; y < coverage_.rows; ++y) {
+		const uint8_t *alpha = coverage_.ptr<uint8_t>(y);
+		cv::Vec4b *light = texture.ptr<cv::Vec4b>(y);
+		cv::Vec4b *dark = texture.ptr<cv::Vec4b>(coverage_.rows + y);
+		for (int x = 0; x < coverage_.cols; ++x) {
+			light[x] = cv::Vec4b(alpha[x], alpha[x], alpha[x], alpha[x]);
+			dark[x] = cv::Vec4b(0, 0, 0, alpha[x]);
+		}
+	}
+	return texture;
+}
+
+void GlyphAtlas::drawText(cv::Mat &image, cv::Point origin, const std::string &text,
+			  const cv::Scalar &color) const
+{
+	CV_Assert(image.depth() == CV_8U && (image.channels() == 3 || image.channels() == 4));
+	const int bgr[3] = {(int)color[0], (int)color[1], (int)color[2]};
+	std::vector<uint8_t> overlay;
+	const int top = origin.y - ascent_ - PADDING;
+	int x = origin.x;
+	for (const char c : text) {
+		const Glyph &cell = glyph(c);
+		// the cell on the image, clipped
+		const int left = x - PADDING;
+		const cv::Rect area = cv::Rect(left, top, cell.width, cellHeight()) &
+				      cv::Rect(0, 0, image.cols, image.rows);
+		for (int y = area.y; y < area.y + area.height; ++y) {
+			blend_row(coverage_.ptr<uint8_t>(y - top) + cell.x + (area.x - left),
+				  image.ptr<uint8_t>(y) + (size_t)area.x * image.channels(),
+				  area.width, image.channels(), bgr, overlay);
+		}
+		x += cell.advance;
+	}
+}
+
+int GlyphAtlas::textWidth(const std::string &text) const
+{
+	int width = 0;
+	for (const char c : text) {
+		width += glyph(c).advance;
+	}
+	return width;
+}
+
+} // namespace overlay
@@ -0,0 +1,68 @@
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include <opencv2/core.hpp>
+
+#include <string>
+
+namespace overlay {
+
+/**
+ * The printable ASCII glyphs of the label font, rasterized once side by side so that text can
+ * be drawn as one quad per glyph instead of with cv::putText on every frame.
+ *
+ * The font is the one draw_objects labels with, FONT_HERSHEY_SIMPLEX at scale 0.4. Glyphs are
+ * placed in cells with PADDING pixels around them for the antialiased edges, the baseline is
+ * PADDING + ascent() from the top of a cell.
+ */
+class GlyphAtlas {
+public:
+	static constexpr int FIRST = 32;
+	static constexpr int LAST = 126;
+	static constexpr int PADDING = 1;
+
+	// A glyph's cell in the atlas, in pixels
+	struct Glyph {
+		int x;
+		int width;   // of the cell, advance + 2 * PADDING
+		int advance; // to the next glyph
+	};
+
+	// Rasterized on first use
+	static const GlyphAtlas &instance();
+
+	// Characters outside the atlas are drawn as '?'
+	const Glyph &glyph(char c) const;
+	int textWidth(const std::string &text) const;
+
+	int ascent() const { return ascent_; }
+	int descent() const { return descent_; }
+	int cellHeight() const { return ascent_ + descent_ + 2 * PADDING; }
+
+	// CV_8UC1 coverage of all glyphs, cellHeight() rows
+	const cv::Mat &coverage() const { return coverage_; }
+	// Premultiplied BGRA for the GPU: white glyphs in the upper cellHeight() rows, black ones
+	// in the lower
+	cv::Mat toneTexture() const;
+
+	/**
+	 * Blend text in color into an 8-bit BGR or BGRA image, touching only the pixels the glyphs
+	 * cover. On BGRA the glyphs are also composited into the alpha channel.
+	 *
+	 * @param origin The start of the text on its baseline, like cv::putText's.
+	 */
+	void drawText(cv::Mat &image, cv::Point origin, const std::string &text,
+		      const cv::Scalar &color) const;
+
+private:
+	GlyphAtlas();
+
+	Glyph glyphs_[LAST - FIRST + 1];
+	int ascent_ = 0;
+	int descent_ = 0;
+	cv::Mat coverage_;
+};
+
+} // namespace overlay
+
+#endif /* GLYPH_ATLAS_H */
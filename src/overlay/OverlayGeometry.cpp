@@ -0,0 +1,182 @@
+#include "OverlayGeometry.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "ort-model/utils.hpp"
+
+namespace overlay {
+
+namespace {
+
+constexpr float PI = 3.14159265f;
+constexpr int CIRCLE_SEGMENTS = 64;
+
+uint32_t scaled_color(const float *bgr, float scale)
+{
+	return rgba((uint8_t)(bgr[2] * scale), (uint8_t)(bgr[1] * scale),
+		    (uint8_t)(bgr[0] * scale));
+}
+
+} // namespace
+
+void OverlayGeometry::addQuad(float x1, float y1, float x2, float y2, float x3, float y3,
+			      float x4, float y4, uint32_t color)
+{
+	// corners in order around the quad
+	solid_.push_back({x1, y1, color});
+	solid_.push_back({x2, y2, color});
+	solid_.push_back({x3, y3, color});
+	solid_.push_back({x1, y1, color});
+	solid_.push_back({x3, y3, color});
+	solid_.push_back({x4, y4, color});
+}
+
+void OverlayGeometry::addLine(float x1, float y1, float x2, float y2, float thickness,
+			      uint32_t color)
+{
+	const float length = std::hypot(x2 - x1, y2 - y1);
+	if (length <= 0.0f) {
+		return;
+	}
+	const float nx = -(y2 - y1) / length * thickness * 0.5f;
+	const float ny = (x2 - x1) / length * thickness * 0.5f;
+	addQuad(x1 + nx, y1 + ny, x2 + nx, y2 + ny, x2 - nx, y2 - ny, x1 - nx, y1 - ny, color);
+}
+
+void OverlayGeometry::addFilledRect(const cv::Rect_<float> &rect, uint32_t color)
+{
+	const float right = rect.x + rect.width;
+	const float bottom = rect.y + rect.height;
+	addQuad(rect.x, rect.y, right, rect.y, right, bottom, rect.x, bottom, color);
+}
+
+void OverlayGeometry::addRect(const cv::Rect_<float> &rect, float thickness, uint32_t color)
+{
+	const float half = thickness * 0.5f;
+	const float right = rect.x + rect.width;
+	const float bottom = rect.y + rect.height;
+	// the top and bottom edges cover the corners, the sides fit in between
+	addFilledRect({rect.x - half, rect.y - half, rect.width + thickness, thickness}, color);
+	addFilledRect({rect.x - half, bottom - half, rect.width + thickness, thickness}, color);
+	if (rect.height > thickness) {
+		addFilledRect({rect.x - half, rect.y + half, thickness, rect.height - thickness},
+			      color);
+		addFilledRect({right - half, rect.y + half, thickness, rect.height - thickness},
+			      color);
+	}
+}
+
+void OverlayGeometry::addDashedRect(const cv::Rect_<float> &rect, float thickness, float dash,
+				    uint32_t color)
+{
+	if (dash <= 0.0f) {
+		addRect(rect, thickness, color);
+		return;
+	}
+	const float right = rect.x + rect.width;
+	const float bottom = rect.y + rect.height;
+	const float corners[5][2] = {{rect.x, rect.y},
+				     {right, rect.y},
+				     {right, bottom},
+				     {rect.x, bottom},
+				     {rect.x, rect.y}};
+	for (int side = 0; side < 4; ++side) {
+		const float x = corners[side][0];
+		const float y = corners[side][1];
+		const float dx = corners[side + 1][0] - x;
+		const float dy = corners[side + 1][1] - y;
+		const float length = std::hypot(dx, dy);
+		// every side starts with a dash, like drawDashedLine
+		for (float d = 0.0f; d < length; d += 2.0f * dash) {
+			const float end = std::min(d + dash, length);
+			addLine(x + dx * d / length, y + dy * d / length, x + dx * end / length,
+				y + dy * end / length, thickness, color);
+		}
+	}
+}
+
+void OverlayGeometry::addCircle(float x, float y, float radius, float thickness, uint32_t color)
+{
+	const float inner = std::max(radius - thickness * 0.5f, 0.0f);
+	const float outer = radius + thickness * 0.5f;
+	for (int i = 0; i < CIRCLE_SEGMENTS; ++i) {
+		const float a1 = 2.0f * PI * i / CIRCLE_SEGMENTS;
+		const float a2 = 2.0f * PI * (i + 1) / CIRCLE_SEGMENTS;
+		const float c1 = std::cos(a1), s1 = std::sin(a1);
+		const float c2 = std::cos(a2), s2 = std::sin(a2);
+		addQuad(x + inner * c1, y + inner * s1, x + outer * c1, y + outer * s1,
+			x + outer * c2, y + outer * s2, x + inner * c2, y + inner * s2, color);
+	}
+}
+
+void OverlayGeometry::addText(float x, float baseline, const std::string &text, bool dark)
+{
+	const GlyphAtlas &atlas = GlyphAtlas::instance();
+	const float atlas_width = (float)atlas.coverage().cols;
+	const float atlas_height = 2.0f * atlas.cellHeight();
+	const float top = baseline - atlas.ascent() - GlyphAtlas::PADDING;
+	const float bottom = top + atlas.cellHeight();
+	const float v1 = (dark ? atlas.cellHeight() : 0) / atlas_height;
+	const float v2 = v1 + atlas.cellHeight() / atlas_height;
+	for (const char c : text) {
+		const GlyphAtlas::Glyph &glyph = atlas.glyph(c);
+		if (c != ' ') {
+			const float left = x - GlyphAtlas::PADDING;
+			const float right = left + glyph.width;
+			const float u1 = glyph.x / atlas_width;
+			const float u2 = (glyph.x + glyph.width) / atlas_width;
+			text_.push_back({left, top, u1, v1});
+			text_.push_back({right, top, u2, v1});
+			text_.push_back({right, bottom, u2, v2});
+			text_.push_back({left, top, u1, v1});
+			text_.push_back({right, bottom, u2, v2});
+			text_.push_back({left, bottom, u1, v2});
+		}
+		x += glyph.advance;
+	}
+}
+
+void OverlayGeometry::addObjects(const std::vector<Object> &objects,
+				 const std::vector<std::string> &class_names)
+{
+	const GlyphAtlas &atlas = GlyphAtlas::instance();
+	for (const Object &obj : objects) {
+		const float *color = color_list[obj.label % 80];
+		// the mean draw_objects takes, over the three channels and a zero
+		const bool dark_text = (color[0] + color[1] + color[2]) / 4.0f > 0.5f;
+
+		addRect(obj.rect, 2.0f, scaled_color(color, 255.0f));
+
+		char text[256];
+		if (obj.label >= 0 && (size_t)obj.label < class_names.size()) {
+			snprintf(text, sizeof(text), "%s %.1f%%", class_names[obj.label].c_str(),
+				 obj.prob * 100);
+		} else {
+			snprintf(text, sizeof(text), "%d %.1f%%", obj.label, obj.prob * 100);
+		}
+
+		const float x = (float)(int)obj.rect.x;
+		const float y = (float)std::min((int)(obj.rect.y + 1), height_);
+		addFilledRect({x, y, (float)atlas.textWidth(text),
+			       (float)(atlas.ascent() + atlas.descent())},
+			      scaled_color(color, 0.7f * 255.0f));
+		addText(x, y + atlas.ascent(), text, dark_text);
+
+		snprintf(text, sizeof(text), "ID: %d", (int)obj.id);
+		addText(x, y + atlas.ascent() + 15.0f, text, dark_text);
+	}
+}
+
+void OverlayGeometry::addMarkers()
+{
+	const float x = (float)(width_ / 2);
+	const float y = (float)(height_ / 2);
+	const uint32_t green = rgba(0, 255, 0);
+	addLine(x - 30.0f, y, x + 30.0f, y, 2.0f, green);
+	addLine(x, y - 30.0f, x, y + 30.0f, 2.0f, green);
+	addCircle(x, y, 50.0f, 2.0f, rgba(255, 0, 0));
+}
+
+} // namespace overlay
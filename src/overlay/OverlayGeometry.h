@@ -0,0 +1,82 @@
+#ifndef OVERLAY_GEOMETRY_H
+#define OVERLAY_GEOMETRY_H
+
+#include <opencv2/core/types.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ort-model/types.hpp"
+#include "GlyphAtlas.h"
+
+namespace overlay {
+
+// A colour the way libobs packs vertex colours, 0xAABBGGRR
+inline uint32_t rgba(uint8_t r, uint8_t g, uint8_t b, uint8_t a = 255)
+{
+	return (uint32_t)r | (uint32_t)g << 8 | (uint32_t)b << 16 | (uint32_t)a << 24;
+}
+
+struct SolidVertex {
+	float x;
+	float y;
+	uint32_t color; // opaque, see rgba()
+};
+
+struct TextVertex {
+	float x;
+	float y;
+	float u; // into GlyphAtlas::toneTexture(), 0 to 1
+	float v;
+};
+
+/**
+ * The preview overlay of one result as triangle lists, in the pixel coordinates of the frame it
+ * was made on: boxes, labels, the crop rectangle and the centre markers, for the GPU to draw on
+ * top of the source. Built on the inference thread, a few hundred vertices for a typical result.
+ *
+ * Solid shapes go into solid(), text into text() as quads on the tone texture of
+ * GlyphAtlas::instance().
+ */
+class OverlayGeometry {
+public:
+	OverlayGeometry(int width, int height) : width_(width), height_(height) {}
+
+	int width() const { return width_; }
+	int height() const { return height_; }
+	const std::vector<SolidVertex> &solid() const { return solid_; }
+	const std::vector<TextVertex> &text() const { return text_; }
+	bool empty() const { return solid_.empty() && text_.empty(); }
+
+	// A line of the given thickness, centred on the points
+	void addLine(float x1, float y1, float x2, float y2, float thickness, uint32_t color);
+	// The outline of rect, centred on its edges like cv::rectangle
+	void addRect(const cv::Rect_<float> &rect, float thickness, uint32_t color);
+	void addFilledRect(const cv::Rect_<float> &rect, uint32_t color);
+	// The outline of rect in dashes and gaps of dash pixels, like drawDashedRectangle
+	void addDashedRect(const cv::Rect_<float> &rect, float thickness, float dash,
+			   uint32_t color);
+	void addCircle(float x, float y, float radius, float thickness, uint32_t color);
+	// Text starting at x on the given baseline
+	void addText(float x, float baseline, const std::string &text, bool dark);
+
+	// Boxes and labels of objects, laid out like draw_objects in ort-model/utils.hpp
+	void addObjects(const std::vector<Object> &objects,
+			const std::vector<std::string> &class_names);
+	// The crosshair and circle at the centre of the frame
+	void addMarkers();
+
+private:
+	void addQuad(float x1, float y1, float x2, float y2, float x3, float y3, float x4,
+		     float y4, uint32_t color);
+
+	int width_;
+	int height_;
+	std::vector<SolidVertex> solid_;
+	std::vector<TextVertex> text_;
+};
+
+} // namespace overlay
+
+#endif /* OVERLAY_GEOMETRY_H */
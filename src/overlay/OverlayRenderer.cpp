@@ -0,0 +1,134 @@
+#include "OverlayRenderer.h"
+
+#include <graphics/vec2.h>
+#include <graphics/vec3.h>
+#include <graphics/vec4.h>
+
+namespace overlay {
+
+namespace {
+
+gs_vertbuffer_t *create_solid_buffer(const std::vector<SolidVertex> &vertices)
+{
+	gs_vb_data *data = gs_vbdata_create();
+	data->num = vertices.size();
+	data->points = (struct vec3 *)bmalloc(sizeof(struct vec3) * vertices.size());
+	data->colors = (uint32_t *)bmalloc(sizeof(uint32_t) * vertices.size());
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		vec3_set(&data->points[i], vertices[i].x, vertices[i].y, 0.0f);
+		data->colors[i] = vertices[i].color;
+	}
+	// the buffer owns data from here on
+	return gs_vertexbuffer_create(data, 0);
+}
+
+gs_vertbuffer_t *create_text_buffer(const std::vector<TextVertex> &vertices)
+{
+	gs_vb_data *data = gs_vbdata_create();
+	data->num = vertices.size();
+	data->points = (struct vec3 *)bmalloc(sizeof(struct vec3) * vertices.size());
+	data->num_tex = 1;
+	data->tvarray = (struct gs_tvertarray *)bzalloc(sizeof(struct gs_tvertarray));
+	data->tvarray->width = 2;
+	data->tvarray->array = bmalloc(sizeof(struct vec2) * vertices.size());
+	struct vec2 *uv = (struct vec2 *)data->tvarray->array;
+	for (size_t i = 0; i < vertices.size(); ++i) {
+		vec3_set(&data->points[i], vertices[i].x, vertices[i].y, 0.0f);
+		vec2_set(&uv[i], vertices[i].u, vertices[i].v);
+	}
+	return gs_vertexbuffer_create(data, 0);
+}
+
+} // namespace
+
+void OverlayRenderer::upload(const OverlayGeometry &geometry)
+{
+	if (solid_) {
+		gs_vertexbuffer_destroy(solid_);
+		solid_ = nullptr;
+	}
+	if (text_) {
+		gs_vertexbuffer_destroy(text_);
+		text_ = nullptr;
+	}
+	solidCount_ = (uint32_t)geometry.solid().size();
+	textCount_ = (uint32_t)geometry.text().size();
+	if (solidCount_ > 0) {
+		solid_ = create_solid_buffer(geometry.solid());
+	}
+	if (textCount_ > 0) {
+		text_ = create_text_buffer(geometry.text());
+		if (!atlas_) {
+			const cv::Mat texture = GlyphAtlas::instance().toneTexture();
+			const uint8_t *pixels = texture.data;
+			atlas_ = gs_texture_create(texture.cols, texture.rows, GS_BGRA, 1, &pixels,
+						   0);
+		}
+	}
+}
+
+void OverlayRenderer::draw(const std::shared_ptr<const OverlayGeometry> &geometry,
+			   uint32_t width, uint32_t height)
+{
+	if (!geometry || geometry->empty() || geometry->width() <= 0 ||
+	    geometry->height() <= 0) {
+		return;
+	}
+	if (geometry != current_) {
+		upload(*geometry);
+		current_ = geometry;
+	}
+
+	gs_matrix_push();
+	// the result may be from before the source was resized
+	gs_matrix_scale3f((float)width / geometry->width(), (float)height / geometry->height(),
+			  1.0f);
+	gs_blend_state_push();
+	gs_enable_blending(true);
+	// the colours are opaque and the atlas is premultiplied
+	gs_blend_function(GS_BLEND_ONE, GS_BLEND_INVSRCALPHA);
+
+	if (solid_) {
+		gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_SOLID);
+		struct vec4 white;
+		vec4_set(&white, 1.0f, 1.0f, 1.0f, 1.0f);
+		gs_effect_set_vec4(gs_effect_get_param_by_name(effect, "color"), &white);
+		gs_load_vertexbuffer(solid_);
+		gs_load_indexbuffer(nullptr);
+		while (gs_effect_loop(effect, "SolidColored")) {
+			gs_draw(GS_TRIS, 0, solidCount_);
+		}
+	}
+	if (text_ && atlas_) {
+		gs_effect_t *effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
+		gs_effect_set_texture(gs_effect_get_param_by_name(effect, "image"), atlas_);
+		gs_load_vertexbuffer(text_);
+		gs_load_indexbuffer(nullptr);
+		while (gs_effect_loop(effect, "Draw")) {
+			gs_draw(GS_TRIS, 0, textCount_);
+		}
+	}
+	gs_load_vertexbuffer(nullptr);
+
+	gs_blend_state_pop();
+	gs_matrix_pop();
+}
+
+void OverlayRenderer::destroy()
+{
+	if (solid_) {
+		gs_vertexbuffer_destroy(solid_);
+		solid_ = nullptr;
+	}
+	if (text_) {
+		gs_vertexbuffer_destroy(text_);
+		text_ = nullptr;
+	}
+	if (atlas_) {
+		gs_texture_destroy(atlas_);
+		atlas_ = nullptr;
+	}
+	current_.reset();
+}
+
+} // namespace overlay
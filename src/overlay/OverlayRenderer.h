@@ -0,0 +1,43 @@
+#ifndef OVERLAY_RENDERER_H
+#define OVERLAY_RENDERER_H
+
+#include <obs-module.h>
+
+#include <memory>
+
+#include "OverlayGeometry.h"
+
+namespace overlay {
+
+/**
+ * Draws OverlayGeometry with the OBS graphics subsystem: one vertex buffer of coloured
+ * triangles and one of glyph quads on the atlas texture. The buffers are rebuilt only when a
+ * new geometry comes in, drawing the same one again costs two draw calls.
+ *
+ * Graphics thread only, destroy() inside obs_enter_graphics() before the renderer goes away.
+ */
+class OverlayRenderer {
+public:
+	OverlayRenderer() = default;
+	OverlayRenderer(const OverlayRenderer &) = delete;
+	OverlayRenderer &operator=(const OverlayRenderer &) = delete;
+
+	// Draw geometry scaled to width x height, in the current render target and matrices
+	void draw(const std::shared_ptr<const OverlayGeometry> &geometry, uint32_t width,
+		  uint32_t height);
+	void destroy();
+
+private:
+	void upload(const OverlayGeometry &geometry);
+
+	std::shared_ptr<const OverlayGeometry> current_;
+	gs_vertbuffer_t *solid_ = nullptr;
+	gs_vertbuffer_t *text_ = nullptr;
+	uint32_t solidCount_ = 0;
+	uint32_t textCount_ = 0;
+	gs_texture_t *atlas_ = nullptr;
+};
+
+} // namespace overlay
+
+#endif /* OVERLAY_RENDERER_H */
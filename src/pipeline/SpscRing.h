@@ -0,0 +1,120 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace pipeline {
+
+/**
+ * Bounded single producer, single consumer queue between two pipeline stages.
+ *
+ * Pushing and popping are lock-free; the mutex is only taken by a stage that has to wait for
+ * space or for an item, and by the other side when it sees a stage waiting.
+ */
+template<typename T> class SpscRing {
+public:
+	explicit SpscRing(size_t capacity) : items_(capacity + 1) {}
+
+	bool tryPush(T &&item)
+	{
+		const size_t tail = tail_.load(std::memory_order_relaxed);
+		const size_t next = (tail + 1) % items_.size();
+		if (next == head_.load()) {
+			return false;
+		}
+		items_[tail] = std::move(item);
+		// sequentially consistent, so either this side sees the waiter or the waiter sees
+		// the new item
+		tail_.store(next);
+		wake();
+		return true;
+	}
+
+	bool tryPop(T &item)
+	{
+		const size_t head = head_.load(std::memory_order_relaxed);
+		if (head == tail_.load()) {
+			return false;
+		}
+		item = std::move(items_[head]);
+		items_[head] = T();
+		head_.store((head + 1) % items_.size());
+		wake();
+		return true;
+	}
+
+	// Block until there is space, returns false (dropping the item) once stop is set
+	bool push(T &&item, const std::atomic<bool> &stop)
+	{
+		while (!tryPush(std::move(item))) {
+			wait([&] { return !full() || stop.load(); });
+			if (stop) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Block until there is an item, returns false once stop is set
+	bool pop(T &item, const std::atomic<bool> &stop)
+	{
+		while (!tryPop(item)) {
+			wait([&] { return !empty() || stop.load(); });
+			if (stop) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Wake the waiting stage, e.g. after setting its stop flag
+	void wake()
+	{
+		if (waiters_.load() == 0) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(wait_mutex_);
+		}
+		changed_.notify_all();
+	}
+
+	// Drop the remaining items, only while neither stage runs
+	void clear()
+	{
+		T item;
+		while (tryPop(item)) {
+		}
+	}
+
+	bool empty() const { return head_.load() == tail_.load(); }
+
+	bool full() const { return (tail_.load() + 1) % items_.size() == head_.load(); }
+
+private:
+	template<typename Predicate> void wait(Predicate ready)
+	{
+		waiters_++;
+		{
+			std::unique_lock<std::mutex> lock(wait_mutex_);
+			changed_.wait(lock, ready);
+		}
+		waiters_--;
+	}
+
+	std::vector<T> items_;
+	alignas(64) std::atomic<size_t> head_{0};
+	alignas(64) std::atomic<size_t> tail_{0};
+	std::atomic<int> waiters_{0};
+	std::mutex wait_mutex_;
+	std::condition_variable changed_;
+};
+
+} // namespace pipeline
+
+#endif /* SPSC_RING_H */
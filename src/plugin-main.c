@@ -28,9 +28,11 @@ MODULE_EXPORT const char *obs_module_description(void)
 }
 
 extern struct obs_source_info detect_filter_info;
+extern void detect_kernels_init(void);
 
 bool obs_module_load(void)
 {
+	detect_kernels_init();
 	obs_register_source(&detect_filter_info);
 	obs_log(LOG_INFO, "plugin loaded successfully (version %s)", PLUGIN_VERSION);
 	return true;
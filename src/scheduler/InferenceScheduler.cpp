@@ -0,0 +1,106 @@
+#include "InferenceScheduler.h"
+
+#include <obs.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "plugin-support.h"
+
+namespace scheduler {
+
+namespace {
+
+// weight of a new run time in the cost average
+constexpr double COST_SMOOTHING = 0.2;
+// a filter that has not ticked for this long is disabled or gone
+constexpr std::chrono::seconds IDLE_AFTER(1);
+
+} // namespace
+
+InferenceScheduler &InferenceScheduler::instance()
+{
+	static InferenceScheduler scheduler;
+	return scheduler;
+}
+
+uint64_t InferenceScheduler::registerFilter()
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	const uint64_t id = next_id_++;
+	filters_[id] = FilterState();
+	return id;
+}
+
+void InferenceScheduler::unregisterFilter(uint64_t id)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	filters_.erase(id);
+}
+
+double InferenceScheduler::stretch(Clock::time_point now) const
+{
+	double demand = 0.0;
+	for (const auto &entry : filters_) {
+		const FilterState &state = entry.second;
+		if (state.interval > 0.0 && now - state.last_seen < IDLE_AFTER) {
+			demand += state.cost / state.interval;
+		}
+	}
+	return std::max(1.0, demand / policy_.budget);
+}
+
+bool InferenceScheduler::shouldRun(uint64_t id, Visibility visibility, int priority,
+				   bool pause_hidden, Clock::time_point now)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = filters_.find(id);
+	if (it == filters_.end()) {
+		return false;
+	}
+	FilterState &state = it->second;
+	state.last_seen = now;
+
+	double interval = policy_.program_interval;
+	if (visibility == Visibility::Preview) {
+		interval = policy_.preview_interval;
+	} else if (visibility == Visibility::Hidden) {
+		interval = pause_hidden ? 0.0 : policy_.hidden_interval;
+	}
+	// a paused filter asks for nothing and does not count towards the demand
+	state.interval = interval > 0.0 ? interval * std::pow(2.0, -std::clamp(priority, -1, 1))
+					: 0.0;
+	if (state.interval <= 0.0) {
+		return false;
+	}
+
+	const double factor = stretch(now);
+	if ((factor > 1.0) != overloaded_) {
+		overloaded_ = factor > 1.0;
+		obs_log(LOG_INFO,
+			overloaded_ ? "Inference demand exceeds the budget, slowing all filters by %.1fx"
+				    : "Inference demand is within the budget again (%.1fx)",
+			factor);
+	}
+
+	const double elapsed = std::chrono::duration<double>(now - state.last_run).count();
+	if (elapsed < state.interval * factor) {
+		return false;
+	}
+	state.last_run = now;
+	return true;
+}
+
+void InferenceScheduler::reportRun(uint64_t id, double seconds)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	auto it = filters_.find(id);
+	if (it == filters_.end()) {
+		return;
+	}
+	FilterState &state = it->second;
+	state.cost = state.cost > 0.0 ? state.cost + COST_SMOOTHING * (seconds - state.cost)
+				      : seconds;
+}
+
+} // namespace scheduler
@@ -0,0 +1,74 @@
+#ifndef INFERENCE_SCHEDULER_H
+#define INFERENCE_SCHEDULER_H
+
+#include <chrono>
+#include <map>
+#include <mutex>
+
+namespace scheduler {
+
+// Where the filter's source is seen, from obs_source_active() and obs_source_showing()
+enum class Visibility { Program, Preview, Hidden };
+
+struct SchedulerPolicy {
+	// seconds between inferences at normal priority, high priority halves them, low doubles
+	double program_interval = 0.2;
+	double preview_interval = 0.5;
+	double hidden_interval = 2.0;
+	// inference seconds per second all filters together may ask for, intervals are stretched
+	// by the same factor for every filter beyond that
+	double budget = 1.0;
+};
+
+/**
+ * Module-wide inference rate control for all Detect filters.
+ *
+ * Every filter gets an interval from its visibility and priority. While the filters' combined
+ * demand (run cost / interval, summed) stays within the budget they run at those intervals.
+ * Under overload all intervals are stretched by the same factor, so every filter keeps its
+ * weighted share instead of the fastest loop taking the CPU.
+ */
+class InferenceScheduler {
+public:
+	using Clock = std::chrono::steady_clock;
+
+	static InferenceScheduler &instance();
+
+	uint64_t registerFilter();
+	void unregisterFilter(uint64_t id);
+
+	/**
+	 * Whether the filter should submit a frame now, called on every video tick. A true
+	 * answer counts as a submission.
+	 *
+	 * @param priority -1 low, 0 normal, 1 high.
+	 * @param pause_hidden Hidden sources do not run at all instead of trickling.
+	 */
+	bool shouldRun(uint64_t id, Visibility visibility, int priority, bool pause_hidden,
+		       Clock::time_point now);
+
+	// How long a submitted frame kept the inference busy, feeds the demand estimate
+	void reportRun(uint64_t id, double seconds);
+
+	const SchedulerPolicy &policy() const { return policy_; }
+
+private:
+	struct FilterState {
+		double interval = 0.0; // requested, before the overload stretch
+		double cost = 0.0;     // moving average of the reported run times
+		Clock::time_point last_run;
+		Clock::time_point last_seen; // filters that stopped asking do not count
+	};
+
+	double stretch(Clock::time_point now) const;
+
+	SchedulerPolicy policy_;
+	std::mutex mutex_;
+	std::map<uint64_t, FilterState> filters_;
+	uint64_t next_id_ = 1;
+	bool overloaded_ = false;
+};
+
+} // namespace scheduler
+
+#endif /* INFERENCE_SCHEDULER_H */
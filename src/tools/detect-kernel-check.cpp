@@ -0,0 +1,316 @@
+// obs-detect-kernel-check: check every kernel variant the CPU supports against the scalar
+// reference, outside of OBS.
+//
+// Usage: obs-detect-kernel-check [--seed N] [--rounds N] [--iterations N]
+//
+// Runs each variant and the scalar kernels on the same random inputs, with sizes around the
+// vector widths so that the SIMD bodies and the scalar tails are both covered, and requires
+// bit-identical results. Then times each variant on a 640x640 frame. Exits with 1 when a check
+// fails.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "kernels/kernels.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string &what)
+{
+	if (!ok) {
+		printf("FAIL %s\n", what.c_str());
+		failures++;
+	}
+}
+
+// Widths around 4, 8, 16 and 64 lanes, and the two extra BGR pixels the wide loads read ahead
+const int SIZES[] = {0, 1, 3, 4, 5, 7, 8, 9, 15, 16, 17, 18, 19, 31, 32, 33, 34, 63, 64, 65, 100};
+
+std::vector<uint8_t> random_bytes(std::mt19937 &rng, size_t count)
+{
+	std::uniform_int_distribution<int> byte(0, 255);
+	std::vector<uint8_t> bytes(count);
+	for (uint8_t &b : bytes) {
+		b = (uint8_t)byte(rng);
+	}
+	return bytes;
+}
+
+void check_preprocessing_case(const detect_kernels &k, const detect_kernels &ref, std::mt19937 &rng,
+			      int width, int height, int channels)
+{
+	const std::string size = std::to_string(width) + "x" + std::to_string(height) + "x" +
+				 std::to_string(channels);
+	// rows padded like a cropped cv::Mat
+	const size_t step = (size_t)width * channels + 5;
+	const std::vector<uint8_t> src = random_bytes(rng, step * height);
+	const size_t plane = (size_t)width * height;
+
+	std::vector<float> got(3 * plane + 1, -1.0f), want(got);
+	k.hwc_u8_to_chw_f32(src.data(), step, width, height, channels, got.data());
+	ref.hwc_u8_to_chw_f32(src.data(), step, width, height, channels, want.data());
+	check(memcmp(got.data(), want.data(), got.size() * sizeof(float)) == 0,
+	      std::string(k.name) + " hwc_u8_to_chw_f32 " + size);
+
+	for (const uint8_t mask : {0x00, 0x80}) {
+		std::vector<uint8_t> got8(3 * plane + 1, 0x5a), want8(got8);
+		k.hwc_u8_to_chw_u8(src.data(), step, width, height, channels, got8.data(), mask);
+		ref.hwc_u8_to_chw_u8(src.data(), step, width, height, channels, want8.data(), mask);
+		check(got8 == want8, std::string(k.name) + " hwc_u8_to_chw_u8 " + size + " xor " +
+					     std::to_string(mask));
+	}
+}
+
+void check_preprocessing(const detect_kernels &k, const detect_kernels &ref, std::mt19937 &rng)
+{
+	int cases = 0;
+	for (const int channels : {3, 4}) {
+		for (const int width : SIZES) {
+			for (const int height : {1, 3}) {
+				check_preprocessing_case(k, ref, rng, width, height, channels);
+				cases++;
+			}
+		}
+	}
+	printf("%s: %d pre-processing cases\n", k.name, cases);
+}
+
+void check_scores(const detect_kernels &k, const detect_kernels &ref, std::mt19937 &rng,
+		  int rounds)
+{
+	std::uniform_real_distribution<float> score(-0.2f, 1.0f);
+	std::uniform_int_distribution<int> pick(0, 9);
+	int cases = 0;
+	for (int round = 0; round < rounds; ++round) {
+		for (const int count : SIZES) {
+			std::vector<float> scores(count);
+			for (float &s : scores) {
+				// ties, exact zeros and NaNs as well as plain values
+				const int kind = pick(rng);
+				s = kind == 0   ? 0.0f
+				    : kind == 1 ? 0.75f
+				    : kind == 2 && round % 4 == 3
+					    ? std::numeric_limits<float>::quiet_NaN()
+					    : score(rng);
+			}
+			for (const float scale : {1.0f, 0.5f, -1.0f}) {
+				int got_index = -1, want_index = -1;
+				const float got = k.max_scaled_score(scores.data(), count, scale,
+								     &got_index);
+				const float want = ref.max_scaled_score(scores.data(), count, scale,
+									&want_index);
+				// bitwise, the returned max has to be the very same float
+				const bool same = memcmp(&got, &want, sizeof(float)) == 0 &&
+						  got_index == want_index;
+				check(same, std::string(k.name) + " max_scaled_score count " +
+						    std::to_string(count) + " scale " +
+						    std::to_string(scale));
+				cases++;
+			}
+		}
+	}
+	printf("%s: %d score cases\n", k.name, cases);
+}
+
+void check_iou(const detect_kernels &k, const detect_kernels &ref, std::mt19937 &rng, int rounds)
+{
+	std::uniform_real_distribution<float> coord(0.0f, 200.0f);
+	std::uniform_real_distribution<float> extent(0.0f, 60.0f);
+	int cases = 0, hits = 0;
+	for (int round = 0; round < rounds; ++round) {
+		for (const int count : SIZES) {
+			std::vector<float> x0(count), y0(count), x1(count), y1(count), area(count);
+			for (int j = 0; j < count; ++j) {
+				x0[j] = coord(rng);
+				y0[j] = coord(rng);
+				x1[j] = x0[j] + extent(rng);
+				y1[j] = y0[j] + extent(rng);
+				area[j] = (x1[j] - x0[j]) * (y1[j] - y0[j]);
+			}
+			float box[4];
+			if (count > 0 && round % 2 == 0) {
+				// a copy of the last box, only found when the tail is checked
+				box[0] = x0[count - 1];
+				box[1] = y0[count - 1];
+				box[2] = x1[count - 1];
+				box[3] = y1[count - 1];
+			} else {
+				box[0] = coord(rng);
+				box[1] = coord(rng);
+				box[2] = box[0] + extent(rng);
+				box[3] = box[1] + extent(rng);
+			}
+			const float box_area = (box[2] - box[0]) * (box[3] - box[1]);
+			for (const float threshold : {0.0f, 0.3f, 0.45f, 0.99f}) {
+				const bool got = k.any_iou_above(x0.data(), y0.data(), x1.data(),
+								 y1.data(), area.data(), count, box,
+								 box_area, threshold);
+				const bool want = ref.any_iou_above(x0.data(), y0.data(), x1.data(),
+								    y1.data(), area.data(), count,
+								    box, box_area, threshold);
+				check(got == want, std::string(k.name) + " any_iou_above count " +
+							   std::to_string(count) + " threshold " +
+							   std::to_string(threshold));
+				hits += want ? 1 : 0;
+				cases++;
+			}
+		}
+	}
+	printf("%s: %d IoU cases, %d above the threshold\n", k.name, cases, hits);
+}
+
+void check_absdiff(const detect_kernels &k, const detect_kernels &ref, std::mt19937 &rng)
+{
+	int cases = 0;
+	// the wide variants count in 8-bit lanes and flush them every 255 blocks
+	std::vector<size_t> counts(std::begin(SIZES), std::end(SIZES));
+	counts.insert(counts.end(), {127, 128, 129, 4095, 16320, 16384, 40000, 320 * 180});
+	for (const size_t count : counts) {
+		const std::vector<uint8_t> a = random_bytes(rng, count);
+		std::vector<uint8_t> b = random_bytes(rng, count);
+		for (size_t i = 0; i < count; i += 3) {
+			// mostly small differences, like two frames of a still scene
+			b[i] = (uint8_t)std::min(255, a[i] + (int)(b[i] % 8));
+		}
+		for (const uint8_t threshold : {0, 7, 25, 254, 255}) {
+			const size_t got =
+				k.count_absdiff_above(a.data(), b.data(), count, threshold);
+			const size_t want =
+				ref.count_absdiff_above(a.data(), b.data(), count, threshold);
+			check(got == want, std::string(k.name) + " count_absdiff_above count " +
+						   std::to_string(count) + " threshold " +
+						   std::to_string(threshold));
+			cases++;
+		}
+	}
+	printf("%s: %d absdiff cases\n", k.name, cases);
+}
+
+void check_blend(const detect_kernels &k, const detect_kernels &ref, std::mt19937 &rng)
+{
+	int cases = 0;
+	for (const int count : SIZES) {
+		std::vector<uint8_t> overlay = random_bytes(rng, (size_t)count * 4);
+		for (int i = 0; i < count; i += 3) {
+			// uncovered and fully covered pixels, like the edges of a glyph
+			overlay[(size_t)i * 4 + 3] = (uint8_t)(i % 2 == 0 ? 0 : 255);
+		}
+		for (const int background : {-1, 0, 255}) {
+			// random, transparent black and opaque destinations
+			std::vector<uint8_t> got = random_bytes(rng, (size_t)count * 4 + 4);
+			for (int i = 0; background >= 0 && i < count; ++i) {
+				got[(size_t)i * 4 + 3] = (uint8_t)background;
+			}
+			std::vector<uint8_t> want(got);
+			k.bgra_blend_over(got.data(), overlay.data(), count);
+			ref.bgra_blend_over(want.data(), overlay.data(), count);
+			check(got == want, std::string(k.name) + " bgra_blend_over count " +
+						   std::to_string(count) + " alpha " +
+						   std::to_string(background));
+			cases++;
+		}
+	}
+	printf("%s: %d blend cases\n", k.name, cases);
+}
+
+void time_variant(const detect_kernels &k, int iterations)
+{
+	const int width = 640, height = 640;
+	std::mt19937 rng(1);
+	const std::vector<uint8_t> frame = random_bytes(rng, (size_t)width * height * 4);
+	std::vector<float> blob((size_t)width * height * 3);
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		k.hwc_u8_to_chw_f32(frame.data(), (size_t)width * 4, width, height, 4, blob.data());
+	}
+	const double preprocess_us = std::chrono::duration<double, std::micro>(
+					     std::chrono::steady_clock::now() - start)
+					     .count() /
+				     iterations;
+
+	std::vector<uint8_t> canvas(frame);
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		k.bgra_blend_over(canvas.data(), frame.data(), (size_t)width * height);
+	}
+	const double blend_us = std::chrono::duration<double, std::micro>(
+					std::chrono::steady_clock::now() - start)
+					.count() /
+				iterations;
+
+	const std::vector<uint8_t> other = random_bytes(rng, frame.size());
+	size_t above = 0;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		above += k.count_absdiff_above(frame.data(), other.data(), frame.size(), 25);
+	}
+	const double absdiff_us = std::chrono::duration<double, std::micro>(
+					  std::chrono::steady_clock::now() - start)
+					  .count() /
+				  iterations;
+	printf("%-7s %dx%d BGRA: %.1f us to CHW float, %.1f us to blend, %.1f us to count "
+	       "differences (%zu)\n",
+	       k.name, width, height, preprocess_us, blend_us, absdiff_us, above / iterations);
+}
+
+void usage(const char *program)
+{
+	fprintf(stderr, "Usage: %s [--seed N] [--rounds N] [--iterations N]\n", program);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	unsigned seed = 1;
+	int rounds = 20;
+	int iterations = 100;
+	for (int i = 1; i < argc; ++i) {
+		const bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--seed") == 0 && has_value) {
+			seed = (unsigned)strtoul(argv[++i], nullptr, 10);
+		} else if (strcmp(argv[i], "--rounds") == 0 && has_value) {
+			rounds = std::max(1, atoi(argv[++i]));
+		} else if (strcmp(argv[i], "--iterations") == 0 && has_value) {
+			iterations = std::max(1, atoi(argv[++i]));
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	const detect_kernels &ref = scalar_kernels();
+	const std::vector<const detect_kernels *> variants = supported_kernel_variants();
+	for (const detect_kernels *k : variants) {
+		if (k == &ref) {
+			continue;
+		}
+		// the same inputs for every variant
+		std::mt19937 rng(seed);
+		check_preprocessing(*k, ref, rng);
+		check_scores(*k, ref, rng, rounds);
+		check_iou(*k, ref, rng, rounds);
+		check_absdiff(*k, ref, rng);
+		check_blend(*k, ref, rng);
+	}
+	if (variants.size() == 1) {
+		printf("Only the scalar kernels run on this CPU, nothing to compare\n");
+	}
+
+	for (const detect_kernels *k : variants) {
+		time_variant(*k, iterations);
+	}
+
+	printf("%s\n", failures > 0 ? "FAILED" : "All variants match the scalar kernels");
+	return failures > 0 ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+// obs-detect-overlay-check: check the preview overlay geometry outside of OBS, no GPU needed.
+//
+// Usage: obs-detect-overlay-check [--image out.ppm] [--objects N] [--iterations N]
+//
+// Builds the geometry of known shapes and synthetic results the way the filter does and checks
+// vertex counts, bounds and atlas coordinates, then times building a result's geometry against
+// drawing the same result on a 1080p frame with draw_objects. Exits with 1 when a check fails.
+//
+// --image rasterizes the geometry of a synthetic result on the CPU next to draw_objects'
+// drawing of it into a binary PPM, to compare the two by eye.
+
+#include <opencv2/core.hpp>
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "kernels/kernels.h"
+#include "ort-model/utils.hpp"
+#include "overlay/GlyphAtlas.h"
+#include "overlay/OverlayGeometry.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const char *what)
+{
+	printf("%s %s\n", ok ? "PASS" : "FAIL", what);
+	if (!ok) {
+		failures++;
+	}
+}
+
+struct bounds {
+	float left = 1e9f, top = 1e9f, right = -1e9f, bottom = -1e9f;
+};
+
+bounds solid_bounds(const overlay::OverlayGeometry &geometry)
+{
+	bounds b;
+	for (const overlay::SolidVertex &v : geometry.solid()) {
+		b.left = std::min(b.left, v.x);
+		b.top = std::min(b.top, v.y);
+		b.right = std::max(b.right, v.x);
+		b.bottom = std::max(b.bottom, v.y);
+	}
+	return b;
+}
+
+size_t glyph_count(const std::string &text)
+{
+	return (size_t)std::count_if(text.begin(), text.end(), [](char c) { return c != ' '; });
+}
+
+bool finite_and_in_atlas(const overlay::OverlayGeometry &geometry)
+{
+	for (const overlay::SolidVertex &v : geometry.solid()) {
+		if (!std::isfinite(v.x) || !std::isfinite(v.y)) {
+			return false;
+		}
+	}
+	for (const overlay::TextVertex &v : geometry.text()) {
+		if (!std::isfinite(v.x) || !std::isfinite(v.y) || v.u < 0.0f || v.u > 1.0f ||
+		    v.v < 0.0f || v.v > 1.0f) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::vector<Object> synthetic_objects(int count, int width, int height)
+{
+	std::vector<Object> objects;
+	cv::RNG rng(42);
+	for (int i = 0; i < count; ++i) {
+		Object obj;
+		obj.rect.width = rng.uniform(40.0f, width / 4.0f);
+		obj.rect.height = rng.uniform(40.0f, height / 4.0f);
+		obj.rect.x = rng.uniform(0.0f, width - obj.rect.width);
+		obj.rect.y = rng.uniform(0.0f, height - obj.rect.height);
+		obj.label = rng.uniform(0, 80);
+		obj.prob = rng.uniform(0.3f, 1.0f);
+		obj.id = (uint64_t)i + 1;
+		objects.push_back(obj);
+	}
+	return objects;
+}
+
+void check_shapes()
+{
+	overlay::OverlayGeometry box(640, 480);
+	box.addRect({100.0f, 50.0f, 200.0f, 100.0f}, 2.0f, overlay::rgba(255, 0, 0));
+	const bounds b = solid_bounds(box);
+	check(box.solid().size() == 24, "a box outline is four quads");
+	check(b.left == 99.0f && b.top == 49.0f && b.right == 301.0f && b.bottom == 151.0f,
+	      "a box outline is centred on the box edges");
+	check(box.text().empty(), "a box outline has no text");
+
+	overlay::OverlayGeometry flat(640, 480);
+	flat.addRect({10.0f, 10.0f, 50.0f, 1.0f}, 2.0f, overlay::rgba(255, 0, 0));
+	check(flat.solid().size() == 12, "a box thinner than its outline has no sides");
+
+	overlay::OverlayGeometry dashed(640, 480);
+	dashed.addDashedRect({0.0f, 0.0f, 100.0f, 40.0f}, 5.0f, 15.0f, overlay::rgba(0, 255, 0));
+	// 4 dashes on the long sides, 2 on the short ones
+	check(dashed.solid().size() == 12 * 6, "dashes of a dashed rectangle");
+	const bounds d = solid_bounds(dashed);
+	check(d.left == -2.5f && d.right == 102.5f, "dashes end at the rectangle corners");
+
+	overlay::OverlayGeometry markers(1920, 1080);
+	markers.addMarkers();
+	const bounds m = solid_bounds(markers);
+	check(std::fabs((m.left + m.right) / 2 - 960.0f) < 0.01f &&
+		      std::fabs((m.top + m.bottom) / 2 - 540.0f) < 0.01f,
+	      "markers are centred");
+	check(m.right - m.left <= 102.0f + 0.01f, "the marker circle has a radius of 50");
+}
+
+void check_text()
+{
+	const overlay::GlyphAtlas &atlas = overlay::GlyphAtlas::instance();
+	check(!atlas.coverage().empty() && atlas.ascent() > 0, "the glyph atlas is rasterized");
+	check(cv::countNonZero(atlas.coverage()) > 0, "the glyph atlas has glyphs");
+
+	const std::string text = "ID: 42";
+	overlay::OverlayGeometry light(640, 480);
+	light.addText(10.0f, 20.0f, text, false);
+	check(light.text().size() == glyph_count(text) * 6, "one quad per glyph, none for spaces");
+	check(finite_and_in_atlas(light), "glyph quads sample inside the atlas");
+	const float first_width = light.text()[1].x - light.text()[0].x;
+	check(first_width == (float)atlas.glyph('I').width, "a glyph quad covers its cell");
+	const overlay::TextVertex &last = light.text()[light.text().size() - 2];
+	check(last.x == 10.0f + atlas.textWidth(text) + overlay::GlyphAtlas::PADDING,
+	      "text ends at its width");
+	bool upper = true;
+	for (const overlay::TextVertex &v : light.text()) {
+		upper = upper && v.v <= 0.5f;
+	}
+	check(upper, "light text samples the white glyphs");
+
+	overlay::OverlayGeometry dark(640, 480);
+	dark.addText(10.0f, 20.0f, text, true);
+	bool lower = true;
+	for (const overlay::TextVertex &v : dark.text()) {
+		lower = lower && v.v >= 0.5f;
+	}
+	check(lower, "dark text samples the black glyphs");
+
+	cv::Mat canvas(40, 120, CV_8UC4, cv::Scalar(10, 20, 30, 255));
+	const cv::Mat before = canvas.clone();
+	atlas.drawText(canvas, cv::Point(5, 20), text, cv::Scalar(255, 255, 255));
+	const cv::Rect cells(5 - overlay::GlyphAtlas::PADDING,
+			     20 - atlas.ascent() - overlay::GlyphAtlas::PADDING,
+			     atlas.textWidth(text) + 2 * overlay::GlyphAtlas::PADDING,
+			     atlas.cellHeight());
+	int inside = 0, outside = 0, transparent = 0;
+	for (int y = 0; y < canvas.rows; ++y) {
+		for (int x = 0; x < canvas.cols; ++x) {
+			if (canvas.at<cv::Vec4b>(y, x) != before.at<cv::Vec4b>(y, x)) {
+				(cells.contains(cv::Point(x, y)) ? inside : outside)++;
+			}
+			transparent += canvas.at<cv::Vec4b>(y, x)[3] != 255;
+		}
+	}
+	check(inside > 0 && outside == 0, "drawn text touches only the glyph cells");
+	check(transparent == 0, "drawn text keeps BGRA opaque");
+
+	// BGRA is blended by the dispatched kernel, BGR by the scalar loop
+	cv::Mat bgr;
+	cv::cvtColor(before, bgr, cv::COLOR_BGRA2BGR);
+	atlas.drawText(bgr, cv::Point(5, 20), text, cv::Scalar(255, 255, 255));
+	cv::Mat drawn_bgr;
+	cv::cvtColor(canvas, drawn_bgr, cv::COLOR_BGRA2BGR);
+	check(cv::norm(bgr, drawn_bgr, cv::NORM_INF) == 0, "BGR and BGRA text are the same");
+	// on transparent black the glyphs come out premultiplied, the coverage in the alpha
+	cv::Mat clear(40, 120, CV_8UC4, cv::Scalar::all(0));
+	atlas.drawText(clear, cv::Point(5, 20), text, cv::Scalar(255, 255, 255));
+	std::vector<cv::Mat> planes;
+	cv::split(clear, planes);
+	check(cv::countNonZero(planes[3]) > 0 && cv::norm(planes[0], planes[3], cv::NORM_INF) == 0,
+	      "text on transparent black is premultiplied");
+	// clipped at every edge
+	atlas.drawText(canvas, cv::Point(-7, 3), text, cv::Scalar(0, 0, 0));
+	atlas.drawText(canvas, cv::Point(100, 38), text, cv::Scalar(0, 0, 0));
+
+	overlay::OverlayGeometry unknown(640, 480);
+	unknown.addText(0.0f, 20.0f, "\xe4\xba\xba", false);
+	check(unknown.text().size() == 3 * 6, "characters outside the atlas are drawn");
+}
+
+void check_objects()
+{
+	const std::vector<std::string> names = {"person", "bicycle"};
+	Object obj;
+	obj.rect = cv::Rect_<float>(100.0f, 100.0f, 50.0f, 80.0f);
+	obj.label = 0;
+	obj.prob = 0.5f;
+	obj.id = 7;
+	overlay::OverlayGeometry geometry(640, 480);
+	geometry.addObjects({obj}, names);
+	check(geometry.solid().size() == 24 + 6, "an object is a box outline and a label");
+	check(geometry.text().size() == (glyph_count("person 50.0%") + glyph_count("ID: 7")) * 6,
+	      "an object is labeled with its class, confidence and id");
+
+	obj.label = 5;
+	overlay::OverlayGeometry unnamed(640, 480);
+	unnamed.addObjects({obj}, names);
+	check(unnamed.text().size() == (glyph_count("5 50.0%") + glyph_count("ID: 7")) * 6,
+	      "a label without a class name is labeled with its number");
+
+	overlay::OverlayGeometry many(1920, 1080);
+	many.addObjects(synthetic_objects(20, 1920, 1080), {});
+	check(finite_and_in_atlas(many), "geometry of a result is finite");
+	check(many.solid().size() % 3 == 0 && many.text().size() % 3 == 0,
+	      "geometry is made of whole triangles");
+}
+
+// The way the GPU draws it: triangles filled, glyphs blended from the atlas
+void rasterize(const overlay::OverlayGeometry &geometry, cv::Mat &bgr)
+{
+	const std::vector<overlay::SolidVertex> &solid = geometry.solid();
+	constexpr int SHIFT = 4;
+	for (size_t i = 0; i + 2 < solid.size(); i += 3) {
+		cv::Point points[3];
+		for (int k = 0; k < 3; ++k) {
+			points[k] = cv::Point((int)std::lround(solid[i + k].x * (1 << SHIFT)),
+					      (int)std::lround(solid[i + k].y * (1 << SHIFT)));
+		}
+		const uint32_t rgba = solid[i].color;
+		const cv::Scalar bgr_color((rgba >> 16) & 0xff, (rgba >> 8) & 0xff, rgba & 0xff);
+		cv::fillConvexPoly(bgr, points, 3, bgr_color, cv::LINE_8, SHIFT);
+	}
+
+	const cv::Mat texture = overlay::GlyphAtlas::instance().toneTexture();
+	const std::vector<overlay::TextVertex> &text = geometry.text();
+	for (size_t i = 0; i + 5 < text.size(); i += 6) {
+		// the first triangle goes from the top left to the bottom right corner
+		const overlay::TextVertex &a = text[i];
+		const overlay::TextVertex &c = text[i + 2];
+		const int u = (int)std::lround(a.u * texture.cols);
+		const int v = (int)std::lround(a.v * texture.rows);
+		for (int y = 0; y < (int)(c.y - a.y); ++y) {
+			for (int x = 0; x < (int)(c.x - a.x); ++x) {
+				const int px = (int)a.x + x;
+				const int py = (int)a.y + y;
+				if (px < 0 || py < 0 || px >= bgr.cols || py >= bgr.rows) {
+					continue;
+				}
+				const cv::Vec4b texel = texture.at<cv::Vec4b>(v + y, u + x);
+				cv::Vec3b &pixel = bgr.at<cv::Vec3b>(py, px);
+				for (int ch = 0; ch < 3; ++ch) {
+					pixel[ch] = (uint8_t)(texel[ch] +
+							      pixel[ch] * (255 - texel[3]) / 255);
+				}
+			}
+		}
+	}
+}
+
+bool write_ppm(const std::string &path, const cv::Mat &bgr)
+{
+	std::ofstream file(path, std::ios::binary);
+	if (!file) {
+		return false;
+	}
+	file << "P6\n" << bgr.cols << " " << bgr.rows << "\n255\n";
+	std::vector<uint8_t> row((size_t)bgr.cols * 3);
+	for (int y = 0; y < bgr.rows; ++y) {
+		const cv::Vec3b *pixels = bgr.ptr<cv::Vec3b>(y);
+		for (int x = 0; x < bgr.cols; ++x) {
+			row[(size_t)x * 3] = pixels[x][2];
+			row[(size_t)x * 3 + 1] = pixels[x][1];
+			row[(size_t)x * 3 + 2] = pixels[x][0];
+		}
+		file.write((const char *)row.data(), (std::streamsize)row.size());
+	}
+	return (bool)file;
+}
+
+void usage(const char *program)
+{
+	fprintf(stderr, "Usage: %s [--image out.ppm] [--objects N] [--iterations N]\n", program);
+}
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+	std::string image;
+	int object_count = 10;
+	int iterations = 200;
+	for (int i = 1; i < argc; ++i) {
+		const bool has_value = i + 1 < argc;
+		if (strcmp(argv[i], "--image") == 0 && has_value) {
+			image = argv[++i];
+		} else if (strcmp(argv[i], "--objects") == 0 && has_value) {
+			object_count = std::max(0, atoi(argv[++i]));
+		} else if (strcmp(argv[i], "--iterations") == 0 && has_value) {
+			iterations = std::max(1, atoi(argv[++i]));
+		} else {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	detect_kernels_init();
+	check_shapes();
+	check_text();
+	check_objects();
+
+	const int width = 1920, height = 1080;
+	std::vector<std::string> names;
+	for (int i = 0; i < 80; ++i) {
+		names.push_back("class" + std::to_string(i));
+	}
+	const std::vector<Object> objects = synthetic_objects(object_count, width, height);
+
+	size_t vertices = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		overlay::OverlayGeometry geometry(width, height);
+		geometry.addObjects(objects, names);
+		geometry.addMarkers();
+		vertices = geometry.solid().size() + geometry.text().size();
+	}
+	const double geometry_us = std::chrono::duration<double, std::micro>(
+					   std::chrono::steady_clock::now() - start)
+					   .count() /
+				   iterations;
+
+	cv::Mat frame(height, width, CV_8UC4, cv::Scalar(40, 40, 40, 255));
+	cv::Mat bgra;
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i) {
+		// what the detected-frame preview does: copy the frame and draw into it
+		frame.copyTo(bgra);
+		draw_objects(bgra, objects, names);
+	}
+	const double cpu_us = std::chrono::duration<double, std::micro>(
+				      std::chrono::steady_clock::now() - start)
+				      .count() /
+			      iterations;
+	printf("%d objects: %zu vertices, %.1f us to build the geometry, %.1f us to draw on a "
+	       "%dx%d frame\n",
+	       object_count, vertices, geometry_us, cpu_us, width, height);
+
+	if (!image.empty()) {
+		overlay::OverlayGeometry geometry(width, height);
+		geometry.addObjects(objects, names);
+		geometry.addMarkers();
+		cv::Mat gpu(height, width, CV_8UC3, cv::Scalar(40, 40, 40));
+		rasterize(geometry, gpu);
+		cv::Mat cpu(height, width, CV_8UC3, cv::Scalar(40, 40, 40));
+		draw_objects(cpu, objects, names);
+		cv::Mat both;
+		cv::hconcat(gpu, cpu, both);
+		if (!write_ppm(image, both)) {
+			fprintf(stderr, "Cannot write %s\n", image.c_str());
+			return 1;
+		}
+		printf("Wrote the geometry (left) and draw_objects (right) to %s\n", image.c_str());
+	}
+
+	return failures > 0 ? 1 : 0;
+}
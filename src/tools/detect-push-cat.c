@@ -0,0 +1,251 @@
+/*
+ * Prints the detections pushed by the Detect filters, a stand-in client for the push server.
+ *
+ * usage: obs-detect-push-cat [-b | -d] [-s source]... <socket path | ws://127.0.0.1:port/[source]>
+ *
+ * -b asks for binary messages (obs_detect_shm_record, see detection-shm.h) and prints a summary
+ * of each, -d for delta JSON messages, -s subscribes to a source, by default every source is
+ * received. JSON messages are printed as they arrive, one per line. POSIX only.
+ */
+
+#include <arpa/inet.h>
+#include <inttypes.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "output/detection-shm.h"
+
+#define MAX_SOURCES 16
+
+static int websocket;
+
+static int read_exactly(int fd, void *data, size_t size)
+{
+	char *p = (char *)data;
+	while (size > 0) {
+		const ssize_t n = read(fd, p, size);
+		if (n <= 0)
+			return -1;
+		p += n;
+		size -= (size_t)n;
+	}
+	return 0;
+}
+
+static int write_all(int fd, const void *data, size_t size)
+{
+	const char *p = (const char *)data;
+	while (size > 0) {
+		const ssize_t n = write(fd, p, size);
+		if (n <= 0)
+			return -1;
+		p += n;
+		size -= (size_t)n;
+	}
+	return 0;
+}
+
+/* a command line on the Unix socket, a masked text frame on the WebSocket */
+static int send_command(int fd, const char *command)
+{
+	const size_t size = strlen(command);
+	unsigned char header[8];
+
+	if (!websocket) {
+		return write_all(fd, command, size) || write_all(fd, "\n", 1);
+	}
+	if (size > 125)
+		return -1;
+	header[0] = 0x81;
+	header[1] = (unsigned char)(0x80 | size);
+	/* a zero mask leaves the payload as is */
+	memset(header + 2, 0, 4);
+	return write_all(fd, header, 6) || write_all(fd, command, size);
+}
+
+static void print_message(int binary, const char *data, size_t size)
+{
+	struct obs_detect_shm_record record;
+	uint32_t i;
+
+	if (!binary) {
+		fwrite(data, 1, size, stdout);
+		fputc('\n', stdout);
+		fflush(stdout);
+		return;
+	}
+	memset(&record, 0, sizeof(record));
+	memcpy(&record, data, size < sizeof(record) ? size : sizeof(record));
+	printf("#%" PRIu64 " t=%" PRIu64 " %ux%u %u objects\n", record.sequence,
+	       record.timestamp_ns, record.frame_width, record.frame_height, record.total);
+	for (i = 0; i < record.count && i < OBS_DETECT_SHM_MAX_OBJECTS; i++) {
+		const struct obs_detect_shm_object *obj = &record.objects[i];
+		printf("  %s(%d) %.2f [%.0f %.0f %.0f %.0f] id=%" PRIu64 "\n", obj->label,
+		       obj->label_id, obj->score, obj->x, obj->y, obj->width, obj->height,
+		       obj->track_id);
+	}
+	fflush(stdout);
+}
+
+static int connect_websocket(const char *url)
+{
+	struct sockaddr_in addr;
+	char request[1024];
+	char response[4096];
+	size_t received = 0;
+	const char *path;
+	int port;
+	int fd;
+
+	if (sscanf(url, "ws://127.0.0.1:%d", &port) != 1) {
+		fprintf(stderr, "only ws://127.0.0.1:<port>/ URLs are served\n");
+		return -1;
+	}
+	path = strchr(url + 5, '/');
+	fd = socket(AF_INET, SOCK_STREAM, 0);
+	memset(&addr, 0, sizeof(addr));
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons((uint16_t)port);
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	if (fd < 0 || connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		perror("connect");
+		return -1;
+	}
+	snprintf(request, sizeof(request),
+		 "GET %s HTTP/1.1\r\nHost: 127.0.0.1:%d\r\nUpgrade: websocket\r\n"
+		 "Connection: Upgrade\r\nSec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+		 "Sec-WebSocket-Version: 13\r\n\r\n",
+		 path ? path : "/", port);
+	if (write_all(fd, request, strlen(request)))
+		return -1;
+	/* the response ends with a blank line, read it byte by byte */
+	while (received + 1 < sizeof(response)) {
+		if (read_exactly(fd, response + received, 1))
+			return -1;
+		received++;
+		response[received] = '\0';
+		if (received >= 4 && strcmp(response + received - 4, "\r\n\r\n") == 0)
+			break;
+	}
+	if (strncmp(response, "HTTP/1.1 101", 12) != 0) {
+		fprintf(stderr, "handshake failed: %s", response);
+		return -1;
+	}
+	return fd;
+}
+
+static int connect_unix(const char *path)
+{
+	struct sockaddr_un addr;
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+	if (fd < 0 || connect(fd, (const struct sockaddr *)&addr, sizeof(addr)) != 0) {
+		perror("connect");
+		return -1;
+	}
+	return fd;
+}
+
+int main(int argc, char **argv)
+{
+	const char *sources[MAX_SOURCES];
+	int source_count = 0;
+	const char *target = NULL;
+	char *message = NULL;
+	int binary = 0;
+	int delta = 0;
+	int fd;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-b") == 0)
+			binary = 1;
+		else if (strcmp(argv[i], "-d") == 0)
+			delta = 1;
+		else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc && source_count < MAX_SOURCES)
+			sources[source_count++] = argv[++i];
+		else
+			target = argv[i];
+	}
+	if (!target) {
+		fprintf(stderr, "usage: %s [-b | -d] [-s source]... <socket path | ws://...>\n",
+			argv[0]);
+		return 2;
+	}
+
+	websocket = strncmp(target, "ws://", 5) == 0;
+	fd = websocket ? connect_websocket(target) : connect_unix(target);
+	if (fd < 0)
+		return 1;
+	if (binary && send_command(fd, "binary"))
+		return 1;
+	if (delta && !binary && send_command(fd, "delta"))
+		return 1;
+	for (i = 0; i < source_count; i++) {
+		char command[256];
+		snprintf(command, sizeof(command), "subscribe %s", sources[i]);
+		if (send_command(fd, command))
+			return 1;
+	}
+
+	for (;;) {
+		uint64_t size = 0;
+		int is_binary = binary;
+
+		if (websocket) {
+			unsigned char header[10];
+			if (read_exactly(fd, header, 2))
+				break;
+			size = header[1] & 0x7f;
+			if (size == 126) {
+				if (read_exactly(fd, header + 2, 2))
+					break;
+				size = (uint64_t)header[2] << 8 | header[3];
+			} else if (size == 127) {
+				if (read_exactly(fd, header + 2, 8))
+					break;
+				size = 0;
+				for (i = 0; i < 8; i++)
+					size = size << 8 | header[2 + i];
+			}
+			is_binary = (header[0] & 0x0f) == 0x2;
+			if ((header[0] & 0x0f) == 0x8)
+				break;
+		} else if (binary) {
+			unsigned char length[4];
+			if (read_exactly(fd, length, 4))
+				break;
+			size = (uint64_t)length[0] | (uint64_t)length[1] << 8 |
+			       (uint64_t)length[2] << 16 | (uint64_t)length[3] << 24;
+		} else {
+			/* JSON lines: read up to the newline */
+			char c;
+			size_t used = 0;
+			while (read_exactly(fd, &c, 1) == 0 && c != '\n') {
+				message = (char *)realloc(message, used + 1);
+				message[used++] = c;
+			}
+			if (used == 0)
+				break;
+			print_message(0, message, used);
+			continue;
+		}
+
+		message = (char *)realloc(message, (size_t)size + 1);
+		if (read_exactly(fd, message, (size_t)size))
+			break;
+		print_message(is_binary, message, (size_t)size);
+	}
+
+	free(message);
+	close(fd);
+	return 0;
+}
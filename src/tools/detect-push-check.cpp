@@ -0,0 +1,552 @@
+// obs-detect-push-check: loopback check of the push server, outside of OBS.
+//
+// Usage: obs-detect-push-check
+//
+// Starts a PushServer on a free port of 127.0.0.1 and a Unix socket, and connects stand-in
+// clients to it: WebSocket handshakes with and without an Origin, JSON, binary and delta
+// messages, subscribe commands and a Unix socket client. Exits with 1 when a check fails.
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <obs-module.h>
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "output/PushServer.h"
+#include "output/detection-shm.h"
+
+// the module configuration functions are linked in with the server, outside of OBS they find
+// no configuration
+OBS_DECLARE_MODULE()
+
+namespace {
+
+int failures = 0;
+
+void check(bool ok, const std::string &what)
+{
+	if (!ok) {
+		printf("FAIL %s\n", what.c_str());
+		failures++;
+	}
+}
+
+constexpr int TIMEOUT_MS = 2000;
+
+// A stand-in client, what it received and not yet consumed is in in
+struct Connection {
+	int fd = -1;
+	std::string in;
+
+	~Connection()
+	{
+		if (fd >= 0) {
+			close(fd);
+		}
+	}
+
+	bool send(const std::string &data) const
+	{
+		size_t sent = 0;
+		while (sent < data.size()) {
+			const ssize_t n = ::send(fd, data.data() + sent, data.size() - sent, 0);
+			if (n <= 0) {
+				return false;
+			}
+			sent += (size_t)n;
+		}
+		return true;
+	}
+
+	// Receive what arrives within timeout_ms, false when nothing did
+	bool receive(int timeout_ms)
+	{
+		pollfd pfd = {fd, POLLIN, 0};
+		if (poll(&pfd, 1, timeout_ms) <= 0) {
+			return false;
+		}
+		char buffer[16 * 1024];
+		const ssize_t n = recv(fd, buffer, sizeof(buffer), 0);
+		if (n <= 0) {
+			return false;
+		}
+		in.append(buffer, (size_t)n);
+		return true;
+	}
+};
+
+int free_port()
+{
+	const int s = socket(AF_INET, SOCK_STREAM, 0);
+	sockaddr_in addr{};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t length = sizeof(addr);
+	int port = 0;
+	if (bind(s, (const sockaddr *)&addr, sizeof(addr)) == 0 &&
+	    getsockname(s, (sockaddr *)&addr, &length) == 0) {
+		port = ntohs(addr.sin_port);
+	}
+	close(s);
+	return port;
+}
+
+// Connect to the port, retried while the server starts listening
+bool connect_tcp(Connection &connection, int port)
+{
+	const auto deadline =
+		std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT_MS);
+	while (std::chrono::steady_clock::now() < deadline) {
+		connection.fd = socket(AF_INET, SOCK_STREAM, 0);
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons((uint16_t)port);
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		if (connect(connection.fd, (const sockaddr *)&addr, sizeof(addr)) == 0) {
+			return true;
+		}
+		close(connection.fd);
+		connection.fd = -1;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return false;
+}
+
+bool connect_unix(Connection &connection, const std::string &path)
+{
+	const auto deadline =
+		std::chrono::steady_clock::now() + std::chrono::milliseconds(TIMEOUT_MS);
+	while (std::chrono::steady_clock::now() < deadline) {
+		connection.fd = socket(AF_UNIX, SOCK_STREAM, 0);
+		sockaddr_un addr{};
+		addr.sun_family = AF_UNIX;
+		strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+		if (connect(connection.fd, (const sockaddr *)&addr, sizeof(addr)) == 0) {
+			return true;
+		}
+		close(connection.fd);
+		connection.fd = -1;
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+	return false;
+}
+
+/**
+ * Connect and upgrade to a WebSocket.
+ *
+ * @return the status line of the response, empty if there was none.
+ */
+std::string handshake(Connection &connection, int port, const std::string &target,
+		      const std::string &origin)
+{
+	if (!connect_tcp(connection, port)) {
+		return std::string();
+	}
+	// the key and accept value of the RFC 6455 example
+	std::string request = "GET " + target +
+			      " HTTP/1.1\r\n"
+			      "Host: 127.0.0.1\r\n"
+			      "Upgrade: websocket\r\n"
+			      "Connection: Upgrade\r\n"
+			      "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+			      "Sec-WebSocket-Version: 13\r\n";
+	if (!origin.empty()) {
+		request += "Origin: " + origin + "\r\n";
+	}
+	request += "\r\n";
+	if (!connection.send(request)) {
+		return std::string();
+	}
+	size_t end;
+	while ((end = connection.in.find("\r\n\r\n")) == std::string::npos) {
+		if (!connection.receive(TIMEOUT_MS)) {
+			return std::string();
+		}
+	}
+	const std::string response = connection.in.substr(0, end + 4);
+	connection.in.erase(0, end + 4);
+	if (response.compare(0, 12, "HTTP/1.1 101") == 0) {
+		check(response.find("Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=\r\n") !=
+			      std::string::npos,
+		      "Sec-WebSocket-Accept for " + target);
+	}
+	return response.substr(0, response.find("\r\n"));
+}
+
+// Send a masked client frame
+bool send_frame(Connection &connection, uint8_t opcode, const std::string &payload)
+{
+	std::string frame;
+	frame += (char)(0x80 | opcode);
+	frame += (char)(0x80 | payload.size()); // short test payloads only
+	const uint8_t mask[4] = {0x12, 0x34, 0x56, 0x78};
+	frame.append((const char *)mask, 4);
+	for (size_t i = 0; i < payload.size(); ++i) {
+		frame += (char)(payload[i] ^ mask[i % 4]);
+	}
+	return connection.send(frame);
+}
+
+// Take the next server frame, false if none came within the timeout
+bool read_frame(Connection &connection, uint8_t &opcode, std::string &payload,
+		int timeout_ms = TIMEOUT_MS)
+{
+	while (true) {
+		const std::string &in = connection.in;
+		if (in.size() >= 2) {
+			const auto *bytes = (const uint8_t *)in.data();
+			uint64_t size = bytes[1] & 0x7f;
+			size_t header = 2;
+			if (size == 126 && in.size() >= 4) {
+				header = 4;
+				size = (uint64_t)bytes[2] << 8 | bytes[3];
+			} else if (size == 127 && in.size() >= 10) {
+				header = 10;
+				size = 0;
+				for (int i = 0; i < 8; ++i) {
+					size = size << 8 | bytes[2 + i];
+				}
+			}
+			// server frames are not masked
+			check((bytes[1] & 0x80) == 0, "server frame without mask");
+			if (size < 126 || header > 2) {
+				if (in.size() >= header + size) {
+					opcode = bytes[0] & 0x0f;
+					payload = in.substr(header, (size_t)size);
+					connection.in.erase(0, header + (size_t)size);
+					return true;
+				}
+			}
+		}
+		if (!connection.receive(timeout_ms)) {
+			return false;
+		}
+	}
+}
+
+// The next text frame as JSON, null if there was none
+nlohmann::json read_json(Connection &connection, const std::string &what)
+{
+	uint8_t opcode = 0;
+	std::string payload;
+	if (!read_frame(connection, opcode, payload)) {
+		check(false, what + ": no message");
+		return nullptr;
+	}
+	check(opcode == 0x1, what + ": text frame");
+	try {
+		return nlohmann::json::parse(payload);
+	} catch (const std::exception &) {
+		check(false, what + ": invalid JSON " + payload);
+		return nullptr;
+	}
+}
+
+// Make sure the server handled everything the client sent before, it answers in order
+bool sync(Connection &connection)
+{
+	if (!send_frame(connection, 0x9, "sync")) {
+		return false;
+	}
+	uint8_t opcode = 0;
+	std::string payload;
+	return read_frame(connection, opcode, payload) && opcode == 0xa && payload == "sync";
+}
+
+Object make_object(int label, float x, float y, float width, float height, float prob)
+{
+	Object obj;
+	obj.rect = cv::Rect_<float>(x, y, width, height);
+	obj.label = label;
+	obj.prob = prob;
+	obj.id = 0;
+	obj.parent_id = 0;
+	return obj;
+}
+
+const std::vector<std::string> FIRST_STAGE_NAMES = {"person", "bicycle", "car", "motorcycle",
+						    "dog"};
+// cascade children are named from these, a face is not a "person"
+const std::vector<std::string> CASCADE_NAMES = {"face"};
+const output::ClassNames CLASS_NAMES = {FIRST_STAGE_NAMES, CASCADE_NAMES};
+const cv::Size FRAME_SIZE(640, 480);
+
+void check_origins(int port)
+{
+	const std::pair<const char *, bool> origins[] = {
+		{"", true},
+		{"http://localhost:8080", true},
+		{"http://127.0.0.1", true},
+		{"https://[::1]:3000", true},
+		{"http://absolute", true},
+		{"https://overlay.example", true}, // in allowed_origins
+		{"https://evil.example", false},
+		{"http://localhost.evil.example", false},
+		{"null", false},
+	};
+	for (const auto &origin : origins) {
+		Connection connection;
+		const std::string status = handshake(connection, port, "/", origin.first);
+		const std::string expected = origin.second ? "HTTP/1.1 101" : "HTTP/1.1 403";
+		check(status.compare(0, expected.size(), expected) == 0,
+		      std::string("origin '") + origin.first + "': " + status);
+	}
+	printf("%zu origins\n", std::size(origins));
+}
+
+void check_json(output::PushServer &server, int port)
+{
+	Connection client;
+	if (handshake(client, port, "/Cam", "") != "HTTP/1.1 101 Switching Protocols") {
+		check(false, "JSON client handshake");
+		return;
+	}
+	const std::vector<Object> objects = {make_object(0, 10, 20, 50, 100, 0.9f),
+					     make_object(2, 200, 50, 80, 40, 0.6f)};
+	server.publish("Cam", "Detect", objects, 1000, FRAME_SIZE, CLASS_NAMES,
+		       output::DeltaConfig());
+	nlohmann::json message = read_json(client, "JSON");
+	if (!message.is_null()) {
+		check(message["source"] == "Cam" && message["filter"] == "Detect", "JSON source");
+		check(message["seq"] == 1 && message["timestamp_ns"] == 1000, "JSON sequence");
+		check(message["width"] == 640 && message["height"] == 480, "JSON frame size");
+		check(message["objects"].size() == 2 && message["objects"][1]["label"] == 2 &&
+			      message["objects"][1]["rect"]["x"] == 200,
+		      "JSON objects");
+	}
+
+	// subscribed to Cam only, until it subscribes to Other as well
+	server.publish("Other", "Detect", objects, 2000, FRAME_SIZE, CLASS_NAMES,
+		       output::DeltaConfig());
+	server.publish("Cam", "Detect", {}, 3000, FRAME_SIZE, CLASS_NAMES, output::DeltaConfig());
+	message = read_json(client, "JSON after another source");
+	check(!message.is_null() && message["source"] == "Cam" && message["seq"] == 2 &&
+		      message["objects"].empty(),
+	      "JSON of another source left out");
+
+	check(send_frame(client, 0x1, "subscribe Other") && sync(client), "subscribe command");
+	server.publish("Other", "Detect", objects, 4000, FRAME_SIZE, CLASS_NAMES,
+		       output::DeltaConfig());
+	message = read_json(client, "JSON after subscribing");
+	check(!message.is_null() && message["source"] == "Other" && message["seq"] == 2,
+	      "JSON of a subscribed source");
+	printf("JSON messages checked\n");
+}
+
+void check_binary(output::PushServer &server, int port)
+{
+	Connection client;
+	if (handshake(client, port, "/Binary?format=binary", "") !=
+	    "HTTP/1.1 101 Switching Protocols") {
+		check(false, "binary client handshake");
+		return;
+	}
+	// untracked, the detector numbered the parent 5
+	Object parent = make_object(0, 10, 20, 50, 100, 0.9f);
+	parent.id = 5;
+	Object child = make_object(0, 30, 40, 10, 10, 0.7f);
+	child.parent_id = 5;
+	const std::vector<Object> objects = {parent, child};
+	server.publish("Binary", "Detect", objects, 5000, FRAME_SIZE, CLASS_NAMES,
+		       output::DeltaConfig());
+	uint8_t opcode = 0;
+	std::string payload;
+	if (!read_frame(client, opcode, payload)) {
+		check(false, "binary: no message");
+		return;
+	}
+	check(opcode == 0x2, "binary frame");
+	const size_t expected = offsetof(obs_detect_shm_record, objects) +
+				objects.size() * sizeof(obs_detect_shm_object);
+	check(payload.size() == expected, "binary record size " + std::to_string(payload.size()));
+	if (payload.size() != expected) {
+		return;
+	}
+	obs_detect_shm_record record;
+	memcpy(&record, payload.data(), payload.size());
+	check(record.sequence == 1 && record.timestamp_ns == 5000, "binary sequence");
+	check(record.frame_width == 640 && record.frame_height == 480, "binary frame size");
+	check(record.count == 2 && record.total == 2, "binary count");
+	check(strcmp(record.objects[0].label, "person") == 0 && record.objects[0].x == 10.0f,
+	      "binary first object");
+	check(strcmp(record.objects[1].label, "face") == 0, "binary child object");
+	// the detector's numbers are no track ids, the child points at its parent's position
+	check(record.objects[0].track_id == 0 && record.objects[1].track_id == 0 &&
+		      record.objects[1].parent_id == 1,
+	      "binary ids without tracking");
+	printf("binary messages checked\n");
+}
+
+void check_delta(output::PushServer &server, int port)
+{
+	Connection client;
+	if (handshake(client, port, "/Delta?format=delta", "") !=
+	    "HTTP/1.1 101 Switching Protocols") {
+		check(false, "delta client handshake");
+		return;
+	}
+	const output::DeltaConfig config;
+	const uint64_t second = 1'000'000'000ull;
+	// untracked, the ids are the NMS order by score
+	Object person = make_object(0, 10, 20, 50, 100, 0.9f);
+	Object car = make_object(2, 200, 50, 80, 40, 0.6f);
+	person.id = 1;
+	car.id = 2;
+
+	// the first message is a keyframe with the keys of the objects
+	server.publish("Delta", "Detect", {person, car}, second, FRAME_SIZE, CLASS_NAMES, config);
+	nlohmann::json message = read_json(client, "delta keyframe");
+	uint64_t person_key = 0, car_key = 0;
+	if (!message.is_null()) {
+		check(message["keyframe"] == true && message["objects"].size() == 2,
+		      "delta keyframe objects");
+		person_key = message["objects"][0]["key"].get<uint64_t>();
+		car_key = message["objects"][1]["key"].get<uint64_t>();
+		check(person_key != car_key, "delta keys differ");
+	}
+
+	// only the person moved further than the tolerance, and its score fell below the car's
+	person.rect.x += 40;
+	person.id = 2;
+	car.id = 1;
+	server.publish("Delta", "Detect", {person, car}, second + 100, FRAME_SIZE, CLASS_NAMES,
+		       config);
+	message = read_json(client, "delta update");
+	if (!message.is_null()) {
+		check(message["seq"] == 2 && message["enter"].empty() && message["exit"].empty() &&
+			      message["update"].size() == 1 &&
+			      message["update"][0]["key"] == person_key &&
+			      message["update"][0]["rect"]["x"] == 50,
+		      "delta update of the moved object");
+	}
+
+	// the car left
+	server.publish("Delta", "Detect", {person}, second + 200, FRAME_SIZE, CLASS_NAMES, config);
+	message = read_json(client, "delta exit");
+	if (!message.is_null()) {
+		check(message["seq"] == 3 && message["enter"].empty() &&
+			      message["update"].empty() && message["exit"].size() == 1 &&
+			      message["exit"][0] == car_key,
+		      "delta exit of the object that left");
+	}
+
+	// nothing changed, no message; then a dog came in
+	person.rect.x += 2;
+	server.publish("Delta", "Detect", {person}, second + 300, FRAME_SIZE, CLASS_NAMES, config);
+	uint8_t opcode = 0;
+	std::string payload;
+	check(!read_frame(client, opcode, payload, 200), "no delta without changes");
+	const Object dog = make_object(4, 400, 300, 60, 40, 0.8f);
+	server.publish("Delta", "Detect", {person, dog}, second + 400, FRAME_SIZE, CLASS_NAMES,
+		       config);
+	message = read_json(client, "delta enter");
+	if (!message.is_null()) {
+		check(message["seq"] == 5 && message["update"].empty() && message["exit"].empty() &&
+			      message["enter"].size() == 1 && message["enter"][0]["label"] == 4,
+		      "delta enter of the new object");
+	}
+	printf("delta messages checked\n");
+}
+
+void check_unix(output::PushServer &server, const std::string &path)
+{
+	Connection client;
+	if (!connect_unix(client, path)) {
+		check(false, "Unix socket connection");
+		return;
+	}
+	// the server takes the connection on its own thread, publish until the client has it
+	const std::vector<Object> objects = {make_object(0, 10, 20, 50, 100, 0.9f)};
+	size_t end = std::string::npos;
+	for (int attempt = 0; attempt < 100 && end == std::string::npos; ++attempt) {
+		server.publish("Unix", "Detect", objects, 6000, FRAME_SIZE, CLASS_NAMES,
+			       output::DeltaConfig());
+		client.receive(20);
+		end = client.in.find('\n');
+	}
+	if (end == std::string::npos) {
+		check(false, "Unix socket: no message");
+		return;
+	}
+	try {
+		const nlohmann::json message = nlohmann::json::parse(client.in.substr(0, end));
+		check(message["source"] == "Unix" && message["objects"].size() == 1,
+		      "Unix socket JSON line");
+	} catch (const std::exception &e) {
+		check(false, std::string("Unix socket: invalid JSON: ") + e.what());
+	}
+}
+
+// A socket file nothing listens on, like the one of an instance that crashed
+bool leave_stale_socket(const std::string &path)
+{
+	const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un addr{};
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+	const bool bound = bind(fd, (const sockaddr *)&addr, sizeof(addr)) == 0;
+	close(fd);
+	return bound;
+}
+
+// A second server on the same path, another OBS instance, must leave the live socket alone
+void check_unix_taken(output::PushServer &server, const output::PushConfig &config)
+{
+	output::PushConfig second = config;
+	second.port = 0;
+	{
+		output::PushServer other(second);
+		// it gives up on the socket on its own thread
+		std::this_thread::sleep_for(std::chrono::milliseconds(200));
+		check_unix(server, config.socket_path);
+	}
+	check(access(config.socket_path.c_str(), F_OK) == 0,
+	      "a second server leaves the live socket in place");
+	check_unix(server, config.socket_path);
+}
+
+} // namespace
+
+int main()
+{
+	output::PushConfig config;
+	config.port = free_port();
+	config.socket_path = "/tmp/obs-detect-push-check-" + std::to_string(getpid()) + ".sock";
+	config.allowed_origins = "https://unused.example, https://overlay.example/";
+	if (config.port == 0) {
+		printf("FAILED: no free port\n");
+		return 1;
+	}
+
+	unlink(config.socket_path.c_str());
+	check(leave_stale_socket(config.socket_path), "stale socket left behind");
+	{
+		output::PushServer server(config);
+		check_origins(config.port);
+		check_json(server, config.port);
+		check_binary(server, config.port);
+		check_delta(server, config.port);
+		// the stale socket was replaced
+		check_unix(server, config.socket_path);
+		check_unix_taken(server, config);
+		printf("Unix socket checked\n");
+	}
+	check(access(config.socket_path.c_str(), F_OK) != 0, "Unix socket removed on stop");
+
+	printf("%s\n", failures > 0 ? "FAILED" : "The push server works over loopback");
+	return failures > 0 ? 1 : 0;
+}
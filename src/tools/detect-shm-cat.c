@@ -0,0 +1,102 @@
+/*
+ * Prints the detections a Detect filter publishes in shared memory, an example consumer of
+ * detection-shm.h.
+ *
+ * usage: obs-detect-shm-cat <source name> [-f]
+ *
+ * Without -f the latest result is printed, with -f every new result until interrupted; results
+ * overwritten before they were read are reported as missed.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "output/detection-shm.h"
+
+static void sleep_ms(unsigned int ms)
+{
+#ifdef _WIN32
+	Sleep(ms);
+#else
+	usleep(ms * 1000);
+#endif
+}
+
+static void print_record(const struct obs_detect_shm_record *record)
+{
+	uint32_t i;
+
+	printf("#%" PRIu64 " t=%" PRIu64 " %ux%u %u objects", record->sequence,
+	       record->timestamp_ns, record->frame_width, record->frame_height, record->total);
+	if (record->total > record->count)
+		printf(" (%u shown)", record->count);
+	printf("\n");
+	for (i = 0; i < record->count; i++) {
+		const struct obs_detect_shm_object *obj = &record->objects[i];
+		printf("  %s(%d) %.2f [%.0f %.0f %.0f %.0f] id=%" PRIu64, obj->label, obj->label_id,
+		       obj->score, obj->x, obj->y, obj->width, obj->height, obj->track_id);
+		if (obj->parent_id)
+			printf(" parent=%" PRIu64, obj->parent_id);
+		printf("\n");
+	}
+	fflush(stdout);
+}
+
+int main(int argc, char **argv)
+{
+	struct obs_detect_shm_reader reader;
+	struct obs_detect_shm_record record;
+	uint64_t next;
+	int follow;
+	int result;
+
+	if (argc < 2 || (argc > 2 && strcmp(argv[2], "-f") != 0)) {
+		fprintf(stderr, "usage: %s <source name> [-f]\n", argv[0]);
+		return 2;
+	}
+	follow = argc > 2;
+
+	result = obs_detect_shm_open(argv[1], &reader);
+	if (result != 0) {
+		char name[OBS_DETECT_SHM_NAME_SIZE];
+		obs_detect_shm_name(argv[1], name, sizeof(name));
+		fprintf(stderr,
+			"cannot open %s (%d), is shared memory output on for this source?\n", name,
+			result);
+		return 1;
+	}
+
+	if (!follow) {
+		result = obs_detect_shm_read_latest(&reader, &record);
+		if (result == 0)
+			print_record(&record);
+		else
+			fprintf(stderr, "no detections (%d)\n", result);
+		obs_detect_shm_close(&reader);
+		return result == 0 ? 0 : 1;
+	}
+
+	next = obs_detect_shm_write_index(&reader);
+	if (next == 0)
+		next = 1;
+	for (;;) {
+		const uint64_t latest = obs_detect_shm_write_index(&reader);
+		if (next > latest) {
+			sleep_ms(5);
+			continue;
+		}
+		/* the ring only keeps the last OBS_DETECT_SHM_SLOTS results */
+		if (latest - next >= OBS_DETECT_SHM_SLOTS) {
+			printf("missed %" PRIu64 " results\n",
+			       latest - next + 1 - OBS_DETECT_SHM_SLOTS);
+			next = latest - OBS_DETECT_SHM_SLOTS + 1;
+		}
+		result = obs_detect_shm_read(&reader, next, &record);
+		if (result == 0)
+			print_record(&record);
+		else if (result == OBS_DETECT_SHM_ERR_MISSED)
+			printf("missed #%" PRIu64 "\n", next);
+		next++;
+	}
+}
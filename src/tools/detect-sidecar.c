@@ -0,0 +1,149 @@
+/*
+ * Looks up the detections in a sidecar a Detect filter recorded next to a video, an example
+ * consumer of detection-sidecar.h.
+ *
+ * usage: obs-detect-sidecar <file> [info | at <time> | range <from> <to> | dump]
+ *
+ * Times are into the recording, in seconds or as [h:]m:s. at prints the result in effect at that
+ * point of the video, range every result made in between; both find their first result with a
+ * binary search of the index and read nothing else of the file.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "output/detection-sidecar.h"
+
+/* seconds, m:s or h:m:s into the recording, -1 if it is not a time */
+static double parse_time(const char *text)
+{
+	double seconds = 0.0;
+	const char *p = text;
+
+	for (;;) {
+		char *end;
+		const double part = strtod(p, &end);
+		if (end == p || part < 0.0)
+			return -1.0;
+		seconds = seconds * 60.0 + part;
+		if (*end == '\0')
+			return seconds;
+		if (*end != ':')
+			return -1.0;
+		p = end + 1;
+	}
+}
+
+static uint64_t recording_time_ns(const struct obs_detect_sidecar *sidecar, double seconds)
+{
+	return sidecar->header->start_ns + (uint64_t)(seconds * 1e9);
+}
+
+static void print_frame(const struct obs_detect_sidecar *sidecar,
+			const struct obs_detect_sidecar_frame *frame)
+{
+	const struct obs_detect_sidecar_header *header = sidecar->header;
+	const struct obs_detect_sidecar_object *objects = obs_detect_sidecar_objects(frame);
+	const double seconds = frame->timestamp_ns >= header->start_ns
+				       ? (double)(frame->timestamp_ns - header->start_ns) / 1e9
+				       : 0.0;
+	uint32_t i;
+
+	printf("#%" PRIu64 " %.3f s", frame->sequence, seconds);
+	if (header->fps_den != 0)
+		printf(" (frame %.0f)", seconds * header->fps_num / header->fps_den);
+	printf(" %ux%u %u objects\n", frame->frame_width, frame->frame_height, frame->count);
+	for (i = 0; i < frame->count; i++) {
+		const struct obs_detect_sidecar_object *obj = &objects[i];
+		printf("  %s(%d) %.2f [%.0f %.0f %.0f %.0f] id=%" PRIu64,
+		       obs_detect_sidecar_label(sidecar, obj->label_id), obj->label_id, obj->score,
+		       obj->x, obj->y, obj->width, obj->height, obj->track_id);
+		if (obj->parent_id)
+			printf(" parent=%" PRIu64, obj->parent_id);
+		printf("\n");
+	}
+}
+
+static void print_info(const struct obs_detect_sidecar *sidecar)
+{
+	const struct obs_detect_sidecar_header *header = sidecar->header;
+
+	printf("video      %ux%u at %u/%u fps\n", header->video_width, header->video_height,
+	       header->fps_num, header->fps_den);
+	printf("start      %" PRIu64 " ns\n", header->start_ns);
+	if (header->end_ns > header->start_ns)
+		printf("duration   %.3f s\n", (double)(header->end_ns - header->start_ns) / 1e9);
+	else
+		printf("duration   unknown, the recording did not finish\n");
+	printf("results    %" PRIu64 "%s\n", sidecar->frame_count,
+	       header->index_offset ? "" : " (no index, scanned)");
+	printf("labels     %u\n", header->label_count);
+	if (sidecar->frame_count > 0) {
+		const struct obs_detect_sidecar_frame *last =
+			obs_detect_sidecar_frame_at(sidecar, sidecar->frame_count - 1);
+		printf("first      ");
+		print_frame(sidecar, obs_detect_sidecar_frame_at(sidecar, 0));
+		printf("last       ");
+		print_frame(sidecar, last);
+	}
+}
+
+int main(int argc, char **argv)
+{
+	struct obs_detect_sidecar sidecar;
+	const char *command = argc > 2 ? argv[2] : "info";
+	int result;
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <file> [info | at <time> | range <from> <to> | dump]\n",
+			argv[0]);
+		return 2;
+	}
+	result = obs_detect_sidecar_open(argv[1], &sidecar);
+	if (result != 0) {
+		fprintf(stderr, "cannot open %s: %s\n", argv[1],
+			result == OBS_DETECT_SIDECAR_ERR_FORMAT ? "not a detection sidecar"
+								: "cannot read it");
+		return 1;
+	}
+
+	result = 0;
+	if (strcmp(command, "info") == 0) {
+		print_info(&sidecar);
+	} else if (strcmp(command, "dump") == 0) {
+		uint64_t i;
+		for (i = 0; i < sidecar.frame_count; i++)
+			print_frame(&sidecar, obs_detect_sidecar_frame_at(&sidecar, i));
+	} else if (strcmp(command, "at") == 0 && argc == 4 && parse_time(argv[3]) >= 0.0) {
+		const uint64_t at = recording_time_ns(&sidecar, parse_time(argv[3]));
+		const int64_t i = obs_detect_sidecar_find(&sidecar, at);
+		if (i >= 0) {
+			print_frame(&sidecar, obs_detect_sidecar_frame_at(&sidecar, (uint64_t)i));
+		} else {
+			fprintf(stderr, "no detections that early\n");
+			result = 1;
+		}
+	} else if (strcmp(command, "range") == 0 && argc == 5 && parse_time(argv[3]) >= 0.0 &&
+		   parse_time(argv[4]) >= 0.0) {
+		const uint64_t from = recording_time_ns(&sidecar, parse_time(argv[3]));
+		const uint64_t to = recording_time_ns(&sidecar, parse_time(argv[4]));
+		/* the first result at or after from */
+		int64_t i = obs_detect_sidecar_find(&sidecar, from);
+		if (i < 0 || sidecar.index[i].timestamp_ns < from)
+			i++;
+		for (; (uint64_t)i < sidecar.frame_count; i++) {
+			if (sidecar.index[i].timestamp_ns > to)
+				break;
+			print_frame(&sidecar, obs_detect_sidecar_frame_at(&sidecar, (uint64_t)i));
+		}
+	} else {
+		fprintf(stderr, "usage: %s <file> [info | at <time> | range <from> <to> | dump]\n",
+			argv[0]);
+		result = 2;
+	}
+
+	obs_detect_sidecar_close(&sidecar);
+	return result;
+}
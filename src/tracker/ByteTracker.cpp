@@ -0,0 +1,158 @@
+#include "ByteTracker.h"
+
+#include "Hungarian.h"
+
+#include <algorithm>
+
+namespace tracker {
+
+namespace {
+
+float iou(const cv::Rect_<float> &a, const cv::Rect_<float> &b)
+{
+	const float inter = (a & b).area();
+	const float uni = a.area() + b.area() - inter;
+	return uni > 0.0f ? inter / uni : 0.0f;
+}
+
+} // namespace
+
+ByteTracker::ByteTracker(const ByteTrackerConfig &config) : config_(config) {}
+
+void ByteTracker::associate(std::vector<size_t> &track_indices,
+			    const std::vector<Object> &detections,
+			    std::vector<size_t> &detection_indices, float min_iou, double timestamp)
+{
+	if (track_indices.empty() || detection_indices.empty()) {
+		return;
+	}
+
+	// 1 - IoU, tracks never take a detection of another class
+	cv::Mat_<float> cost((int)track_indices.size(), (int)detection_indices.size());
+	for (size_t t = 0; t < track_indices.size(); ++t) {
+		const Track &track = tracks_[track_indices[t]];
+		const cv::Rect_<float> predicted = track.filter.box();
+		for (size_t d = 0; d < detection_indices.size(); ++d) {
+			const Object &detection = detections[detection_indices[d]];
+			cost((int)t, (int)d) = detection.label == track.label
+						       ? 1.0f - iou(predicted, detection.rect)
+						       : 2.0f;
+		}
+	}
+
+	const std::vector<int> assignment = hungarianAssign(cost, 1.0f - min_iou);
+	std::vector<bool> detection_used(detection_indices.size(), false);
+	std::vector<size_t> unmatched_tracks;
+	for (size_t t = 0; t < track_indices.size(); ++t) {
+		if (assignment[t] < 0) {
+			unmatched_tracks.push_back(track_indices[t]);
+			continue;
+		}
+		const Object &detection = detections[detection_indices[(size_t)assignment[t]]];
+		Track &track = tracks_[track_indices[t]];
+		track.filter.update(detection.rect);
+		track.prob = detection.prob;
+		track.last_seen = timestamp;
+		track.confirmed = true;
+		track.matched = true;
+		detection_used[(size_t)assignment[t]] = true;
+	}
+
+	std::vector<size_t> unmatched_detections;
+	for (size_t d = 0; d < detection_indices.size(); ++d) {
+		if (!detection_used[d]) {
+			unmatched_detections.push_back(detection_indices[d]);
+		}
+	}
+	track_indices.swap(unmatched_tracks);
+	detection_indices.swap(unmatched_detections);
+}
+
+std::vector<Object> ByteTracker::update(const std::vector<Object> &detections, double timestamp)
+{
+	const double dt = started_ ? std::max(timestamp - last_timestamp_, 0.0) : 0.0;
+
+	// tracks matched in the previous frame may take low score detections later on
+	std::vector<size_t> confirmed, tentative;
+	std::vector<bool> was_tracked(tracks_.size());
+	for (size_t i = 0; i < tracks_.size(); ++i) {
+		Track &track = tracks_[i];
+		track.filter.predict(dt);
+		was_tracked[i] = track.matched;
+		track.matched = false;
+		(track.confirmed ? confirmed : tentative).push_back(i);
+	}
+
+	std::vector<size_t> high, low;
+	for (size_t d = 0; d < detections.size(); ++d) {
+		if (detections[d].prob >= config_.high_threshold) {
+			high.push_back(d);
+		} else if (detections[d].prob >= config_.low_threshold) {
+			low.push_back(d);
+		}
+	}
+
+	associate(confirmed, detections, high, config_.match_iou, timestamp);
+
+	std::vector<size_t> recently_tracked;
+	for (size_t i : confirmed) {
+		if (was_tracked[i]) {
+			recently_tracked.push_back(i);
+		}
+	}
+	associate(recently_tracked, detections, low, config_.low_match_iou, timestamp);
+
+	associate(tentative, detections, high, config_.tentative_match_iou, timestamp);
+
+	for (size_t d : high) {
+		const Object &detection = detections[d];
+		tracks_.push_back(Track{next_id_++, detection.label, detection.prob,
+					KalmanBoxFilter(detection.rect), timestamp, !started_,
+					true});
+	}
+
+	tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(),
+				     [&](const Track &track) {
+					     return !track.matched &&
+						    (!track.confirmed ||
+						     timestamp - track.last_seen >
+							     config_.max_lost_seconds);
+				     }),
+		      tracks_.end());
+
+	last_timestamp_ = timestamp;
+	started_ = true;
+
+	std::vector<Object> objects;
+	for (const Track &track : tracks_) {
+		if (track.matched && track.confirmed) {
+			objects.push_back({track.filter.box(), track.label, track.prob, track.id});
+		}
+	}
+	return objects;
+}
+
+std::vector<Object> ByteTracker::predict(double timestamp) const
+{
+	std::vector<Object> objects;
+	const double dt = timestamp - last_timestamp_;
+	if (!started_ || dt > config_.max_lost_seconds) {
+		return objects;
+	}
+	for (const Track &track : tracks_) {
+		if (track.matched && track.confirmed) {
+			objects.push_back(
+				{track.filter.extrapolate(dt), track.label, track.prob, track.id});
+		}
+	}
+	return objects;
+}
+
+void ByteTracker::reset()
+{
+	// ids keep counting so consumers never see an id reused for another object
+	tracks_.clear();
+	started_ = false;
+}
+
+} // namespace tracker
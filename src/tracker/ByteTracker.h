@@ -0,0 +1,84 @@
+#ifndef BYTE_TRACKER_H
+#define BYTE_TRACKER_H
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+#include "ort-model/types.hpp"
+#include "KalmanBoxFilter.h"
+
+namespace tracker {
+
+struct ByteTrackerConfig {
+	// detections at or above this score continue tracks in the first association
+	float high_threshold = 0.5f;
+	// detections between this and high_threshold only keep tracked objects alive
+	float low_threshold = 0.1f;
+	// minimum IoU of a match in the first, second (low score) and tentative associations
+	float match_iou = 0.2f;
+	float low_match_iou = 0.5f;
+	float tentative_match_iou = 0.3f;
+	// tracks without a match for this long are dropped
+	double max_lost_seconds = 1.0;
+};
+
+/**
+ * Multi-object tracker after ByteTrack: a constant-velocity Kalman filter per track, IoU
+ * costs solved with the Hungarian algorithm, and a second association of the unmatched
+ * tracks with the low score detections, which keeps occluded or blurred objects tracked.
+ *
+ * Tracks only match detections of their own class. A new track is tentative until it is
+ * matched again, except on the first update where every high score detection starts a
+ * confirmed track. Not thread-safe.
+ */
+class ByteTracker {
+public:
+	explicit ByteTracker(const ByteTrackerConfig &config = ByteTrackerConfig());
+
+	void setHighThreshold(float threshold) { config_.high_threshold = threshold; }
+	const ByteTrackerConfig &config() const { return config_; }
+
+	/**
+	 * Associate the detections of a frame with the tracks.
+	 *
+	 * @param detections Detections of the frame, scores down to low_threshold.
+	 * @param timestamp When the frame was captured, in seconds.
+	 * @return The confirmed tracks matched in this frame, with their track id in Object::id.
+	 */
+	std::vector<Object> update(const std::vector<Object> &detections, double timestamp);
+
+	/**
+	 * The tracks returned by the last update, moved along their velocity to timestamp.
+	 * Empty once the last update is more than max_lost_seconds old.
+	 */
+	std::vector<Object> predict(double timestamp) const;
+
+	void reset();
+
+private:
+	struct Track {
+		uint64_t id;
+		int label;
+		float prob;
+		KalmanBoxFilter filter;
+		double last_seen;
+		bool confirmed;
+		bool matched;
+	};
+
+	// match tracks[track_indices] with detections[detection_indices], matched entries are
+	// removed from both index lists
+	void associate(std::vector<size_t> &track_indices, const std::vector<Object> &detections,
+		       std::vector<size_t> &detection_indices, float min_iou, double timestamp);
+
+	ByteTrackerConfig config_;
+	std::vector<Track> tracks_;
+	uint64_t next_id_ = 1;
+	double last_timestamp_ = 0.0;
+	bool started_ = false;
+};
+
+} // namespace tracker
+
+#endif /* BYTE_TRACKER_H */
@@ -0,0 +1,84 @@
+#include "Hungarian.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace tracker {
+
+std::vector<int> hungarianAssign(const cv::Mat_<float> &cost, float max_cost)
+{
+	const int rows = cost.rows;
+	const int cols = cost.cols;
+	std::vector<int> assignment((size_t)rows, -1);
+	if (rows == 0 || cols == 0) {
+		return assignment;
+	}
+
+	// one extra "unassigned" column per row at max_cost, pairs above it are never cheaper
+	const int n = rows;
+	const int m = cols + rows;
+	auto at = [&](int r, int c) -> double {
+		if (c >= cols) {
+			return max_cost;
+		}
+		const float value = cost(r, c);
+		return value <= max_cost ? value : (double)max_cost + 1.0;
+	};
+
+	// potentials formulation with 1-based rows and columns, column 0 is a sentinel
+	const double inf = std::numeric_limits<double>::infinity();
+	std::vector<double> u((size_t)n + 1, 0.0), v((size_t)m + 1, 0.0);
+	std::vector<int> p((size_t)m + 1, 0), way((size_t)m + 1, 0);
+	std::vector<double> minv((size_t)m + 1);
+	std::vector<bool> used((size_t)m + 1);
+	for (int i = 1; i <= n; ++i) {
+		p[0] = i;
+		int j0 = 0;
+		std::fill(minv.begin(), minv.end(), inf);
+		std::fill(used.begin(), used.end(), false);
+		do {
+			used[(size_t)j0] = true;
+			const int i0 = p[(size_t)j0];
+			double delta = inf;
+			int j1 = 0;
+			for (int j = 1; j <= m; ++j) {
+				if (used[(size_t)j]) {
+					continue;
+				}
+				const double cur = at(i0 - 1, j - 1) - u[(size_t)i0] - v[(size_t)j];
+				if (cur < minv[(size_t)j]) {
+					minv[(size_t)j] = cur;
+					way[(size_t)j] = j0;
+				}
+				if (minv[(size_t)j] < delta) {
+					delta = minv[(size_t)j];
+					j1 = j;
+				}
+			}
+			for (int j = 0; j <= m; ++j) {
+				if (used[(size_t)j]) {
+					u[(size_t)p[(size_t)j]] += delta;
+					v[(size_t)j] -= delta;
+				} else {
+					minv[(size_t)j] -= delta;
+				}
+			}
+			j0 = j1;
+		} while (p[(size_t)j0] != 0);
+		do {
+			const int j1 = way[(size_t)j0];
+			p[(size_t)j0] = p[(size_t)j1];
+			j0 = j1;
+		} while (j0 != 0);
+	}
+
+	for (int j = 1; j <= cols; ++j) {
+		const int row = p[(size_t)j] - 1;
+		if (row >= 0 && cost(row, j - 1) <= max_cost) {
+			assignment[(size_t)row] = j - 1;
+		}
+	}
+	return assignment;
+}
+
+} // namespace tracker
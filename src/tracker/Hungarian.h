@@ -0,0 +1,23 @@
+#ifndef HUNGARIAN_H
+#define HUNGARIAN_H
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+namespace tracker {
+
+/**
+ * Minimum cost assignment of rows to columns (Hungarian / Kuhn-Munkres, O(n^2 m)).
+ *
+ * The matrix may be rectangular. Pairs whose cost is above max_cost are never assigned.
+ *
+ * @param cost Rows x columns cost matrix.
+ * @param max_cost The highest cost an assigned pair may have.
+ * @return The column assigned to each row, -1 for unassigned rows.
+ */
+std::vector<int> hungarianAssign(const cv::Mat_<float> &cost, float max_cost);
+
+} // namespace tracker
+
+#endif /* HUNGARIAN_H */
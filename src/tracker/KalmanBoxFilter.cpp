@@ -0,0 +1,115 @@
+#include "KalmanBoxFilter.h"
+
+#include <algorithm>
+
+namespace tracker {
+
+namespace {
+
+// ByteTrack's noise weights are per frame at 30 fps, velocities here are per second
+constexpr double REFERENCE_FPS = 30.0;
+constexpr double STD_WEIGHT_POSITION = 1.0 / 20.0;
+constexpr double STD_WEIGHT_VELOCITY = 1.0 / 160.0 * REFERENCE_FPS;
+
+typedef cv::Matx<double, 4, 8> Projection;
+
+Projection projection()
+{
+	Projection h = Projection::zeros();
+	for (int i = 0; i < 4; ++i) {
+		h(i, i) = 1.0;
+	}
+	return h;
+}
+
+cv::Vec<double, 4> measurement(const cv::Rect_<float> &box)
+{
+	const double height = std::max(box.height, 1.0f);
+	return {box.x + box.width / 2.0, box.y + box.height / 2.0, box.width / height, height};
+}
+
+} // namespace
+
+KalmanBoxFilter::KalmanBoxFilter(const cv::Rect_<float> &box)
+{
+	const cv::Vec<double, 4> z = measurement(box);
+	const double h = z[3];
+	mean_ = State(z[0], z[1], z[2], z[3], 0.0, 0.0, 0.0, 0.0);
+
+	const double std[8] = {2 * STD_WEIGHT_POSITION * h,  2 * STD_WEIGHT_POSITION * h, 1e-2,
+			       2 * STD_WEIGHT_POSITION * h,  10 * STD_WEIGHT_VELOCITY * h,
+			       10 * STD_WEIGHT_VELOCITY * h, 1e-5 * REFERENCE_FPS,
+			       10 * STD_WEIGHT_VELOCITY * h};
+	covariance_ = Covariance::zeros();
+	for (int i = 0; i < 8; ++i) {
+		covariance_(i, i) = std[i] * std[i];
+	}
+}
+
+void KalmanBoxFilter::predict(double dt)
+{
+	if (dt <= 0.0) {
+		return;
+	}
+	Covariance motion = Covariance::eye();
+	for (int i = 0; i < 4; ++i) {
+		motion(i, i + 4) = dt;
+	}
+
+	// process noise grows with the number of reference frames that passed
+	const double frames = dt * REFERENCE_FPS;
+	const double h = std::max(mean_[3], 1.0);
+	const double std[8] = {STD_WEIGHT_POSITION * h, STD_WEIGHT_POSITION * h, 1e-2,
+			       STD_WEIGHT_POSITION * h, STD_WEIGHT_VELOCITY * h,
+			       STD_WEIGHT_VELOCITY * h, 1e-5 * REFERENCE_FPS,
+			       STD_WEIGHT_VELOCITY * h};
+	Covariance noise = Covariance::zeros();
+	for (int i = 0; i < 8; ++i) {
+		noise(i, i) = std[i] * std[i] * frames;
+	}
+
+	mean_ = motion * mean_;
+	covariance_ = motion * covariance_ * motion.t() + noise;
+}
+
+void KalmanBoxFilter::update(const cv::Rect_<float> &box)
+{
+	const Projection h = projection();
+	const double height = std::max(mean_[3], 1.0);
+	const double std[4] = {STD_WEIGHT_POSITION * height, STD_WEIGHT_POSITION * height, 1e-1,
+			       STD_WEIGHT_POSITION * height};
+	cv::Matx<double, 4, 4> noise = cv::Matx<double, 4, 4>::zeros();
+	for (int i = 0; i < 4; ++i) {
+		noise(i, i) = std[i] * std[i];
+	}
+
+	const cv::Matx<double, 8, 4> pht = covariance_ * h.t();
+	const cv::Matx<double, 4, 4> innovation_covariance = h * pht + noise;
+	const cv::Matx<double, 8, 4> gain = pht * innovation_covariance.inv(cv::DECOMP_CHOLESKY);
+	const cv::Vec<double, 4> innovation = measurement(box) - h * mean_;
+
+	mean_ += gain * innovation;
+	covariance_ = (Covariance::eye() - gain * h) * covariance_;
+}
+
+cv::Rect_<float> KalmanBoxFilter::box() const
+{
+	return toRect(mean_[0], mean_[1], mean_[2], mean_[3]);
+}
+
+cv::Rect_<float> KalmanBoxFilter::extrapolate(double dt) const
+{
+	dt = std::max(dt, 0.0);
+	return toRect(mean_[0] + mean_[4] * dt, mean_[1] + mean_[5] * dt, mean_[2] + mean_[6] * dt,
+		      mean_[3] + mean_[7] * dt);
+}
+
+cv::Rect_<float> KalmanBoxFilter::toRect(double cx, double cy, double aspect, double height)
+{
+	height = std::max(height, 1.0);
+	const double width = std::max(aspect, 0.0) * height;
+	return cv::Rect_<float>((float)(cx - width / 2), (float)(cy - height / 2), (float)width,
+				(float)height);
+}
+
+} // namespace tracker
@@ -0,0 +1,41 @@
+#ifndef KALMAN_BOX_FILTER_H
+#define KALMAN_BOX_FILTER_H
+
+#include <opencv2/core.hpp>
+
+namespace tracker {
+
+/**
+ * Constant-velocity Kalman filter over a box as (center x, center y, aspect ratio, height),
+ * the motion model of SORT / ByteTrack.
+ *
+ * Time is continuous: velocities are per second and predict() takes the elapsed seconds, so
+ * the detector can run at any rate and boxes can be extrapolated to every rendered frame.
+ */
+class KalmanBoxFilter {
+public:
+	explicit KalmanBoxFilter(const cv::Rect_<float> &box);
+
+	// Advance the state by dt seconds
+	void predict(double dt);
+	// Correct the state with a measured box
+	void update(const cv::Rect_<float> &box);
+
+	// The current estimate
+	cv::Rect_<float> box() const;
+	// The estimate moved dt seconds ahead along its velocity, the state is not changed
+	cv::Rect_<float> extrapolate(double dt) const;
+
+private:
+	typedef cv::Vec<double, 8> State;
+	typedef cv::Matx<double, 8, 8> Covariance;
+
+	static cv::Rect_<float> toRect(double cx, double cy, double aspect, double height);
+
+	State mean_;
+	Covariance covariance_;
+};
+
+} // namespace tracker
+
+#endif /* KALMAN_BOX_FILTER_H */
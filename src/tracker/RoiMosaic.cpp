@@ -0,0 +1,150 @@
+#include "RoiMosaic.h"
+
+#include <opencv2/imgproc.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace tracker {
+
+namespace {
+
+// keeps the resize of one tile from bleeding into its neighbour
+constexpr int TILE_GAP = 2;
+constexpr double SCALE_STEP = 0.9;
+
+bool shelf_pack(const std::vector<cv::Rect> &regions, const std::vector<size_t> &order,
+		const cv::Size &canvas, double scale, std::vector<MosaicTile> &tiles)
+{
+	tiles.clear();
+	int x = 0, y = 0, shelf_height = 0;
+	for (size_t i : order) {
+		const cv::Rect &region = regions[i];
+		const int w = std::max(1, (int)std::lround(region.width * scale));
+		const int h = std::max(1, (int)std::lround(region.height * scale));
+		if (x > 0 && x + w > canvas.width) {
+			x = 0;
+			y += shelf_height + TILE_GAP;
+			shelf_height = 0;
+		}
+		if (x + w > canvas.width || y + h > canvas.height) {
+			return false;
+		}
+		tiles.push_back({region, cv::Rect(x, y, w, h)});
+		x += w + TILE_GAP;
+		shelf_height = std::max(shelf_height, h);
+	}
+	return true;
+}
+
+} // namespace
+
+std::vector<cv::Rect> expandRegions(const std::vector<Object> &boxes, const cv::Rect &bounds,
+				    float expand, int min_size)
+{
+	std::vector<cv::Rect> regions;
+	for (const Object &box : boxes) {
+		const float w = std::max(box.rect.width * (1.0f + 2.0f * expand), (float)min_size);
+		const float h = std::max(box.rect.height * (1.0f + 2.0f * expand), (float)min_size);
+		const float cx = box.rect.x + box.rect.width / 2.0f;
+		const float cy = box.rect.y + box.rect.height / 2.0f;
+		const cv::Rect region =
+			cv::Rect((int)std::floor(cx - w / 2), (int)std::floor(cy - h / 2),
+				 (int)std::ceil(w), (int)std::ceil(h)) &
+			bounds;
+		if (region.area() > 0) {
+			regions.push_back(region);
+		}
+	}
+
+	// merge until no two regions overlap, an object is never split across tiles
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (size_t i = 0; i < regions.size() && !merged; ++i) {
+			for (size_t j = i + 1; j < regions.size(); ++j) {
+				if ((regions[i] & regions[j]).area() > 0) {
+					regions[i] |= regions[j];
+					regions.erase(regions.begin() + (std::ptrdiff_t)j);
+					merged = true;
+					break;
+				}
+			}
+		}
+	}
+	return regions;
+}
+
+bool packMosaic(const std::vector<cv::Rect> &regions, const cv::Size &canvas, double min_scale,
+		std::vector<MosaicTile> &tiles)
+{
+	tiles.clear();
+	if (regions.empty() || min_scale >= 1.0) {
+		return false;
+	}
+
+	// tallest first keeps the shelves tight
+	std::vector<size_t> order(regions.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(),
+		  [&](size_t a, size_t b) { return regions[a].height > regions[b].height; });
+
+	for (double scale = 1.0; scale > min_scale; scale *= SCALE_STEP) {
+		if (shelf_pack(regions, order, canvas, scale, tiles)) {
+			return true;
+		}
+	}
+	tiles.clear();
+	return false;
+}
+
+void renderMosaic(const cv::Mat &frame, const cv::Size &canvas,
+		  const std::vector<MosaicTile> &tiles, cv::Mat &mosaic)
+{
+	mosaic.create(canvas, frame.type());
+	mosaic.setTo(cv::Scalar(114, 114, 114, 255));
+	for (const MosaicTile &tile : tiles) {
+		cv::Mat target = mosaic(tile.target);
+		cv::resize(frame(tile.source), target, tile.target.size(), 0, 0,
+			   cv::INTER_LINEAR);
+	}
+}
+
+std::vector<Object> mapMosaicDetections(const std::vector<Object> &detections,
+					const std::vector<MosaicTile> &tiles,
+					std::vector<size_t> *tile_indices)
+{
+	std::vector<Object> mapped;
+	if (tile_indices) {
+		tile_indices->clear();
+	}
+	for (const Object &detection : detections) {
+		const cv::Point2f center(detection.rect.x + detection.rect.width / 2.0f,
+					 detection.rect.y + detection.rect.height / 2.0f);
+		for (size_t t = 0; t < tiles.size(); ++t) {
+			const MosaicTile &tile = tiles[t];
+			if (!tile.target.contains(cv::Point((int)center.x, (int)center.y))) {
+				continue;
+			}
+			const float sx = (float)tile.source.width / (float)tile.target.width;
+			const float sy = (float)tile.source.height / (float)tile.target.height;
+			Object object = detection;
+			object.rect = cv::Rect_<float>(
+					      tile.source.x + (detection.rect.x - tile.target.x) * sx,
+					      tile.source.y + (detection.rect.y - tile.target.y) * sy,
+					      detection.rect.width * sx, detection.rect.height * sy) &
+				      cv::Rect_<float>(tile.source);
+			if (object.rect.area() > 0.0f) {
+				mapped.push_back(object);
+				if (tile_indices) {
+					tile_indices->push_back(t);
+				}
+			}
+			break;
+		}
+	}
+	return mapped;
+}
+
+} // namespace tracker
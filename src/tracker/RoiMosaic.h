@@ -0,0 +1,50 @@
+#ifndef ROI_MOSAIC_H
+#define ROI_MOSAIC_H
+
+#include <opencv2/core.hpp>
+
+#include <vector>
+
+#include "ort-model/types.hpp"
+
+namespace tracker {
+
+// A frame region and where it is drawn in the mosaic
+struct MosaicTile {
+	cv::Rect source;
+	cv::Rect target;
+};
+
+/**
+ * Regions around the tracked boxes that the detector should look at: every box grown by
+ * `expand` times its size on each side (at least min_size), clipped to bounds, and overlapping
+ * regions merged.
+ */
+std::vector<cv::Rect> expandRegions(const std::vector<Object> &boxes, const cv::Rect &bounds,
+				    float expand, int min_size);
+
+/**
+ * Lay the regions out in a canvas of the model input size with a shelf packer, all at the
+ * largest common scale up to 1 (regions are never upscaled).
+ *
+ * @param min_scale The scale the full frame would get, a mosaic that needs a smaller scale
+ *                  than that shows nothing the full frame would not, and is rejected.
+ * @return false if the regions do not fit above min_scale.
+ */
+bool packMosaic(const std::vector<cv::Rect> &regions, const cv::Size &canvas, double min_scale,
+		std::vector<MosaicTile> &tiles);
+
+// Resize the tiles of the frame into a canvas of the same type, the rest is letterbox gray
+void renderMosaic(const cv::Mat &frame, const cv::Size &canvas,
+		  const std::vector<MosaicTile> &tiles, cv::Mat &mosaic);
+
+// Map detections on the mosaic back to frame coordinates, dropping the ones whose center is
+// not on a tile and clipping the rest to their tile's region. tile_indices, if given, gets the
+// tile of every mapped detection.
+std::vector<Object> mapMosaicDetections(const std::vector<Object> &detections,
+					const std::vector<MosaicTile> &tiles,
+					std::vector<size_t> *tile_indices = nullptr);
+
+} // namespace tracker
+
+#endif /* ROI_MOSAIC_H */
@@ -16,9 +16,10 @@ namespace yunet {
 
 YuNetONNX::YuNetONNX(file_name_t path_to_model, int intra_op_num_threads, int keep_topk,
 		     int inter_op_num_threads, const std::string &use_gpu_, int device_id,
-		     bool use_parallel, float nms_th, float conf_th)
+		     bool use_parallel, float nms_th, float conf_th, const SessionTuning *tuning,
+		     const std::string &ep_options)
 	: ONNXRuntimeModel(path_to_model, intra_op_num_threads, 1, inter_op_num_threads, use_gpu_,
-			   device_id, use_parallel, nms_th, conf_th),
+			   device_id, use_parallel, nms_th, conf_th, tuning, ep_options),
 	  keep_topk(keep_topk),
 	  strides({8, 16, 32}),
 	  divisor(32)
@@ -27,15 +28,13 @@ YuNetONNX::YuNetONNX(file_name_t path_to_model, int intra_op_num_threads, int ke
 	padH = (int((this->input_h_[0] - 1) / divisor) + 1) * divisor;
 }
 
-std::vector<Object> YuNetONNX::inference(const cv::Mat &frame)
+std::vector<Object> YuNetONNX::decode(const cv::Size &frame_size)
 {
-	ONNXRuntimeModel::inference(frame, 0);
-
 	// Postprocessing
 	std::vector<Object> objects = postProcess(this->output_tensor_);
 
-	const float scale = std::fminf((float)input_w_[0] / (float)frame.cols,
-				       (float)input_h_[0] / (float)frame.rows);
+	const float scale = std::fminf((float)input_w_[0] / (float)frame_size.width,
+				       (float)input_h_[0] / (float)frame_size.height);
 
 	// adjust scale to original image
 	for (auto &obj : objects) {
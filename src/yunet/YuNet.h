@@ -19,9 +19,12 @@ class YuNetONNX : public ONNXRuntimeModel {
 public:
 	YuNetONNX(file_name_t path_to_model, int intra_op_num_threads, int keep_topk = 50,
 		  int inter_op_num_threads = 1, const std::string &use_gpu_ = "", int device_id = 0,
-		  bool use_parallel = false, float nms_th = 0.45f, float conf_th = 0.3f);
+		  bool use_parallel = false, float nms_th = 0.45f, float conf_th = 0.3f,
+		  const SessionTuning *tuning = nullptr,
+		  const std::string &ep_options = std::string());
 
-	std::vector<Object> inference(const cv::Mat &frame) override;
+protected:
+	std::vector<Object> decode(const cv::Size &frame_size) override;
 
 private:
 	std::tuple<std::vector<cv::Rect>, std::vector<std::array<cv::Point2f, 5>>,